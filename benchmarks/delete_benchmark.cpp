@@ -0,0 +1,176 @@
+// Compare ds::delete_tree with `rm -rf` on a tree shaped like a node_modules
+// directory. The tree is created on a tmpfs by default, so only the cost of
+// the system calls is measured, not the disk.
+//
+// Usage: delete_benchmark [directory] [nbPackages] [filesPerPackage]
+//                         [repetitions]
+
+#include <algorithm>  // for sort
+#include <atomic>     // for atomic
+#include <chrono>     // for steady_clock
+#include <cstdlib>    // for system, strtoul
+#include <string>     // for string
+#include <thread>     // for hardware_concurrency
+#include <vector>     // for vector
+
+#include <fcntl.h>     // for open
+#include <sys/stat.h>  // for mkdir
+#include <unistd.h>    // for close, write
+
+#include <fmt/format.h>  // for print, format
+
+#include "app/file_delete.hpp"  // for ds::delete_tree
+
+namespace
+{
+    struct Tree
+    {
+        uint64_t nbFiles;
+        uint64_t nbDirectories;
+    };
+
+    void make_directory ( fs::path const & path, Tree & tree )
+    {
+        if ( mkdir( path.c_str(), 0755 ) != 0 )
+        {
+            fmt::print( stderr, "Can't create {}\n", path.string() );
+            std::exit( EXIT_FAILURE );
+        }
+        ++tree.nbDirectories;
+    }
+
+    void make_files ( fs::path const & directory, unsigned long nbFiles,
+                      Tree & tree )
+    {
+        static constexpr char content[] =
+            "module.exports = function () { return 42; };\n";
+        for ( unsigned long idx = 0; idx < nbFiles; ++idx )
+        {
+            fs::path path { directory / fmt::format( "file{}.js", idx ) };
+            int      descriptor =
+                open( path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644 );
+            if ( descriptor < 0
+                 || write( descriptor, content, sizeof( content ) - 1 ) < 0 )
+            {
+                fmt::print( stderr, "Can't create {}\n", path.string() );
+                std::exit( EXIT_FAILURE );
+            }
+            close( descriptor );
+            ++tree.nbFiles;
+        }
+    }
+
+    // Every package has files at its root and in lib/, and one package out
+    // of ten has its own nested dependency
+    Tree make_tree ( fs::path const & root, unsigned long nbPackages,
+                     unsigned long filesPerPackage )
+    {
+        Tree tree { 0, 0 };
+        make_directory( root, tree );
+        for ( unsigned long idx = 0; idx < nbPackages; ++idx )
+        {
+            fs::path package { root / fmt::format( "package{}", idx ) };
+            make_directory( package, tree );
+            make_files( package, filesPerPackage / 2, tree );
+            make_directory( package / "lib", tree );
+            make_files( package / "lib", filesPerPackage - filesPerPackage / 2,
+                        tree );
+            if ( idx % 10 == 0 )
+            {
+                fs::path dependency { package / "node_modules" / "dependency" };
+                make_directory( package / "node_modules", tree );
+                make_directory( dependency, tree );
+                make_files( dependency, filesPerPackage / 4, tree );
+            }
+        }
+        return tree;
+    }
+
+    template < typename Delete >
+    double median_seconds ( fs::path const & root, unsigned long nbPackages,
+                            unsigned long filesPerPackage,
+                            unsigned long nbRepetitions, Delete remove )
+    {
+        std::vector< double > durations {};
+        for ( unsigned long idx = 0; idx < nbRepetitions; ++idx )
+        {
+            make_tree( root, nbPackages, filesPerPackage );
+            auto start = std::chrono::steady_clock::now();
+            remove();
+            std::chrono::duration< double > duration =
+                std::chrono::steady_clock::now() - start;
+            if ( fs::exists( root ) )
+            {
+                fmt::print( stderr, "{} hasn't been removed\n", root.string() );
+                std::exit( EXIT_FAILURE );
+            }
+            durations.push_back( duration.count() );
+        }
+        std::sort( durations.begin(), durations.end() );
+        return durations[durations.size() / 2];
+    }
+}  // namespace
+
+int main ( int argc, char ** argv )
+{
+    fs::path      directory { argc > 1 ? argv[1] : "/dev/shm" };
+    unsigned long nbPackages { argc > 2 ? std::strtoul( argv[2], nullptr, 10 )
+                                        : 5000 };
+    unsigned long filesPerPackage {
+        argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 40 };
+    unsigned long nbRepetitions {
+        argc > 4 ? std::strtoul( argv[4], nullptr, 10 ) : 5 };
+
+    fs::path root { directory / "delete_benchmark_tree" };
+    if ( fs::exists( root ) )
+    {
+        fmt::print( stderr, "{} already exists\n", root.string() );
+        return EXIT_FAILURE;
+    }
+    Tree tree = make_tree( root, nbPackages, filesPerPackage );
+    fs::remove_all( root );
+    uint64_t nbEntries = tree.nbFiles + tree.nbDirectories;
+    fmt::print( "{} files and {} directories in {}, median of {} runs\n\n",
+                tree.nbFiles, tree.nbDirectories, directory.string(),
+                nbRepetitions );
+    fmt::print( "{:<24} {:>10} {:>14}\n", "method", "time (ms)",
+                "entries / s" );
+
+    auto report = [nbEntries] ( std::string const & name, double seconds ) {
+        fmt::print( "{:<24} {:>10.1f} {:>14.0f}\n", name, seconds * 1000.,
+                    static_cast< double >( nbEntries ) / seconds );
+    };
+
+    std::string command { fmt::format( "rm -rf '{}'", root.string() ) };
+    report( "rm -rf", median_seconds( root, nbPackages, filesPerPackage,
+                                      nbRepetitions, [&command] () {
+                                          if ( std::system( command.c_str() )
+                                               != 0 )
+                                          {
+                                              std::exit( EXIT_FAILURE );
+                                          }
+                                      } ) );
+
+    std::vector< unsigned int > threadCounts { 1, 2, 4 };
+    unsigned int nbCores {
+        std::max( 1u, std::thread::hardware_concurrency() ) };
+    if ( nbCores > 4 )
+    {
+        threadCounts.push_back( nbCores );
+    }
+    for ( unsigned int nbThreads : threadCounts )
+    {
+        report( fmt::format( "delete_tree, {} threads", nbThreads ),
+                median_seconds(
+                    root, nbPackages, filesPerPackage, nbRepetitions,
+                    [&root, nbThreads] () {
+                        std::atomic< uint64_t > nbRemoved { 0 };
+                        ds::delete_tree( root, nbThreads, nbRemoved,
+                                         [] ( std::string const & error ) {
+                                             fmt::print( stderr, "{}\n",
+                                                         error );
+                                         } );
+                    } ) );
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,394 @@
+// Time the filesystem and listing hot paths of the explorer on synthetic
+// trees created on a tmpfs, so only the cost of the code and the system calls
+// is measured: the scan of a directory behind FolderNavigator::refresh, the
+// search box completion, the size formatting and the folder size.
+//
+// Each case runs its warmup runs, then its measured runs, and reports the
+// percentiles of their durations. The results can be written as JSON to
+// compare the runs of two commits, with the perf events counted in the
+// regions of the explorer during the measured runs, by call.
+//
+// Usage: explorer_bench [--directory /dev/shm] [--flat 1000000]
+//                       [--deep 256] [--small 10000] [--warmup 2]
+//                       [--repetitions 10] [--json file] [--case name]
+
+#include <algorithm>   // for sort, max
+#include <chrono>      // for steady_clock, system_clock
+#include <cmath>       // for ceil
+#include <cstdlib>     // for strtoul, exit
+#include <fstream>     // for ofstream
+#include <functional>  // for function
+#include <map>         // for map
+#include <numeric>     // for accumulate
+#include <string>      // for string
+#include <vector>      // for vector
+
+#include <fcntl.h>     // for open
+#include <sys/stat.h>  // for mkdir
+#include <unistd.h>    // for close, getpid
+
+#include <fmt/format.h>  // for print, format
+
+#include "app/filesystem.hpp"     // for ds::scan_directory, ds::filter_entries
+#include "app/perf_counters.hpp"  // for PerfCounters
+
+namespace
+{
+    struct Options
+    {
+        fs::path      directory { "/dev/shm" };
+        // Entries of the flat directory
+        unsigned long nbFlatEntries { 1'000'000 };
+        // Directories nested in the deep tree
+        unsigned long depth { 256 };
+        // Directories of the tree of small directories
+        unsigned long nbSmallDirectories { 10'000 };
+        unsigned long nbWarmups { 2 };
+        unsigned long nbRepetitions { 10 };
+        fs::path      json {};
+        // Only the cases whose name contains it
+        std::string   filter {};
+    };
+
+    // Files in each directory of the deep and small trees
+    constexpr unsigned long FILES_PER_DIRECTORY { 8 };
+    // Sizes formatted by a run of get_size_pretty_print
+    constexpr std::size_t   NB_SIZES { 1'000'000 };
+    // Of the perf events, in the JSON
+    constexpr char const *  EVENT_KEYS[] { "task_clock_ns", "context_switches",
+                                          "page_faults",   "syscalls",
+                                          "instructions",  "cache_misses" };
+
+    struct Case
+    {
+        std::string             name;
+        // Processed by a run, to give the time per item
+        uint64_t                nbItems;
+        std::function< void() > run;
+    };
+
+    struct Result
+    {
+        std::string           name;
+        uint64_t              nbItems;
+        // In nanoseconds, sorted
+        std::vector< double > durations;
+        // Of the measured runs
+        std::map< std::string, PerfCounters::Totals, std::less<> > regions;
+
+        double get_percentile ( double percentile ) const
+        {
+            // Nearest rank
+            auto rank = static_cast< std::size_t >(
+                std::ceil( percentile / 100. * durations.size() ) );
+            return durations[std::max< std::size_t >( rank, 1 ) - 1];
+        }
+
+        double get_mean () const
+        {
+            return std::accumulate( durations.begin(), durations.end(), 0. )
+                   / static_cast< double >( durations.size() );
+        }
+    };
+
+    [[noreturn]] void fail ( std::string const & message )
+    {
+        fmt::print( stderr, "{}\n", message );
+        std::exit( EXIT_FAILURE );
+    }
+
+    Options parse_options ( int argc, char ** argv )
+    {
+        Options options {};
+        for ( int idx = 1; idx + 1 < argc; idx += 2 )
+        {
+            std::string   option { argv[idx] };
+            char const *  value { argv[idx + 1] };
+            unsigned long number { std::strtoul( value, nullptr, 10 ) };
+            if ( option == "--directory" )
+            {
+                options.directory = value;
+            }
+            else if ( option == "--flat" )
+            {
+                options.nbFlatEntries = number;
+            }
+            else if ( option == "--deep" )
+            {
+                options.depth = number;
+            }
+            else if ( option == "--small" )
+            {
+                options.nbSmallDirectories = number;
+            }
+            else if ( option == "--warmup" )
+            {
+                options.nbWarmups = number;
+            }
+            else if ( option == "--repetitions" )
+            {
+                options.nbRepetitions = std::max( number, 1ul );
+            }
+            else if ( option == "--json" )
+            {
+                options.json = value;
+            }
+            else if ( option == "--case" )
+            {
+                options.filter = value;
+            }
+            else
+            {
+                fail( fmt::format( "Unknown option {}", option ) );
+            }
+        }
+        return options;
+    }
+
+    void make_directory ( fs::path const & path )
+    {
+        if ( mkdir( path.c_str(), 0755 ) != 0 )
+        {
+            fail( fmt::format( "Can't create {}", path.string() ) );
+        }
+    }
+
+    void make_files ( fs::path const & directory, unsigned long nbFiles )
+    {
+        for ( unsigned long idx = 0; idx < nbFiles; ++idx )
+        {
+            // Various types, as they are classified by their extension
+            static constexpr char const * extensions[] { "txt", "cpp", "png",
+                                                         "json", "md" };
+            fs::path path { directory
+                            / fmt::format( "File{}.{}", idx,
+                                           extensions[idx % 5] ) };
+            int descriptor =
+                open( path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644 );
+            if ( descriptor < 0 )
+            {
+                fail( fmt::format( "Can't create {}", path.string() ) );
+            }
+            close( descriptor );
+        }
+    }
+
+    // One directory with every entry, one directory out of ten
+    void make_flat_tree ( fs::path const & root, unsigned long nbEntries )
+    {
+        make_directory( root );
+        make_files( root, nbEntries - nbEntries / 10 );
+        for ( unsigned long idx = 0; idx < nbEntries / 10; ++idx )
+        {
+            make_directory( root / fmt::format( "Directory{}", idx ) );
+        }
+    }
+
+    void make_deep_tree ( fs::path root, unsigned long depth )
+    {
+        for ( unsigned long idx = 0; idx < depth; ++idx )
+        {
+            make_directory( root );
+            make_files( root, FILES_PER_DIRECTORY );
+            root /= "nested";
+        }
+    }
+
+    void make_small_tree ( fs::path const & root,
+                           unsigned long    nbDirectories )
+    {
+        make_directory( root );
+        for ( unsigned long idx = 0; idx < nbDirectories; ++idx )
+        {
+            fs::path directory { root / fmt::format( "Small{}", idx ) };
+            make_directory( directory );
+            make_files( directory, FILES_PER_DIRECTORY );
+        }
+    }
+
+    template < typename Function >
+    double measure ( Function const & function )
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration< double, std::nano > {
+            std::chrono::steady_clock::now() - start }
+            .count();
+    }
+
+    Result run_case ( Case const & benchmark, Options const & options )
+    {
+        for ( unsigned long idx = 0; idx < options.nbWarmups; ++idx )
+        {
+            benchmark.run();
+        }
+        Result result { benchmark.name, benchmark.nbItems, {}, {} };
+        PerfCounters::get_instance().clear();
+        for ( unsigned long idx = 0; idx < options.nbRepetitions; ++idx )
+        {
+            result.durations.push_back( measure( benchmark.run ) );
+        }
+        std::sort( result.durations.begin(), result.durations.end() );
+        result.regions = PerfCounters::get_instance().get_regions();
+        return result;
+    }
+
+    void print_result ( Result const & result )
+    {
+        auto ms = [] ( double nanoseconds ) { return nanoseconds / 1e6; };
+        fmt::print( "{:<32} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f} "
+                    "{:>12.1f}\n",
+                    result.name, ms( result.get_percentile( 50 ) ),
+                    ms( result.get_percentile( 90 ) ),
+                    ms( result.get_percentile( 99 ) ),
+                    ms( result.durations.back() ),
+                    result.get_percentile( 50 )
+                        / static_cast< double >( result.nbItems ) );
+    }
+
+    // Means by call of the events counted
+    std::string to_json ( PerfCounters::Totals const & totals )
+    {
+        std::string json = fmt::format( "{{\"calls\": {}", totals.nbCalls );
+        for ( std::size_t idx = 0; idx < PerfCounters::NB_EVENTS; ++idx )
+        {
+            if ( totals.nbCounted[idx] > 0 )
+            {
+                json += fmt::format(
+                    ", \"{}\": {:.1f}", EVENT_KEYS[idx],
+                    static_cast< double >( totals.values[idx] )
+                        / static_cast< double >( totals.nbCounted[idx] ) );
+            }
+        }
+        return json + "}";
+    }
+
+    void write_json ( fs::path const & path, Options const & options,
+                      std::vector< Result > const & results )
+    {
+        std::string json { "{\n" };
+        json += fmt::format(
+            "  \"timestamp\": {},\n",
+            std::chrono::duration_cast< std::chrono::seconds >(
+                std::chrono::system_clock::now().time_since_epoch() )
+                .count() );
+        json += fmt::format(
+            "  \"config\": {{\"flat\": {}, \"deep\": {}, \"small\": {}, "
+            "\"warmup\": {}, \"repetitions\": {}}},\n",
+            options.nbFlatEntries, options.depth, options.nbSmallDirectories,
+            options.nbWarmups, options.nbRepetitions );
+        // The events which can't be counted are missing from the results
+        json += fmt::format( "  \"perf_status\": \"{}\",\n",
+                             PerfCounters::get_instance().get_status() );
+        json += "  \"results\": [\n";
+        for ( std::size_t idx = 0; idx < results.size(); ++idx )
+        {
+            Result const & result = results[idx];
+            std::string    regions {};
+            for ( auto const & [name, totals] : result.regions )
+            {
+                regions += fmt::format( "{}\"{}\": {}",
+                                        regions.empty() ? "" : ", ", name,
+                                        to_json( totals ) );
+            }
+            json += fmt::format(
+                "    {{\"name\": \"{}\", \"unit\": \"ns\", \"items\": {}, "
+                "\"min\": {:.0f}, \"p50\": {:.0f}, \"p90\": {:.0f}, "
+                "\"p99\": {:.0f}, \"max\": {:.0f}, \"mean\": {:.0f}, "
+                "\"perf\": {{{}}}}}{}\n",
+                result.name, result.nbItems, result.durations.front(),
+                result.get_percentile( 50 ), result.get_percentile( 90 ),
+                result.get_percentile( 99 ), result.durations.back(),
+                result.get_mean(), regions,
+                idx + 1 < results.size() ? "," : "" );
+        }
+        json += "  ]\n}\n";
+
+        std::ofstream file { path };
+        file << json;
+        if ( ! file )
+        {
+            fail( fmt::format( "Can't write {}", path.string() ) );
+        }
+    }
+}  // namespace
+
+int main ( int argc, char ** argv )
+{
+    Options  options { parse_options( argc, argv ) };
+    fs::path root { options.directory
+                    / fmt::format( "explorer_bench_{}", getpid() ) };
+    fs::path flat { root / "flat" };
+    fs::path deep { root / "deep" };
+    fs::path small { root / "small" };
+
+    fmt::print( "Creating the trees in {}\n", root.string() );
+    make_directory( root );
+    make_flat_tree( flat, options.nbFlatEntries );
+    make_deep_tree( deep, options.depth );
+    make_small_tree( small, options.nbSmallDirectories );
+
+    std::vector< uintmax_t > sizes( NB_SIZES );
+    for ( std::size_t idx = 0; idx < sizes.size(); ++idx )
+    {
+        // Spread over every unit
+        sizes[idx] = ( uintmax_t { 1 } << ( idx % 60 ) ) + idx;
+    }
+    uintmax_t   nbFormatted { 0 };
+    std::string flatFilter { "file1" };
+
+    std::vector< Case > cases {
+        { "scan_directory/flat", options.nbFlatEntries,
+          [&flat] () { ds::scan_directory( flat, false ); } },
+        { "scan_directory/small", options.nbSmallDirectories,
+          [&small] () { ds::scan_directory( small, false ); } },
+        { "filter_entries/flat", options.nbFlatEntries,
+          [&flat, &flatFilter] () {
+              ds::filter_entries( flat, flatFilter, false );
+          } },
+        { "get_size_pretty_print", NB_SIZES,
+          [&sizes, &nbFormatted] () {
+              for ( uintmax_t size : sizes )
+              {
+                  nbFormatted +=
+                      ds::get_size_pretty_print( size, false ).size();
+              }
+          } },
+        { "get_folder_size/deep", options.depth * ( FILES_PER_DIRECTORY + 1 ),
+          [&deep] () { ds::get_folder_size( deep ); } },
+        { "get_folder_size/small",
+          options.nbSmallDirectories * ( FILES_PER_DIRECTORY + 1 ),
+          [&small] () { ds::get_folder_size( small ); } },
+    };
+
+    PerfCounters::get_instance().set_enabled( true );
+    if ( ! PerfCounters::get_instance().get_status().empty() )
+    {
+        fmt::print( "Perf events not counted: {}\n",
+                    PerfCounters::get_instance().get_status() );
+    }
+
+    fmt::print( "{} warmup and {} measured runs\n\n", options.nbWarmups,
+                options.nbRepetitions );
+    fmt::print( "{:<32} {:>10} {:>10} {:>10} {:>10} {:>12}\n", "case",
+                "p50 (ms)", "p90 (ms)", "p99 (ms)", "max (ms)",
+                "ns / item" );
+    std::vector< Result > results {};
+    for ( Case const & benchmark : cases )
+    {
+        if ( benchmark.name.find( options.filter ) == std::string::npos )
+        {
+            continue;
+        }
+        results.push_back( run_case( benchmark, options ) );
+        print_result( results.back() );
+    }
+
+    if ( ! options.json.empty() )
+    {
+        write_json( options.json, options, results );
+    }
+    std::error_code error {};
+    fs::remove_all( root, error );
+    return EXIT_SUCCESS;
+}
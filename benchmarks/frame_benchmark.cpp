@@ -0,0 +1,225 @@
+// Measure the frames of the explorer without GPU nor display server: the
+// window is headless, ImGui builds its draw data for a fixed display size and
+// nothing renders it. The directories are synthetic, held by the memory file
+// system, so only the cost of the frames is measured.
+//
+// Each directory is showed in the list and the grid views, once still and
+// once scrolled by a notch of the mouse wheel on every frame. The CPU time of
+// the UI thread is reported for the whole frame and for Explorer::update, with
+// the size of the draw data given to the renderer: its vertices, indices,
+// draw lists and draw commands, each command being a draw call.
+//
+// Usage: frame_benchmark [frames=300] [warmup=30] [width=1280] [height=800]
+
+#include <algorithm>  // for sort
+#include <cfloat>     // for FLT_MAX
+#include <chrono>     // for steady_clock, seconds
+#include <cstdlib>    // for strtoul, strtof
+#include <memory>     // for make_shared
+#include <string>     // for string
+#include <thread>     // for sleep_for
+#include <vector>     // for vector
+
+#include <time.h>  // for clock_gettime
+
+#include <fmt/format.h>   // for print, format
+#include <imgui/imgui.h>  // for ImGui::GetDrawData
+
+#include "app/explorer.hpp"            // for Explorer
+#include "app/memory_file_system.hpp"  // for vfs::MemoryFileSystem
+#include "app/window.hpp"              // for Window
+
+namespace
+{
+    constexpr uint64_t ROWS[] { 1'000, 100'000, 1'000'000 };
+    constexpr uint64_t MAX_FILE_SIZE { 1024 * 1024 };
+    // The largest listing is read by the worker of its mount
+    constexpr std::chrono::seconds LISTING_TIMEOUT { 120 };
+
+    struct Frame
+    {
+        // CPU time of the UI thread, in milliseconds
+        double frameTime;
+        double updateTime;
+        int    nbVertices;
+        int    nbIndices;
+        int    nbLists;
+        int    nbCommands;
+    };
+
+    double get_thread_time ()
+    {
+        timespec time {};
+        clock_gettime( CLOCK_THREAD_CPUTIME_ID, &time );
+        return static_cast< double >( time.tv_sec ) * 1e3
+               + static_cast< double >( time.tv_nsec ) / 1e6;
+    }
+
+    Frame run_frame ( Window & window, Explorer & explorer, bool isScrolling )
+    {
+        ImGuiIO & io = ImGui::GetIO();
+        if ( isScrolling )
+        {
+            // Over the rows, below the header bar
+            io.AddMousePosEvent( io.DisplaySize.x / 2.f,
+                                 io.DisplaySize.y / 2.f );
+            io.AddMouseWheelEvent( 0.f, -1.f );
+        }
+        else
+        {
+            io.AddMousePosEvent( -FLT_MAX, -FLT_MAX );
+        }
+
+        Frame  frame {};
+        double start = get_thread_time();
+        window.update( [&explorer, &frame] () {
+            double updateStart = get_thread_time();
+            explorer.update();
+            frame.updateTime = get_thread_time() - updateStart;
+        } );
+        frame.frameTime = get_thread_time() - start;
+
+        ImDrawData const * drawData = ImGui::GetDrawData();
+        frame.nbVertices            = drawData->TotalVtxCount;
+        frame.nbIndices             = drawData->TotalIdxCount;
+        frame.nbLists               = drawData->CmdListsCount;
+        for ( int idx = 0; idx < drawData->CmdListsCount; ++idx )
+        {
+            frame.nbCommands += drawData->CmdLists[idx]->CmdBuffer.Size;
+        }
+        return frame;
+    }
+
+    // The listing is read in background when it's too long for a frame
+    bool wait_listing ( Window & window, Explorer & explorer,
+                        uint64_t nbRows )
+    {
+        auto start = std::chrono::steady_clock::now();
+        while ( explorer.get_tab_navigator()
+                    .get_current()
+                    .get_listing()
+                    .entries.size()
+                != nbRows )
+        {
+            if ( std::chrono::steady_clock::now() - start > LISTING_TIMEOUT )
+            {
+                return false;
+            }
+            run_frame( window, explorer, false );
+            std::this_thread::sleep_for( std::chrono::milliseconds { 10 } );
+        }
+        return true;
+    }
+
+    double get_percentile ( std::vector< double > values, double percentile )
+    {
+        std::sort( values.begin(), values.end() );
+        std::size_t rank = static_cast< std::size_t >(
+            percentile / 100. * static_cast< double >( values.size() - 1 ) );
+        return values[rank];
+    }
+
+    void print_frames ( std::string const &          name,
+                        std::vector< Frame > const & frames )
+    {
+        std::vector< double > frameTimes {};
+        std::vector< double > updateTimes {};
+
+        double nbVertices { 0 };
+        double nbIndices { 0 };
+        double nbLists { 0 };
+        double nbCommands { 0 };
+        for ( Frame const & frame : frames )
+        {
+            frameTimes.push_back( frame.frameTime );
+            updateTimes.push_back( frame.updateTime );
+            nbVertices += frame.nbVertices;
+            nbIndices += frame.nbIndices;
+            nbLists += frame.nbLists;
+            nbCommands += frame.nbCommands;
+        }
+        double nbFrames = static_cast< double >( frames.size() );
+        fmt::print( "{:<22} {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f} {:>9.0f} "
+                    "{:>9.0f} {:>6.1f} {:>8.1f}\n",
+                    name, get_percentile( frameTimes, 50 ),
+                    get_percentile( frameTimes, 99 ),
+                    get_percentile( updateTimes, 50 ),
+                    get_percentile( updateTimes, 99 ), nbVertices / nbFrames,
+                    nbIndices / nbFrames, nbLists / nbFrames,
+                    nbCommands / nbFrames );
+    }
+}  // namespace
+
+int main ( int argc, char ** argv )
+{
+    unsigned long nbFrames { argc > 1 ? std::strtoul( argv[1], nullptr, 10 )
+                                      : 300 };
+    unsigned long nbWarmups { argc > 2 ? std::strtoul( argv[2], nullptr, 10 )
+                                       : 30 };
+    float width { argc > 3 ? std::strtof( argv[3], nullptr ) : 1280.f };
+    float height { argc > 4 ? std::strtof( argv[4], nullptr ) : 800.f };
+
+    fs::path home { ds::get_home_directory() };
+    auto     fileSystem = std::make_shared< vfs::MemoryFileSystem >();
+    fileSystem->create_directory( home );
+    for ( uint64_t nbRows : ROWS )
+    {
+        fileSystem->create_synthetic_files(
+            home / fmt::format( "rows_{}", nbRows ), nbRows, MAX_FILE_SIZE );
+    }
+    vfs::set_file_system( fileSystem );
+
+    Window   window { ImVec2 { width, height } };
+    Explorer explorer { window };
+
+    fmt::print( "{} frames of {}x{}, after {} warmup frames\n\n", nbFrames,
+                width, height, nbWarmups );
+    fmt::print( "{:<22} {:>8} {:>8} {:>8} {:>8} {:>9} {:>9} {:>6} {:>8}\n",
+                "", "frame", "", "update", "", "", "", "", "" );
+    fmt::print( "{:<22} {:>8} {:>8} {:>8} {:>8} {:>9} {:>9} {:>6} {:>8}\n",
+                "case (ms CPU)", "p50", "p99", "p50", "p99", "vertices",
+                "indices", "lists", "commands" );
+    for ( uint64_t nbRows : ROWS )
+    {
+        FolderNavigator & navigator =
+            explorer.get_tab_navigator().get_current();
+        for ( FolderNavigator::ViewMode viewMode :
+              { FolderNavigator::ViewMode::List,
+                FolderNavigator::ViewMode::Grid } )
+        {
+            for ( bool isScrolling : { false, true } )
+            {
+                // From the top of the directory
+                navigator.change_directory(
+                    home / fmt::format( "rows_{}", nbRows ) );
+                navigator.set_view_mode( viewMode );
+                if ( ! wait_listing( window, explorer, nbRows ) )
+                {
+                    fmt::print( stderr, "The directory of {} rows can't be "
+                                        "read\n",
+                                nbRows );
+                    return EXIT_FAILURE;
+                }
+
+                for ( unsigned long idx = 0; idx < nbWarmups; ++idx )
+                {
+                    run_frame( window, explorer, isScrolling );
+                }
+                std::vector< Frame > frames {};
+                for ( unsigned long idx = 0; idx < nbFrames; ++idx )
+                {
+                    frames.push_back(
+                        run_frame( window, explorer, isScrolling ) );
+                }
+                print_frames(
+                    fmt::format( "{}/{}/{}", nbRows,
+                                 viewMode == FolderNavigator::ViewMode::List
+                                     ? "list"
+                                     : "grid",
+                                 isScrolling ? "scroll" : "still" ),
+                    frames );
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
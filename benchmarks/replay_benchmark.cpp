@@ -0,0 +1,228 @@
+// Replay a session recorded by explorer --record-input in a headless window,
+// and report the time of its frames and the latency of its input: from the
+// moment the events were received in the session, to the end of the frame
+// which handled them.
+//
+// The frames are replayed at the pace of the session by default, so the
+// background work (reading a large directory, the thumbnails...) overlaps
+// the input as it did. With --fast they are replayed as fast as possible, and
+// the latency is only the time of the frame. The session must be replayed on
+// the same tree: give the --memory or --snapshot option it was recorded with.
+//
+// Usage: replay_benchmark recording [--memory files | --snapshot file]
+//                         [--fast] [--frames file]
+
+#include <algorithm>  // for sort
+#include <chrono>     // for steady_clock
+#include <cmath>      // for ceil
+#include <cstdlib>    // for strtoull
+#include <fstream>    // for ofstream
+#include <string>     // for string
+#include <thread>     // for sleep_until
+#include <vector>     // for vector
+
+#include <time.h>  // for clock_gettime
+
+#include <fmt/format.h>  // for print, format
+
+#include "app/explorer.hpp"              // for Explorer
+#include "app/input_recording.hpp"       // for InputRecording
+#include "app/memory_file_system.hpp"    // for vfs::use_synthetic_home
+#include "app/snapshot_file_system.hpp"  // for vfs::use_snapshot_home
+#include "app/window.hpp"                // for Window
+
+namespace
+{
+    // Longer frames are late on a 60 Hz display
+    constexpr double FRAME_BUDGET { 1000. / 60. };
+
+    struct FrameTiming
+    {
+        // In milliseconds, since the start of the replay
+        double start;
+        double duration;
+        // CPU time of the UI thread
+        double cpuTime;
+        // Negative without input
+        double latency;
+        std::size_t nbEvents;
+    };
+
+    double get_thread_time ()
+    {
+        timespec time {};
+        clock_gettime( CLOCK_THREAD_CPUTIME_ID, &time );
+        return static_cast< double >( time.tv_sec ) * 1e3
+               + static_cast< double >( time.tv_nsec ) / 1e6;
+    }
+
+    double to_milliseconds ( std::chrono::steady_clock::duration duration )
+    {
+        return std::chrono::duration< double, std::milli > { duration }
+            .count();
+    }
+
+    // Nearest rank, values must not be empty
+    double get_percentile ( std::vector< double > values, double percentile )
+    {
+        std::sort( values.begin(), values.end() );
+        auto rank = static_cast< std::size_t >( std::ceil(
+            percentile / 100. * static_cast< double >( values.size() ) ) );
+        return values[std::max< std::size_t >( rank, 1 ) - 1];
+    }
+
+    void print_summary ( std::string const &           name,
+                         std::vector< double > const & values )
+    {
+        if ( values.empty() )
+        {
+            fmt::print( "{:<14} no frame\n", name );
+            return;
+        }
+        fmt::print( "{:<14} {:>8.2f} {:>8.2f} {:>8.2f} {:>8.2f} {:>8}\n", name,
+                    get_percentile( values, 50 ), get_percentile( values, 90 ),
+                    get_percentile( values, 99 ),
+                    *std::max_element( values.begin(), values.end() ),
+                    values.size() );
+    }
+
+    bool write_frames ( fs::path const &                   file,
+                        std::vector< FrameTiming > const & timings )
+    {
+        std::ofstream output { file };
+        output << "frame,start_ms,duration_ms,cpu_ms,latency_ms,events\n";
+        for ( std::size_t idx = 0; idx < timings.size(); ++idx )
+        {
+            FrameTiming const & timing = timings[idx];
+            output << fmt::format( "{},{:.3f},{:.3f},{:.3f},{},{}\n", idx,
+                                   timing.start, timing.duration,
+                                   timing.cpuTime,
+                                   timing.latency < 0.
+                                       ? std::string {}
+                                       : fmt::format( "{:.3f}",
+                                                      timing.latency ),
+                                   timing.nbEvents );
+        }
+        return static_cast< bool >( output );
+    }
+}  // namespace
+
+int main ( int argc, char ** argv )
+{
+    if ( argc < 2 )
+    {
+        fmt::print( stderr,
+                    "Usage: {} recording [--memory files | --snapshot file] "
+                    "[--fast] [--frames file]\n",
+                    argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    bool     isFast { false };
+    fs::path framesFile {};
+    for ( int idx = 2; idx < argc; ++idx )
+    {
+        std::string option { argv[idx] };
+        if ( option == "--fast" )
+        {
+            isFast = true;
+        }
+        else if ( option == "--memory" && idx + 1 < argc )
+        {
+            vfs::use_synthetic_home(
+                std::strtoull( argv[++idx], nullptr, 10 ) );
+        }
+        else if ( option == "--snapshot" && idx + 1 < argc )
+        {
+            if ( ! vfs::use_snapshot_home( argv[++idx] ) )
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else if ( option == "--frames" && idx + 1 < argc )
+        {
+            framesFile = argv[++idx];
+        }
+        else
+        {
+            fmt::print( stderr, "Unknown option {}\n", option );
+            return EXIT_FAILURE;
+        }
+    }
+
+    InputRecording recording {};
+    if ( ! recording.load( argv[1] ) || recording.get_frames().empty() )
+    {
+        return EXIT_FAILURE;
+    }
+    std::vector< InputRecording::Frame > const & frames =
+        recording.get_frames();
+
+    Window   window { frames.front().displaySize };
+    Explorer explorer { window };
+
+    std::vector< FrameTiming > timings {};
+    auto replayStart = std::chrono::steady_clock::now();
+    for ( InputRecording::Frame const & frame : frames )
+    {
+        // When the events of the frame were received in the session
+        auto received = replayStart + ( frame.time - frames.front().time );
+        if ( isFast )
+        {
+            received = std::chrono::steady_clock::now();
+        }
+        else
+        {
+            std::this_thread::sleep_until( received );
+        }
+
+        window.replay_input( frame );
+        auto   start     = std::chrono::steady_clock::now();
+        double startTime = get_thread_time();
+        window.update( [&explorer] () { explorer.update(); } );
+        auto end = std::chrono::steady_clock::now();
+
+        timings.push_back( FrameTiming {
+            to_milliseconds( start - replayStart ),
+            to_milliseconds( end - start ), get_thread_time() - startTime,
+            frame.events.empty() ? -1. : to_milliseconds( end - received ),
+            frame.events.size() } );
+    }
+
+    std::vector< double > durations {};
+    std::vector< double > cpuTimes {};
+    std::vector< double > latencies {};
+    std::size_t           nbLateFrames { 0 };
+    for ( FrameTiming const & timing : timings )
+    {
+        durations.push_back( timing.duration );
+        cpuTimes.push_back( timing.cpuTime );
+        if ( timing.latency >= 0. )
+        {
+            latencies.push_back( timing.latency );
+        }
+        if ( timing.duration > FRAME_BUDGET )
+        {
+            ++nbLateFrames;
+        }
+    }
+
+    fmt::print( "{} frames replayed {} in {:.1f} s, {} over {:.1f} ms\n\n",
+                timings.size(), isFast ? "as fast as possible" : "at pace",
+                to_milliseconds( std::chrono::steady_clock::now()
+                                 - replayStart )
+                    / 1000.,
+                nbLateFrames, FRAME_BUDGET );
+    fmt::print( "{:<14} {:>8} {:>8} {:>8} {:>8} {:>8}\n", "(ms)", "p50", "p90",
+                "p99", "max", "frames" );
+    print_summary( "frame", durations );
+    print_summary( "frame CPU", cpuTimes );
+    print_summary( "input latency", latencies );
+
+    if ( ! framesFile.empty() && ! write_frames( framesFile, timings ) )
+    {
+        fmt::print( stderr, "Can't write {}\n", framesFile.string() );
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
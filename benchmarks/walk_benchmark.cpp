@@ -0,0 +1,116 @@
+// Compare the orders of ds::walk_tree, and std::recursive_directory_iterator,
+// on an existing tree. The page cache is dropped before each run when the
+// benchmark runs as root, otherwise the reads are served from memory and the
+// order doesn't matter. walk_benchmark.sh creates a tree on a loopback ext4
+// image to run it on.
+//
+// Usage: walk_benchmark directory [repetitions]
+
+#include <algorithm>  // for sort
+#include <chrono>     // for steady_clock
+#include <cstdlib>    // for strtoul
+#include <fstream>    // for ofstream
+#include <string>     // for string
+#include <vector>     // for vector
+
+#include <sys/stat.h>  // for stat
+#include <unistd.h>    // for sync
+
+#include <fmt/format.h>  // for print, format
+
+#include "app/tree_walker.hpp"  // for ds::walk_tree
+
+namespace
+{
+    bool drop_caches ()
+    {
+        sync();
+        std::ofstream file { "/proc/sys/vm/drop_caches" };
+        file << "3\n";
+        file.flush();
+        return file.good();
+    }
+
+    template < typename Walk >
+    double median_seconds ( unsigned long nbRepetitions, bool isCold,
+                            Walk walk )
+    {
+        std::vector< double > durations {};
+        for ( unsigned long idx = 0; idx < nbRepetitions; ++idx )
+        {
+            if ( isCold )
+            {
+                drop_caches();
+            }
+            auto start = std::chrono::steady_clock::now();
+            walk();
+            std::chrono::duration< double > duration =
+                std::chrono::steady_clock::now() - start;
+            durations.push_back( duration.count() );
+        }
+        std::sort( durations.begin(), durations.end() );
+        return durations[durations.size() / 2];
+    }
+
+    uint64_t walk ( fs::path const & root, ds::WalkOrder order )
+    {
+        uint64_t nbEntries { 0 };
+        ds::walk_tree(
+            root, order,
+            [&nbEntries] ( fs::path const &, struct stat const & ) {
+                ++nbEntries;
+            },
+            [] ( std::string const & error ) {
+                fmt::print( stderr, "{}\n", error );
+            } );
+        return nbEntries;
+    }
+}  // namespace
+
+int main ( int argc, char ** argv )
+{
+    if ( argc < 2 )
+    {
+        fmt::print( stderr, "Usage: {} directory [repetitions]\n", argv[0] );
+        return EXIT_FAILURE;
+    }
+    fs::path      root { argv[1] };
+    unsigned long nbRepetitions {
+        argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 3 };
+
+    bool isCold { drop_caches() };
+    if ( ! isCold )
+    {
+        fmt::print( stderr, "Can't drop the page cache, the runs are warm\n" );
+    }
+    uint64_t nbEntries { walk( root, ds::WalkOrder::Directory ) };
+    fmt::print( "{} entries in {}, {} runs, median of {} runs\n\n", nbEntries,
+                root.string(), isCold ? "cold" : "warm", nbRepetitions );
+    fmt::print( "{:<32} {:>10} {:>14}\n", "method", "time (ms)",
+                "entries / s" );
+
+    auto report = [nbEntries] ( std::string const & name, double seconds ) {
+        fmt::print( "{:<32} {:>10.1f} {:>14.0f}\n", name, seconds * 1000.,
+                    static_cast< double >( nbEntries ) / seconds );
+    };
+
+    report( "recursive_directory_iterator",
+            median_seconds( nbRepetitions, isCold, [&root] () {
+                std::error_code error {};
+                for ( fs::recursive_directory_iterator it { root, error };
+                      ! error && it != fs::recursive_directory_iterator {};
+                      it.increment( error ) )
+                {
+                    it->symlink_status( error );
+                }
+            } ) );
+    report( "walk_tree, directory order",
+            median_seconds( nbRepetitions, isCold, [&root] () {
+                walk( root, ds::WalkOrder::Directory );
+            } ) );
+    report( "walk_tree, inode order",
+            median_seconds( nbRepetitions, isCold, [&root] () {
+                walk( root, ds::WalkOrder::Inode );
+            } ) );
+    return EXIT_SUCCESS;
+}
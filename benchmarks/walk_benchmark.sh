@@ -0,0 +1,54 @@
+#!/bin/sh
+# Run walk_benchmark on a fresh ext4 filesystem mounted from a loopback image.
+# The files are created in a different order than the one of their directory,
+# like a tree filled over time, so the directory order seeks on a rotational
+# disk. Must run as root to mount the image and drop the page cache.
+#
+# Usage: walk_benchmark.sh [build directory=build] [nbDirectories=200]
+#                          [filesPerDirectory=200] [repetitions=3]
+
+set -eu
+
+buildDirectory=${1:-build}
+nbDirectories=${2:-200}
+filesPerDirectory=${3:-200}
+repetitions=${4:-3}
+
+workDirectory=$(mktemp -d)
+image="$workDirectory/walk_benchmark.img"
+mountPoint="$workDirectory/mount"
+
+cleanup() {
+    umount "$mountPoint" 2>/dev/null || true
+    rm -rf "$workDirectory"
+}
+trap cleanup EXIT
+
+truncate -s 2G "$image"
+mkfs.ext4 -q -F "$image"
+mkdir "$mountPoint"
+mount -o loop "$image" "$mountPoint"
+
+# One file in each directory at a time, so the inodes of a directory are
+# spread over the whole tree
+directory=0
+while [ "$directory" -lt "$nbDirectories" ]; do
+    mkdir -p "$mountPoint/tree/directory$directory/nested"
+    directory=$((directory + 1))
+done
+file=0
+while [ "$file" -lt "$filesPerDirectory" ]; do
+    directory=0
+    while [ "$directory" -lt "$nbDirectories" ]; do
+        if [ $((file % 10)) -eq 0 ]; then
+            : > "$mountPoint/tree/directory$directory/nested/file$file"
+        else
+            : > "$mountPoint/tree/directory$directory/file$file"
+        fi
+        directory=$((directory + 1))
+    done
+    file=$((file + 1))
+done
+sync
+
+"$buildDirectory/walk_benchmark" "$mountPoint/tree" "$repetitions"
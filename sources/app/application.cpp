@@ -38,3 +38,8 @@ bool Application::should_run() const
 {
     return m_shouldRun;
 }
+
+void Application::record_input( fs::path const & file )
+{
+    m_window.record_input( file );
+}
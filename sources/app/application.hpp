@@ -19,4 +19,7 @@ class Application
 
     void should_run ( bool shouldRun );
     bool should_run () const;
+
+    // Saved in the file when the application ends
+    void record_input ( fs::path const & file );
 };
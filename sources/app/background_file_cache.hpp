@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>         // for atomic
+#include <chrono>         // for steady_clock
+#include <functional>     // for function
+#include <mutex>          // for mutex
+#include <optional>       // for optional
+#include <string>         // for string
+#include <unordered_map>  // for unordered_map
+
+#include "app/filesystem.hpp"     // for ds::FileKey
+#include "app/job_scheduler.hpp"  // for JobScheduler
+
+// Information computed in background on the files showed to the user, and
+// cached for each version of the file. The most recently requested files are
+// computed first, and a file not requested since a while, or left by a
+// navigation, is skipped.
+template< typename Result >
+class BackgroundFileCache
+{
+  public:
+    // Called on a worker thread, nullopt if the file has no such information
+    using Compute =
+        std::function< std::optional< Result >( fs::path const & ) >;
+
+  private:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    Compute     m_compute;
+    std::size_t m_maxOutstanding;
+    std::size_t m_maxResults;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map< ds::FileKey, std::optional< Result >, ds::FileKeyHash >
+        m_results;
+    // Time of the last request of each file waiting to be computed
+    std::unordered_map< ds::FileKey, TimePoint, ds::FileKeyHash > m_pending;
+
+    std::atomic< uint64_t > m_nbComputed;
+    std::atomic< uint64_t > m_nbCancelled;
+    // Destroyed first, so no job runs on a partially destroyed cache
+    JobScheduler::Queue     m_jobs;
+
+  public:
+    BackgroundFileCache( Compute compute, std::size_t maxOutstanding,
+                         std::size_t maxResults );
+    virtual ~BackgroundFileCache() = default;
+
+    // nullopt while the result isn't computed, or if the file has no such
+    // information. Queue the computation if it's not already done.
+    std::optional< Result > get ( ds::FileKey const & key,
+                                  fs::path const &    path );
+
+    void debug_gui () const;
+
+  private:
+    void compute ( ds::FileKey key, fs::path const & path,
+                   std::stop_token const & stopToken );
+};
+
+#include "background_file_cache_impl.hpp"
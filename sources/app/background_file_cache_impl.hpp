@@ -0,0 +1,129 @@
+#pragma once
+
+#include <exception>  // for exception
+
+#include <imgui/imgui.h>  // for ImGui::Text
+
+#include "background_file_cache.hpp"
+#include "tools/traces.hpp"  // for Trace
+
+namespace background_file_cache
+{
+    // A file not requested since is not showed anymore
+    constexpr std::chrono::milliseconds REQUEST_TIMEOUT { 250 };
+}  // namespace background_file_cache
+
+template< typename Result >
+BackgroundFileCache< Result >::BackgroundFileCache( Compute     compute,
+                                                    std::size_t maxOutstanding,
+                                                    std::size_t maxResults )
+  : m_compute { std::move( compute ) },
+    m_maxOutstanding { maxOutstanding },
+    m_maxResults { maxResults },
+    m_mutex {},
+    m_results {},
+    m_pending {},
+    m_nbComputed { 0 },
+    m_nbCancelled { 0 },
+    m_jobs { JobScheduler::JobClass::Metadata }
+{}
+
+template< typename Result >
+std::optional< Result > BackgroundFileCache< Result >::get(
+    ds::FileKey const & key, fs::path const & path )
+{
+    // Inode 0 means that the file couldn't be stat
+    if ( key.inode == 0 )
+    {
+        return std::nullopt;
+    }
+
+    std::lock_guard< std::mutex > lock { m_mutex };
+
+    auto result = m_results.find( key );
+    if ( result != m_results.end() )
+    {
+        return result->second;
+    }
+
+    TimePoint now     = std::chrono::steady_clock::now();
+    auto      pending = m_pending.find( key );
+    if ( pending != m_pending.end() )
+    {
+        pending->second = now;
+    }
+    else if ( m_pending.size() < m_maxOutstanding )
+    {
+        m_pending.emplace( key, now );
+        // The last files requested are the ones currently showed
+        m_jobs.submit(
+            static_cast< dev_t >( key.device ),
+            [this, key, path] ( std::stop_token stopToken ) {
+                this->compute( key, path, stopToken );
+            },
+            now.time_since_epoch().count() );
+    }
+    return std::nullopt;
+}
+
+template< typename Result >
+void BackgroundFileCache< Result >::debug_gui() const
+{
+    std::size_t nbResults = 0;
+    std::size_t nbPending = 0;
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        nbResults = m_results.size();
+        nbPending = m_pending.size();
+    }
+
+    ImGui::Text( "Computed: %lu (%lu cached)", m_nbComputed.load(),
+                 nbResults );
+    ImGui::Text( "Pending: %lu / %lu", nbPending, m_maxOutstanding );
+    ImGui::Text( "Cancelled: %lu", m_nbCancelled.load() );
+}
+
+template< typename Result >
+void BackgroundFileCache< Result >::compute(
+    ds::FileKey key, fs::path const & path, std::stop_token const & stopToken )
+{
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        auto pending = m_pending.find( key );
+        if ( pending == m_pending.end() )
+        {
+            return;
+        }
+        // The row has been scrolled away, or the user left the directory. It
+        // is requested again if it's still showed.
+        if ( stopToken.stop_requested()
+             || std::chrono::steady_clock::now() - pending->second
+                    > background_file_cache::REQUEST_TIMEOUT )
+        {
+            m_pending.erase( pending );
+            ++m_nbCancelled;
+            return;
+        }
+    }
+
+    std::optional< Result > result {};
+    try
+    {
+        result = m_compute( path );
+    }
+    catch ( std::exception const & exception )
+    {
+        // Cached as missing, so the file isn't computed again
+        Trace::Error( "Can't compute the information of {}: {}",
+                      path.c_str(), exception.what() );
+    }
+    ++m_nbComputed;
+
+    std::lock_guard< std::mutex > lock { m_mutex };
+    if ( m_results.size() >= m_maxResults )
+    {
+        m_results.clear();
+    }
+    m_results[key] = std::move( result );
+    m_pending.erase( key );
+}
@@ -0,0 +1,77 @@
+#include "content_sniffer.hpp"
+
+#include <array>        // for array
+#include <string_view>  // for string_view
+
+#include <fcntl.h>     // for open, posix_fadvise
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for pread, close
+
+#include <imgui/imgui.h>  // for ImGui::Text
+
+namespace
+{
+    // Enough for every signature, and the interpreter of a shebang
+    constexpr std::size_t HEADER_SIZE { 512 };
+    // Files queued or being read at the same time
+    constexpr std::size_t MAX_OUTSTANDING_READS { 32 };
+    constexpr std::size_t MAX_RESULTS { 100'000 };
+
+    // Return the number of bytes read, 0 if the file can't be read
+    std::size_t read_header ( fs::path const & path, char * buffer,
+                              bool & isExecutable )
+    {
+        // O_NOATIME is only allowed for the owner of the file
+        int file = open( path.c_str(), O_RDONLY | O_CLOEXEC | O_NOATIME );
+        if ( file < 0 )
+        {
+            file = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+        }
+        if ( file < 0 )
+        {
+            return 0;
+        }
+
+        struct stat status {};
+        fstat( file, &status );
+        isExecutable = status.st_mode & ( S_IXUSR | S_IXGRP | S_IXOTH );
+
+        // No read ahead, only the first bytes are needed
+        posix_fadvise( file, 0, 0, POSIX_FADV_RANDOM );
+        ssize_t size = pread( file, buffer, HEADER_SIZE, 0 );
+        // The header shouldn't stay in the page cache because of us
+        posix_fadvise( file, 0, HEADER_SIZE, POSIX_FADV_DONTNEED );
+        close( file );
+
+        return size > 0 ? static_cast< std::size_t >( size ) : 0;
+    }
+
+    std::optional< ds::FileTypeInfo > sniff ( fs::path const & path )
+    {
+        std::array< char, HEADER_SIZE > header {};
+        bool                            isExecutable = false;
+        std::size_t size = read_header( path, header.data(), isExecutable );
+        return ds::get_content_type( std::string_view { header.data(), size },
+                                     isExecutable );
+    }
+}  // namespace
+
+ContentSniffer::ContentSniffer()
+  : m_cache { sniff, MAX_OUTSTANDING_READS, MAX_RESULTS }
+{}
+
+ds::FileTypeInfo ContentSniffer::get_type( ds::Entry const & entry )
+{
+    ds::FileTypeInfo typeInfo { entry.type, entry.icon };
+    if ( entry.isDirectory )
+    {
+        return typeInfo;
+    }
+    return ds::resolve_type( typeInfo, m_cache.get( entry.key, entry.path ) );
+}
+
+void ContentSniffer::debug_gui()
+{
+    ImGui::Text( "Content sniffing" );
+    m_cache.debug_gui();
+}
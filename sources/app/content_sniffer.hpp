@@ -0,0 +1,25 @@
+#pragma once
+
+#include "app/background_file_cache.hpp"  // for BackgroundFileCache
+#include "app/filesystem.hpp"             // for ds::Entry
+#include "tools/singleton.hpp"
+
+// Read the first bytes of the showed files in background to find their type
+// from their content, for the files without extension or with a wrong one
+class ContentSniffer : public Singleton< ContentSniffer >
+{
+    ENABLE_SINGLETON( ContentSniffer );
+
+    BackgroundFileCache< ds::FileTypeInfo > m_cache;
+
+    ContentSniffer();
+    virtual ~ContentSniffer() = default;
+
+  public:
+    // Type found from the content if the extension is unknown or wrong, from
+    // the extension otherwise. Queue the file to be read if it's not already
+    // done.
+    ds::FileTypeInfo get_type ( ds::Entry const & entry );
+
+    void debug_gui ();
+};
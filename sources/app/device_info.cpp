@@ -0,0 +1,346 @@
+#include "device_info.hpp"
+
+#include <algorithm>     // for clamp, find
+#include <array>         // for array
+#include <cstdio>        // for sscanf
+#include <fstream>       // for ifstream
+#include <sstream>       // for istringstream
+#include <string_view>   // for string_view
+#include <system_error>  // for error_code
+
+#include <sys/stat.h>       // for stat
+#include <sys/sysmacros.h>  // for major, minor, makedev
+
+#include <fmt/format.h>   // for format
+#include <imgui/imgui.h>  // for ImGui::BeginTable
+
+#include "app/explorer_settings.hpp"  // for ExplorerSettings
+
+namespace
+{
+    // Loop devices and device mapper targets followed to find the disk
+    constexpr unsigned int MAX_DEPTH { 4 };
+
+    constexpr std::array< std::string_view, 12 > NETWORK_TYPES {
+        "nfs",  "nfs4",        "cifs",           "smb3",
+        "9p",   "afs",         "ceph",           "fuse.sshfs",
+        "ncpfs", "fuse.rclone", "fuse.glusterfs", "davfs" };
+    constexpr std::array< std::string_view, 8 > MEMORY_TYPES {
+        "tmpfs", "ramfs", "devtmpfs", "proc",
+        "sysfs", "cgroup2", "devpts", "debugfs" };
+
+    constexpr char const * KIND_NAMES[] { "SSD",    "HDD",    "Removable",
+                                          "Network", "Memory", "Unknown" };
+
+    // Spaces, tabs and backslashes are written as octal escapes
+    std::string decode_field ( std::string const & field )
+    {
+        std::string decoded {};
+        for ( std::size_t idx = 0; idx < field.size(); ++idx )
+        {
+            if ( field[idx] == '\\' && idx + 3 < field.size() )
+            {
+                decoded += static_cast< char >(
+                    std::stoi( field.substr( idx + 1, 3 ), nullptr, 8 ) );
+                idx += 3;
+            }
+            else
+            {
+                decoded += field[idx];
+            }
+        }
+        return decoded;
+    }
+
+    std::string read_first_line ( fs::path const & path )
+    {
+        std::ifstream file { path };
+        std::string   line {};
+        std::getline( file, line );
+        return line;
+    }
+
+    template< std::size_t Size >
+    bool contains ( std::array< std::string_view, Size > const & types,
+                    std::string const &                          type )
+    {
+        return std::find( types.begin(), types.end(), type ) != types.end();
+    }
+
+    // The kind allowing the least concurrency
+    DeviceInfo::Kind get_slowest ( DeviceInfo::Kind lhs, DeviceInfo::Kind rhs )
+    {
+        return DeviceInfo::get_default_concurrency( rhs )
+                       < DeviceInfo::get_default_concurrency( lhs )
+                   ? rhs
+                   : lhs;
+    }
+
+    DeviceInfo::Kind describe_mount ( ds::Mount const &                mount,
+                                      std::vector< ds::Mount > const & mounts,
+                                      unsigned int                     depth );
+
+    // Deepest mount point holding the path, found without accessing the
+    // path itself, as its filesystem may not be responding
+    ds::Mount const * find_mount_of ( std::string const &              path,
+                                      std::vector< ds::Mount > const & mounts )
+    {
+        ds::Mount const * deepest { nullptr };
+        std::size_t       deepestSize { 0 };
+        for ( ds::Mount const & mount : mounts )
+        {
+            std::string const & mountPoint { mount.mountPoint.native() };
+            bool isInside = mountPoint == "/"
+                                ? path.starts_with( '/' )
+                                : path.starts_with( mountPoint )
+                                      && ( path.size() == mountPoint.size()
+                                           || path[mountPoint.size()] == '/' );
+            // The last mount on a mount point hides the ones before it
+            if ( isInside
+                 && ( deepest == nullptr || mountPoint.size() >= deepestSize ) )
+            {
+                deepest     = &mount;
+                deepestSize = mountPoint.size();
+            }
+        }
+        return deepest;
+    }
+
+    // Kind of a block device from its directory in /sys/block
+    DeviceInfo::Kind describe_disk ( fs::path const &                 disk,
+                                     std::vector< ds::Mount > const & mounts,
+                                     unsigned int                     depth )
+    {
+        // Partitions are in the directory of their disk
+        fs::path        directory { disk };
+        std::error_code error {};
+        if ( fs::exists( directory / "partition", error ) )
+        {
+            directory = directory.parent_path();
+        }
+
+        // Depends on the disk holding the backing file
+        std::string backingFile =
+            read_first_line( directory / "loop" / "backing_file" );
+        if ( ! backingFile.empty() && depth < MAX_DEPTH )
+        {
+            ds::Mount const * mount = find_mount_of( backingFile, mounts );
+            if ( mount != nullptr )
+            {
+                return describe_mount( *mount, mounts, depth + 1 );
+            }
+        }
+
+        DeviceInfo::Kind kind { DeviceInfo::Kind::SolidState };
+        if ( directory.string().find( "/usb" ) != std::string::npos
+             || read_first_line( directory / "removable" ) == "1" )
+        {
+            kind = DeviceInfo::Kind::Removable;
+        }
+        else if ( read_first_line( directory / "queue" / "rotational" ) == "1" )
+        {
+            kind = DeviceInfo::Kind::Rotational;
+        }
+
+        // Device mapper and raid devices are as slow as their slowest disk
+        if ( depth < MAX_DEPTH )
+        {
+            for ( fs::directory_entry const & slave :
+                  fs::directory_iterator { directory / "slaves", error } )
+            {
+                fs::path slaveDisk = fs::canonical( slave.path(), error );
+                if ( ! error )
+                {
+                    kind = get_slowest(
+                        kind, describe_disk( slaveDisk, mounts, depth + 1 ) );
+                }
+            }
+        }
+        return kind;
+    }
+
+    fs::path get_disk_directory ( dev_t device )
+    {
+        std::error_code error {};
+        fs::path        disk = fs::canonical(
+            fmt::format( "/sys/dev/block/{}:{}", major( device ),
+                         minor( device ) ),
+            error );
+        return error ? fs::path {} : disk;
+    }
+
+    // Block device holding a mounted filesystem, 0 if there is none
+    dev_t get_block_device ( ds::Mount const & mount )
+    {
+        // Btrfs and the other filesystems with several devices give an
+        // anonymous device to stat, the source is the real one
+        struct stat status {};
+        if ( mount.source.starts_with( "/dev/" )
+             && stat( mount.source.c_str(), &status ) == 0
+             && S_ISBLK( status.st_mode ) )
+        {
+            return status.st_rdev;
+        }
+        return major( mount.device ) == 0 ? 0 : mount.device;
+    }
+
+    DeviceInfo::Kind describe_mount ( ds::Mount const &                mount,
+                                      std::vector< ds::Mount > const & mounts,
+                                      unsigned int                     depth )
+    {
+        if ( contains( NETWORK_TYPES, mount.type ) )
+        {
+            return DeviceInfo::Kind::Network;
+        }
+        if ( contains( MEMORY_TYPES, mount.type ) )
+        {
+            return DeviceInfo::Kind::Memory;
+        }
+        fs::path disk = get_disk_directory( get_block_device( mount ) );
+        if ( disk.empty() )
+        {
+            return DeviceInfo::Kind::Unknown;
+        }
+        return describe_disk( disk, mounts, depth );
+    }
+}  // namespace
+
+namespace ds
+{
+    std::vector< Mount > read_mounts ()
+    {
+        std::vector< Mount > mounts {};
+        std::ifstream        mountInfo { "/proc/self/mountinfo" };
+        std::string          line {};
+        while ( std::getline( mountInfo, line ) )
+        {
+            // "id parent major:minor root mountpoint options [optional...] -
+            // type source superoptions"
+            std::istringstream stream { line };
+            std::string        id {}, parent {}, device {}, root {},
+                mountPoint {}, field {};
+            stream >> id >> parent >> device >> root >> mountPoint;
+            while ( stream >> field && field != "-" )
+            {}
+
+            Mount mount {};
+            stream >> mount.type >> mount.source;
+            unsigned int majorNumber { 0 };
+            unsigned int minorNumber { 0 };
+            if ( std::sscanf( device.c_str(), "%u:%u", &majorNumber,
+                              &minorNumber )
+                 != 2 )
+            {
+                continue;
+            }
+            mount.device     = makedev( majorNumber, minorNumber );
+            mount.mountPoint = decode_field( mountPoint );
+            mount.source     = decode_field( mount.source );
+            mounts.push_back( std::move( mount ) );
+        }
+        return mounts;
+    }
+}  // namespace ds
+
+DeviceInfo::DeviceInfo() : m_mutex {}, m_devices {}
+{
+    // Constructed before so it's destroyed after
+    Settings::get_instance();
+}
+
+DeviceInfo::Device DeviceInfo::get_device( dev_t device )
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    if ( ! m_devices.contains( device ) )
+    {
+        this->refresh();
+    }
+    // Not mounted, it's not looked for again
+    auto [iterator, isInserted] =
+        m_devices.try_emplace( device, Device { Kind::Unknown, {}, {} } );
+    return iterator->second;
+}
+
+unsigned int DeviceInfo::get_concurrency( dev_t device )
+{
+    auto kind = static_cast< std::size_t >( this->get_device( device ).kind );
+    return std::clamp( Settings::get_instance().deviceConcurrency[kind], 1u,
+                       MAX_CONCURRENCY );
+}
+
+void DeviceInfo::debug_gui() const
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+
+    ImGui::Text( "Devices" );
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders
+                            | ImGuiTableFlags_SizingFixedFit;
+    if ( ! ImGui::BeginTable( "Devices", 4, flags ) )
+    {
+        return;
+    }
+    for ( char const * header :
+          { "Device", "Mount Point", "Block Device", "Kind" } )
+    {
+        ImGui::TableSetupColumn( header );
+    }
+    ImGui::TableHeadersRow();
+    for ( auto const & [device, info] : m_devices )
+    {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text( "%u:%u", major( device ), minor( device ) );
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted( info.mountPoint.string().c_str() );
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted( info.blockDevice.c_str() );
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted( get_kind_name( info.kind ) );
+    }
+    ImGui::EndTable();
+}
+
+char const * DeviceInfo::get_kind_name( Kind kind )
+{
+    return KIND_NAMES[static_cast< std::size_t >( kind )];
+}
+
+unsigned int DeviceInfo::get_default_concurrency( Kind kind )
+{
+    switch ( kind )
+    {
+    case Kind::SolidState :
+    case Kind::Memory :
+        return 16;
+    case Kind::Rotational :
+        return 2;
+    case Kind::Removable :
+        return 1;
+    case Kind::Network :
+    case Kind::Unknown :
+    case Kind::Count :
+        break;
+    }
+    return 4;
+}
+
+void DeviceInfo::refresh()
+{
+    std::vector< ds::Mount > mounts = ds::read_mounts();
+    for ( ds::Mount const & mount : mounts )
+    {
+        // Bind mounts share the device of the first mount
+        if ( m_devices.contains( mount.device ) )
+        {
+            continue;
+        }
+        Device device { describe_mount( mount, mounts, 0 ), mount.mountPoint,
+                        {} };
+        fs::path disk = get_disk_directory( get_block_device( mount ) );
+        if ( ! disk.empty() )
+        {
+            device.blockDevice = disk.filename().string();
+        }
+        m_devices.emplace( mount.device, std::move( device ) );
+    }
+}
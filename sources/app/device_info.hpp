@@ -0,0 +1,81 @@
+#pragma once
+
+#include <mutex>          // for mutex
+#include <string>         // for string
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+#include <sys/types.h>  // for dev_t
+
+#include "app/filesystem.hpp"  // for fs::path
+#include "tools/singleton.hpp"
+
+namespace ds
+{
+    // Line of /proc/self/mountinfo
+    struct Mount
+    {
+        // Device of the files, the one given by stat
+        dev_t       device;
+        fs::path    mountPoint;
+        std::string type;
+        // Block device or remote location mounted, "none" if there is none
+        std::string source;
+    };
+
+    std::vector< Mount > read_mounts ();
+}  // namespace ds
+
+// Storage behind each device, to know how many files can be read from it at
+// the same time. Parallel reads help a lot on SSDs, but random seeks make
+// them slower than a single reader on spinning disks and USB sticks.
+class DeviceInfo : public Singleton< DeviceInfo >
+{
+    ENABLE_SINGLETON( DeviceInfo );
+
+  public:
+    enum class Kind
+    {
+        SolidState = 0,
+        Rotational,
+        // USB sticks, SD cards and disks behind USB
+        Removable,
+        Network,
+        // tmpfs and the other filesystems without a disk
+        Memory,
+        Unknown,
+        Count
+    };
+
+    // Limit of the settings
+    static constexpr unsigned int MAX_CONCURRENCY { 16 };
+
+    struct Device
+    {
+        Kind        kind;
+        fs::path    mountPoint;
+        // Name of the block device in /sys/block, empty if there is none
+        std::string blockDevice;
+    };
+
+  private:
+    mutable std::mutex                  m_mutex;
+    std::unordered_map< dev_t, Device > m_devices;
+
+    DeviceInfo();
+    virtual ~DeviceInfo() = default;
+
+  public:
+    // Mounts are read again when the device isn't known yet
+    Device get_device ( dev_t device );
+    // Files of the device read or written at the same time
+    unsigned int get_concurrency ( dev_t device );
+
+    void debug_gui () const;
+
+    static char const * get_kind_name ( Kind kind );
+    static unsigned int get_default_concurrency ( Kind kind );
+
+  private:
+    void refresh ();
+};
@@ -0,0 +1,75 @@
+#include "entry_completion.hpp"
+
+#include "app/mount_guard.hpp"  // for MountGuard
+#include "tools/string.hpp"     // for string::to_lowercase
+
+EntryCompletion::EntryCompletion()
+  : m_directory {},
+    m_showHidden { false },
+    m_request {},
+    m_filter {},
+    m_isFiltered { false },
+    m_matches {}
+{}
+
+std::vector< fs::path > const & EntryCompletion::get_matches(
+    fs::path const & directory, std::string const & filter, bool showHidden )
+{
+    if ( ! m_request || directory != m_directory
+         || showHidden != m_showHidden )
+    {
+        m_directory  = directory;
+        m_showHidden = showHidden;
+        m_request    = std::make_shared< Request >();
+        m_isFiltered = false;
+        m_matches.clear();
+
+        MountGuard::get_instance().post(
+            directory,
+            [directory, showHidden, request = m_request] () {
+                std::vector< fs::path > entries =
+                    ds::filter_entries( directory, "", showHidden );
+                std::vector< std::string > lowercaseNames {};
+                lowercaseNames.reserve( entries.size() );
+                for ( fs::path const & entry : entries )
+                {
+                    lowercaseNames.push_back(
+                        string::to_lowercase( entry.filename().string() ) );
+                }
+
+                std::lock_guard< std::mutex > lock { request->mutex };
+                request->entries        = std::move( entries );
+                request->lowercaseNames = std::move( lowercaseNames );
+                request->isDone         = true;
+            },
+            MountGuard::Lane::Scan );
+    }
+
+    if ( m_isFiltered && filter == m_filter )
+    {
+        return m_matches;
+    }
+    std::lock_guard< std::mutex > lock { m_request->mutex };
+    if ( ! m_request->isDone )
+    {
+        return m_matches;
+    }
+    m_filter     = filter;
+    m_isFiltered = true;
+    m_matches.clear();
+    std::string lowercaseFilter { string::to_lowercase( filter ) };
+    for ( std::size_t idx = 0; idx < m_request->entries.size(); ++idx )
+    {
+        if ( m_request->lowercaseNames[idx].find( lowercaseFilter )
+             != std::string::npos )
+        {
+            m_matches.push_back( m_request->entries[idx] );
+        }
+    }
+    return m_matches;
+}
+
+void EntryCompletion::clear()
+{
+    m_request.reset();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>  // for shared_ptr
+#include <mutex>   // for mutex
+#include <string>  // for string
+#include <vector>  // for vector
+
+#include "app/filesystem.hpp"  // for fs::path
+
+// Entries proposed while typing a path. The directory is read once by the
+// scan worker of its mount, and only the names read are filtered as the
+// user types, so a frame never waits for the directory, and a long listing
+// doesn't make the mount look hung.
+class EntryCompletion
+{
+    // Shared with the worker, which may finish after a new directory is
+    // requested
+    struct Request
+    {
+        std::mutex                 mutex;
+        bool                       isDone;
+        std::vector< fs::path >    entries;
+        std::vector< std::string > lowercaseNames;
+    };
+
+    fs::path                   m_directory;
+    bool                       m_showHidden;
+    std::shared_ptr< Request > m_request;
+
+    // Matches of the last filter, filtered again when it changes
+    std::string                m_filter;
+    bool                       m_isFiltered;
+    std::vector< fs::path >    m_matches;
+
+  public:
+    EntryCompletion();
+    virtual ~EntryCompletion() = default;
+
+    // Entries of the directory containing the filter, nothing until the
+    // directory has been read
+    std::vector< fs::path > const & get_matches ( fs::path const &    directory,
+                                                  std::string const & filter,
+                                                  bool showHidden );
+    // Read the directory again the next time
+    void                            clear ();
+};
@@ -7,9 +7,21 @@
 #include <fmt/core.h>
 #include <imgui/imgui_stdlib.h>  // for ImGui::InputText
 
+#include "app/content_sniffer.hpp"
+#include "app/device_info.hpp"
 #include "app/display.hpp"
-#include "tools/string.hpp"
+#include "app/file_operations.hpp"
+#include "app/image_metadata.hpp"
+#include "app/job_scheduler.hpp"
+#include "app/listing_cache.hpp"
+#include "app/mount_guard.hpp"
+#include "app/perf_counters.hpp"
+#include "app/performance_overlay.hpp"
+#include "app/texture_atlas.hpp"
+#include "app/thumbnails.hpp"
+#include "app/vfs.hpp"
 #include "tools/traces.hpp"
+#include "tools/tracing.hpp"
 
 namespace
 {
@@ -32,6 +44,12 @@ namespace
         ImGui::Separator();
 
         ImGui::Text( "FPS: %.1f", io.Framerate );
+        PerformanceOverlay & overlay = PerformanceOverlay::get_instance();
+        bool                 isOverlayShown { overlay.is_shown() };
+        if ( ImGui::Checkbox( "Show Performance Overlay", &isOverlayShown ) )
+        {
+            overlay.set_shown( isOverlayShown );
+        }
 
         ImGui::Separator();
 
@@ -62,33 +80,29 @@ namespace
         }
     }
 
-    std::vector< fs::path > filter_entry ( fs::path const &    directory,
-                                           std::string const & entryFilter,
-                                           bool                showHidden )
+    void tracing ( std::string & traceFile )
     {
-        std::vector< fs::path > entries {};
-
-        // Check if the directory exists
-        if ( ! fs::exists( directory ) && ! fs::is_directory( directory ) )
+#ifdef NDEBUG
+        static_cast< void >( traceFile );
+        ImGui::Text( "The spans are removed from the release builds" );
+#else
+        Tracing::Statistics statistics =
+            Tracing::get_instance().get_statistics();
+        ImGui::Text( "Threads: %lu", statistics.nbThreads );
+        ImGui::Text( "Spans: %lu", statistics.nbSpans );
+        ImGui::Text( "Replaced by newer spans: %lu", statistics.nbLost );
+
+        ImGui::InputText( "File##TraceFile", &traceFile );
+        if ( ImGui::Button( "Export Chrome Trace" ) )
         {
-            return entries;
+            Tracing::get_instance().export_chrome_trace( traceFile );
         }
-        for ( auto const & entry : fs::directory_iterator( directory ) )
+        ImGui::SameLine();
+        if ( ImGui::Button( "Clear Spans" ) )
         {
-            if ( ! showHidden && ds::is_hidden( entry ) )
-            {
-                continue;
-            }
-
-            if ( string::to_lowercase( entry.path().filename().string() )
-                     .find( string::to_lowercase( entryFilter ) )
-                 != std::string::npos )
-            {
-                entries.push_back( entry.path() );
-            }
+            Tracing::get_instance().clear();
         }
-
-        return entries;
+#endif
     }
 }  // namespace
 
@@ -117,13 +131,17 @@ void TabNavigator::update_gui()
             }
             bool        isOpen = true;
             std::string label  = fmt::format(
-                "{}##{}", m_tabs[idx].get_directory().filename().string(),
+                "{}{}##{}", m_tabs[idx].get_directory().filename().string(),
+                MountGuard::get_instance().is_responding(
+                    m_tabs[idx].get_directory() )
+                    ? ""
+                    : " (not responding)",
                 idx );
             if ( ImGui::BeginTabItem( label.c_str(), &isOpen, tabItemFlags ) )
             {
                 if ( m_idxTab.value() != idx )
                 {
-                    Trace::Debug( "Change tab :" + idx );
+                    Trace::Debug( "Change tab: {}", idx );
                     this->set_current( idx );
                 }
                 m_tabs[idx].update_gui();
@@ -195,7 +213,7 @@ void TabNavigator::remove( unsigned int idx )
         m_idxTab = m_idxTab.value() - 1;
     }
 
-    Trace::Debug( fmt::format( "idx after rm: {}", m_idxTab.value() ) );
+    Trace::Debug( "idx after rm: {}", m_idxTab.value() );
 }
 
 void TabNavigator::set_current( unsigned int idx )
@@ -212,14 +230,19 @@ void TabNavigator::set_current( unsigned int idx )
 Explorer::Explorer( Window & window )
   : m_window { window },
     m_tabNavigator {},
+    m_trashWindow {},
+    m_entryCompletion {},
     m_showSettings { false },
-    m_showDemoWindow { false }
+    m_showDemoWindow { false },
+    m_isDeleteRequested { false },
+    m_traceFile { "explorer_trace.json" }
 {
     m_tabNavigator.add( ds::get_home_directory(), true );
 }
 
 void Explorer::update()
 {
+    TRACE_SPAN( "Explorer::update" );
     ImGuiWindowFlags fullScreenflags = ImGuiWindowFlags_NoDecoration
                                        | ImGuiWindowFlags_NoMove
                                        | ImGuiWindowFlags_NoBringToFrontOnFocus;
@@ -243,12 +266,64 @@ void Explorer::update()
     ImGui::End();
     ImGui::PopStyleColor();
 
+    FileOperations::get_instance().update_gui();
+    PerformanceOverlay::get_instance().update_gui();
+    m_trashWindow.update_gui();
+    this->update_shortcuts();
+
     if ( m_showDemoWindow )
     {
         ImGui::ShowDemoWindow( &m_showDemoWindow );
     }
 }
 
+TabNavigator & Explorer::get_tab_navigator()
+{
+    return m_tabNavigator;
+}
+
+void Explorer::update_shortcuts()
+{
+    ImGuiIO const & io = ImGui::GetIO();
+    if ( io.WantTextInput )
+    {
+        return;
+    }
+
+    FolderNavigator & navigator = m_tabNavigator.get_current();
+    if ( ImGui::IsKeyPressed( ImGuiKey_Delete, false )
+         && ! navigator.get_selection().empty() )
+    {
+        if ( io.KeyShift )
+        {
+            m_isDeleteRequested = true;
+        }
+        else
+        {
+            FileOperations::get_instance().trash(
+                { navigator.get_selection() } );
+        }
+    }
+    if ( ! io.KeyCtrl )
+    {
+        return;
+    }
+    if ( ImGui::IsKeyPressed( ImGuiKey_C, false )
+         && ! navigator.get_selection().empty() )
+    {
+        FileOperations::get_instance().copy( { navigator.get_selection() } );
+    }
+    if ( ImGui::IsKeyPressed( ImGuiKey_X, false )
+         && ! navigator.get_selection().empty() )
+    {
+        FileOperations::get_instance().cut( { navigator.get_selection() } );
+    }
+    if ( ImGui::IsKeyPressed( ImGuiKey_V, false ) )
+    {
+        FileOperations::get_instance().paste( navigator.get_directory() );
+    }
+}
+
 void Explorer::update_header_bar()
 {
     if ( ImGui::Button( "Previous" ) )
@@ -284,9 +359,89 @@ void Explorer::update_header_bar()
     {
         m_tabNavigator.get_current().refresh();
     }
+    ImGui::SameLine();
+    bool isGridView { m_tabNavigator.get_current().get_view_mode()
+                      == FolderNavigator::ViewMode::Grid };
+    if ( ImGui::Button( isGridView ? "List##ViewModeButton"
+                                   : "Grid##ViewModeButton" ) )
+    {
+        m_tabNavigator.get_current().set_view_mode(
+            isGridView ? FolderNavigator::ViewMode::List
+                       : FolderNavigator::ViewMode::Grid );
+    }
+    ImGui::SameLine();
+    this->update_clipboard_buttons();
     this->update_settings();
 }
 
+void Explorer::update_clipboard_buttons()
+{
+    FolderNavigator & navigator = m_tabNavigator.get_current();
+    bool              hasSelection { ! navigator.get_selection().empty() };
+
+    ImGui::BeginDisabled( ! hasSelection );
+    if ( ImGui::Button( "Copy##CopyButton" ) )
+    {
+        FileOperations::get_instance().copy( { navigator.get_selection() } );
+    }
+    ImGui::SameLine();
+    if ( ImGui::Button( "Cut##CutButton" ) )
+    {
+        FileOperations::get_instance().cut( { navigator.get_selection() } );
+    }
+    ImGui::SameLine();
+    if ( ImGui::Button( "Trash##TrashButton" ) )
+    {
+        FileOperations::get_instance().trash( { navigator.get_selection() } );
+    }
+    ImGui::SameLine();
+    if ( ImGui::Button( "Delete##DeleteButton" ) )
+    {
+        m_isDeleteRequested = true;
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::BeginDisabled( ! FileOperations::get_instance().has_clipboard() );
+    if ( ImGui::Button( "Paste##PasteButton" ) )
+    {
+        FileOperations::get_instance().paste( navigator.get_directory() );
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    if ( ImGui::Button( "Show Trash##ShowTrashButton" ) )
+    {
+        m_trashWindow.open();
+    }
+
+    if ( m_isDeleteRequested )
+    {
+        ImGui::OpenPopup( "Delete Permanently?" );
+        m_isDeleteRequested = false;
+    }
+    if ( ImGui::BeginPopupModal( "Delete Permanently?", nullptr,
+                                 ImGuiWindowFlags_AlwaysAutoResize ) )
+    {
+        ImGui::Text( "%s will be deleted, it can't be undone.",
+                     navigator.get_selection().filename().string().c_str() );
+        if ( ImGui::Button( "Delete##ConfirmDelete" ) )
+        {
+            if ( ! navigator.get_selection().empty() )
+            {
+                FileOperations::get_instance().remove(
+                    { navigator.get_selection() } );
+            }
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::SameLine();
+        if ( ImGui::Button( "Cancel##CancelDelete" )
+             || ImGui::IsKeyPressed( ImGuiKey_Escape, false ) )
+        {
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::EndPopup();
+    }
+}
+
 void Explorer::update_search_box()
 {
     std::string searchBoxStr {
@@ -301,6 +456,8 @@ void Explorer::update_search_box()
 
     if ( ImGui::IsItemActivated() )
     {
+        // The directory may have changed since the last completion
+        m_entryCompletion.clear();
         ImGui::OpenPopup( "Entry Autocompletion",
                           ImGuiPopupFlags_NoOpenOverExistingPopup );
     }
@@ -312,12 +469,9 @@ void Explorer::update_search_box()
              ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoMove
                  | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_ChildWindow ) )
     {
-        for ( auto const & entry : filter_entry(
-                  m_tabNavigator.get_current().get_search_box().parent_path(),
-                  m_tabNavigator.get_current()
-                      .get_search_box()
-                      .filename()
-                      .string(),
+        fs::path searchBox { m_tabNavigator.get_current().get_search_box() };
+        for ( fs::path const & entry : m_entryCompletion.get_matches(
+                  searchBox.parent_path(), searchBox.filename().string(),
                   Settings::get_instance().showHidden ) )
         {
             if ( ImGui::Selectable( entry.string().c_str() ) )
@@ -335,10 +489,18 @@ void Explorer::update_search_box()
     }
     if ( isInputTextPressed )
     {
-        if ( fs::exists( m_tabNavigator.get_current().get_search_box() ) )
+        fs::path searchBox { m_tabNavigator.get_current().get_search_box() };
+        if ( MountGuard::get_instance()
+                 .call< bool >( searchBox,
+                                [searchBox] () {
+                                    std::error_code error {};
+                                    vfs::get_file_system().status( searchBox,
+                                                                   error );
+                                    return ! error;
+                                } )
+                 .value_or( false ) )
         {
-            m_tabNavigator.get_current().open_entry(
-                m_tabNavigator.get_current().get_search_box() );
+            m_tabNavigator.get_current().open_entry( searchBox );
         }
     }
 }
@@ -372,7 +534,40 @@ void Explorer::update_settings()
         {
             ImGui::Checkbox( "Show Hidden Files/Folder",
                              &Settings::get_instance().showHidden );
+            ImGui::Checkbox( "Show Text Preview",
+                             &Settings::get_instance().showPreview );
+            ImGui::Checkbox( "Open Binary Files in Hex Viewer",
+                             &Settings::get_instance().useHexViewer );
             ImGui::Checkbox( "Show Demo Window", &m_showDemoWindow );
+            int fileOperationThreads = static_cast< int >(
+                Settings::get_instance().fileOperationThreads );
+            if ( ImGui::SliderInt( "File Operation Threads",
+                                   &fileOperationThreads, 1, 16 ) )
+            {
+                Settings::get_instance().fileOperationThreads =
+                    static_cast< unsigned int >( fileOperationThreads );
+            }
+            if ( ImGui::TreeNode( "Parallel Accesses by Device" ) )
+            {
+                for ( std::size_t idx = 0;
+                      idx < Settings::get_instance().deviceConcurrency.size();
+                      ++idx )
+                {
+                    unsigned int & concurrency =
+                        Settings::get_instance().deviceConcurrency[idx];
+                    int value = static_cast< int >( concurrency );
+                    if ( ImGui::SliderInt(
+                             DeviceInfo::get_kind_name(
+                                 static_cast< DeviceInfo::Kind >( idx ) ),
+                             &value, 1,
+                             static_cast< int >(
+                                 DeviceInfo::MAX_CONCURRENCY ) ) )
+                    {
+                        concurrency = static_cast< unsigned int >( value );
+                    }
+                }
+                ImGui::TreePop();
+            }
             if ( ImGui::Button( "Reset Preferences" ) )
             {
                 Settings::get_instance().reset();
@@ -400,6 +595,37 @@ void Explorer::update_settings()
             m_tabNavigator.get_current().gui_info();
             ImGui::EndTabItem();
         }
+        if ( ImGui::BeginTabItem( "Jobs Informations" ) )
+        {
+            JobScheduler::get_instance().debug_gui();
+            ImGui::Separator();
+            DeviceInfo::get_instance().debug_gui();
+            ImGui::Separator();
+            MountGuard::get_instance().debug_gui();
+            ImGui::Separator();
+            vfs::get_file_system().debug_gui();
+            ImGui::EndTabItem();
+        }
+        if ( ImGui::BeginTabItem( "Cache Informations" ) )
+        {
+            ListingCache::get_instance().debug_gui();
+            ImGui::Separator();
+            ContentSniffer::get_instance().debug_gui();
+            ImGui::Separator();
+            ImageMetadata::get_instance().debug_gui();
+            ImGui::Separator();
+            Thumbnails::get_instance().debug_gui();
+            ImGui::Separator();
+            TextureAtlas::get_instance().debug_gui();
+            ImGui::EndTabItem();
+        }
+        if ( ImGui::BeginTabItem( "Tracing" ) )
+        {
+            tracing( m_traceFile );
+            ImGui::Separator();
+            PerfCounters::get_instance().debug_gui();
+            ImGui::EndTabItem();
+        }
         ImGui::EndTabBar();
     }
 
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <optional>
+#include <string>
 
+#include "app/entry_completion.hpp"   // for EntryCompletion
 #include "app/explorer_settings.hpp"  // for ExplorerSettings
 #include "app/folder_navigator.hpp"   // for FolderNavigator
+#include "app/trash_window.hpp"       // for TrashWindow
 #include "app/window.hpp"             // for Window
 
 class TabNavigator
@@ -26,11 +29,18 @@ class TabNavigator
 
 class Explorer
 {
-    Window &     m_window;
-    TabNavigator m_tabNavigator;
+    Window &        m_window;
+    TabNavigator    m_tabNavigator;
+    TrashWindow     m_trashWindow;
+    // Proposed under the search box
+    EntryCompletion m_entryCompletion;
 
     bool m_showSettings;
     bool m_showDemoWindow;
+    // Shift+Delete has been pressed, the confirmation must be opened
+    bool m_isDeleteRequested;
+    // Where the spans are exported from the settings
+    std::string m_traceFile;
 
   public:
     Explorer( Window & window );
@@ -38,8 +48,14 @@ class Explorer
 
     void update ();
 
+    // For the benchmarks, which drive the tabs without input
+    TabNavigator & get_tab_navigator ();
+
   private:
     void update_header_bar ();
+    void update_clipboard_buttons ();
     void update_search_box ();
     void update_settings ();
+    // Copy, cut, paste, trash and delete of the selected entry
+    void update_shortcuts ();
 };
@@ -8,6 +8,14 @@ ExplorerSettings::ExplorerSettings()
 void ExplorerSettings::reset()
 {
     showHidden      = false;
+    showPreview     = true;
+    useHexViewer    = true;
     backgroundColor = ImVec4( 0.2f, 0.2f, 0.2f, 1.f );
     maxHistorySize  = 15u;
+    fileOperationThreads = 4u;
+    for ( std::size_t idx = 0; idx < deviceConcurrency.size(); ++idx )
+    {
+        deviceConcurrency[idx] = DeviceInfo::get_default_concurrency(
+            static_cast< DeviceInfo::Kind >( idx ) );
+    }
 }
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <array>  // for array
+
 #include <imgui/imgui.h>  // for ImVec4
 
+#include "app/device_info.hpp"  // for DeviceInfo::Kind
 #include "tools/singleton.hpp"
 
 class ExplorerSettings : public Singleton< ExplorerSettings >
@@ -10,8 +13,17 @@ class ExplorerSettings : public Singleton< ExplorerSettings >
 
   public:
     bool         showHidden;
+    bool         showPreview;
+    bool         useHexViewer;
     ImVec4       backgroundColor;
     unsigned int maxHistorySize;
+    // Files copied at the same time by every file operation, and directories
+    // emptied at the same time by a deletion
+    unsigned int fileOperationThreads;
+    // Files of a device read or written at the same time, by kind of device
+    std::array< unsigned int,
+                static_cast< std::size_t >( DeviceInfo::Kind::Count ) >
+        deviceConcurrency;
 
   private:
     ExplorerSettings();
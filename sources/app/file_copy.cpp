@@ -0,0 +1,350 @@
+#include "file_copy.hpp"
+
+#include <algorithm>     // for min
+#include <array>         // for array
+#include <cerrno>        // for errno
+#include <semaphore>     // for counting_semaphore
+#include <system_error>  // for error_code
+#include <thread>        // for jthread
+#include <vector>        // for vector
+
+#include <fcntl.h>         // for posix_fadvise, AT_FDCWD
+#include <linux/fs.h>      // for FICLONE
+#include <stdio.h>         // for renameat2, RENAME_NOREPLACE
+#include <sys/ioctl.h>     // for ioctl
+#include <sys/sendfile.h>  // for sendfile
+#include <unistd.h>        // for copy_file_range, pread, pwrite
+
+namespace
+{
+    // Copied by a single call, so a stop is seen between two of them
+    constexpr uint64_t KERNEL_CHUNK_SIZE { 16 * 1024 * 1024 };
+    constexpr std::size_t BUFFER_SIZE { 1024 * 1024 };
+
+    enum class Status
+    {
+        Done,
+        // Nothing has been copied, the next method can be tried
+        Unsupported,
+        Failed
+    };
+
+    // The errors meaning the method can't be used for these two files
+    bool is_unsupported ( int error )
+    {
+        return error == EXDEV || error == EINVAL || error == ENOSYS
+               || error == EOPNOTSUPP || error == ENOTTY || error == EBADF;
+    }
+
+    // The methods set the error to the errno of their failure, read on the
+    // thread that failed
+
+    Status reflink ( int source, int destination, uint64_t size,
+                     std::atomic< uint64_t > & nbCopied, int & error )
+    {
+        if ( ioctl( destination, FICLONE, source ) != 0 )
+        {
+            error = errno;
+            return is_unsupported( error ) ? Status::Unsupported
+                                           : Status::Failed;
+        }
+        nbCopied += size;
+        return Status::Done;
+    }
+
+    // copy_file_range and sendfile only differ by their call
+    template < typename Copy >
+    Status kernel_copy ( uint64_t size, std::atomic< uint64_t > & nbCopied,
+                         std::stop_token const & stopToken, int & error,
+                         Copy copy )
+    {
+        uint64_t offset = 0;
+        while ( offset < size )
+        {
+            if ( stopToken.stop_requested() )
+            {
+                error = ECANCELED;
+                return Status::Failed;
+            }
+            uint64_t length    = std::min( size - offset, KERNEL_CHUNK_SIZE );
+            ssize_t  nbWritten = copy( offset, length );
+            if ( nbWritten < 0 && errno == EINTR )
+            {
+                continue;
+            }
+            if ( nbWritten < 0 )
+            {
+                error = errno;
+                return offset == 0 && is_unsupported( error )
+                           ? Status::Unsupported
+                           : Status::Failed;
+            }
+            if ( nbWritten == 0 )
+            {
+                // The source has been truncated since it was stat
+                break;
+            }
+            offset += static_cast< uint64_t >( nbWritten );
+            nbCopied += static_cast< uint64_t >( nbWritten );
+        }
+        return Status::Done;
+    }
+
+    // Return 0 or the errno of the failure
+    int write_all ( int destination, char const * data, std::size_t size,
+                    uint64_t offset )
+    {
+        while ( size > 0 )
+        {
+            ssize_t nbWritten = pwrite( destination, data, size,
+                                        static_cast< off_t >( offset ) );
+            if ( nbWritten < 0 && errno == EINTR )
+            {
+                continue;
+            }
+            if ( nbWritten < 0 )
+            {
+                return errno;
+            }
+            if ( nbWritten == 0 )
+            {
+                return EIO;
+            }
+            data += nbWritten;
+            size -= static_cast< std::size_t >( nbWritten );
+            offset += static_cast< uint64_t >( nbWritten );
+        }
+        return 0;
+    }
+
+    ssize_t read_some ( int source, char * data, std::size_t size,
+                        uint64_t offset )
+    {
+        ssize_t nbRead = 0;
+        do
+        {
+            nbRead =
+                pread( source, data, size, static_cast< off_t >( offset ) );
+        } while ( nbRead < 0 && errno == EINTR );
+        return nbRead;
+    }
+
+    // The next buffer is read while the previous one is written by another
+    // thread, so the two files are busy at the same time
+    Status read_write ( int source, int destination, uint64_t size,
+                        std::atomic< uint64_t > & nbCopied,
+                        std::stop_token const & stopToken, int & error )
+    {
+        struct Buffer
+        {
+            std::vector< char > data;
+            // Negative once the reading is over
+            ssize_t             size;
+        };
+
+        // Not worth a thread
+        if ( size <= BUFFER_SIZE )
+        {
+            std::vector< char > buffer( BUFFER_SIZE );
+            uint64_t            offset = 0;
+            while ( offset < size )
+            {
+                ssize_t nbRead = read_some( source, buffer.data(),
+                                            buffer.size(), offset );
+                if ( nbRead < 0 )
+                {
+                    error = errno;
+                    return Status::Failed;
+                }
+                if ( nbRead == 0 )
+                {
+                    break;
+                }
+                error = write_all( destination, buffer.data(),
+                                   static_cast< std::size_t >( nbRead ),
+                                   offset );
+                if ( error != 0 )
+                {
+                    return Status::Failed;
+                }
+                offset += static_cast< uint64_t >( nbRead );
+                nbCopied += static_cast< uint64_t >( nbRead );
+            }
+            return Status::Done;
+        }
+
+        std::array< Buffer, 2 > buffers {};
+        for ( Buffer & buffer : buffers )
+        {
+            buffer.data.resize( BUFFER_SIZE );
+        }
+        std::counting_semaphore< 2 > nbEmpty { 2 };
+        std::counting_semaphore< 2 > nbFull { 0 };
+        // Set by the writer thread, its errno isn't the one of this thread
+        std::atomic< int >           writeError { 0 };
+
+        std::jthread writer { [&] () {
+            uint64_t offset = 0;
+            for ( std::size_t idx = 0;; ++idx )
+            {
+                nbFull.acquire();
+                Buffer & buffer = buffers[idx % 2];
+                if ( buffer.size < 0 )
+                {
+                    return;
+                }
+                // The buffers are still consumed after a failure, so the
+                // reader is never blocked
+                if ( writeError == 0 )
+                {
+                    writeError = write_all(
+                        destination, buffer.data.data(),
+                        static_cast< std::size_t >( buffer.size ), offset );
+                }
+                if ( writeError == 0 )
+                {
+                    nbCopied += static_cast< uint64_t >( buffer.size );
+                }
+                offset += static_cast< uint64_t >( buffer.size );
+                nbEmpty.release();
+            }
+        } };
+
+        int      readError = 0;
+        uint64_t offset    = 0;
+        for ( std::size_t idx = 0;; ++idx )
+        {
+            nbEmpty.acquire();
+            Buffer & buffer = buffers[idx % 2];
+            bool     isOver = offset >= size || writeError != 0
+                          || stopToken.stop_requested();
+            buffer.size = isOver ? -1
+                                 : read_some( source, buffer.data.data(),
+                                              buffer.data.size(), offset );
+            if ( buffer.size <= 0 )
+            {
+                if ( ! isOver && buffer.size < 0 )
+                {
+                    readError = errno;
+                }
+                buffer.size = -1;
+                nbFull.release();
+                break;
+            }
+            offset += static_cast< uint64_t >( buffer.size );
+            nbFull.release();
+        }
+        writer.join();
+
+        error = readError != 0 ? readError : writeError.load();
+        if ( error == 0 && stopToken.stop_requested() )
+        {
+            error = ECANCELED;
+        }
+        return error != 0 ? Status::Failed : Status::Done;
+    }
+}  // namespace
+
+namespace ds
+{
+    std::optional< CopyMethod > copy_content (
+        int source, int destination, uint64_t size,
+        std::atomic< uint64_t > & nbCopied, std::stop_token stopToken,
+        int & error )
+    {
+        error         = 0;
+        Status status = reflink( source, destination, size, nbCopied, error );
+        if ( status == Status::Done )
+        {
+            return CopyMethod::Reflink;
+        }
+
+        if ( status == Status::Unsupported )
+        {
+            status = kernel_copy(
+                size, nbCopied, stopToken, error,
+                [source, destination] ( uint64_t offset, std::size_t length ) {
+                    auto sourceOffset      = static_cast< off_t >( offset );
+                    auto destinationOffset = static_cast< off_t >( offset );
+                    return copy_file_range( source, &sourceOffset, destination,
+                                            &destinationOffset, length, 0 );
+                } );
+            if ( status == Status::Done )
+            {
+                return CopyMethod::CopyFileRange;
+            }
+        }
+
+        // The source will be read once, from its start to its end
+        posix_fadvise( source, 0, 0, POSIX_FADV_SEQUENTIAL );
+
+        if ( status == Status::Unsupported )
+        {
+            status = kernel_copy(
+                size, nbCopied, stopToken, error,
+                [source, destination] ( uint64_t offset, std::size_t length ) {
+                    // Written at the position of the destination, which
+                    // follows the copied bytes
+                    auto sourceOffset = static_cast< off_t >( offset );
+                    return sendfile( destination, source, &sourceOffset,
+                                     length );
+                } );
+            if ( status == Status::Done )
+            {
+                return CopyMethod::Sendfile;
+            }
+        }
+
+        if ( status == Status::Unsupported )
+        {
+            status = read_write( source, destination, size, nbCopied,
+                                 stopToken, error );
+            if ( status == Status::Done )
+            {
+                return CopyMethod::ReadWrite;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::string_view to_string ( CopyMethod method )
+    {
+        switch ( method )
+        {
+        case CopyMethod::Reflink :
+            return "reflink";
+        case CopyMethod::CopyFileRange :
+            return "copy_file_range";
+        case CopyMethod::Sendfile :
+            return "sendfile";
+        case CopyMethod::ReadWrite :
+            return "read/write";
+        case CopyMethod::Count :
+            break;
+        }
+        return "unknown";
+    }
+
+    int rename_no_replace ( fs::path const & source,
+                            fs::path const & destination )
+    {
+        if ( renameat2( AT_FDCWD, source.c_str(), AT_FDCWD,
+                        destination.c_str(), RENAME_NOREPLACE )
+             == 0 )
+        {
+            return 0;
+        }
+        if ( errno != EINVAL && errno != ENOSYS )
+        {
+            return errno;
+        }
+        // The filesystem doesn't support the flag
+        std::error_code error {};
+        if ( fs::exists( fs::symlink_status( destination, error ) ) )
+        {
+            return EEXIST;
+        }
+        return ::rename( source.c_str(), destination.c_str() ) == 0 ? 0
+                                                                    : errno;
+    }
+}  // namespace ds
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>       // for atomic
+#include <cstdint>      // for uint64_t, uint8_t
+#include <optional>     // for optional
+#include <stop_token>   // for stop_token
+#include <string_view>  // for string_view
+
+#include "app/filesystem.hpp"  // for fs::path
+
+namespace ds
+{
+    // Ways to copy a file content, from the fastest to the slowest
+    enum class CopyMethod : uint8_t
+    {
+        // Shares the extents of the source, nothing is copied
+        Reflink = 0,
+        // Copied by the kernel, or by the server of a network filesystem
+        CopyFileRange,
+        Sendfile,
+        // Read in a buffer while the previous one is written
+        ReadWrite,
+        Count
+    };
+
+    // Copy the content of the source descriptor to the destination one, both
+    // at their start, with the fastest method they support. The copied bytes
+    // are added to the counter as they are written, so the progress can be
+    // read from another thread. Return the method used, nullopt on error or
+    // if a stop has been requested (the destination is then incomplete). The
+    // error is then set to the errno of the failure, or ECANCELED.
+    std::optional< CopyMethod > copy_content (
+        int source, int destination, uint64_t size,
+        std::atomic< uint64_t > & nbCopied, std::stop_token stopToken,
+        int & error );
+
+    std::string_view to_string ( CopyMethod method );
+
+    // Rename, but fail with EEXIST instead of replacing the destination.
+    // Return 0 or the errno of the failure, EXDEV if they aren't on the same
+    // filesystem.
+    int rename_no_replace ( fs::path const & source,
+                            fs::path const & destination );
+}  // namespace ds
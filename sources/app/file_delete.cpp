@@ -0,0 +1,324 @@
+#include "file_delete.hpp"
+
+#include <condition_variable>  // for condition_variable
+#include <cstring>             // for strcmp
+#include <memory>              // for shared_ptr
+#include <mutex>               // for mutex
+#include <system_error>        // for generic_category
+#include <thread>              // for jthread
+#include <vector>              // for vector
+
+#include <dirent.h>    // for getdents64, dirent64
+#include <fcntl.h>     // for openat, AT_REMOVEDIR
+#include <sys/stat.h>  // for fstatat
+#include <unistd.h>    // for unlinkat, close
+
+#include <fmt/format.h>  // for format
+
+namespace
+{
+    // Entries read by a single getdents call
+    constexpr std::size_t DIRENT_BUFFER_SIZE { 64 * 1024 };
+
+    struct Directory
+    {
+        // Keeps the descriptor of the parent open until this one is removed
+        std::shared_ptr< Directory > parent;
+        std::string                  name;
+        // Only used for the error messages
+        fs::path                     path;
+        int                          descriptor;
+        // The scan of this directory and its subdirectories not removed yet
+        std::atomic< std::size_t >   nbPending;
+        // An entry couldn't be removed, so this directory can't be either
+        std::atomic< bool >          isIncomplete;
+
+        Directory( std::shared_ptr< Directory > parentDirectory,
+                   std::string entryName, fs::path entryPath )
+          : parent { std::move( parentDirectory ) },
+            name { std::move( entryName ) },
+            path { std::move( entryPath ) },
+            descriptor { -1 },
+            nbPending { 1 },
+            isIncomplete { false }
+        {}
+
+        ~Directory()
+        {
+            if ( descriptor >= 0 )
+            {
+                close( descriptor );
+            }
+        }
+
+        Directory( Directory const & )              = delete;
+        Directory & operator= ( Directory const & ) = delete;
+    };
+
+    class Deleter
+    {
+        std::atomic< uint64_t > &                    m_nbRemoved;
+        std::function< void( std::string ) > const & m_onError;
+        std::stop_token                              m_stopToken;
+
+        std::mutex                                 m_mutex;
+        std::condition_variable                    m_condition;
+        // The last directory found is emptied first, so the walk stays close
+        // to a depth first one and few directories are open at once
+        std::vector< std::shared_ptr< Directory > > m_pending;
+        unsigned int                               m_nbActive;
+        // Stopped with directories left, their parents are never finished
+        // so they can't report it
+        bool                                       m_isInterrupted;
+
+      public:
+        Deleter( std::atomic< uint64_t > &                    nbRemoved,
+                 std::function< void( std::string ) > const & onError,
+                 std::stop_token                              stopToken )
+          : m_nbRemoved { nbRemoved },
+            m_onError { onError },
+            m_stopToken { std::move( stopToken ) },
+            m_mutex {},
+            m_condition {},
+            m_pending {},
+            m_nbActive { 0 },
+            m_isInterrupted { false }
+        {}
+
+        void push ( std::shared_ptr< Directory > directory )
+        {
+            {
+                std::lock_guard< std::mutex > lock { m_mutex };
+                m_pending.push_back( std::move( directory ) );
+            }
+            m_condition.notify_one();
+        }
+
+        // Return once every directory has been emptied
+        void run ()
+        {
+            std::vector< char > buffer( DIRENT_BUFFER_SIZE );
+            while ( true )
+            {
+                std::shared_ptr< Directory > directory {};
+                {
+                    std::unique_lock< std::mutex > lock { m_mutex };
+                    m_condition.wait( lock, [this] () {
+                        return ! m_pending.empty() || m_nbActive == 0;
+                    } );
+                    if ( m_stopToken.stop_requested() && ! m_pending.empty() )
+                    {
+                        // Their descriptors are closed with them
+                        m_pending.clear();
+                        m_isInterrupted = true;
+                    }
+                    if ( m_pending.empty() )
+                    {
+                        m_condition.notify_all();
+                        return;
+                    }
+                    directory = std::move( m_pending.back() );
+                    m_pending.pop_back();
+                    ++m_nbActive;
+                }
+
+                this->empty( directory, buffer );
+
+                std::lock_guard< std::mutex > lock { m_mutex };
+                --m_nbActive;
+                if ( m_nbActive == 0 && m_pending.empty() )
+                {
+                    m_condition.notify_all();
+                }
+            }
+        }
+
+        // Called once every run has returned
+        bool is_interrupted () const
+        {
+            return m_isInterrupted;
+        }
+
+      private:
+        void report ( fs::path const & path, int error )
+        {
+            m_onError(
+                fmt::format( "Can't remove {}: {}", path.string(),
+                             std::generic_category().message( error ) ) );
+        }
+
+        // Remove the directory once its content has been removed, and its
+        // parent if it was the last one pending
+        void finish ( std::shared_ptr< Directory > directory )
+        {
+            // The top directory has no parent, it's the one containing the
+            // removed entry
+            while ( directory->parent && --directory->nbPending == 0 )
+            {
+                std::shared_ptr< Directory > parent = directory->parent;
+                close( directory->descriptor );
+                directory->descriptor = -1;
+
+                if ( directory->isIncomplete )
+                {
+                    parent->isIncomplete = true;
+                }
+                else if ( unlinkat( parent->descriptor, directory->name.c_str(),
+                                    AT_REMOVEDIR )
+                          == 0 )
+                {
+                    ++m_nbRemoved;
+                }
+                else
+                {
+                    this->report( directory->path, errno );
+                    parent->isIncomplete = true;
+                }
+                directory = std::move( parent );
+            }
+        }
+
+        void empty ( std::shared_ptr< Directory > const & directory,
+                     std::vector< char > &                buffer )
+        {
+            directory->descriptor =
+                openat( directory->parent->descriptor, directory->name.c_str(),
+                        O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC );
+            if ( directory->descriptor < 0 )
+            {
+                this->report( directory->path, errno );
+                directory->isIncomplete = true;
+                this->finish( directory );
+                return;
+            }
+
+            while ( ! m_stopToken.stop_requested() )
+            {
+                ssize_t nbRead = getdents64( directory->descriptor,
+                                             buffer.data(), buffer.size() );
+                if ( nbRead < 0 )
+                {
+                    this->report( directory->path, errno );
+                    directory->isIncomplete = true;
+                    break;
+                }
+                if ( nbRead == 0 )
+                {
+                    break;
+                }
+
+                for ( ssize_t offset = 0; offset < nbRead; )
+                {
+                    auto const * entry = reinterpret_cast< dirent64 const * >(
+                        buffer.data() + offset );
+                    offset += entry->d_reclen;
+                    this->remove_entry( directory, entry );
+                }
+            }
+            if ( m_stopToken.stop_requested() )
+            {
+                directory->isIncomplete = true;
+            }
+            this->finish( directory );
+        }
+
+        void remove_entry ( std::shared_ptr< Directory > const & directory,
+                            dirent64 const *                     entry )
+        {
+            char const * name = entry->d_name;
+            if ( std::strcmp( name, "." ) == 0
+                 || std::strcmp( name, ".." ) == 0 )
+            {
+                return;
+            }
+
+            // Some filesystems don't give the type
+            bool isDirectory = entry->d_type == DT_DIR;
+            if ( entry->d_type == DT_UNKNOWN )
+            {
+                struct stat status {};
+                isDirectory = fstatat( directory->descriptor, name, &status,
+                                       AT_SYMLINK_NOFOLLOW )
+                                  == 0
+                              && S_ISDIR( status.st_mode );
+            }
+
+            if ( isDirectory )
+            {
+                ++directory->nbPending;
+                this->push( std::make_shared< Directory >(
+                    directory, name, directory->path / name ) );
+            }
+            else if ( unlinkat( directory->descriptor, name, 0 ) == 0 )
+            {
+                ++m_nbRemoved;
+            }
+            else
+            {
+                this->report( directory->path / name, errno );
+                directory->isIncomplete = true;
+            }
+        }
+    };
+}  // namespace
+
+namespace ds
+{
+    bool delete_tree ( fs::path const & path, unsigned int nbThreads,
+                       std::atomic< uint64_t > &                     nbRemoved,
+                       std::function< void( std::string ) > const & onError,
+                       std::stop_token                               stopToken )
+    {
+        // "directory/" is removed as "directory"
+        fs::path target { path.has_filename() ? path : path.parent_path() };
+        fs::path parentPath { target.parent_path().empty()
+                                  ? fs::path { "." }
+                                  : target.parent_path() };
+        auto     parent =
+            std::make_shared< Directory >( nullptr, "", parentPath );
+        parent->descriptor = ::open( parentPath.c_str(),
+                                     O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+        if ( parent->descriptor < 0 )
+        {
+            onError( fmt::format( "Can't open {}: {}", parentPath.string(),
+                                  std::generic_category().message( errno ) ) );
+            return false;
+        }
+
+        // A link to a directory is removed, not what it points to
+        std::string name { target.filename().string() };
+        struct stat status {};
+        if ( fstatat( parent->descriptor, name.c_str(), &status,
+                      AT_SYMLINK_NOFOLLOW )
+             != 0 )
+        {
+            onError( fmt::format( "Can't remove {}: {}", path.string(),
+                                  std::generic_category().message( errno ) ) );
+            return false;
+        }
+        if ( ! S_ISDIR( status.st_mode ) )
+        {
+            if ( unlinkat( parent->descriptor, name.c_str(), 0 ) != 0 )
+            {
+                onError( fmt::format(
+                    "Can't remove {}: {}", path.string(),
+                    std::generic_category().message( errno ) ) );
+                return false;
+            }
+            ++nbRemoved;
+            return true;
+        }
+
+        Deleter deleter { nbRemoved, onError, stopToken };
+        deleter.push( std::make_shared< Directory >( parent, name, target ) );
+        {
+            std::vector< std::jthread > workers {};
+            for ( unsigned int idx = 1; idx < nbThreads; ++idx )
+            {
+                workers.emplace_back( [&deleter] () { deleter.run(); } );
+            }
+            deleter.run();
+        }
+        return ! parent->isIncomplete && ! deleter.is_interrupted();
+    }
+}  // namespace ds
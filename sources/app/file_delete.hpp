@@ -0,0 +1,25 @@
+#pragma once
+
+#include <atomic>      // for atomic
+#include <cstdint>     // for uint64_t
+#include <functional>  // for function
+#include <stop_token>  // for stop_token
+#include <string>      // for string
+
+#include "app/filesystem.hpp"  // for fs::path
+
+namespace ds
+{
+    // Remove the file, or the directory and everything in it. The entries are
+    // found with getdents and removed with unlinkat relative to their
+    // directory descriptor, so a directory renamed or replaced by a link
+    // during the walk can't redirect it. The sibling directories are emptied
+    // by several threads at the same time. The removed entries are added to
+    // the counter as they are removed. An entry that can't be removed is
+    // given to onError and the others are still removed; return true if
+    // everything has been removed.
+    bool delete_tree ( fs::path const & path, unsigned int nbThreads,
+                       std::atomic< uint64_t > &                     nbRemoved,
+                       std::function< void( std::string ) > const & onError,
+                       std::stop_token stopToken = {} );
+}  // namespace ds
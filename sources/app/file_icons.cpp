@@ -0,0 +1,176 @@
+#include "file_icons.hpp"
+
+#include <cstdint>  // for uint32_t
+
+namespace
+{
+    constexpr uint32_t ICON_SIZE { 64 };
+    // Samples on each axis of a pixel, for anti aliased borders
+    constexpr uint32_t NB_SAMPLES { 4 };
+
+    struct Color
+    {
+        unsigned char red;
+        unsigned char green;
+        unsigned char blue;
+    };
+
+    constexpr Color PAPER { 0xE6, 0xE6, 0xE6 };
+    constexpr Color FOLD { 0xB4, 0xB4, 0xB4 };
+
+    // Color of the folder, or of the band at the bottom of the page
+    constexpr std::array< Color, static_cast< std::size_t >( ds::Icon::Count ) >
+        ICON_COLORS { {
+            { 0xE8, 0xB9, 0x4A },  // Folder
+            { 0x90, 0x90, 0x90 },  // File
+            { 0x7A, 0x8C, 0xA0 },  // Text
+            { 0x50, 0x60, 0x70 },  // Markdown
+            { 0x2B, 0x57, 0x9A },  // Document
+            { 0x21, 0x73, 0x46 },  // Spreadsheet
+            { 0xD2, 0x47, 0x26 },  // Presentation
+            { 0xD9, 0x30, 0x25 },  // PDF
+            { 0x8E, 0x44, 0xAD },  // Image
+            { 0xB0, 0x5C, 0xD6 },  // VectorImage
+            { 0x6C, 0x34, 0x83 },  // RawImage
+            { 0xE9, 0x1E, 0x63 },  // Audio
+            { 0xC2, 0x18, 0x5B },  // Video
+            { 0x8D, 0x6E, 0x63 },  // Archive
+            { 0x6D, 0x4C, 0x41 },  // Package
+            { 0x45, 0x5A, 0x64 },  // DiskImage
+            { 0x55, 0x55, 0xAA },  // C
+            { 0x00, 0x59, 0x9C },  // Cpp
+            { 0x65, 0x9A, 0xD2 },  // Header
+            { 0x68, 0x21, 0x7A },  // CSharp
+            { 0xB0, 0x72, 0x19 },  // Java
+            { 0x37, 0x76, 0xAB },  // Python
+            { 0xF0, 0xDB, 0x4F },  // JavaScript
+            { 0x31, 0x78, 0xC6 },  // TypeScript
+            { 0xCE, 0x42, 0x2B },  // Rust
+            { 0x00, 0xAD, 0xD8 },  // Go
+            { 0x4E, 0xAA, 0x25 },  // Shell
+            { 0xE3, 0x4F, 0x26 },  // Html
+            { 0x15, 0x72, 0xB6 },  // Css
+            { 0xCB, 0xA0, 0x2B },  // Json
+            { 0x6D, 0x80, 0x86 },  // Config
+            { 0x33, 0x67, 0x91 },  // Database
+            { 0x5D, 0x6D, 0x7E },  // Font
+            { 0x2E, 0x7D, 0x32 },  // Executable
+            { 0x82, 0x77, 0x17 },  // Library
+        } };
+
+    // Color of the point of the icon, nullopt if it's transparent
+    std::optional< Color > get_folder_color ( float x, float y, Color color )
+    {
+        bool isTab  = x >= 6.f && x < 28.f && y >= 12.f && y < 20.f;
+        bool isBody = x >= 6.f && x < 58.f && y >= 18.f && y < 54.f;
+        if ( ! isTab && ! isBody )
+        {
+            return std::nullopt;
+        }
+        return color;
+    }
+
+    std::optional< Color > get_page_color ( float x, float y, Color color )
+    {
+        constexpr float LEFT { 14.f };
+        constexpr float RIGHT { 50.f };
+        constexpr float TOP { 6.f };
+        constexpr float BOTTOM { 58.f };
+        // The top right corner is folded
+        constexpr float FOLD_SIZE { 12.f };
+
+        if ( x < LEFT || x >= RIGHT || y < TOP || y >= BOTTOM )
+        {
+            return std::nullopt;
+        }
+        float foldX = x - ( RIGHT - FOLD_SIZE );
+        float foldY = y - TOP;
+        if ( foldX > 0.f && foldY < FOLD_SIZE )
+        {
+            if ( foldX > foldY )
+            {
+                return std::nullopt;
+            }
+            return FOLD;
+        }
+        if ( y >= 38.f && y < 50.f )
+        {
+            return color;
+        }
+        return PAPER;
+    }
+
+    ds::Image draw_icon ( ds::Icon icon )
+    {
+        Color color = ICON_COLORS[static_cast< std::size_t >( icon )];
+
+        ds::Image image { ICON_SIZE, ICON_SIZE, {} };
+        image.pixels.resize( ICON_SIZE * ICON_SIZE * 4 );
+        for ( uint32_t y = 0; y < ICON_SIZE; ++y )
+        {
+            for ( uint32_t x = 0; x < ICON_SIZE; ++x )
+            {
+                uint32_t red = 0, green = 0, blue = 0, coverage = 0;
+                for ( uint32_t sample = 0; sample < NB_SAMPLES * NB_SAMPLES;
+                      ++sample )
+                {
+                    float offsetX =
+                        ( static_cast< float >( sample % NB_SAMPLES ) + 0.5f )
+                        / NB_SAMPLES;
+                    float offsetY =
+                        ( static_cast< float >( sample / NB_SAMPLES ) + 0.5f )
+                        / NB_SAMPLES;
+                    float sampleX = static_cast< float >( x ) + offsetX;
+                    float sampleY = static_cast< float >( y ) + offsetY;
+                    std::optional< Color > sampleColor =
+                        icon == ds::Icon::Folder
+                            ? get_folder_color( sampleX, sampleY, color )
+                            : get_page_color( sampleX, sampleY, color );
+                    if ( sampleColor.has_value() )
+                    {
+                        red += sampleColor->red;
+                        green += sampleColor->green;
+                        blue += sampleColor->blue;
+                        ++coverage;
+                    }
+                }
+
+                unsigned char * pixel =
+                    image.pixels.data() + ( y * ICON_SIZE + x ) * 4;
+                if ( coverage > 0 )
+                {
+                    pixel[0] = static_cast< unsigned char >( red / coverage );
+                    pixel[1] = static_cast< unsigned char >( green / coverage );
+                    pixel[2] = static_cast< unsigned char >( blue / coverage );
+                    pixel[3] = static_cast< unsigned char >(
+                        coverage * 255 / ( NB_SAMPLES * NB_SAMPLES ) );
+                }
+            }
+        }
+        return image;
+    }
+}  // namespace
+
+FileIcons::FileIcons() : m_allocations {} {}
+
+std::optional< TextureAtlas::Region > FileIcons::get_icon( ds::Icon icon )
+{
+    std::optional< TextureAtlas::Allocation > & allocation =
+        m_allocations[static_cast< std::size_t >( icon )];
+
+    std::optional< TextureAtlas::Region > region {};
+    if ( allocation.has_value() )
+    {
+        region = TextureAtlas::get_instance().get( allocation.value() );
+    }
+    // Drawn again if its page has been evicted
+    if ( ! region.has_value() )
+    {
+        allocation = TextureAtlas::get_instance().insert( draw_icon( icon ) );
+        if ( allocation.has_value() )
+        {
+            region = TextureAtlas::get_instance().get( allocation.value() );
+        }
+    }
+    return region;
+}
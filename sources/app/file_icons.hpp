@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>     // for array
+#include <optional>  // for optional
+
+#include "app/file_type.hpp"      // for ds::Icon
+#include "app/texture_atlas.hpp"  // for TextureAtlas
+#include "tools/singleton.hpp"
+
+// Icons of the file types, drawn when they are first needed and kept in the
+// texture atlas with the thumbnails
+class FileIcons : public Singleton< FileIcons >
+{
+    ENABLE_SINGLETON( FileIcons );
+
+    std::array< std::optional< TextureAtlas::Allocation >,
+                static_cast< std::size_t >( ds::Icon::Count ) >
+        m_allocations;
+
+    FileIcons();
+    virtual ~FileIcons() = default;
+
+  public:
+    // nullopt only if the atlas is full of images showed by this frame
+    std::optional< TextureAtlas::Region > get_icon ( ds::Icon icon );
+};
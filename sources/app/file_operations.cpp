@@ -0,0 +1,823 @@
+#include "file_operations.hpp"
+
+#include <algorithm>         // for clamp, min
+#include <cerrno>            // for errno
+#include <cstring>           // for strerror
+#include <initializer_list>  // for initializer_list
+#include <system_error>      // for error_code
+
+#include <fcntl.h>     // for open, O_TMPFILE, linkat
+#include <stdlib.h>    // for mkostemp
+#include <sys/stat.h>  // for fstat, fchmod, futimens, mkdir
+#include <unistd.h>    // for close, unlink, rmdir
+
+#include <fmt/format.h>   // for format
+#include <imgui/imgui.h>  // for ImGui::Begin, ImGui::ProgressBar
+
+#include "app/device_info.hpp"        // for DeviceInfo
+#include "app/explorer_settings.hpp"  // for ExplorerSettings
+#include "app/file_delete.hpp"        // for ds::delete_tree
+#include "app/job_scheduler.hpp"      // for JobScheduler
+#include "app/trash.hpp"              // for ds::create_trash_item
+#include "app/tree_walker.hpp"        // for ds::walk_tree
+
+namespace
+{
+    constexpr unsigned int MAX_THREADS { 16 };
+    // Only the first errors of an operation are kept
+    constexpr std::size_t MAX_ERRORS { 100 };
+    // Delay between two measures of the speed of an operation
+    constexpr std::chrono::milliseconds SPEED_SAMPLE_INTERVAL { 500 };
+    // Weight of the last measure in the smoothed speed
+    constexpr double SPEED_SMOOTHING { 0.3 };
+
+    // Threads of an operation, limited by the slowest device it reads or
+    // writes
+    unsigned int get_nb_threads ( std::initializer_list< fs::path > paths )
+    {
+        unsigned int nbThreads = std::clamp(
+            Settings::get_instance().fileOperationThreads, 1u, MAX_THREADS );
+        for ( fs::path const & path : paths )
+        {
+            dev_t device = JobScheduler::get_device( path );
+            if ( device != 0 )
+            {
+                nbThreads = std::min(
+                    nbThreads,
+                    DeviceInfo::get_instance().get_concurrency( device ) );
+            }
+        }
+        return nbThreads;
+    }
+
+    // "name (2).ext" if "name.ext" already exists, and so on
+    fs::path get_free_path ( fs::path const & path )
+    {
+        std::error_code error {};
+        if ( ! fs::exists( fs::symlink_status( path, error ) ) )
+        {
+            return path;
+        }
+        for ( unsigned int idx = 2;; ++idx )
+        {
+            fs::path candidate = path.parent_path()
+                                 / fmt::format( "{} ({}){}",
+                                                path.stem().string(), idx,
+                                                path.extension().string() );
+            if ( ! fs::exists( fs::symlink_status( candidate, error ) ) )
+            {
+                return candidate;
+            }
+        }
+    }
+
+    bool is_inside ( fs::path const & path, fs::path const & directory )
+    {
+        std::error_code error {};
+        fs::path        canonicalPath { fs::weakly_canonical( path, error ) };
+        fs::path        canonicalDirectory { fs::weakly_canonical( directory,
+                                                                   error ) };
+        auto [mismatch, end] = std::mismatch(
+            canonicalDirectory.begin(), canonicalDirectory.end(),
+            canonicalPath.begin(), canonicalPath.end() );
+        return mismatch == canonicalDirectory.end();
+    }
+
+    std::string format_duration ( double seconds )
+    {
+        auto total = static_cast< uint64_t >( seconds );
+        if ( total >= 3600 )
+        {
+            return fmt::format( "{}h {:02}m", total / 3600,
+                                total % 3600 / 60 );
+        }
+        return fmt::format( "{}m {:02}s", total / 60, total % 60 );
+    }
+}  // namespace
+
+FileOperations::FileOperations()
+  : m_operations {}, m_clipboard { std::nullopt }, m_nbFinished { 0 }
+{}
+
+FileOperations::~FileOperations()
+{
+    // The threads are joined when the operations are destroyed
+    this->cancel_all();
+}
+
+void FileOperations::copy( std::vector< fs::path > paths )
+{
+    m_clipboard = Clipboard { Kind::Copy, std::move( paths ) };
+}
+
+void FileOperations::cut( std::vector< fs::path > paths )
+{
+    m_clipboard = Clipboard { Kind::Move, std::move( paths ) };
+}
+
+void FileOperations::trash( std::vector< fs::path > paths )
+{
+    this->submit( Kind::Trash, std::move( paths ), {} );
+}
+
+void FileOperations::remove( std::vector< fs::path > paths )
+{
+    this->submit( Kind::Delete, std::move( paths ), {} );
+}
+
+void FileOperations::restore( std::vector< ds::TrashItem > items )
+{
+    std::vector< fs::path > sources {};
+    for ( ds::TrashItem const & item : items )
+    {
+        sources.push_back( item.get_path() );
+    }
+    this->start( Kind::Restore, std::move( sources ), {}, std::move( items ) );
+}
+
+void FileOperations::paste( fs::path const & directory )
+{
+    if ( ! m_clipboard.has_value() )
+    {
+        return;
+    }
+    this->submit( m_clipboard->kind, m_clipboard->paths, directory );
+    // The files aren't there anymore
+    if ( m_clipboard->kind == Kind::Move )
+    {
+        m_clipboard = std::nullopt;
+    }
+}
+
+bool FileOperations::has_clipboard() const
+{
+    return m_clipboard.has_value();
+}
+
+void FileOperations::submit( Kind kind, std::vector< fs::path > sources,
+                             fs::path const & destination )
+{
+    this->start( kind, std::move( sources ), destination, {} );
+}
+
+void FileOperations::start( Kind kind, std::vector< fs::path > sources,
+                            fs::path const &             destination,
+                            std::vector< ds::TrashItem > restoredItems )
+{
+    if ( sources.empty() )
+    {
+        return;
+    }
+
+    auto operation          = std::make_unique< Operation >();
+    operation->kind         = kind;
+    operation->sources      = std::move( sources );
+    operation->destination  = destination;
+    operation->restoredItems = std::move( restoredItems );
+    operation->nbTotalBytes = 0;
+    operation->nbCopiedBytes = 0;
+    operation->nbTotalFiles = 0;
+    operation->nbDoneFiles  = 0;
+    for ( std::atomic< uint64_t > & nbFiles : operation->nbFilesByMethod )
+    {
+        nbFiles = 0;
+    }
+    operation->isDone          = false;
+    operation->lastSampleTime  = std::chrono::steady_clock::now();
+    operation->lastSampleProgress = 0;
+    operation->speed              = 0.;
+
+    Operation & started = *operation;
+    started.thread = std::jthread { [this, &started] ( std::stop_token stop ) {
+        this->run( started, stop );
+    } };
+    m_operations.push_back( std::move( operation ) );
+}
+
+void FileOperations::cancel_all()
+{
+    for ( std::unique_ptr< Operation > const & operation : m_operations )
+    {
+        operation->thread.request_stop();
+    }
+}
+
+uint64_t FileOperations::get_nb_finished() const
+{
+    return m_nbFinished;
+}
+
+void FileOperations::update_gui()
+{
+    if ( m_operations.empty() )
+    {
+        return;
+    }
+
+    ImGui::SetNextWindowSize( ImVec2 { 480.f, 0.f }, ImGuiCond_FirstUseEver );
+    ImGui::Begin( "File Operations" );
+
+    auto now = std::chrono::steady_clock::now();
+    std::optional< std::size_t > idxDismissed {};
+    for ( std::size_t idx = 0; idx < m_operations.size(); ++idx )
+    {
+        Operation & operation = *m_operations[idx];
+        if ( operation.isDone && operation.thread.joinable() )
+        {
+            operation.thread.join();
+            ++m_nbFinished;
+        }
+
+        // Bytes copied, or entries removed
+        bool     isDelete = operation.kind == Kind::Delete;
+        uint64_t progress = isDelete ? operation.nbDoneFiles.load()
+                                     : operation.nbCopiedBytes.load();
+        std::chrono::duration< double > elapsed =
+            now - operation.lastSampleTime;
+        if ( elapsed >= SPEED_SAMPLE_INTERVAL )
+        {
+            // The progress of a failed file is removed
+            uint64_t nbSampled = progress > operation.lastSampleProgress
+                                     ? progress - operation.lastSampleProgress
+                                     : 0;
+            double   speed =
+                static_cast< double >( nbSampled ) / elapsed.count();
+            operation.speed =
+                operation.speed == 0.
+                    ? speed
+                    : ( 1. - SPEED_SMOOTHING ) * operation.speed
+                          + SPEED_SMOOTHING * speed;
+            operation.lastSampleTime     = now;
+            operation.lastSampleProgress = progress;
+        }
+
+        ImGui::PushID( static_cast< int >( idx ) );
+        if ( isDelete )
+        {
+            this->update_delete_gui( operation, progress );
+        }
+        else
+        {
+            this->update_copy_gui( operation, progress );
+        }
+
+        if ( operation.isDone )
+        {
+            ImGui::SameLine();
+            if ( ImGui::Button( "Dismiss" ) )
+            {
+                idxDismissed = idx;
+            }
+        }
+        else
+        {
+            ImGui::SameLine();
+            if ( ImGui::Button( "Cancel" ) )
+            {
+                operation.thread.request_stop();
+            }
+        }
+
+        std::lock_guard< std::mutex > lock { operation.errorsMutex };
+        std::string errorsLabel { fmt::format(
+            "{} errors##Errors", operation.errors.size() ) };
+        if ( ! operation.errors.empty()
+             && ImGui::TreeNode( errorsLabel.c_str() ) )
+        {
+            for ( std::string const & error : operation.errors )
+            {
+                ImGui::TextUnformatted( error.c_str() );
+            }
+            ImGui::TreePop();
+        }
+        ImGui::PopID();
+        ImGui::Separator();
+    }
+    ImGui::End();
+
+    if ( idxDismissed.has_value() )
+    {
+        m_operations.erase( m_operations.begin()
+                            + static_cast< std::ptrdiff_t >(
+                                idxDismissed.value() ) );
+    }
+}
+
+void FileOperations::update_copy_gui( Operation const & operation,
+                                      uint64_t          nbCopied ) const
+{
+    uint64_t nbTotal = operation.nbTotalBytes;
+    if ( operation.kind == Kind::Trash )
+    {
+        ImGui::Text( "Move %lu items to the trash",
+                     operation.sources.size() );
+    }
+    else if ( operation.kind == Kind::Restore )
+    {
+        ImGui::Text( "Restore %lu items from the trash",
+                     operation.sources.size() );
+    }
+    else
+    {
+        ImGui::Text( "%s %lu files to %s",
+                     operation.kind == Kind::Copy ? "Copy" : "Move",
+                     operation.nbTotalFiles.load(),
+                     operation.destination.string().c_str() );
+    }
+
+    std::string overlay { fmt::format(
+        "{} / {}", ds::get_size_pretty_print( nbCopied, false ),
+        ds::get_size_pretty_print( nbTotal, false ) ) };
+    float fraction = operation.isDone ? 1.f : 0.f;
+    if ( nbTotal > 0 )
+    {
+        fraction = static_cast< float >( static_cast< double >( nbCopied )
+                                         / static_cast< double >( nbTotal ) );
+    }
+    ImGui::ProgressBar( fraction, ImVec2 { -1.f, 0.f }, overlay.c_str() );
+
+    std::string methods {};
+    for ( std::size_t idxMethod = 0;
+          idxMethod < operation.nbFilesByMethod.size(); ++idxMethod )
+    {
+        methods += fmt::format(
+            "{}{}: {}", methods.empty() ? "" : ", ",
+            ds::to_string( static_cast< ds::CopyMethod >( idxMethod ) ),
+            operation.nbFilesByMethod[idxMethod].load() );
+    }
+    ImGui::TextDisabled( "%s", methods.c_str() );
+
+    if ( operation.isDone )
+    {
+        ImGui::Text( "Done, %lu / %lu files", operation.nbDoneFiles.load(),
+                     operation.nbTotalFiles.load() );
+        return;
+    }
+    double remaining = operation.speed > 0.
+                           ? static_cast< double >( nbTotal - nbCopied )
+                                 / operation.speed
+                           : 0.;
+    ImGui::Text(
+        "%s/s, %s left, %lu / %lu files",
+        ds::get_size_pretty_print( static_cast< uintmax_t >( operation.speed ),
+                                   false )
+            .c_str(),
+        operation.speed > 0. ? format_duration( remaining ).c_str() : "?",
+        operation.nbDoneFiles.load(), operation.nbTotalFiles.load() );
+}
+
+void FileOperations::update_delete_gui( Operation const & operation,
+                                        uint64_t          nbRemoved ) const
+{
+    // The number of entries isn't known before they are removed
+    ImGui::Text( "Delete %lu items", operation.sources.size() );
+    if ( operation.isDone )
+    {
+        ImGui::Text( "Done, %lu entries removed", nbRemoved );
+        return;
+    }
+    ImGui::Text( "%lu entries removed, %.0f / s", nbRemoved, operation.speed );
+}
+
+void FileOperations::run( Operation & operation, std::stop_token stopToken )
+{
+    // Inherited by the threads deleting the files
+    JobScheduler::set_thread_class( JobScheduler::JobClass::Background );
+    if ( operation.kind == Kind::Delete )
+    {
+        std::vector< fs::path > removed {};
+        for ( fs::path const & source : operation.sources )
+        {
+            if ( stopToken.stop_requested() )
+            {
+                break;
+            }
+            if ( ds::delete_tree(
+                     source, get_nb_threads( { source } ),
+                     operation.nbDoneFiles,
+                     [&operation] ( std::string error ) {
+                         add_error( operation, std::move( error ) );
+                     },
+                     stopToken ) )
+            {
+                removed.push_back( source );
+            }
+        }
+        // The files deleted from a trash are removed from it
+        ds::forget_trash_items( removed );
+        operation.isDone = true;
+        return;
+    }
+
+    std::vector< Item >          items {};
+    // Sources of a move that must be copied, removed once they are
+    std::vector< fs::path >      sourcesToRemove {};
+    // Items of the trash whose file is copied from another filesystem
+    std::vector< ds::TrashItem > copiedTrashItems {};
+    // Files of the restored items copied to another filesystem
+    std::vector< fs::path >      copiedRestoredPaths {};
+    for ( std::size_t idxSource = 0; idxSource < operation.sources.size();
+          ++idxSource )
+    {
+        fs::path const & source = operation.sources[idxSource];
+        if ( stopToken.stop_requested() )
+        {
+            break;
+        }
+        if ( is_inside( operation.destination, source ) )
+        {
+            add_error( operation,
+                       fmt::format( "Can't copy {} inside itself",
+                                    source.string() ) );
+            continue;
+        }
+
+        if ( operation.kind == Kind::Move
+             && source.parent_path() == operation.destination )
+        {
+            // Already there
+            continue;
+        }
+
+        fs::path                       destination {};
+        std::optional< ds::TrashItem > trashItem {};
+        if ( operation.kind == Kind::Trash )
+        {
+            trashItem = ds::create_trash_item( source );
+            if ( ! trashItem.has_value() )
+            {
+                add_error( operation,
+                           fmt::format( "Can't trash {}: {}", source.string(),
+                                        std::strerror( errno ) ) );
+                continue;
+            }
+            destination = trashItem->get_path();
+        }
+        else if ( operation.kind == Kind::Restore )
+        {
+            ds::TrashItem const & item = operation.restoredItems[idxSource];
+            // Nothing to copy if the trash is on the same filesystem
+            int error = ds::restore_trash_item( item );
+            if ( error == 0 )
+            {
+                ++operation.nbTotalFiles;
+                ++operation.nbDoneFiles;
+            }
+            else if ( error != EXDEV )
+            {
+                add_error( operation,
+                           fmt::format( "Can't restore {} to {}: {}",
+                                        item.name, item.originalPath.string(),
+                                        std::strerror( error ) ) );
+            }
+            else
+            {
+                // The home trash holds files of the other filesystems that
+                // have no trash of their own
+                sourcesToRemove.push_back( source );
+                copiedRestoredPaths.push_back( source );
+                this->list_items( operation, source, item.originalPath,
+                                  items );
+            }
+            continue;
+        }
+        else
+        {
+            destination =
+                get_free_path( operation.destination / source.filename() );
+        }
+
+        if ( operation.kind != Kind::Copy )
+        {
+            // Nothing to copy on the same filesystem
+            int error = ds::rename_no_replace( source, destination );
+            if ( error == 0 )
+            {
+                if ( trashItem.has_value() )
+                {
+                    ds::add_directory_size( trashItem.value() );
+                }
+                ++operation.nbTotalFiles;
+                ++operation.nbDoneFiles;
+                continue;
+            }
+            if ( error != EXDEV )
+            {
+                if ( trashItem.has_value() )
+                {
+                    ds::discard_trash_item( trashItem.value() );
+                }
+                add_error( operation,
+                           fmt::format( "Can't move {}: {}", source.string(),
+                                        std::strerror( error ) ) );
+                continue;
+            }
+            sourcesToRemove.push_back( source );
+            if ( trashItem.has_value() )
+            {
+                copiedTrashItems.push_back( trashItem.value() );
+            }
+        }
+        this->list_items( operation, source, destination, items );
+    }
+
+    // The directories are created before their content. They are writable
+    // until the files are copied, their permissions are set at the end.
+    std::vector< Item const * > directories {};
+    for ( Item const & item : items )
+    {
+        if ( item.type != fs::file_type::directory )
+        {
+            continue;
+        }
+        if ( mkdir( item.destination.c_str(), S_IRWXU ) != 0 )
+        {
+            add_error( operation,
+                       fmt::format( "Can't create {}: {}",
+                                    item.destination.string(),
+                                    std::strerror( errno ) ) );
+            continue;
+        }
+        directories.push_back( &item );
+    }
+
+    // The files are copied by background jobs, so the copies of every
+    // operation share the limits of the devices
+    std::atomic< std::size_t > idxNext { 0 };
+    std::atomic< bool >        isFailed { false };
+    if ( ! items.empty() )
+    {
+        Item const & first     = items.front();
+        unsigned int nbThreads = get_nb_threads(
+            { first.source, first.destination.parent_path() } );
+        JobScheduler::Queue jobs { JobScheduler::JobClass::Background };
+        dev_t               device { JobScheduler::get_device( first.source ) };
+        for ( unsigned int idx = 0; idx < nbThreads; ++idx )
+        {
+            jobs.submit( device, [&] ( std::stop_token jobToken ) {
+                while ( ! jobToken.stop_requested() )
+                {
+                    std::size_t idxItem = idxNext++;
+                    if ( idxItem >= items.size() )
+                    {
+                        return;
+                    }
+                    Item const & item = items[idxItem];
+                    if ( item.type == fs::file_type::directory )
+                    {
+                        continue;
+                    }
+                    if ( this->copy_file( operation, item, jobToken ) )
+                    {
+                        ++operation.nbDoneFiles;
+                    }
+                    else
+                    {
+                        isFailed = true;
+                    }
+                }
+            }, 0, stopToken );
+        }
+        jobs.wait();
+    }
+
+    std::error_code error {};
+    for ( auto it = directories.rbegin(); it != directories.rend(); ++it )
+    {
+        if ( stopToken.stop_requested() )
+        {
+            // Only the directories left empty by the cancel are removed
+            rmdir( ( *it )->destination.c_str() );
+            continue;
+        }
+        fs::permissions( ( *it )->destination, ( *it )->permissions, error );
+    }
+
+    // The sources of a move are only removed if everything has been copied
+    bool hasErrors = isFailed;
+    {
+        std::lock_guard< std::mutex > lock { operation.errorsMutex };
+        hasErrors |= ! operation.errors.empty();
+    }
+    if ( ! stopToken.stop_requested() && ! hasErrors )
+    {
+        for ( fs::path const & source : sourcesToRemove )
+        {
+            fs::remove_all( source, error );
+            if ( error )
+            {
+                add_error( operation,
+                           fmt::format( "Can't remove {}: {}", source.string(),
+                                        error.message() ) );
+                // Still in the trash
+                std::erase( copiedRestoredPaths, source );
+            }
+        }
+        for ( ds::TrashItem const & item : copiedTrashItems )
+        {
+            ds::add_directory_size( item );
+        }
+        ds::forget_trash_items( copiedRestoredPaths );
+    }
+    else
+    {
+        // The copies are partial, the trash must not show them
+        for ( ds::TrashItem const & item : copiedTrashItems )
+        {
+            fs::remove_all( item.get_path(), error );
+            ds::discard_trash_item( item );
+        }
+    }
+    operation.isDone = true;
+}
+
+void FileOperations::list_items( Operation & operation,
+                                 fs::path const & source,
+                                 fs::path const & destination,
+                                 std::vector< Item > & items ) const
+{
+    // Read in inode order on the disks where a seek costs more than a read
+    dev_t device { JobScheduler::get_device( source ) };
+    bool  isRotational { device != 0
+                        && DeviceInfo::get_instance().get_device( device ).kind
+                               == DeviceInfo::Kind::Rotational };
+    ds::WalkOrder order { isRotational ? ds::WalkOrder::Inode
+                                       : ds::WalkOrder::Directory };
+
+    // The symbolic links to directories are copied as links, not followed
+    ds::walk_tree(
+        source, order,
+        [&] ( fs::path const & path, struct stat const & status ) {
+            fs::file_type type { fs::file_type::unknown };
+            if ( S_ISREG( status.st_mode ) )
+            {
+                type = fs::file_type::regular;
+            }
+            else if ( S_ISDIR( status.st_mode ) )
+            {
+                type = fs::file_type::directory;
+            }
+            else if ( S_ISLNK( status.st_mode ) )
+            {
+                type = fs::file_type::symlink;
+            }
+            else
+            {
+                add_error( operation, fmt::format( "Special file {} not copied",
+                                                   path.string() ) );
+                return;
+            }
+
+            uint64_t size { type == fs::file_type::regular
+                                ? static_cast< uint64_t >( status.st_size )
+                                : 0 };
+            fs::path target { path == source
+                                  ? destination
+                                  : destination
+                                        / path.lexically_relative( source ) };
+            items.push_back( Item { path, target, type,
+                                    static_cast< fs::perms >(
+                                        status.st_mode & 07777 ),
+                                    size } );
+            if ( type != fs::file_type::directory )
+            {
+                ++operation.nbTotalFiles;
+                operation.nbTotalBytes += size;
+            }
+        },
+        [&operation] ( std::string error ) {
+            add_error( operation, std::move( error ) );
+        } );
+}
+
+bool FileOperations::copy_file( Operation & operation, Item const & item,
+                                std::stop_token const & stopToken ) const
+{
+    if ( item.type == fs::file_type::symlink )
+    {
+        std::error_code error {};
+        fs::copy_symlink( item.source, item.destination, error );
+        if ( error )
+        {
+            add_error( operation, fmt::format( "Can't copy {}: {}",
+                                               item.source.string(),
+                                               error.message() ) );
+            return false;
+        }
+        return true;
+    }
+
+    int source =
+        ::open( item.source.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW );
+    struct stat status {};
+    if ( source < 0 || fstat( source, &status ) != 0 )
+    {
+        add_error( operation, fmt::format( "Can't read {}: {}",
+                                           item.source.string(),
+                                           std::strerror( errno ) ) );
+        if ( source >= 0 )
+        {
+            close( source );
+        }
+        operation.nbTotalBytes -= item.size;
+        return false;
+    }
+
+    // Unnamed until it's complete, so it can't be seen half written. A named
+    // temporary file is used on the filesystems that don't support it, which
+    // is left behind if the explorer is killed during the copy.
+    fs::path directory { item.destination.parent_path() };
+    fs::path temporary {};
+    int      destination = ::open( directory.c_str(),
+                                   O_TMPFILE | O_WRONLY | O_CLOEXEC,
+                                   S_IRUSR | S_IWUSR );
+    if ( destination < 0 )
+    {
+        std::string name { ( directory
+                             / fmt::format( ".{}.XXXXXX",
+                                            item.destination.filename()
+                                                .string() ) )
+                               .string() };
+        destination = mkostemp( name.data(), O_CLOEXEC );
+        temporary   = name;
+    }
+    if ( destination < 0 )
+    {
+        add_error( operation, fmt::format( "Can't create {}: {}",
+                                           item.destination.string(),
+                                           std::strerror( errno ) ) );
+        close( source );
+        operation.nbTotalBytes -= item.size;
+        return false;
+    }
+
+    int                             error  = 0;
+    std::optional< ds::CopyMethod > method = ds::copy_content(
+        source, destination, static_cast< uint64_t >( status.st_size ),
+        operation.nbCopiedBytes, stopToken, error );
+
+    if ( method.has_value() )
+    {
+        fchmod( destination, status.st_mode & 07777 );
+        struct timespec times[2] { status.st_atim, status.st_mtim };
+        futimens( destination, times );
+
+        if ( temporary.empty() )
+        {
+            // Never replaces an existing file
+            std::string descriptorPath {
+                fmt::format( "/proc/self/fd/{}", destination ) };
+            if ( linkat( AT_FDCWD, descriptorPath.c_str(), AT_FDCWD,
+                         item.destination.c_str(), AT_SYMLINK_FOLLOW )
+                 != 0 )
+            {
+                error = errno;
+            }
+        }
+        else
+        {
+            error = ds::rename_no_replace( temporary, item.destination );
+        }
+    }
+
+    if ( ! method.has_value() || error != 0 )
+    {
+        // The progress of the file is forgotten
+        struct stat written {};
+        if ( fstat( destination, &written ) == 0 )
+        {
+            operation.nbCopiedBytes -=
+                std::min( static_cast< uint64_t >( written.st_size ),
+                          operation.nbCopiedBytes.load() );
+        }
+        operation.nbTotalBytes -= item.size;
+        if ( ! temporary.empty() )
+        {
+            unlink( temporary.c_str() );
+        }
+        if ( ! stopToken.stop_requested() )
+        {
+            add_error( operation, fmt::format( "Can't copy {}: {}",
+                                               item.source.string(),
+                                               std::strerror( error ) ) );
+        }
+    }
+    else
+    {
+        ++operation.nbFilesByMethod[static_cast< std::size_t >(
+            method.value() )];
+    }
+
+    close( destination );
+    close( source );
+    return method.has_value() && error == 0;
+}
+
+void FileOperations::add_error( Operation & operation, std::string error )
+{
+    std::lock_guard< std::mutex > lock { operation.errorsMutex };
+    if ( operation.errors.size() < MAX_ERRORS )
+    {
+        operation.errors.push_back( std::move( error ) );
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>       // for array
+#include <atomic>      // for atomic
+#include <chrono>      // for steady_clock
+#include <cstdint>     // for uint64_t
+#include <memory>      // for unique_ptr
+#include <mutex>       // for mutex
+#include <optional>    // for optional
+#include <stop_token>  // for stop_token
+#include <string>      // for string
+#include <thread>      // for jthread
+#include <vector>      // for vector
+
+#include "app/file_copy.hpp"   // for ds::CopyMethod
+#include "app/filesystem.hpp"  // for fs::path
+#include "app/trash.hpp"       // for ds::TrashItem
+#include "tools/singleton.hpp"
+
+// Copy, move, trash and delete the files in background. Each operation copies
+// several files at the same time, and a file is only visible at its
+// destination once it's complete, so a cancelled or failed operation never
+// leaves a partial file.
+class FileOperations : public Singleton< FileOperations >
+{
+    ENABLE_SINGLETON( FileOperations );
+
+  public:
+    enum class Kind
+    {
+        Copy = 0,
+        Move,
+        Delete,
+        // Move to the trash of the filesystem
+        Trash,
+        // Move from the trash back to the original paths
+        Restore
+    };
+
+    // Files copied or cut, waiting to be pasted
+    struct Clipboard
+    {
+        Kind                    kind;
+        std::vector< fs::path > paths;
+    };
+
+  private:
+    // A file, directory or symbolic link of the operation
+    struct Item
+    {
+        fs::path      source;
+        fs::path      destination;
+        fs::file_type type;
+        fs::perms     permissions;
+        uint64_t      size;
+    };
+
+    struct Operation
+    {
+        Kind                    kind;
+        std::vector< fs::path >      sources;
+        fs::path                     destination;
+        // Of a restore, the item of each source
+        std::vector< ds::TrashItem > restoredItems;
+
+        // Written by the threads of the operation
+        std::atomic< uint64_t > nbTotalBytes;
+        std::atomic< uint64_t > nbCopiedBytes;
+        std::atomic< uint64_t > nbTotalFiles;
+        std::atomic< uint64_t > nbDoneFiles;
+        std::array< std::atomic< uint64_t >,
+                    static_cast< std::size_t >( ds::CopyMethod::Count ) >
+                                    nbFilesByMethod;
+        std::atomic< bool >         isDone;
+        mutable std::mutex          errorsMutex;
+        std::vector< std::string >  errors;
+
+        // Only used by the UI thread, to estimate the speed in bytes copied
+        // or entries removed by second
+        std::chrono::steady_clock::time_point lastSampleTime;
+        uint64_t                              lastSampleProgress;
+        double                                speed;
+
+        // Started last, once every other member is initialized
+        std::jthread thread;
+    };
+
+    std::vector< std::unique_ptr< Operation > > m_operations;
+    std::optional< Clipboard >                  m_clipboard;
+    // Incremented when an operation ends, so the showed directories can be
+    // read again
+    uint64_t                                    m_nbFinished;
+
+    FileOperations();
+    virtual ~FileOperations();
+
+  public:
+    void copy ( std::vector< fs::path > paths );
+    void cut ( std::vector< fs::path > paths );
+    // Copy or move the clipboard files in the directory. Cut files are moved
+    // once, copied files can be pasted again.
+    void paste ( fs::path const & directory );
+    bool has_clipboard () const;
+    void trash ( std::vector< fs::path > paths );
+    // Delete the files and directories permanently
+    void remove ( std::vector< fs::path > paths );
+    void restore ( std::vector< ds::TrashItem > items );
+
+    // Start the operation in background
+    void submit ( Kind kind, std::vector< fs::path > sources,
+                  fs::path const & destination );
+    // Stop every operation, the files already copied are kept
+    void cancel_all ();
+
+    uint64_t get_nb_finished () const;
+
+    // Progress of the operations, shown while there is any
+    void update_gui ();
+
+  private:
+    void start ( Kind kind, std::vector< fs::path > sources,
+                 fs::path const &             destination,
+                 std::vector< ds::TrashItem > restoredItems );
+
+    void update_copy_gui ( Operation const & operation,
+                           uint64_t          nbCopied ) const;
+    void update_delete_gui ( Operation const & operation,
+                             uint64_t          nbRemoved ) const;
+
+    void run ( Operation & operation, std::stop_token stopToken );
+    // Add the items to copy for the source, directories before their content
+    void list_items ( Operation & operation, fs::path const & source,
+                      fs::path const & destination,
+                      std::vector< Item > & items ) const;
+    bool copy_file ( Operation & operation, Item const & item,
+                     std::stop_token const & stopToken ) const;
+
+    static void add_error ( Operation & operation, std::string error );
+};
@@ -0,0 +1,469 @@
+#include "file_type.hpp"
+
+#include <array>  // for array, to_array
+
+#include <elf.h>  // for ET_REL, ET_DYN, PT_INTERP, PT_LOAD
+
+#include "tools/perfect_hash.hpp"  // for perfect_hash::Map
+
+namespace ds
+{
+    using namespace std::literals;
+
+    namespace
+    {
+        constexpr FileTypeInfo TEXT         { FileType::Text, Icon::Text };
+        constexpr FileTypeInfo MARKDOWN     { FileType::Text, Icon::Markdown };
+        constexpr FileTypeInfo DOCUMENT     { FileType::Document,
+                                              Icon::Document };
+        constexpr FileTypeInfo SPREADSHEET  { FileType::Spreadsheet,
+                                              Icon::Spreadsheet };
+        constexpr FileTypeInfo PRESENTATION { FileType::Presentation,
+                                              Icon::Presentation };
+        constexpr FileTypeInfo PDF          { FileType::PDF, Icon::PDF };
+        constexpr FileTypeInfo IMAGE        { FileType::Image, Icon::Image };
+        constexpr FileTypeInfo VECTOR_IMAGE { FileType::Image,
+                                              Icon::VectorImage };
+        constexpr FileTypeInfo RAW_IMAGE    { FileType::Image, Icon::RawImage };
+        constexpr FileTypeInfo AUDIO        { FileType::Audio, Icon::Audio };
+        constexpr FileTypeInfo VIDEO        { FileType::Video, Icon::Video };
+        constexpr FileTypeInfo ARCHIVE      { FileType::Archive,
+                                              Icon::Archive };
+        constexpr FileTypeInfo PACKAGE      { FileType::Archive,
+                                              Icon::Package };
+        constexpr FileTypeInfo DISK_IMAGE   { FileType::DiskImage,
+                                              Icon::DiskImage };
+        constexpr FileTypeInfo C            { FileType::SourceCode, Icon::C };
+        constexpr FileTypeInfo CPP          { FileType::SourceCode, Icon::Cpp };
+        constexpr FileTypeInfo HEADER       { FileType::SourceCode,
+                                              Icon::Header };
+        constexpr FileTypeInfo CSHARP       { FileType::SourceCode,
+                                              Icon::CSharp };
+        constexpr FileTypeInfo JAVA         { FileType::SourceCode,
+                                              Icon::Java };
+        constexpr FileTypeInfo PYTHON       { FileType::Script, Icon::Python };
+        constexpr FileTypeInfo JAVASCRIPT   { FileType::Script,
+                                              Icon::JavaScript };
+        constexpr FileTypeInfo TYPESCRIPT   { FileType::Script,
+                                              Icon::TypeScript };
+        constexpr FileTypeInfo RUST         { FileType::SourceCode,
+                                              Icon::Rust };
+        constexpr FileTypeInfo GO           { FileType::SourceCode, Icon::Go };
+        constexpr FileTypeInfo SOURCE       { FileType::SourceCode,
+                                              Icon::Text };
+        constexpr FileTypeInfo SHELL        { FileType::Script, Icon::Shell };
+        constexpr FileTypeInfo SCRIPT       { FileType::Script, Icon::Text };
+        constexpr FileTypeInfo HTML         { FileType::Web, Icon::Html };
+        constexpr FileTypeInfo CSS          { FileType::Web, Icon::Css };
+        constexpr FileTypeInfo JSON         { FileType::Data, Icon::Json };
+        constexpr FileTypeInfo CONFIG       { FileType::Data, Icon::Config };
+        constexpr FileTypeInfo DATABASE     { FileType::Database,
+                                              Icon::Database };
+        constexpr FileTypeInfo FONT         { FileType::Font, Icon::Font };
+        constexpr FileTypeInfo EXECUTABLE   { FileType::Executable,
+                                              Icon::Executable };
+        constexpr FileTypeInfo LIBRARY      { FileType::Library,
+                                              Icon::Library };
+
+        constexpr auto EXTENSION_LIST =
+            std::to_array< perfect_hash::Entry< FileTypeInfo > >( {
+                { "txt", TEXT }, { "text", TEXT }, { "log", TEXT },
+                { "nfo", TEXT }, { "diz", TEXT }, { "me", TEXT },
+                { "1st", TEXT }, { "srt", TEXT }, { "sub", TEXT },
+                { "vtt", TEXT }, { "ass", TEXT },
+                { "md", MARKDOWN }, { "markdown", MARKDOWN },
+                { "mdown", MARKDOWN }, { "rst", MARKDOWN },
+                { "adoc", MARKDOWN }, { "asciidoc", MARKDOWN },
+                { "org", MARKDOWN }, { "tex", MARKDOWN }, { "latex", MARKDOWN },
+                { "bib", MARKDOWN },
+                { "doc", DOCUMENT }, { "docx", DOCUMENT }, { "docm", DOCUMENT },
+                { "dot", DOCUMENT }, { "dotx", DOCUMENT }, { "odt", DOCUMENT },
+                { "ott", DOCUMENT }, { "rtf", DOCUMENT }, { "pages", DOCUMENT },
+                { "wpd", DOCUMENT }, { "wps", DOCUMENT }, { "abw", DOCUMENT },
+                { "epub", DOCUMENT }, { "mobi", DOCUMENT }, { "azw", DOCUMENT },
+                { "azw3", DOCUMENT }, { "djvu", DOCUMENT }, { "fb2", DOCUMENT },
+                { "xps", DOCUMENT },
+                { "xls", SPREADSHEET }, { "xlsx", SPREADSHEET },
+                { "xlsm", SPREADSHEET }, { "xlsb", SPREADSHEET },
+                { "xlt", SPREADSHEET }, { "xltx", SPREADSHEET },
+                { "ods", SPREADSHEET }, { "ots", SPREADSHEET },
+                { "csv", SPREADSHEET }, { "tsv", SPREADSHEET },
+                { "numbers", SPREADSHEET },
+                { "ppt", PRESENTATION }, { "pptx", PRESENTATION },
+                { "pptm", PRESENTATION }, { "pps", PRESENTATION },
+                { "ppsx", PRESENTATION }, { "pot", PRESENTATION },
+                { "potx", PRESENTATION }, { "odp", PRESENTATION },
+                { "otp", PRESENTATION }, { "key", PRESENTATION },
+                { "pdf", PDF }, { "ps", PDF }, { "eps", PDF },
+                { "png", IMAGE }, { "jpg", IMAGE }, { "jpeg", IMAGE },
+                { "jpe", IMAGE }, { "jfif", IMAGE }, { "gif", IMAGE },
+                { "bmp", IMAGE }, { "dib", IMAGE }, { "webp", IMAGE },
+                { "tif", IMAGE }, { "tiff", IMAGE }, { "ico", IMAGE },
+                { "cur", IMAGE }, { "tga", IMAGE }, { "pcx", IMAGE },
+                { "ppm", IMAGE }, { "pgm", IMAGE }, { "pbm", IMAGE },
+                { "pnm", IMAGE }, { "xpm", IMAGE }, { "xbm", IMAGE },
+                { "heic", IMAGE }, { "heif", IMAGE }, { "avif", IMAGE },
+                { "jxl", IMAGE }, { "jp2", IMAGE }, { "j2k", IMAGE },
+                { "qoi", IMAGE }, { "dds", IMAGE }, { "exr", IMAGE },
+                { "hdr", IMAGE }, { "psd", IMAGE }, { "xcf", IMAGE },
+                { "kra", IMAGE }, { "ora", IMAGE },
+                { "svg", VECTOR_IMAGE }, { "svgz", VECTOR_IMAGE },
+                { "ai", VECTOR_IMAGE }, { "cdr", VECTOR_IMAGE },
+                { "wmf", VECTOR_IMAGE }, { "emf", VECTOR_IMAGE },
+                { "raw", RAW_IMAGE }, { "cr2", RAW_IMAGE },
+                { "cr3", RAW_IMAGE }, { "nef", RAW_IMAGE },
+                { "nrw", RAW_IMAGE }, { "arw", RAW_IMAGE },
+                { "srf", RAW_IMAGE }, { "sr2", RAW_IMAGE },
+                { "orf", RAW_IMAGE }, { "rw2", RAW_IMAGE },
+                { "raf", RAW_IMAGE }, { "dng", RAW_IMAGE },
+                { "pef", RAW_IMAGE }, { "srw", RAW_IMAGE },
+                { "x3f", RAW_IMAGE },
+                { "mp3", AUDIO }, { "wav", AUDIO }, { "flac", AUDIO },
+                { "ogg", AUDIO }, { "oga", AUDIO }, { "opus", AUDIO },
+                { "aac", AUDIO }, { "m4a", AUDIO }, { "m4b", AUDIO },
+                { "wma", AUDIO }, { "aif", AUDIO }, { "aiff", AUDIO },
+                { "aifc", AUDIO }, { "alac", AUDIO }, { "ape", AUDIO },
+                { "mid", AUDIO }, { "midi", AUDIO }, { "mka", AUDIO },
+                { "ac3", AUDIO }, { "dts", AUDIO }, { "amr", AUDIO },
+                { "au", AUDIO }, { "snd", AUDIO },
+                { "mp4", VIDEO }, { "m4v", VIDEO }, { "mkv", VIDEO },
+                { "webm", VIDEO }, { "avi", VIDEO }, { "mov", VIDEO },
+                { "qt", VIDEO }, { "wmv", VIDEO }, { "flv", VIDEO },
+                { "f4v", VIDEO }, { "mpg", VIDEO }, { "mpeg", VIDEO },
+                { "mpe", VIDEO }, { "m2v", VIDEO }, { "m2ts", VIDEO },
+                { "mts", VIDEO },
+                { "ts", TYPESCRIPT },
+                { "vob", VIDEO }, { "ogv", VIDEO }, { "3gp", VIDEO },
+                { "3g2", VIDEO }, { "rm", VIDEO }, { "rmvb", VIDEO },
+                { "asf", VIDEO }, { "divx", VIDEO },
+                { "zip", ARCHIVE }, { "rar", ARCHIVE }, { "7z", ARCHIVE },
+                { "tar", ARCHIVE }, { "gz", ARCHIVE }, { "tgz", ARCHIVE },
+                { "bz2", ARCHIVE }, { "tbz", ARCHIVE }, { "tbz2", ARCHIVE },
+                { "xz", ARCHIVE }, { "txz", ARCHIVE }, { "lz", ARCHIVE },
+                { "lzma", ARCHIVE }, { "tlz", ARCHIVE }, { "zst", ARCHIVE },
+                { "tzst", ARCHIVE }, { "lz4", ARCHIVE }, { "z", ARCHIVE },
+                { "cab", ARCHIVE }, { "arj", ARCHIVE }, { "ace", ARCHIVE },
+                { "cpio", ARCHIVE }, { "ar", ARCHIVE },
+                { "deb", PACKAGE }, { "rpm", PACKAGE }, { "apk", PACKAGE },
+                { "jar", PACKAGE }, { "war", PACKAGE }, { "ear", PACKAGE },
+                { "whl", PACKAGE }, { "gem", PACKAGE }, { "crate", PACKAGE },
+                { "snap", PACKAGE }, { "flatpak", PACKAGE },
+                { "appimage", PACKAGE }, { "pkg", PACKAGE }, { "msi", PACKAGE },
+                { "iso", DISK_IMAGE }, { "img", DISK_IMAGE },
+                { "dmg", DISK_IMAGE }, { "vhd", DISK_IMAGE },
+                { "vhdx", DISK_IMAGE }, { "vmdk", DISK_IMAGE },
+                { "qcow", DISK_IMAGE }, { "qcow2", DISK_IMAGE },
+                { "vdi", DISK_IMAGE }, { "toast", DISK_IMAGE },
+                { "c", C }, { "i", C },
+                { "cpp", CPP }, { "cc", CPP }, { "cxx", CPP }, { "c++", CPP },
+                { "cp", CPP }, { "ii", CPP }, { "ixx", CPP }, { "cppm", CPP },
+                { "tpp", CPP }, { "ipp", CPP }, { "inl", CPP },
+                { "h", HEADER }, { "hpp", HEADER }, { "hh", HEADER },
+                { "hxx", HEADER }, { "h++", HEADER },
+                { "cs", CSHARP }, { "csx", CSHARP },
+                { "java", JAVA }, { "kt", JAVA }, { "kts", JAVA },
+                { "scala", JAVA }, { "groovy", JAVA }, { "gradle", JAVA },
+                { "clj", JAVA },
+                { "py", PYTHON }, { "pyw", PYTHON }, { "pyi", PYTHON },
+                { "pyx", PYTHON }, { "pxd", PYTHON }, { "ipynb", PYTHON },
+                { "js", JAVASCRIPT }, { "mjs", JAVASCRIPT },
+                { "cjs", JAVASCRIPT }, { "jsx", JAVASCRIPT },
+                { "tsx", TYPESCRIPT }, { "cts", TYPESCRIPT },
+                { "rs", RUST },
+                { "go", GO },
+                { "swift", SOURCE }, { "m", SOURCE }, { "mm", SOURCE },
+                { "d", SOURCE }, { "zig", SOURCE }, { "nim", SOURCE },
+                { "v", SOURCE }, { "sv", SOURCE }, { "svh", SOURCE },
+                { "f", SOURCE }, { "f90", SOURCE }, { "f95", SOURCE },
+                { "for", SOURCE }, { "pas", SOURCE }, { "pp", SOURCE },
+                { "hs", SOURCE }, { "lhs", SOURCE }, { "ml", SOURCE },
+                { "mli", SOURCE }, { "fs", SOURCE }, { "fsi", SOURCE },
+                { "fsx", SOURCE }, { "ex", SOURCE }, { "exs", SOURCE },
+                { "erl", SOURCE }, { "hrl", SOURCE }, { "elm", SOURCE },
+                { "dart", SOURCE }, { "asm", SOURCE }, { "s", SOURCE },
+                { "sol", SOURCE }, { "cmake", SOURCE }, { "mk", SOURCE },
+                { "sh", SHELL }, { "bash", SHELL }, { "zsh", SHELL },
+                { "fish", SHELL }, { "ksh", SHELL }, { "csh", SHELL },
+                { "tcsh", SHELL }, { "bat", SHELL }, { "cmd", SHELL },
+                { "ps1", SHELL }, { "psm1", SHELL },
+                { "rb", SCRIPT }, { "pl", SCRIPT }, { "pm", SCRIPT },
+                { "php", SCRIPT }, { "lua", SCRIPT }, { "r", SCRIPT },
+                { "tcl", SCRIPT }, { "awk", SCRIPT }, { "sed", SCRIPT },
+                { "vim", SCRIPT }, { "el", SCRIPT }, { "lisp", SCRIPT },
+                { "scm", SCRIPT }, { "rkt", SCRIPT }, { "jl", SCRIPT },
+                { "html", HTML }, { "htm", HTML }, { "xhtml", HTML },
+                { "shtml", HTML }, { "vue", HTML }, { "svelte", HTML },
+                { "astro", HTML }, { "jsp", HTML }, { "asp", HTML },
+                { "aspx", HTML },
+                { "css", CSS }, { "scss", CSS }, { "sass", CSS },
+                { "less", CSS }, { "styl", CSS },
+                { "json", JSON }, { "jsonc", JSON }, { "json5", JSON },
+                { "geojson", JSON }, { "ndjson", JSON },
+                { "xml", CONFIG }, { "yaml", CONFIG }, { "yml", CONFIG },
+                { "toml", CONFIG }, { "ini", CONFIG }, { "cfg", CONFIG },
+                { "conf", CONFIG }, { "config", CONFIG },
+                { "properties", CONFIG }, { "env", CONFIG },
+                { "desktop", CONFIG }, { "service", CONFIG },
+                { "plist", CONFIG }, { "reg", CONFIG }, { "lock", CONFIG },
+                { "db", DATABASE }, { "sqlite", DATABASE },
+                { "sqlite3", DATABASE }, { "db3", DATABASE },
+                { "mdb", DATABASE }, { "accdb", DATABASE }, { "sql", DATABASE },
+                { "dbf", DATABASE }, { "frm", DATABASE }, { "ibd", DATABASE },
+                { "parquet", DATABASE }, { "avro", DATABASE },
+                { "ttf", FONT }, { "otf", FONT }, { "woff", FONT },
+                { "woff2", FONT }, { "eot", FONT }, { "pfb", FONT },
+                { "pfm", FONT }, { "fon", FONT }, { "fnt", FONT },
+                { "exe", EXECUTABLE }, { "com", EXECUTABLE },
+                { "bin", EXECUTABLE }, { "elf", EXECUTABLE },
+                { "run", EXECUTABLE }, { "out", EXECUTABLE },
+                { "app", EXECUTABLE }, { "x86_64", EXECUTABLE },
+                { "so", LIBRARY }, { "dll", LIBRARY }, { "dylib", LIBRARY },
+                { "a", LIBRARY }, { "lib", LIBRARY }, { "o", LIBRARY },
+                { "obj", LIBRARY }, { "ko", LIBRARY }, { "pyc", LIBRARY },
+                { "pyd", LIBRARY }, { "class", LIBRARY }, { "wasm", LIBRARY }
+            } );
+
+        // Lowercase extensions, without the leading dot
+        constexpr perfect_hash::Map< FileTypeInfo, EXTENSION_LIST.size() >
+            EXTENSIONS { EXTENSION_LIST };
+
+        // Longer than every extension of the table
+        constexpr std::size_t MAX_EXTENSION_SIZE { 16 };
+
+        constexpr std::array< std::string_view,
+                              static_cast< std::size_t >( FileType::Count ) >
+            FILE_TYPE_NAMES { "Directory",   "Text",       "Document",
+                              "Spreadsheet", "Presentation", "PDF",
+                              "Image",       "Audio",      "Video",
+                              "Archive",     "Disk Image", "Source Code",
+                              "Script",      "Web",        "Data",
+                              "Database",    "Font",       "Executable",
+                              "Library",     "Others" };
+
+        // Unsigned integer of the header, in the endianness of the file
+        uint64_t read_elf_value ( std::string_view header, std::size_t offset,
+                                  std::size_t size )
+        {
+            uint64_t value { 0 };
+            for ( std::size_t idx = 0; idx < size; ++idx )
+            {
+                std::size_t byte = header[EI_DATA] == ELFDATA2MSB
+                                       ? offset + idx
+                                       : offset + size - 1 - idx;
+                value = value << 8
+                        | static_cast< unsigned char >( header[byte] );
+            }
+            return value;
+        }
+
+        // Position independent executables are shared objects too, but they
+        // ask for an interpreter, the dynamic loader. Its program header must
+        // precede the loadable segments, so it's found in the first ones.
+        // Nullopt if they aren't in the header read.
+        std::optional< bool > has_interpreter ( std::string_view header )
+        {
+            bool        is64Bits = header[EI_CLASS] == ELFCLASS64;
+            std::size_t headerSize =
+                is64Bits ? sizeof( Elf64_Ehdr ) : sizeof( Elf32_Ehdr );
+            if ( header.size() < headerSize )
+            {
+                return std::nullopt;
+            }
+            // e_phoff, e_phentsize and e_phnum
+            uint64_t offset    = is64Bits ? read_elf_value( header, 32, 8 )
+                                          : read_elf_value( header, 28, 4 );
+            uint64_t entrySize =
+                read_elf_value( header, is64Bits ? 54 : 42, 2 );
+            uint64_t nbEntries =
+                read_elf_value( header, is64Bits ? 56 : 44, 2 );
+            // p_type is the first field of an entry
+            if ( entrySize < 4 || offset > header.size() )
+            {
+                return std::nullopt;
+            }
+            for ( uint64_t idx = 0;
+                  idx < nbEntries
+                  && offset + ( idx + 1 ) * entrySize <= header.size();
+                  ++idx )
+            {
+                switch ( read_elf_value( header, offset + idx * entrySize, 4 ) )
+                {
+                case PT_INTERP :
+                    return true;
+                case PT_LOAD :
+                    return false;
+                default :
+                    break;
+                }
+            }
+            return std::nullopt;
+        }
+
+        FileTypeInfo get_elf_type ( std::string_view header, bool isExecutable )
+        {
+            if ( header.size() < EI_NIDENT + 2 )
+            {
+                return EXECUTABLE;
+            }
+
+            switch ( read_elf_value( header, EI_NIDENT, 2 ) )
+            {
+            case ET_REL :
+                return LIBRARY;
+            case ET_DYN :
+                // The shared libraries may have the execution right too, it's
+                // only used if the program headers are too far
+                return has_interpreter( header ).value_or( isExecutable )
+                           ? EXECUTABLE
+                           : LIBRARY;
+            default :
+                return EXECUTABLE;
+            }
+        }
+
+        FileTypeInfo get_script_type ( std::string_view header )
+        {
+            // "#!/usr/bin/env -S python3 -u" gives "python3"
+            std::string_view line = header.substr( 2 );
+            line = line.substr( 0, line.find( '\n' ) );
+            std::string_view interpreter {};
+            while ( ! line.empty() )
+            {
+                std::size_t start = line.find_first_not_of( " \t" );
+                if ( start == std::string_view::npos )
+                {
+                    break;
+                }
+                line             = line.substr( start );
+                std::size_t size = line.find_first_of( " \t\r\n" );
+                std::string_view token = line.substr( 0, size );
+                line = size == std::string_view::npos ? std::string_view {}
+                                                      : line.substr( size );
+
+                token = token.substr( token.find_last_of( '/' ) + 1 );
+                if ( token != "env" && ! token.starts_with( '-' ) )
+                {
+                    interpreter = token;
+                    break;
+                }
+            }
+
+            if ( interpreter.starts_with( "python" ) )
+            {
+                return PYTHON;
+            }
+            if ( interpreter == "node" || interpreter == "deno" )
+            {
+                return JAVASCRIPT;
+            }
+            for ( std::string_view shell :
+                  { "sh"sv, "bash"sv, "dash"sv, "zsh"sv, "ksh"sv, "fish"sv } )
+            {
+                if ( interpreter == shell )
+                {
+                    return SHELL;
+                }
+            }
+            return SCRIPT;
+        }
+    }  // namespace
+
+    FileTypeInfo get_file_type ( std::string_view filename )
+    {
+        constexpr FileTypeInfo others { FileType::Others, Icon::File };
+
+        // Same rules as fs::path::extension(), hidden files like ".bashrc"
+        // have no extension
+        std::size_t dotPosition = filename.find_last_of( '.' );
+        if ( dotPosition == std::string_view::npos || dotPosition == 0
+             || filename == ".." )
+        {
+            return others;
+        }
+
+        std::string_view extension = filename.substr( dotPosition + 1 );
+        if ( extension.empty() || extension.size() > MAX_EXTENSION_SIZE )
+        {
+            return others;
+        }
+
+        std::array< char, MAX_EXTENSION_SIZE > lowercase {};
+        for ( std::size_t idx = 0; idx < extension.size(); ++idx )
+        {
+            char character = extension[idx];
+            lowercase[idx] = character >= 'A' && character <= 'Z'
+                                 ? static_cast< char >( character - 'A' + 'a' )
+                                 : character;
+        }
+
+        FileTypeInfo const * info = EXTENSIONS.find(
+            std::string_view { lowercase.data(), extension.size() } );
+        return info ? *info : others;
+    }
+
+    std::optional< FileTypeInfo > get_content_type ( std::string_view header,
+                                                     bool isExecutable )
+    {
+        if ( header.starts_with( "\x7f" "ELF"sv ) )
+        {
+            return get_elf_type( header, isExecutable );
+        }
+        if ( header.starts_with( "#!"sv ) )
+        {
+            return get_script_type( header );
+        }
+        if ( header.starts_with( "\x89PNG\r\n\x1a\n"sv )
+             || header.starts_with( "\xff\xd8\xff"sv )
+             || header.starts_with( "GIF87a"sv )
+             || header.starts_with( "GIF89a"sv )
+             || ( header.starts_with( "RIFF"sv ) && header.size() >= 12
+                  && header.substr( 8, 4 ) == "WEBP"sv ) )
+        {
+            return IMAGE;
+        }
+        if ( header.starts_with( "%PDF-"sv ) )
+        {
+            return PDF;
+        }
+        if ( header.starts_with( "\x1f\x8b"sv )
+             || header.starts_with( "PK\x03\x04"sv )
+             || header.starts_with( "PK\x05\x06"sv )
+             || header.starts_with( "\xfd" "7zXZ\0"sv )
+             || header.starts_with( "BZh"sv )
+             || header.starts_with( "7z\xbc\xaf\x27\x1c"sv )
+             || header.starts_with( "\x28\xb5\x2f\xfd"sv ) )
+        {
+            return ARCHIVE;
+        }
+        return std::nullopt;
+    }
+
+    FileTypeInfo resolve_type ( FileTypeInfo                  extensionType,
+                                std::optional< FileTypeInfo > contentType )
+    {
+        if ( ! contentType.has_value() )
+        {
+            return extensionType;
+        }
+        switch ( extensionType.type )
+        {
+        case FileType::Others :
+            return *contentType;
+        // Every known signature but the shebang is binary
+        case FileType::Text :
+        case FileType::SourceCode :
+        case FileType::Script :
+        case FileType::Web :
+        case FileType::Data :
+            return contentType->type == FileType::Script ? extensionType
+                                                         : *contentType;
+        default :
+            return extensionType;
+        }
+    }
+
+    std::string_view to_string ( FileType type )
+    {
+        return FILE_TYPE_NAMES[static_cast< std::size_t >( type )];
+    }
+}  // namespace ds
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>      // for uint8_t
+#include <optional>     // for optional
+#include <string_view>  // for string_view
+
+namespace ds
+{
+    enum class FileType : uint8_t
+    {
+        Directory = 0,
+        Text,
+        Document,
+        Spreadsheet,
+        Presentation,
+        PDF,
+        Image,
+        Audio,
+        Video,
+        Archive,
+        DiskImage,
+        SourceCode,
+        Script,
+        Web,
+        Data,
+        Database,
+        Font,
+        Executable,
+        Library,
+        Others,
+        Count
+    };
+
+    // Index of the icon showed next to the entry
+    enum class Icon : uint8_t
+    {
+        Folder = 0,
+        File,
+        Text,
+        Markdown,
+        Document,
+        Spreadsheet,
+        Presentation,
+        PDF,
+        Image,
+        VectorImage,
+        RawImage,
+        Audio,
+        Video,
+        Archive,
+        Package,
+        DiskImage,
+        C,
+        Cpp,
+        Header,
+        CSharp,
+        Java,
+        Python,
+        JavaScript,
+        TypeScript,
+        Rust,
+        Go,
+        Shell,
+        Html,
+        Css,
+        Json,
+        Config,
+        Database,
+        Font,
+        Executable,
+        Library,
+        Count
+    };
+
+    struct FileTypeInfo
+    {
+        FileType type;
+        Icon     icon;
+    };
+
+    // Doesn't allocate, the extension is matched case insensitively
+    FileTypeInfo                  get_file_type ( std::string_view filename );
+    // Type recognized from the magic number at the start of the file content,
+    // nullopt if there's no known signature
+    std::optional< FileTypeInfo > get_content_type ( std::string_view header,
+                                                     bool isExecutable );
+    // The type of the extension, unless it's unknown or the content
+    // contradicts it, like binary data with a text extension. The formats
+    // built on a container, like a .docx being a zip, keep their type.
+    FileTypeInfo                  resolve_type (
+        FileTypeInfo extensionType, std::optional< FileTypeInfo > contentType );
+    std::string_view              to_string ( FileType type );
+}  // namespace ds
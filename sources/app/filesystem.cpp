@@ -6,72 +6,122 @@
 #include <fmt/core.h>
 #include <imgui/imgui.h>
 
+#include "app/perf_counters.hpp"  // for PerfCounters
+#include "app/vfs.hpp"            // for vfs::get_file_system
+#include "tools/string.hpp"       // for string::to_lowercase
 #include "tools/traces.hpp"
+#include "tools/tracing.hpp"      // for TRACE_SPAN
+
+namespace
+{
+    // Of the entry itself, stat only if the directory doesn't give it
+    vfs::FileKind get_kind ( vfs::FileSystem & fileSystem,
+                             fs::path const & path,
+                             vfs::DirectoryEntry const & entry )
+    {
+        if ( entry.kind != vfs::FileKind::Unknown )
+        {
+            return entry.kind;
+        }
+        std::error_code error {};
+        vfs::Status     status = fileSystem.symlink_status( path, error );
+        return error ? vfs::FileKind::Unknown : status.kind;
+    }
+}  // namespace
 
 namespace ds
 {
+    std::size_t FileKeyHash::operator() ( FileKey const & key ) const
+    {
+        std::size_t hash = std::hash< uint64_t > {}( key.inode );
+        hash ^= std::hash< uint64_t > {}( key.device ) + 0x9e3779b9
+                + ( hash << 6 ) + ( hash >> 2 );
+        hash ^= std::hash< int64_t > {}( key.modificationTime ) + 0x9e3779b9
+                + ( hash << 6 ) + ( hash >> 2 );
+        return hash;
+    }
+
     fs::path get_home_directory ()
     {
         return fs::path( std::getenv( "HOME" ) );
     }
 
-    bool is_showed_gui ( fs::directory_entry entry )
+    bool get_file_key ( fs::path const & path, FileKey & key )
     {
-        return entry.is_regular_file() || entry.is_directory()
-               || entry.is_symlink();
+        std::error_code error {};
+        vfs::Status     status = vfs::get_file_system().status( path, error );
+        if ( error )
+        {
+            return false;
+        }
+
+        key.device           = status.device;
+        key.inode            = status.inode;
+        key.modificationTime = status.modificationTime;
+        return true;
     }
 
-    bool is_hidden ( fs::directory_entry entry )
+    bool is_hidden ( std::string_view name )
     {
-        return entry.path().filename().string().find( '.' ) == 0;
+        return name.starts_with( '.' );
     }
 
-    std::string get_type ( fs::directory_entry entry )
+    FileTypeInfo get_type ( std::string_view name, bool isDirectory )
     {
-        std::string extension { entry.path().extension().string() };
-
-        if ( extension == "txt" )
-        {
-            return "Text";
-        }
-        else if ( extension == "pdf" )
-        {
-            return "PDF";
-        }
-        else if ( extension == "jpg" || extension == "jpeg"
-                  || extension == "png" )
-        {
-            return "Image";
-        }
-        else
+        if ( isDirectory )
         {
-            return "Others";
+            return FileTypeInfo { FileType::Directory, Icon::Folder };
         }
+
+        return get_file_type( name );
     }
 
     // ! Takes too much time (maybe use a thread)
-    uintmax_t get_folder_size ( fs::path folder )
+    uintmax_t get_folder_size ( fs::path const & folder )
     {
-        uintmax_t size = 0;
+        PerfCounters::Region perfRegion { "ds::get_folder_size" };
+        vfs::FileSystem & fileSystem = vfs::get_file_system();
+        uintmax_t         size       = 0;
 
-        for ( const auto & entry : fs::recursive_directory_iterator( folder ) )
+        std::vector< fs::path > pending { folder };
+        while ( ! pending.empty() )
         {
-            if ( entry.is_regular_file() )
+            fs::path directory { std::move( pending.back() ) };
+            pending.pop_back();
+            std::error_code error {};
+            for ( vfs::DirectoryEntry const & entry :
+                  fileSystem.enumerate( directory, error ) )
             {
-                size += entry.file_size();
+                fs::path        path { directory / entry.name };
+                vfs::FileKind   kind = get_kind( fileSystem, path, entry );
+                if ( kind == vfs::FileKind::Directory )
+                {
+                    pending.push_back( std::move( path ) );
+                    continue;
+                }
+                // The links to files are counted, not the ones to directories
+                vfs::Status status = fileSystem.status( path, error );
+                if ( ! error && status.kind == vfs::FileKind::Regular )
+                {
+                    size += status.size;
+                }
             }
         }
 
         return size;
     }
 
-    unsigned int get_nb_files ( fs::path folder )
+    unsigned int get_nb_files ( fs::path const & folder,
+                                std::error_code & error )
     {
-        unsigned int nbFiles = 0;
+        vfs::FileSystem & fileSystem = vfs::get_file_system();
+        unsigned int      nbFiles    = 0;
 
-        for ( const auto & entry : fs::directory_iterator( folder ) )
+        for ( vfs::DirectoryEntry const & entry :
+              fileSystem.enumerate( folder, error ) )
         {
-            if ( ! entry.is_symlink() && entry.is_regular_file() )
+            if ( get_kind( fileSystem, folder / entry.name, entry )
+                 == vfs::FileKind::Regular )
             {
                 ++nbFiles;
             }
@@ -80,30 +130,17 @@ namespace ds
         return nbFiles;
     }
 
-    uintmax_t get_size ( fs::directory_entry entry )
-    {
-        if ( entry.is_directory() )
-        {
-            Trace::Warning( "get_size() not implemented for directories" );
-            return 0;
-        }
-
-        return entry.file_size();
-    }
-
-    std::string get_size_pretty_print ( fs::directory_entry entry )
+    std::string get_size_pretty_print ( uintmax_t size, bool isDirectory )
     {
-        if ( entry.is_directory() )
+        if ( isDirectory )
         {
-            return fmt::format( "{} files", ds::get_nb_files( entry.path() ) );
+            return fmt::format( "{} files", size );
         }
 
         static std::vector< std::string > units { "B",  "KB", "MB", "GB", "TB",
                                                   "PB", "EB", "ZB", "YB" };
 
         // return the size in Ko, Mo, Go, etc ...
-        uintmax_t size = get_size( entry );
-
         unsigned int unitIndex = 0;
         while ( size >= 1024.0 && unitIndex < units.size() )
         {
@@ -114,6 +151,112 @@ namespace ds
         return fmt::format( "{} {}", size, units[unitIndex] );
     }
 
+    std::shared_ptr< Listing const > scan_directory (
+        fs::path const & directory, bool showHidden, std::stop_token stopToken )
+    {
+        TRACE_SPAN( "ds::scan_directory" );
+        PerfCounters::Region perfRegion { "ds::scan_directory" };
+        vfs::FileSystem & fileSystem = vfs::get_file_system();
+
+        auto listing        = std::make_shared< Listing >();
+        listing->directory  = directory;
+        listing->showHidden = showHidden;
+
+        // The write time is taken before reading the entries, so a change
+        // made during the scan will invalidate the listing
+        std::error_code error {};
+        listing->lastWriteTime =
+            fileSystem.status( directory, error ).modificationTime;
+        std::vector< vfs::DirectoryEntry > entries {};
+        if ( ! error )
+        {
+            entries = fileSystem.enumerate( directory, error );
+        }
+        if ( error )
+        {
+            Trace::Error( "Can't read directory {}: {}", directory.c_str(),
+                          error.message() );
+            return nullptr;
+        }
+
+        listing->entries.reserve( entries.size() );
+        for ( vfs::DirectoryEntry const & entry : entries )
+        {
+            if ( stopToken.stop_requested() )
+            {
+                return nullptr;
+            }
+
+            // Checked before the entry is stat
+            if ( ! showHidden && is_hidden( entry.name ) )
+            {
+                continue;
+            }
+            fs::path      path { directory / entry.name };
+            vfs::FileKind kind = get_kind( fileSystem, path, entry );
+            // Devices, sockets, pipes, and the entries removed since
+            if ( kind != vfs::FileKind::Regular
+                 && kind != vfs::FileKind::Directory
+                 && kind != vfs::FileKind::Symlink )
+            {
+                continue;
+            }
+
+            // The symbolic links are showed as their target
+            vfs::Status status = fileSystem.status( path, error );
+
+            Entry row {};
+            row.isDirectory =
+                ! error && status.kind == vfs::FileKind::Directory;
+            FileTypeInfo typeInfo = get_type( entry.name, row.isDirectory );
+            row.path              = std::move( path );
+            row.name              = entry.name;
+            row.type              = typeInfo.type;
+            row.icon              = typeInfo.icon;
+            if ( ! error )
+            {
+                row.key = FileKey { status.device, status.inode,
+                                    status.modificationTime };
+                row.sizeValue = row.isDirectory
+                                    ? get_nb_files( row.path, error )
+                                    : status.size;
+            }
+            // Broken symlinks or entries removed during the scan
+            row.size = error ? "N/A"
+                             : get_size_pretty_print( row.sizeValue,
+                                                      row.isDirectory );
+            listing->entries.push_back( std::move( row ) );
+        }
+
+        return listing;
+    }
+
+    std::vector< fs::path > filter_entries ( fs::path const &    directory,
+                                             std::string const & filter,
+                                             bool                showHidden )
+    {
+        TRACE_SPAN( "ds::filter_entries" );
+        std::vector< fs::path > entries {};
+
+        std::error_code error {};
+        std::string     lowercaseFilter { string::to_lowercase( filter ) };
+        for ( vfs::DirectoryEntry const & entry :
+              vfs::get_file_system().enumerate( directory, error ) )
+        {
+            if ( ! showHidden && is_hidden( entry.name ) )
+            {
+                continue;
+            }
+
+            if ( string::to_lowercase( entry.name ).find( lowercaseFilter )
+                 != std::string::npos )
+            {
+                entries.push_back( directory / entry.name );
+            }
+        }
+        return entries;
+    }
+
     std::string get_open_command ()
     {
         std::string command;
@@ -1,22 +1,87 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>        // for shared_ptr
+#include <stop_token>    // for stop_token
+#include <string>
+#include <string_view>   // for string_view
+#include <system_error>  // for error_code
+#include <vector>
+
+#include "app/file_type.hpp"  // for ds::FileType, ds::Icon
 
 namespace fs = std::filesystem;
 
 // Data Storage
 namespace ds
 {
+    // Identify a version of a file, it changes when the file is modified
+    struct FileKey
+    {
+        uint64_t device;
+        uint64_t inode;
+        // In nanoseconds since epoch
+        int64_t  modificationTime;
+
+        bool operator== ( FileKey const & ) const = default;
+    };
+
+    struct FileKeyHash
+    {
+        std::size_t operator() ( FileKey const & key ) const;
+    };
+
+    struct Entry
+    {
+        fs::path    path;
+        std::string name;
+        std::string size;
+        // Converted to a string only when it's showed
+        FileType    type;
+        Icon        icon;
+        bool        isDirectory;
+        // Number of files for a directory, number of bytes otherwise
+        uintmax_t   sizeValue;
+        FileKey     key;
+    };
+
+    // Content of a directory at a given time, shared between the folder
+    // navigators and the listing cache
+    struct Listing
+    {
+        fs::path             directory;
+        // Of the directory, in nanoseconds since epoch
+        int64_t              lastWriteTime;
+        bool                 showHidden;
+        std::vector< Entry > entries;
+    };
+
     fs::path get_home_directory ();
 
-    bool is_showed_gui ( fs::directory_entry entry );
-    bool is_hidden ( fs::directory_entry entry );
+    // Return false if the file can't be stat
+    bool get_file_key ( fs::path const & path, FileKey & key );
+
+    bool is_hidden ( std::string_view name );
+
+    FileTypeInfo get_type ( std::string_view name, bool isDirectory );
+
+    uintmax_t    get_folder_size ( fs::path const & folder );
+    // Regular files of the folder, the symbolic links aren't counted
+    unsigned int get_nb_files ( fs::path const & folder,
+                                std::error_code & error );
+    std::string  get_size_pretty_print ( uintmax_t size, bool isDirectory );
 
-    std::string get_type ( fs::directory_entry entry );
+    // Read the entries of the directory that should be showed, returns nullptr
+    // if the directory can't be read or if a stop has been requested
+    std::shared_ptr< Listing const > scan_directory (
+        fs::path const & directory, bool showHidden,
+        std::stop_token stopToken = {} );
 
-    uintmax_t   get_folder_size ( fs::path folder );
-    uintmax_t   get_size ( fs::directory_entry entry );
-    std::string get_size_pretty_print ( fs::directory_entry entry );
+    // Paths of the entries whose name contains the filter, ignoring the case.
+    // Nothing if the directory can't be read.
+    std::vector< fs::path > filter_entries ( fs::path const &    directory,
+                                             std::string const & filter,
+                                             bool                showHidden );
 
     std::string get_open_command ();
     // Open entry with default application
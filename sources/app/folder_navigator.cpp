@@ -1,91 +1,524 @@
 #include "folder_navigator.hpp"
 
-#include <optional>  // for optional
+#include <algorithm>  // for sort, lexicographical_compare
+#include <cctype>     // for tolower
+#include <cmath>      // for floor
+#include <numeric>    // for iota
+#include <optional>   // for optional
 
-#include <fmt/format.h>   // for format
-#include <imgui/imgui.h>  // for ImGui::Text, ImGui::Begin, ImGui::End
+#include <fmt/format.h>            // for format
+#include <imgui/imgui.h>           // for ImGui::Text, ImGui::Begin, ImGui::End
+#include <imgui/imgui_internal.h>  // for ImGui::TableSetColumnSortDirection
 
+#include "app/content_sniffer.hpp"    // for ContentSniffer
 #include "app/explorer_settings.hpp"  // for ExplorerSettings
+#include "app/file_icons.hpp"         // for FileIcons
+#include "app/file_operations.hpp"    // for FileOperations
+#include "app/hex_viewer.hpp"         // for HexViewer
+#include "app/image_metadata.hpp"     // for ImageMetadata
+#include "app/job_scheduler.hpp"      // for JobScheduler
+#include "app/listing_cache.hpp"      // for ListingCache
+#include "app/mount_guard.hpp"        // for MountGuard
+#include "app/perf_counters.hpp"      // for PerfCounters
+#include "app/prefetcher.hpp"         // for Prefetcher
+#include "app/text_preview.hpp"       // for TextPreview
+#include "app/thumbnails.hpp"         // for Thumbnails
+#include "app/vfs.hpp"                // for vfs::get_file_system
 #include "tools/traces.hpp"           // for Trace
+#include "tools/tracing.hpp"          // for TRACE_SPAN
+
+namespace
+{
+    // Part of the width taken by the folder content when the preview is
+    // showed
+    constexpr float PREVIEW_SPLIT { 0.6f };
+
+    // Draw list channels of the grid
+    constexpr int TEXT_CHANNEL { 0 };
+    constexpr int IMAGE_CHANNEL { 1 };
+    constexpr int NB_CHANNELS { 2 };
+
+    // A directory written all the time isn't read again on every frame
+    constexpr std::chrono::milliseconds WATCH_REFRESH_DELAY { 500 };
+
+    // Cut the end of the text to fit the width, instead of clipping it which
+    // would need a draw call
+    std::string fit_text ( std::string const & text, float maxWidth )
+    {
+        if ( ImGui::CalcTextSize( text.c_str() ).x <= maxWidth )
+        {
+            return text;
+        }
+
+        constexpr std::string_view ELLIPSIS { "..." };
+        float ellipsisWidth = ImGui::CalcTextSize( ELLIPSIS.data() ).x;
+        // Longest prefix fitting with the ellipsis
+        std::size_t minSize = 0;
+        std::size_t maxSize = text.size();
+        while ( minSize < maxSize )
+        {
+            std::size_t size = ( minSize + maxSize + 1 ) / 2;
+            float       width =
+                ImGui::CalcTextSize( text.c_str(), text.c_str() + size ).x;
+            if ( width + ellipsisWidth <= maxWidth )
+            {
+                minSize = size;
+            }
+            else
+            {
+                maxSize = size - 1;
+            }
+        }
+        // Don't cut a multibyte character in the middle
+        while ( minSize > 0 && ( text[minSize] & 0xC0 ) == 0x80 )
+        {
+            --minSize;
+        }
+        return text.substr( 0, minSize ) + std::string { ELLIPSIS };
+    }
+
+    bool is_less_case_insensitive ( std::string const & lhs,
+                                    std::string const & rhs )
+    {
+        return std::lexicographical_compare(
+            lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+            [] ( unsigned char lhsChar, unsigned char rhsChar ) {
+                return std::tolower( lhsChar ) < std::tolower( rhsChar );
+            } );
+    }
+
+    bool is_less ( ds::Entry const & lhs, ds::Entry const & rhs,
+                   FolderNavigator::Column column )
+    {
+        switch ( column )
+        {
+        case FolderNavigator::Column::Size :
+            // Directories sizes are a number of files, keep them apart
+            if ( lhs.isDirectory != rhs.isDirectory )
+            {
+                return lhs.isDirectory;
+            }
+            if ( lhs.sizeValue != rhs.sizeValue )
+            {
+                return lhs.sizeValue < rhs.sizeValue;
+            }
+            break;
+        case FolderNavigator::Column::Type :
+            if ( lhs.type != rhs.type )
+            {
+                return lhs.type < rhs.type;
+            }
+            break;
+        case FolderNavigator::Column::Name :
+        case FolderNavigator::Column::Dimensions :
+            break;
+        }
+        return is_less_case_insensitive( lhs.name, rhs.name );
+    }
+}  // namespace
 
 FolderNavigator::FolderNavigator( fs::path const & baseDirectory )
   : m_currentDirectory { baseDirectory },
     m_searchBox { m_currentDirectory },
-    m_previousDirectories {},
-    m_nextDirectories {},
-    m_structure {},
-    // todo have a subclass that handle the number of columns and columns names
-    m_nbColumns { 4 }
+    m_previousDirectories { Settings::get_instance().maxHistorySize },
+    m_nextDirectories { Settings::get_instance().maxHistorySize },
+    m_listing { nullptr },
+    m_rowOrder {},
+    m_isWaitingListing { false },
+    m_selection {},
+    m_sortOrder { Column::Name, true },
+    m_viewMode { ViewMode::List },
+    m_scrollY { 0.f },
+    m_pendingScrollY { std::nullopt },
+    m_isSortOrderPending { false },
+    m_preview { nullptr },
+    m_hexViewer { nullptr },
+    m_nbFinishedOperations { FileOperations::get_instance().get_nb_finished() },
+    m_watch { nullptr },
+    m_isChanged { nullptr },
+    m_lastRefresh {}
 {
-    this->refresh();
+    this->set_current_dir( baseDirectory );
 }
 
 void FolderNavigator::update_gui()
 {
+    uint64_t nbFinished { FileOperations::get_instance().get_nb_finished() };
+    if ( nbFinished != m_nbFinishedOperations )
+    {
+        m_nbFinishedOperations = nbFinished;
+        this->refresh();
+    }
+    if ( std::chrono::steady_clock::now() - m_lastRefresh >= WATCH_REFRESH_DELAY
+         && m_isChanged->exchange( false ) )
+    {
+        this->refresh();
+    }
+    if ( m_isWaitingListing )
+    {
+        this->update_waiting_listing();
+    }
+    if ( ! MountGuard::get_instance().is_responding( m_currentDirectory ) )
+    {
+        ImGui::TextColored(
+            ImVec4 { 1.f, 0.6f, 0.2f, 1.f },
+            "%s is not responding, the directory is showed once it answers",
+            MountGuard::get_instance()
+                .get_mount_point( m_currentDirectory )
+                .string()
+                .c_str() );
+    }
+
+    bool isPreviewShowed { m_preview && Settings::get_instance().showPreview };
+    if ( isPreviewShowed )
+    {
+        ImGui::BeginChild( "Folder Content",
+                           ImVec2 { ImGui::GetContentRegionAvail().x
+                                        * PREVIEW_SPLIT,
+                                    0.f } );
+    }
+
+    std::optional< fs::path > selectedEntry = m_viewMode == ViewMode::Grid
+                                                  ? this->update_grid()
+                                                  : this->update_table();
+
+    if ( isPreviewShowed )
+    {
+        ImGui::EndChild();
+        ImGui::SameLine();
+        if ( ImGui::BeginChild( "Preview" ) )
+        {
+            m_preview->update_gui();
+        }
+        ImGui::EndChild();
+    }
+    this->update_hex_viewer();
+
+    // Open the selected entry after the loop because we can't modify the
+    // listing while iterating over it
+    if ( selectedEntry.has_value() )
+    {
+        this->open_entry( selectedEntry.value() );
+    }
+}
+
+std::optional< fs::path > FolderNavigator::update_table()
+{
+    std::optional< fs::path > selectedEntry { std::nullopt };
+
     ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable
-                            | ImGuiTableFlags_NoBordersInBodyUntilResize;
+                            | ImGuiTableFlags_NoBordersInBodyUntilResize
+                            | ImGuiTableFlags_Sortable
+                            | ImGuiTableFlags_ScrollY;
 
     ImGui::PushStyleVar( ImGuiStyleVar_CellPadding, ImVec2 { 0.f, 10.f } );
-    if ( ImGui::BeginTable( "Filesystem Item List", 3, flags ) )
+    if ( ImGui::BeginTable( "Filesystem Item List", 4, flags ) )
     {
+        ImGui::TableSetupScrollFreeze( 0, 1 );
         ImGui::TableSetupColumn( "Name", ImGuiTableColumnFlags_WidthStretch );
         ImGui::TableSetupColumn( "Size", ImGuiTableColumnFlags_WidthFixed );
         ImGui::TableSetupColumn( "Type", ImGuiTableColumnFlags_WidthFixed );
+        // Only known for the images already read, so not sortable
+        ImGui::TableSetupColumn( "Dimensions",
+                                 ImGuiTableColumnFlags_WidthFixed
+                                     | ImGuiTableColumnFlags_NoSort );
         ImGui::TableHeadersRow();
 
+        if ( m_isSortOrderPending )
+        {
+            ImGui::TableSetColumnSortDirection(
+                static_cast< int >( m_sortOrder.column ),
+                m_sortOrder.isAscending ? ImGuiSortDirection_Ascending
+                                        : ImGuiSortDirection_Descending,
+                false );
+            m_isSortOrderPending = false;
+        }
+        ImGuiTableSortSpecs * sortSpecs = ImGui::TableGetSortSpecs();
+        if ( sortSpecs && sortSpecs->SpecsDirty && sortSpecs->SpecsCount > 0 )
+        {
+            m_sortOrder = SortOrder {
+                static_cast< Column >( sortSpecs->Specs[0].ColumnIndex ),
+                sortSpecs->Specs[0].SortDirection
+                    == ImGuiSortDirection_Ascending };
+            this->sort_rows();
+            sortSpecs->SpecsDirty = false;
+        }
+
         // Trace::Debug( fmt::format( "Table Size: {} {}",
         //                            m_currentDirectory.string(),
         //                            m_table.size() ) );
 
-        std::optional< fs::path > selectedEntry { std::nullopt };
-
-        std::size_t idxRow = 0;
-        for ( auto const & row : this->get_structure() )
+        // Only the visible rows are submitted
+        ImGuiListClipper clipper {};
+        clipper.Begin( static_cast< int >( m_rowOrder.size() ) );
+        while ( clipper.Step() )
         {
-            // Trace::Debug( fmt::format( "Current row: {}", idxRow ) );
-            ImGui::TableNextRow( ImGuiTableRowFlags_None );
-
-            std::size_t idxColumn = 0;
-            for ( std::string const & cell : row )
+            for ( int idxVisible = clipper.DisplayStart;
+                  idxVisible < clipper.DisplayEnd; ++idxVisible )
             {
-                if ( idxColumn == 0 )
+                std::size_t       idxRow = m_rowOrder[idxVisible];
+                ds::Entry const & entry  = this->get_listing().entries[idxRow];
+                // Upgraded once the content of the file has been read
+                ds::FileTypeInfo typeInfo =
+                    ContentSniffer::get_instance().get_type( entry );
+                std::optional< ds::ImageHeader > imageHeader =
+                    ImageMetadata::get_instance().get_header( entry, typeInfo );
+                std::string dimensions {
+                    imageHeader.has_value()
+                        ? fmt::format( "{} x {}", imageHeader->width,
+                                       imageHeader->height )
+                        : "" };
+                // Trace::Debug( fmt::format( "Current row: {}", idxRow ) );
+                ImGui::TableNextRow( ImGuiTableRowFlags_None );
+
+                std::size_t idxColumn = 0;
+                for ( std::string_view cell :
+                      { std::string_view { entry.name },
+                        std::string_view { entry.size },
+                        ds::to_string( typeInfo.type ),
+                        std::string_view { dimensions } } )
                 {
+                    ImGui::TableSetColumnIndex( idxColumn );
+
+                    ImGuiSelectableFlags selectable_flags =
+                        ImGuiSelectableFlags_SpanAllColumns;
+                    // | ImGuiSelectableFlags_AllowItemOverlap;
+                    bool        isSelected { entry.path == m_selection };
+                    std::string id { fmt::format( "{}##Cell{}-{}", cell,
+                                                  idxColumn, idxRow ) };
+                    if ( ImGui::Selectable( id.c_str(), &isSelected,
+                                            selectable_flags,
+                                            ImVec2 { 0, 50.f } ) )
+                    {
+                        this->select( entry, typeInfo );
+                    }
+
+                    if ( ImGui::IsItemHovered() && entry.isDirectory )
+                    {
+                        Prefetcher::get_instance().request( entry.path );
+                    }
+                    if ( ImGui::IsItemHovered()
+                         && ImGui::IsMouseDoubleClicked(
+                             ImGuiMouseButton_Left ) )
+                    {
+                        Trace::Debug( "Double Clicked: {}",
+                                      entry.path.c_str() );
+                        selectedEntry = entry.path;
+                        break;
+                    }
                     ++idxColumn;
-                    continue;
                 }
+            }
+        }
 
-                ImGui::TableSetColumnIndex( idxColumn - 1 );
+        this->update_scroll();
+        ImGui::EndTable();
+    }
+    ImGui::PopStyleVar( 1 );
+    return selectedEntry;
+}
 
-                ImGuiSelectableFlags selectable_flags =
-                    ImGuiSelectableFlags_SpanAllColumns;
-                // | ImGuiSelectableFlags_AllowItemOverlap;
-                bool        isSelected { false };
-                std::string id {
-                    fmt::format( "{}##Cell{}-{}", cell, idxColumn, idxRow ) };
-                ImGui::Selectable( id.c_str(), &isSelected, selectable_flags,
-                                   ImVec2 { 0, 50.f } );
 
-                if ( ImGui::IsItemHovered()
-                     && ImGui::IsMouseDoubleClicked( ImGuiMouseButton_Left ) )
+std::optional< fs::path > FolderNavigator::update_grid()
+{
+    std::optional< fs::path > selectedEntry { std::nullopt };
+
+    if ( ImGui::BeginChild( "Filesystem Item Grid" ) )
+    {
+        // The images are drawn after everything else, so the draw calls
+        // aren't split each time the texture changes between the atlas and
+        // the font
+        ImDrawList * drawList = ImGui::GetWindowDrawList();
+        drawList->ChannelsSplit( NB_CHANNELS );
+        drawList->ChannelsSetCurrent( TEXT_CHANNEL );
+
+        ImGuiStyle const & style = ImGui::GetStyle();
+        float  thumbnailSize     = static_cast< float >( ds::THUMBNAIL_SIZE );
+        ImVec2 cellSize { thumbnailSize + 2.f * style.FramePadding.x,
+                          thumbnailSize + ImGui::GetTextLineHeight()
+                              + 3.f * style.FramePadding.y };
+
+        std::size_t nbColumns = static_cast< std::size_t >( std::max(
+            1.f, ( ImGui::GetContentRegionAvail().x + style.ItemSpacing.x )
+                     / ( cellSize.x + style.ItemSpacing.x ) ) );
+        std::size_t nbRows = ( m_rowOrder.size() + nbColumns - 1 ) / nbColumns;
+
+        // Only the visible lines of cells are submitted
+        ImGuiListClipper clipper {};
+        clipper.Begin( static_cast< int >( nbRows ),
+                       cellSize.y + style.ItemSpacing.y );
+        while ( clipper.Step() )
+        {
+            for ( std::size_t idxLine = clipper.DisplayStart;
+                  idxLine < static_cast< std::size_t >( clipper.DisplayEnd );
+                  ++idxLine )
+            {
+                for ( std::size_t idxColumn = 0; idxColumn < nbColumns;
+                      ++idxColumn )
                 {
-                    Trace::Debug( "Double Clicked: " + row[0] );
-                    selectedEntry = fs::path { row[0] };
-                    break;
+                    std::size_t idxVisible = idxLine * nbColumns + idxColumn;
+                    if ( idxVisible >= m_rowOrder.size() )
+                    {
+                        break;
+                    }
+                    if ( idxColumn > 0 )
+                    {
+                        ImGui::SameLine();
+                    }
+                    std::optional< fs::path > doubleClicked =
+                        this->update_grid_cell( m_rowOrder[idxVisible],
+                                                cellSize );
+                    if ( doubleClicked.has_value() )
+                    {
+                        selectedEntry = doubleClicked;
+                    }
                 }
-                ++idxColumn;
             }
-            ++idxRow;
         }
 
-        // Open the selected entry after the loop because we can't modify the
-        // table while iterating over it
-        if ( selectedEntry.has_value() )
+        drawList->ChannelsMerge();
+        this->update_scroll();
+    }
+    ImGui::EndChild();
+    return selectedEntry;
+}
+
+std::optional< fs::path > FolderNavigator::update_grid_cell(
+    std::size_t idxRow, ImVec2 const & cellSize )
+{
+    std::optional< fs::path > selectedEntry { std::nullopt };
+
+    ds::Entry const & entry = this->get_listing().entries[idxRow];
+    ds::FileTypeInfo  typeInfo =
+        ContentSniffer::get_instance().get_type( entry );
+    ImGuiStyle const & style = ImGui::GetStyle();
+
+    ImGui::PushID( static_cast< int >( idxRow ) );
+    ImVec2 position = ImGui::GetCursorScreenPos();
+    bool   isSelected { entry.path == m_selection };
+    if ( ImGui::Selectable( "##Cell", &isSelected, ImGuiSelectableFlags_None,
+                            cellSize ) )
+    {
+        this->select( entry, typeInfo );
+    }
+    if ( ImGui::IsItemHovered() && entry.isDirectory )
+    {
+        Prefetcher::get_instance().request( entry.path );
+    }
+    if ( ImGui::IsItemHovered()
+         && ImGui::IsMouseDoubleClicked( ImGuiMouseButton_Left ) )
+    {
+        Trace::Debug( "Double Clicked: {}", entry.path.c_str() );
+        selectedEntry = entry.path;
+    }
+
+    ImDrawList * drawList      = ImGui::GetWindowDrawList();
+    float        thumbnailSize = static_cast< float >( ds::THUMBNAIL_SIZE );
+    ImVec2       thumbnailMin { position.x + style.FramePadding.x,
+                                position.y + style.FramePadding.y };
+
+    std::optional< TextureAtlas::Region > image =
+        Thumbnails::get_instance().get_thumbnail( entry, typeInfo );
+    // The type is written under the icon until the thumbnail is ready
+    std::string_view type {};
+    if ( ! image.has_value() )
+    {
+        image = FileIcons::get_instance().get_icon( typeInfo.icon );
+        type  = ds::to_string( typeInfo.type );
+    }
+
+    ImVec2 typeSize {
+        type.empty()
+            ? ImVec2 { 0.f, 0.f }
+            : ImGui::CalcTextSize( type.data(), type.data() + type.size() ) };
+    if ( image.has_value() )
+    {
+        // Centered in its square at a whole pixel, so it isn't blurred
+        ImVec2 imageMin {
+            std::floor( thumbnailMin.x
+                        + ( thumbnailSize - image->size.x ) / 2.f ),
+            std::floor( thumbnailMin.y
+                        + ( thumbnailSize - image->size.y - typeSize.y )
+                              / 2.f ) };
+        drawList->ChannelsSetCurrent( IMAGE_CHANNEL );
+        drawList->AddImage( image->texture, imageMin,
+                            ImVec2 { imageMin.x + image->size.x,
+                                     imageMin.y + image->size.y },
+                            image->uvMin, image->uvMax );
+        drawList->ChannelsSetCurrent( TEXT_CHANNEL );
+        if ( ! type.empty() )
         {
-            this->open_entry( selectedEntry.value() );
+            drawList->AddText(
+                ImVec2 { thumbnailMin.x + ( thumbnailSize - typeSize.x ) / 2.f,
+                         imageMin.y + image->size.y },
+                ImGui::GetColorU32( ImGuiCol_TextDisabled ), type.data(),
+                type.data() + type.size() );
         }
     }
-    ImGui::PopStyleVar( 1 );
-    ImGui::EndTable();
+
+    std::string name = fit_text( entry.name, thumbnailSize );
+    drawList->AddText(
+        ImVec2 { thumbnailMin.x,
+                 thumbnailMin.y + thumbnailSize + style.FramePadding.y },
+        ImGui::GetColorU32( ImGuiCol_Text ), name.c_str() );
+
+    ImGui::PopID();
+    return selectedEntry;
+}
+
+void FolderNavigator::select( ds::Entry const &        entry,
+                              ds::FileTypeInfo const & typeInfo )
+{
+    m_selection = entry.path;
+
+    bool isText = typeInfo.type == ds::FileType::Text
+                  || typeInfo.type == ds::FileType::SourceCode
+                  || typeInfo.type == ds::FileType::Script
+                  || typeInfo.type == ds::FileType::Web
+                  || typeInfo.type == ds::FileType::Data;
+    if ( ! isText || entry.isDirectory )
+    {
+        m_preview = nullptr;
+    }
+    else if ( ! m_preview || m_preview->get_path() != entry.path )
+    {
+        m_preview = std::make_shared< TextPreview >( entry.path );
+    }
+}
+
+void FolderNavigator::update_hex_viewer()
+{
+    if ( ! m_hexViewer )
+    {
+        return;
+    }
+
+    bool        isOpen { true };
+    std::string title { fmt::format(
+        "{}##HexViewer", m_hexViewer->get_path().filename().string() ) };
+    ImGui::SetNextWindowSize( ImVec2 { 720.f, 480.f }, ImGuiCond_FirstUseEver );
+    if ( ImGui::Begin( title.c_str(), &isOpen ) )
+    {
+        m_hexViewer->update_gui();
+    }
+    ImGui::End();
+
+    if ( ! isOpen )
+    {
+        m_hexViewer = nullptr;
+    }
+}
+
+void FolderNavigator::update_scroll()
+{
+    // Applied once the rows are submitted, so the scroll isn't clamped to
+    // the size of the previous directory
+    m_scrollY = ImGui::GetScrollY();
+    if ( m_pendingScrollY.has_value() )
+    {
+        ImGui::SetScrollY( m_pendingScrollY.value() );
+        m_pendingScrollY = std::nullopt;
+    }
 }
 
 fs::path const & FolderNavigator::get_directory() const
@@ -98,32 +531,51 @@ fs::path const & FolderNavigator::get_search_box() const
     return m_searchBox;
 }
 
+fs::path const & FolderNavigator::get_selection() const
+{
+    return m_selection;
+}
+
 // fs::path & FolderNavigator::get_search_box()
 // {
 //     return m_searchBox;
 // }
 
-std::vector< fs::path > const & FolderNavigator::get_previous_directories()
-    const
+RingBuffer< FolderNavigator::HistoryEntry > const &
+    FolderNavigator::get_previous_directories() const
 {
     return m_previousDirectories;
 }
 
-std::vector< fs::path > const & FolderNavigator::get_next_directories() const
+RingBuffer< FolderNavigator::HistoryEntry > const &
+    FolderNavigator::get_next_directories() const
 {
     return m_nextDirectories;
 }
 
-boost::multi_array< std::string, 2 > const & FolderNavigator::get_structure()
-    const
+ds::Listing const & FolderNavigator::get_listing() const
+{
+    return *m_listing;
+}
+
+FolderNavigator::HistoryEntry FolderNavigator::get_view_state() const
+{
+    return HistoryEntry { m_currentDirectory, m_scrollY, m_selection,
+                          m_sortOrder, m_listing };
+}
+
+FolderNavigator::ViewMode FolderNavigator::get_view_mode() const
 {
-    return m_structure;
+    return m_viewMode;
 }
 
 void FolderNavigator::change_directory( fs::path const & path )
 {
-    m_previousDirectories.push_back( m_currentDirectory );
+    this->add_to_previous_dir( this->get_view_state() );
     m_nextDirectories.clear();
+
+    m_selection.clear();
+    m_pendingScrollY = 0.f;
     this->set_current_dir( path );
 }
 
@@ -131,9 +583,10 @@ void FolderNavigator::change_to_previous_dir()
 {
     if ( ! m_previousDirectories.empty() )
     {
-        this->add_to_next_dir( m_currentDirectory );
-        this->set_current_dir( m_previousDirectories.back() );
+        this->add_to_next_dir( this->get_view_state() );
+        HistoryEntry entry { m_previousDirectories.back() };
         m_previousDirectories.pop_back();
+        this->restore_view_state( entry );
     }
 }
 
@@ -141,9 +594,10 @@ void FolderNavigator::change_to_next_dir()
 {
     if ( ! m_nextDirectories.empty() )
     {
-        this->add_to_previous_dir( m_currentDirectory );
-        this->set_current_dir( m_nextDirectories.back() );
+        this->add_to_previous_dir( this->get_view_state() );
+        HistoryEntry entry { m_nextDirectories.back() };
         m_nextDirectories.pop_back();
+        this->restore_view_state( entry );
     }
 }
 
@@ -160,49 +614,19 @@ void FolderNavigator::set_search_box( fs::path const & path )
     m_searchBox = path;
 }
 
-void FolderNavigator::refresh()
+void FolderNavigator::set_view_mode( ViewMode viewMode )
 {
-    // Get all entries to show in the current directory
-    std::vector< fs::directory_entry > entries {};
-    for ( auto const & entry : fs::directory_iterator( this->get_directory() ) )
-    {
-        if ( ! ds::is_showed_gui( entry )
-             || ( ! Settings::get_instance().showHidden
-                  && ds::is_hidden( entry ) ) )
-        {
-            continue;
-        }
-        entries.push_back( entry );
-    }
+    m_viewMode = viewMode;
+}
 
-    m_structure.resize( boost::extents[entries.size()][m_nbColumns] );
-    for ( std::size_t row = 0; row < entries.size(); ++row )
-    {
-        for ( std::size_t column = 0; column < m_nbColumns; column++ )
-        {
-            switch ( column )
-            {
-            case 0 :
-                // Used internally to store the path
-                m_structure[row][column] = entries[row].path().string();
-                break;
-            case 1 :
-                m_structure[row][column] =
-                    entries[row].path().filename().string();
-                break;
-            case 2 :
-                m_structure[row][column] =
-                    ds::get_size_pretty_print( entries[row] );
-                break;
-            case 3 :
-                m_structure[row][column] = ds::get_type( entries[row] );
-                break;
-            default :
-                m_structure[row][column] = "N/A";
-                break;
-            }
-        }
-    }
+void FolderNavigator::refresh()
+{
+    TRACE_SPAN( "FolderNavigator::refresh" );
+    PerfCounters::Region perfRegion { "FolderNavigator::refresh" };
+    m_lastRefresh = std::chrono::steady_clock::now();
+    // Always read the directory again, the cache can't see the size changes
+    this->set_listing( ListingCache::get_instance().scan(
+        this->get_directory(), Settings::get_instance().showHidden ) );
 }
 
 void FolderNavigator::gui_info()
@@ -217,52 +641,182 @@ void FolderNavigator::gui_info()
     }
 
     ImGui::Text( "Previous directories:" );
-    for ( auto const & dir : m_previousDirectories )
+    for ( std::size_t idx = 0; idx < m_previousDirectories.size(); ++idx )
     {
-        ImGui::Text( "%s", dir.string().c_str() );
+        HistoryEntry const & entry = m_previousDirectories[idx];
+        ImGui::Text( "%s (scroll %.0f%s)", entry.directory.string().c_str(),
+                     entry.scrollY,
+                     entry.listing.expired() ? "" : ", cached" );
     }
     ImGui::Text( "Next directories:" );
-    for ( auto const & dir : m_nextDirectories )
+    for ( std::size_t idx = 0; idx < m_nextDirectories.size(); ++idx )
     {
-        ImGui::Text( "%s", dir.string().c_str() );
+        HistoryEntry const & entry = m_nextDirectories[idx];
+        ImGui::Text( "%s (scroll %.0f%s)", entry.directory.string().c_str(),
+                     entry.scrollY,
+                     entry.listing.expired() ? "" : ", cached" );
     }
 }
 
 void FolderNavigator::open_entry( fs::path const & entry )
 {
-    if ( fs::is_directory( entry ) )
+    MountGuard &          mountGuard  = MountGuard::get_instance();
+    std::optional< bool > isDirectory = mountGuard.call< bool >(
+        entry, [entry] () {
+            std::error_code error {};
+            return vfs::get_file_system().status( entry, error ).kind
+                   == vfs::FileKind::Directory;
+        } );
+    if ( ! isDirectory.has_value() )
+    {
+        Trace::Warning( "Can't open {}, its mount isn't responding",
+                        entry.c_str() );
+        return;
+    }
+
+    if ( isDirectory.value() )
     {
         this->change_directory( entry );
     }
+    else if ( Settings::get_instance().useHexViewer
+              && mountGuard
+                     .call< bool >( entry,
+                                    [entry] () {
+                                        return HexViewer::is_binary( entry );
+                                    } )
+                     .value_or( false ) )
+    {
+        m_hexViewer = std::make_shared< HexViewer >( entry );
+    }
     else
     {
         ds::open( entry );
     }
 }
 
-void FolderNavigator::add_to_previous_dir( fs::path const & path )
+void FolderNavigator::add_to_previous_dir( HistoryEntry entry )
+{
+    m_previousDirectories.set_capacity(
+        Settings::get_instance().maxHistorySize );
+    // The oldest entry is overwritten when the history is full
+    m_previousDirectories.push_back( std::move( entry ) );
+}
+
+void FolderNavigator::add_to_next_dir( HistoryEntry entry )
+{
+    m_nextDirectories.set_capacity( Settings::get_instance().maxHistorySize );
+    m_nextDirectories.push_back( std::move( entry ) );
+}
+
+void FolderNavigator::set_current_dir(
+    fs::path const & path, std::weak_ptr< ds::Listing const > const & snapshot )
+{
+    m_currentDirectory = path;
+    m_searchBox        = m_currentDirectory;
+
+    // The jobs of the previous directory are cancelled, so they don't delay
+    // the ones of this directory
+    JobScheduler::get_instance().navigate();
+    Prefetcher::get_instance().cancel();
+    bool showHidden = Settings::get_instance().showHidden;
+    std::shared_ptr< ds::Listing const > listing = snapshot.lock();
+    if ( ! listing || ! ListingCache::is_valid( *listing, showHidden ) )
+    {
+        listing = ListingCache::get_instance().get( m_currentDirectory,
+                                                    showHidden );
+    }
+    this->set_listing( std::move( listing ) );
+    this->watch_directory();
+
+    this->prefetch_neighbours();
+}
+
+void FolderNavigator::set_listing(
+    std::shared_ptr< ds::Listing const > listing )
+{
+    // Still scanned, it's cached once read
+    m_isWaitingListing =
+        ! listing
+        && MountGuard::get_instance().is_scanning( m_currentDirectory );
+    m_listing = listing ? listing : std::make_shared< ds::Listing >();
+    this->sort_rows();
+}
+
+void FolderNavigator::update_waiting_listing()
 {
-    m_previousDirectories.push_back( fs::path { path } );
-    if ( m_previousDirectories.size()
-         > Settings::get_instance().maxHistorySize )
+    std::shared_ptr< ds::Listing const > listing =
+        ListingCache::get_instance().find(
+            m_currentDirectory, Settings::get_instance().showHidden );
+    if ( listing )
     {
-        m_previousDirectories.erase( m_previousDirectories.begin() );
+        this->set_listing( std::move( listing ) );
     }
+    else if ( ! MountGuard::get_instance().is_scanning( m_currentDirectory ) )
+    {
+        // It answered, but the directory couldn't be read
+        m_isWaitingListing = false;
+    }
+}
+
+void FolderNavigator::restore_view_state( HistoryEntry const & entry )
+{
+    m_selection          = entry.selection;
+    m_sortOrder          = entry.sortOrder;
+    m_isSortOrderPending = true;
+    m_pendingScrollY     = entry.scrollY;
+    this->set_current_dir( entry.directory, entry.listing );
+}
+
+void FolderNavigator::sort_rows()
+{
+    TRACE_SPAN( "FolderNavigator::sort_rows" );
+    std::vector< ds::Entry > const & entries = this->get_listing().entries;
+
+    m_rowOrder.resize( entries.size() );
+    std::iota( m_rowOrder.begin(), m_rowOrder.end(), 0 );
+    std::sort( m_rowOrder.begin(), m_rowOrder.end(),
+               [this, &entries] ( std::size_t lhs, std::size_t rhs ) {
+                   return m_sortOrder.isAscending
+                              ? is_less( entries[lhs], entries[rhs],
+                                         m_sortOrder.column )
+                              : is_less( entries[rhs], entries[lhs],
+                                         m_sortOrder.column );
+               } );
 }
 
-void FolderNavigator::add_to_next_dir( fs::path const & path )
+void FolderNavigator::prefetch_neighbours() const
 {
-    // todo check if it's necessary to copy the path ?
-    m_nextDirectories.push_back( fs::path { path } );
-    if ( m_nextDirectories.size() > Settings::get_instance().maxHistorySize )
+    Prefetcher & prefetcher = Prefetcher::get_instance();
+    if ( ! m_previousDirectories.empty() )
+    {
+        prefetcher.request( m_previousDirectories.back().directory );
+    }
+    if ( ! m_nextDirectories.empty() )
     {
-        m_nextDirectories.erase( m_nextDirectories.begin() );
+        prefetcher.request( m_nextDirectories.back().directory );
+    }
+    if ( m_currentDirectory.has_parent_path() )
+    {
+        prefetcher.request( m_currentDirectory.parent_path() );
     }
 }
 
-void FolderNavigator::set_current_dir( fs::path const & path )
+void FolderNavigator::watch_directory()
 {
-    m_currentDirectory = path;
-    m_searchBox        = m_currentDirectory;
-    this->refresh();
+    // A new flag, so a late change of the previous directory isn't seen
+    auto isChanged = std::make_shared< std::atomic< bool > >( false );
+    m_isChanged    = isChanged;
+
+    std::function< std::shared_ptr< vfs::Watch >() > watch =
+        [directory = m_currentDirectory, isChanged] () {
+            std::error_code error {};
+            return std::shared_ptr< vfs::Watch > {
+                vfs::get_file_system().watch(
+                    directory, [isChanged] () { *isChanged = true; },
+                    error ) };
+        };
+    // Not watched if its mount doesn't answer, refresh still reads it
+    m_watch = MountGuard::get_instance()
+                  .call( m_currentDirectory, std::move( watch ) )
+                  .value_or( nullptr );
 }
@@ -1,21 +1,91 @@
 #pragma once
 
-#include <vector>  // for vector
+#include <atomic>    // for atomic
+#include <chrono>    // for steady_clock
+#include <cstdint>   // for uint64_t
+#include <memory>    // for shared_ptr, weak_ptr
+#include <optional>  // for optional
+#include <vector>    // for vector
 
-#include <boost/multi_array.hpp>  // for multi_array
+#include <imgui/imgui.h>  // for ImVec2
 
-#include "app/filesystem.hpp"  // for fs::path
+#include "app/filesystem.hpp"    // for fs::path, ds::Listing
+#include "tools/ring_buffer.hpp"  // for RingBuffer
+
+class HexViewer;
+class TextPreview;
+namespace vfs
+{
+    class Watch;
+}
 
 class FolderNavigator
 {
+  public:
+    enum class Column
+    {
+        Name = 0,
+        Size,
+        Type,
+        Dimensions
+    };
+
+    enum class ViewMode
+    {
+        List = 0,
+        Grid
+    };
+
+    struct SortOrder
+    {
+        Column column;
+        bool   isAscending;
+    };
+
+    // Everything needed to show a directory again exactly as it was left
+    struct HistoryEntry
+    {
+        fs::path                           directory;
+        float                              scrollY;
+        fs::path                           selection;
+        SortOrder                          sortOrder;
+        // Reused without reading the directory again if it's still valid
+        std::weak_ptr< ds::Listing const > listing;
+    };
+
+  private:
     fs::path m_currentDirectory;
     fs::path m_searchBox;
 
-    std::vector< fs::path > m_previousDirectories;
-    std::vector< fs::path > m_nextDirectories;
+    RingBuffer< HistoryEntry > m_previousDirectories;
+    RingBuffer< HistoryEntry > m_nextDirectories;
+
+    std::shared_ptr< ds::Listing const > m_listing;
+    // Indices of the listing entries in the order they are showed
+    std::vector< std::size_t >           m_rowOrder;
+    // The mount of the directory didn't answer in time, the listing is taken
+    // from the cache once it has been read
+    bool                                 m_isWaitingListing;
 
-    boost::multi_array< std::string, 2 > m_structure;
-    unsigned int                         m_nbColumns;
+    fs::path                m_selection;
+    SortOrder               m_sortOrder;
+    ViewMode                m_viewMode;
+    float                   m_scrollY;
+    std::optional< float >  m_pendingScrollY;
+    // The table sort specs must be updated from m_sortOrder
+    bool                    m_isSortOrderPending;
+
+    // Shared by the copies of the navigator, as the file stays mapped
+    std::shared_ptr< TextPreview > m_preview;
+    // Binary file opened in its own window instead of its application
+    std::shared_ptr< HexViewer >   m_hexViewer;
+    // The directory is read again when a file operation ends
+    uint64_t                       m_nbFinishedOperations;
+    // And when its watch sees a change, at most once per refresh delay.
+    // Shared by the copies of the navigator, like the preview.
+    std::shared_ptr< vfs::Watch >         m_watch;
+    std::shared_ptr< std::atomic< bool > > m_isChanged;
+    std::chrono::steady_clock::time_point m_lastRefresh;
 
   public:
     explicit FolderNavigator( fs::path const & baseDirectory );
@@ -27,25 +97,52 @@ class FolderNavigator
 
     void update_gui ();
 
-    fs::path const &                get_directory () const;
-    fs::path const &                get_search_box () const;
+    fs::path const &                   get_directory () const;
+    fs::path const &                   get_search_box () const;
+    fs::path const &                   get_selection () const;
     // fs::path &                      get_search_box ();
-    std::vector< fs::path > const & get_previous_directories () const;
-    std::vector< fs::path > const & get_next_directories () const;
-    boost::multi_array< std::string, 2 > const & get_structure () const;
+    RingBuffer< HistoryEntry > const & get_previous_directories () const;
+    RingBuffer< HistoryEntry > const & get_next_directories () const;
+    ds::Listing const &                get_listing () const;
+    HistoryEntry                       get_view_state () const;
+    ViewMode                           get_view_mode () const;
 
     void change_directory ( fs::path const & path );
     void change_to_previous_dir ();
     void change_to_next_dir ();
     void to_parent_dir ();
     void set_search_box ( fs::path const & path );
+    void set_view_mode ( ViewMode viewMode );
 
     void refresh ();
     void gui_info ();
+    // Directories are browsed, binary files may be opened in the hex viewer
+    // and the other files with their default application
     void open_entry ( fs::path const & entry );
 
   private:
-    void add_to_previous_dir ( fs::path const & path );
-    void add_to_next_dir ( fs::path const & path );
-    void set_current_dir ( fs::path const & path );
+    // Return the entry double clicked, if any
+    std::optional< fs::path > update_table ();
+    std::optional< fs::path > update_grid ();
+    std::optional< fs::path > update_grid_cell ( std::size_t  idxRow,
+                                                 ImVec2 const & cellSize );
+    // Select the entry and preview it if it's a text file
+    void select ( ds::Entry const & entry, ds::FileTypeInfo const & typeInfo );
+    void update_hex_viewer ();
+    // Show the listing read since the mount answered again
+    void update_waiting_listing ();
+    // Keep the scroll position, and apply the one restored from the history
+    void                      update_scroll ();
+
+    void add_to_previous_dir ( HistoryEntry entry );
+    void add_to_next_dir ( HistoryEntry entry );
+    void set_current_dir ( fs::path const &                           path,
+                           std::weak_ptr< ds::Listing const > const & snapshot
+                           = {} );
+    void set_listing ( std::shared_ptr< ds::Listing const > listing );
+    void restore_view_state ( HistoryEntry const & entry );
+    void sort_rows ();
+    // Ask the prefetcher for the directories that could be opened next
+    void prefetch_neighbours () const;
+    void watch_directory ();
 };
@@ -0,0 +1,562 @@
+#include "hex_viewer.hpp"
+
+#include <algorithm>     // for min, min_element
+#include <cctype>        // for isprint, isxdigit, isspace
+#include <charconv>      // for from_chars
+#include <cmath>         // for abs, ceil, floor
+#include <cstring>       // for memchr
+#include <string>        // for string
+#include <system_error>  // for errc
+
+#include <fmt/format.h>   // for format, format_to
+#include <imgui/imgui.h>  // for ImGui::TextUnformatted, ImGui::Dummy
+
+#include "app/file_type.hpp"      // for ds::get_file_type
+#include "app/job_scheduler.hpp"  // for JobScheduler
+#include "tools/byte_search.hpp"  // for byte_search::find
+#include "tools/traces.hpp"       // for Trace
+
+namespace
+{
+    constexpr uint64_t BYTES_PER_ROW { 16 };
+    // A multiple of BYTES_PER_ROW, so a row is always in a single page
+    constexpr uint64_t PAGE_SIZE { 4096 };
+    constexpr std::size_t MAX_CACHED_PAGES { 64 };
+    // Read by the searcher at once
+    constexpr uint64_t SEARCH_CHUNK_SIZE { 4 * 1024 * 1024 };
+    // Read to guess if the file is binary
+    constexpr std::size_t BINARY_SNIFF_SIZE { 4096 };
+    // Height of the scrolled content in rows at most, so the scroll
+    // positions stay exact in float
+    constexpr uint64_t MAX_SCROLLED_ROWS { 64 * 1024 };
+    // Scrolled by a notch of the mouse wheel
+    constexpr float ROWS_PER_WHEEL_NOTCH { 3.f };
+
+    // Accept decimal and hexadecimal with the 0x prefix
+    std::optional< uint64_t > parse_offset ( std::string_view text )
+    {
+        int base = 10;
+        if ( text.starts_with( "0x" ) || text.starts_with( "0X" ) )
+        {
+            text.remove_prefix( 2 );
+            base = 16;
+        }
+        uint64_t offset = 0;
+        auto [end, error] = std::from_chars( text.data(),
+                                             text.data() + text.size(), offset,
+                                             base );
+        if ( error != std::errc {} || end != text.data() + text.size() )
+        {
+            return std::nullopt;
+        }
+        return offset;
+    }
+
+    // Pairs of hexadecimal digits, with any spaces between them
+    std::optional< std::vector< unsigned char > > parse_hex_pattern (
+        std::string_view text )
+    {
+        std::vector< unsigned char > pattern {};
+        std::string                  digits {};
+        for ( char character : text )
+        {
+            if ( std::isspace( static_cast< unsigned char >( character ) ) )
+            {
+                continue;
+            }
+            if ( ! std::isxdigit( static_cast< unsigned char >( character ) ) )
+            {
+                return std::nullopt;
+            }
+            digits += character;
+        }
+        if ( digits.size() % 2 != 0 )
+        {
+            return std::nullopt;
+        }
+        for ( std::size_t idx = 0; idx < digits.size(); idx += 2 )
+        {
+            unsigned char byte = 0;
+            std::from_chars( digits.data() + idx, digits.data() + idx + 2,
+                             byte, 16 );
+            pattern.push_back( byte );
+        }
+        return pattern;
+    }
+}  // namespace
+
+HexViewer::HexViewer( fs::path const & path )
+  : m_path { path },
+    m_file {},
+    m_size { 0 },
+    m_pages {},
+    m_nbPageReads { 0 },
+    m_nbPageHits { 0 },
+    m_offsetInput {},
+    m_patternInput {},
+    m_isHexPattern { true },
+    m_highlight { std::nullopt },
+    m_pendingScrollRow { std::nullopt },
+    m_firstVisibleRow { 0 },
+    m_scrollY { 0.f },
+    m_searchStart { 0 },
+    m_searchedSize { 0 },
+    m_isSearching { false },
+    m_searchMutex {},
+    m_searchResult { std::nullopt },
+    m_isSearchDone { false },
+    m_searcher {}
+{
+    std::error_code error {};
+    m_file = vfs::get_file_system().open( path, error );
+    if ( ! m_file )
+    {
+        Trace::Warning( "Can't open {}: {}", path.c_str(), error.message() );
+        return;
+    }
+    m_size = m_file->get_size();
+    // The showed pages are anywhere in the file, no read ahead
+    m_file->advise( vfs::Access::Random, 0, 0 );
+}
+
+HexViewer::~HexViewer()
+{
+    this->cancel_search();
+}
+
+void HexViewer::update_gui()
+{
+    ImGui::TextUnformatted( m_path.filename().c_str() );
+    if ( ! this->is_open() )
+    {
+        ImGui::TextDisabled( "Can't be read" );
+        return;
+    }
+    ImGui::TextDisabled( "%s (%lu bytes), %lu / %lu pages cached, %lu reads",
+                         ds::get_size_pretty_print( m_size, false ).c_str(),
+                         m_size, m_pages.size(), MAX_CACHED_PAGES,
+                         m_nbPageReads );
+
+    this->update_toolbar();
+    ImGui::Separator();
+    this->update_rows();
+}
+
+fs::path const & HexViewer::get_path() const
+{
+    return m_path;
+}
+
+bool HexViewer::is_open() const
+{
+    return m_file != nullptr;
+}
+
+uint64_t HexViewer::get_size() const
+{
+    return m_size;
+}
+
+std::string_view HexViewer::get_row( uint64_t idxRow )
+{
+    uint64_t offset  = idxRow * BYTES_PER_ROW;
+    uint64_t idxPage = offset / PAGE_SIZE;
+
+    auto pageIt = m_pages.find( idxPage );
+    if ( pageIt == m_pages.end() )
+    {
+        if ( m_pages.size() >= MAX_CACHED_PAGES )
+        {
+            m_pages.erase( std::min_element(
+                m_pages.begin(), m_pages.end(),
+                [] ( auto const & lhs, auto const & rhs ) {
+                    return lhs.second.lastUse < rhs.second.lastUse;
+                } ) );
+        }
+
+        Page page { std::vector< unsigned char >( PAGE_SIZE ), 0 };
+        ssize_t nbRead =
+            m_file->read_at( page.data.data(), PAGE_SIZE, idxPage * PAGE_SIZE );
+        // An unreadable page is cached empty, so it isn't read every frame
+        page.data.resize( nbRead > 0 ? static_cast< std::size_t >( nbRead )
+                                     : 0 );
+        pageIt = m_pages.emplace( idxPage, std::move( page ) ).first;
+        ++m_nbPageReads;
+    }
+    else
+    {
+        ++m_nbPageHits;
+    }
+
+    Page & page  = pageIt->second;
+    page.lastUse = m_nbPageReads + m_nbPageHits;
+
+    uint64_t offsetInPage = offset % PAGE_SIZE;
+    if ( offsetInPage >= page.data.size() )
+    {
+        return {};
+    }
+    return std::string_view {
+        reinterpret_cast< char const * >( page.data.data() ) + offsetInPage,
+        std::min( BYTES_PER_ROW, page.data.size() - offsetInPage ) };
+}
+
+void HexViewer::jump_to( uint64_t offset )
+{
+    if ( offset >= m_size )
+    {
+        Trace::Warning( "Offset {} is past the end of {}", offset,
+                        m_path.c_str() );
+        return;
+    }
+    m_highlight        = Highlight { offset, 1 };
+    m_pendingScrollRow = offset / BYTES_PER_ROW;
+}
+
+void HexViewer::search( std::vector< unsigned char > pattern, uint64_t offset )
+{
+    this->cancel_search();
+    if ( pattern.empty() || offset >= m_size )
+    {
+        return;
+    }
+
+    {
+        std::lock_guard< std::mutex > lock { m_searchMutex };
+        m_searchResult = std::nullopt;
+        m_isSearchDone = false;
+    }
+    m_searchStart  = offset;
+    m_searchedSize = 0;
+    m_isSearching  = true;
+    m_searcher     = std::jthread { [this, pattern = std::move( pattern ),
+                                 offset] ( std::stop_token stopToken ) {
+        this->search_thread( stopToken, pattern, offset );
+    } };
+}
+
+void HexViewer::cancel_search()
+{
+    if ( m_searcher.joinable() )
+    {
+        m_searcher.request_stop();
+        m_searcher.join();
+    }
+    m_isSearching = false;
+}
+
+bool HexViewer::is_binary( fs::path const & path )
+{
+    switch ( ds::get_file_type( path.filename().string() ).type )
+    {
+    case ds::FileType::Executable :
+    case ds::FileType::Library :
+    case ds::FileType::Database :
+    case ds::FileType::DiskImage :
+        return true;
+    case ds::FileType::Others :
+        break;
+    default :
+        // Their default application is better than the hex viewer
+        return false;
+    }
+
+    // Same guess as most tools: text files don't have null bytes
+    std::error_code              error {};
+    std::unique_ptr< vfs::File > file =
+        vfs::get_file_system().open( path, error );
+    if ( ! file )
+    {
+        return false;
+    }
+    std::array< unsigned char, BINARY_SNIFF_SIZE > buffer {};
+    ssize_t nbRead = file->read_at( buffer.data(), buffer.size(), 0 );
+    return nbRead > 0
+           && std::memchr( buffer.data(), '\0',
+                           static_cast< std::size_t >( nbRead ) )
+                  != nullptr;
+}
+
+void HexViewer::update_toolbar()
+{
+    ImGui::SetNextItemWidth( ImGui::GetFontSize() * 10.f );
+    if ( ImGui::InputText( "##HexOffset", m_offsetInput.data(),
+                           m_offsetInput.size(),
+                           ImGuiInputTextFlags_EnterReturnsTrue ) )
+    {
+        std::optional< uint64_t > offset =
+            parse_offset( m_offsetInput.data() );
+        if ( offset.has_value() )
+        {
+            this->jump_to( offset.value() );
+        }
+        else
+        {
+            Trace::Warning( "Invalid offset: {}", m_offsetInput.data() );
+        }
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled( "Offset" );
+
+    ImGui::SetNextItemWidth( ImGui::GetFontSize() * 16.f );
+    bool isSearchAsked = ImGui::InputText(
+        "##HexPattern", m_patternInput.data(), m_patternInput.size(),
+        ImGuiInputTextFlags_EnterReturnsTrue );
+    ImGui::SameLine();
+    ImGui::Checkbox( "Hex##HexPatternIsHex", &m_isHexPattern );
+    ImGui::SameLine();
+    isSearchAsked |= ImGui::Button( "Find Next##HexSearch" );
+    if ( isSearchAsked )
+    {
+        std::string_view text { m_patternInput.data() };
+        std::optional< std::vector< unsigned char > > pattern =
+            m_isHexPattern
+                ? parse_hex_pattern( text )
+                : std::vector< unsigned char > { text.begin(), text.end() };
+        if ( pattern.has_value() )
+        {
+            // After the current match, or from the top of the view
+            this->search( std::move( pattern.value() ),
+                          m_highlight.has_value()
+                              ? m_highlight->offset + 1
+                              : m_firstVisibleRow * BYTES_PER_ROW );
+        }
+        else
+        {
+            Trace::Warning( "Invalid hexadecimal pattern: {}", text );
+        }
+    }
+
+    if ( m_isSearching )
+    {
+        uint64_t start   = m_searchStart;
+        auto     percent = static_cast< float >( m_searchedSize )
+                       / static_cast< float >( m_size - start );
+        ImGui::SameLine();
+        ImGui::ProgressBar( percent,
+                            ImVec2 { ImGui::GetFontSize() * 8.f, 0.f } );
+        ImGui::SameLine();
+        if ( ImGui::Button( "Cancel##HexSearch" ) )
+        {
+            this->cancel_search();
+        }
+    }
+
+    bool isSearchDone = false;
+    std::optional< Highlight > result {};
+    {
+        std::lock_guard< std::mutex > lock { m_searchMutex };
+        isSearchDone   = m_isSearchDone;
+        result         = m_searchResult;
+        m_isSearchDone = false;
+    }
+    if ( isSearchDone )
+    {
+        m_isSearching = false;
+        if ( result.has_value() )
+        {
+            m_highlight        = result;
+            m_pendingScrollRow = result->offset / BYTES_PER_ROW;
+        }
+        else
+        {
+            Trace::Info( "Pattern not found in {}", m_path.c_str() );
+        }
+    }
+}
+
+void HexViewer::update_rows()
+{
+    // The mouse wheel scrolls the rows, not the scroll position
+    if ( ! ImGui::BeginChild( "Hex Rows", ImVec2 { 0.f, 0.f }, false,
+                              ImGuiWindowFlags_HorizontalScrollbar
+                                  | ImGuiWindowFlags_NoScrollWithMouse ) )
+    {
+        ImGui::EndChild();
+        return;
+    }
+
+    float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    // Fully showed, the horizontal scrollbar may hide the bottom
+    float viewHeight =
+        ImGui::GetWindowHeight() - ImGui::GetStyle().ScrollbarSize;
+    float scrollMax = ImGui::GetScrollMaxY();
+
+    uint64_t nbRows       = ( m_size + BYTES_PER_ROW - 1 ) / BYTES_PER_ROW;
+    uint64_t nbShowedRows = static_cast< uint64_t >(
+        std::max( viewHeight / rowHeight, 1.f ) );
+    uint64_t maxFirstRow  = nbRows - std::min( nbRows, nbShowedRows );
+
+    if ( m_pendingScrollRow.has_value() )
+    {
+        m_firstVisibleRow  = m_pendingScrollRow.value();
+        m_pendingScrollRow = std::nullopt;
+    }
+    else if ( std::abs( ImGui::GetScrollY() - m_scrollY ) >= 1.f
+              && scrollMax > 0.f )
+    {
+        double fraction = static_cast< double >( ImGui::GetScrollY() )
+                          / static_cast< double >( scrollMax );
+        m_firstVisibleRow = static_cast< uint64_t >(
+            fraction * static_cast< double >( maxFirstRow ) + 0.5 );
+    }
+    else if ( float wheel = ImGui::GetIO().MouseWheel;
+              wheel != 0.f && ImGui::IsWindowHovered() )
+    {
+        // A touchpad gives a fraction of a notch
+        auto nbWheelRows = static_cast< uint64_t >(
+            std::ceil( std::abs( wheel ) * ROWS_PER_WHEEL_NOTCH ) );
+        m_firstVisibleRow =
+            wheel > 0.f ? m_firstVisibleRow - std::min( m_firstVisibleRow,
+                                                        nbWheelRows )
+                        : m_firstVisibleRow + nbWheelRows;
+    }
+    m_firstVisibleRow = std::min( m_firstVisibleRow, maxFirstRow );
+    uint64_t endRow =
+        std::min( nbRows, m_firstVisibleRow + nbShowedRows + 1 );
+
+    // The content has the height of the rows up to MAX_SCROLLED_ROWS. The
+    // rows drawn stay inside it, or it would grow as they are drawn lower.
+    float contentHeight =
+        static_cast< float >( std::min( nbRows, MAX_SCROLLED_ROWS ) )
+        * rowHeight;
+    float rowsHeight =
+        static_cast< float >( endRow - m_firstVisibleRow ) * rowHeight;
+    ImGui::Dummy( ImVec2 { 0.f, contentHeight } );
+    // The scroll set is only applied next frame, the rows are drawn at the
+    // top of the current view
+    ImGui::SetCursorPosY( std::max(
+        0.f, std::min( ImGui::GetScrollY(), contentHeight - rowsHeight ) ) );
+
+    // Rounded like ImGui does, to tell its position from a drag
+    m_scrollY = 0.f;
+    if ( maxFirstRow > 0 )
+    {
+        m_scrollY = std::floor( static_cast< float >(
+            static_cast< double >( m_firstVisibleRow )
+            / static_cast< double >( maxFirstRow )
+            * static_cast< double >( scrollMax ) ) );
+    }
+    ImGui::SetScrollY( m_scrollY );
+
+    std::string line {};
+    for ( uint64_t idxRow = m_firstVisibleRow; idxRow < endRow; ++idxRow )
+    {
+        uint64_t         offset = idxRow * BYTES_PER_ROW;
+        std::string_view bytes  = this->get_row( idxRow );
+
+        line.clear();
+        fmt::format_to( std::back_inserter( line ), "{:010x}  ", offset );
+        std::size_t hexStart = line.size();
+        for ( uint64_t idx = 0; idx < BYTES_PER_ROW; ++idx )
+        {
+            if ( idx < bytes.size() )
+            {
+                fmt::format_to(
+                    std::back_inserter( line ), "{:02x} ",
+                    static_cast< unsigned char >( bytes[idx] ) );
+            }
+            else
+            {
+                line += "   ";
+            }
+            // Separate the two halves of the row
+            if ( idx == BYTES_PER_ROW / 2 - 1 )
+            {
+                line += ' ';
+            }
+        }
+        line += ' ';
+        for ( char byte : bytes )
+        {
+            line += std::isprint( static_cast< unsigned char >( byte ) )
+                        ? byte
+                        : '.';
+        }
+
+        // The highlighted bytes of the row are drawn behind the text
+        if ( m_highlight.has_value()
+             && m_highlight->offset < offset + bytes.size()
+             && m_highlight->offset + m_highlight->size > offset )
+        {
+            uint64_t first = std::max( m_highlight->offset, offset )
+                             - offset;
+            uint64_t last =
+                std::min( m_highlight->offset + m_highlight->size,
+                          offset + bytes.size() )
+                - offset;
+            auto column = [&] ( uint64_t idx ) {
+                std::size_t position =
+                    hexStart + idx * 3 + ( idx >= BYTES_PER_ROW / 2 );
+                return ImGui::CalcTextSize( line.data(),
+                                            line.data() + position )
+                    .x;
+            };
+            ImVec2 cursor = ImGui::GetCursorScreenPos();
+            ImGui::GetWindowDrawList()->AddRectFilled(
+                ImVec2 { cursor.x + column( first ), cursor.y },
+                ImVec2 { cursor.x + column( last - 1 )
+                             + ImGui::CalcTextSize( "00" ).x,
+                         cursor.y + ImGui::GetTextLineHeight() },
+                ImGui::GetColorU32( ImGuiCol_TextSelectedBg ) );
+        }
+        ImGui::TextUnformatted( line.data(), line.data() + line.size() );
+    }
+    ImGui::EndChild();
+}
+
+void HexViewer::search_thread( std::stop_token                      stopToken,
+                               std::vector< unsigned char > const & pattern,
+                               uint64_t                             offset )
+{
+    // The UI thread reads the same file, it must stay the fastest
+    JobScheduler::set_thread_class( JobScheduler::JobClass::Prefetch );
+
+    std::optional< Highlight > result {};
+    // Opened again, so its read ahead doesn't change the one of the view
+    std::error_code              error {};
+    std::unique_ptr< vfs::File > file =
+        vfs::get_file_system().open( m_path, error );
+    if ( file )
+    {
+        file->advise( vfs::Access::Sequential, 0, 0 );
+
+        // The chunks overlap, for the matches across two of them
+        uint64_t overlap = pattern.size() - 1;
+        std::vector< unsigned char > buffer( SEARCH_CHUNK_SIZE + overlap );
+        uint64_t position = offset;
+        while ( position < m_size && ! stopToken.stop_requested() )
+        {
+            ssize_t nbRead =
+                file->read_at( buffer.data(), buffer.size(), position );
+            if ( nbRead <= 0 )
+            {
+                break;
+            }
+            auto size = static_cast< std::size_t >( nbRead );
+            std::size_t found = byte_search::find(
+                buffer.data(), size, pattern.data(), pattern.size() );
+            if ( found < size )
+            {
+                result = Highlight { position + found, pattern.size() };
+                break;
+            }
+            // Read once, the pages don't need to stay in memory
+            file->advise( vfs::Access::Done, position, SEARCH_CHUNK_SIZE );
+            position += SEARCH_CHUNK_SIZE;
+            m_searchedSize = std::min( position, m_size ) - offset;
+        }
+    }
+    else
+    {
+        Trace::Warning( "Can't open {}: {}", m_path.c_str(),
+                        error.message() );
+    }
+
+    if ( ! stopToken.stop_requested() )
+    {
+        std::lock_guard< std::mutex > lock { m_searchMutex };
+        m_searchResult = result;
+        m_isSearchDone = true;
+    }
+}
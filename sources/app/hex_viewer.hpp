@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>          // for array
+#include <atomic>         // for atomic
+#include <cstdint>        // for uint64_t
+#include <memory>         // for unique_ptr
+#include <mutex>          // for mutex
+#include <optional>       // for optional
+#include <stop_token>     // for stop_token
+#include <string_view>    // for string_view
+#include <thread>         // for jthread
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+#include "app/filesystem.hpp"  // for fs::path
+#include "app/vfs.hpp"         // for vfs::File
+
+// Hexadecimal and ASCII view of a file of any size, read through the file
+// system so every backend can be viewed. Only the pages showed are read, and
+// kept in a small cache; the searches read the file in large chunks on their
+// own thread.
+class HexViewer
+{
+    struct Page
+    {
+        std::vector< unsigned char > data;
+        uint64_t                     lastUse;
+    };
+
+    struct Highlight
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    fs::path                     m_path;
+    std::unique_ptr< vfs::File > m_file;
+    uint64_t                     m_size;
+
+    // Indexed by the offset of the page divided by its size
+    std::unordered_map< uint64_t, Page > m_pages;
+    uint64_t                             m_nbPageReads;
+    uint64_t                             m_nbPageHits;
+
+    std::array< char, 32 >     m_offsetInput;
+    std::array< char, 256 >    m_patternInput;
+    bool                       m_isHexPattern;
+    std::optional< Highlight > m_highlight;
+    std::optional< uint64_t >  m_pendingScrollRow;
+    // The rows are scrolled in 64 bits, a float scroll position can't reach
+    // every row of a large file. The scrollbar only shows the fraction of the
+    // file above the view, it was dragged if it moved from m_scrollY.
+    uint64_t                   m_firstVisibleRow;
+    float                      m_scrollY;
+
+    // Written by the searcher thread
+    std::atomic< uint64_t >    m_searchStart;
+    std::atomic< uint64_t >    m_searchedSize;
+    std::atomic< bool >        m_isSearching;
+    mutable std::mutex         m_searchMutex;
+    std::optional< Highlight > m_searchResult;
+    bool                       m_isSearchDone;
+
+    std::jthread m_searcher;
+
+  public:
+    explicit HexViewer( fs::path const & path );
+    virtual ~HexViewer();
+
+    HexViewer( HexViewer const & )              = delete;
+    HexViewer & operator= ( HexViewer const & ) = delete;
+
+    void update_gui ();
+
+    fs::path const & get_path () const;
+    bool             is_open () const;
+    uint64_t         get_size () const;
+    // Bytes of the row, fewer on the last row of the file
+    std::string_view get_row ( uint64_t idxRow );
+
+    void jump_to ( uint64_t offset );
+    // Search from the offset to the end of the file, the result is
+    // highlighted once it's found
+    void search ( std::vector< unsigned char > pattern, uint64_t offset );
+    void cancel_search ();
+
+    // True if the file content should be showed in the hex viewer rather
+    // than given to its default application
+    static bool is_binary ( fs::path const & path );
+
+  private:
+    void update_toolbar ();
+    void update_rows ();
+    void search_thread ( std::stop_token                      stopToken,
+                         std::vector< unsigned char > const & pattern,
+                         uint64_t                             offset );
+};
@@ -0,0 +1,226 @@
+#include "image_header.hpp"
+
+#include <array>  // for array
+
+#include <fcntl.h>   // for open, posix_fadvise
+#include <unistd.h>  // for pread, close
+
+namespace ds
+{
+    using namespace std::literals;
+
+    namespace
+    {
+        // Enough for the PNG, GIF, BMP and WebP headers and the first JPEG
+        // marker
+        constexpr std::size_t HEADER_SIZE { 32 };
+        // The JPEG frame header usually comes after the EXIF data, stop if
+        // it's not found in a reasonable number of segments
+        constexpr unsigned int MAX_JPEG_SEGMENTS { 64 };
+
+        uint32_t read_be16 ( unsigned char const * data )
+        {
+            return static_cast< uint32_t >( data[0] << 8 | data[1] );
+        }
+
+        uint32_t read_be32 ( unsigned char const * data )
+        {
+            return read_be16( data ) << 16 | read_be16( data + 2 );
+        }
+
+        uint32_t read_le16 ( unsigned char const * data )
+        {
+            return static_cast< uint32_t >( data[1] << 8 | data[0] );
+        }
+
+        uint32_t read_le24 ( unsigned char const * data )
+        {
+            return read_le16( data ) | static_cast< uint32_t >( data[2] ) << 16;
+        }
+
+        uint32_t read_le32 ( unsigned char const * data )
+        {
+            return read_le16( data ) | read_le16( data + 2 ) << 16;
+        }
+
+        class File
+        {
+            int m_descriptor;
+
+          public:
+            explicit File( fs::path const & path )
+              : m_descriptor { ::open( path.c_str(), O_RDONLY | O_CLOEXEC ) }
+            {
+                if ( m_descriptor >= 0 )
+                {
+                    // Only a few scattered bytes are needed
+                    posix_fadvise( m_descriptor, 0, 0, POSIX_FADV_RANDOM );
+                }
+            }
+
+            ~File()
+            {
+                if ( m_descriptor >= 0 )
+                {
+                    ::close( m_descriptor );
+                }
+            }
+
+            File( File const & )              = delete;
+            File & operator= ( File const & ) = delete;
+
+            bool is_open () const { return m_descriptor >= 0; }
+
+            // Return true only if the whole buffer has been read
+            bool read ( unsigned char * buffer, std::size_t size,
+                        off_t offset ) const
+            {
+                return ::pread( m_descriptor, buffer, size, offset )
+                       == static_cast< ssize_t >( size );
+            }
+        };
+
+        std::optional< ImageHeader > read_jpeg ( File const & file )
+        {
+            // Segments are a 0xFF marker, its type and a big endian length
+            // including the length itself
+            off_t offset = 2;
+            for ( unsigned int idx = 0; idx < MAX_JPEG_SEGMENTS; ++idx )
+            {
+                std::array< unsigned char, 9 > segment {};
+                if ( ! file.read( segment.data(), segment.size(), offset )
+                     || segment[0] != 0xFF )
+                {
+                    return std::nullopt;
+                }
+
+                unsigned char marker = segment[1];
+                // Padding before a marker
+                if ( marker == 0xFF )
+                {
+                    offset += 1;
+                    continue;
+                }
+
+                // SOF0 to SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+                if ( marker >= 0xC0 && marker <= 0xCF && marker != 0xC4
+                     && marker != 0xC8 && marker != 0xCC )
+                {
+                    // Length, precision, height then width
+                    return ImageHeader { ImageFormat::JPEG,
+                                         read_be16( &segment[7] ),
+                                         read_be16( &segment[5] ) };
+                }
+                // Start of scan or end of image before any frame header
+                if ( marker == 0xDA || marker == 0xD9 )
+                {
+                    return std::nullopt;
+                }
+
+                offset += 2 + read_be16( &segment[2] );
+            }
+            return std::nullopt;
+        }
+
+        std::optional< ImageHeader > read_webp (
+            std::array< unsigned char, HEADER_SIZE > const & header )
+        {
+            std::string_view chunk {
+                reinterpret_cast< char const * >( &header[12] ), 4 };
+            if ( chunk == "VP8 "sv && header[23] == 0x9D && header[24] == 0x01
+                 && header[25] == 0x2A )
+            {
+                // Lossy: 14 bits sizes after the key frame start code
+                return ImageHeader { ImageFormat::WebP,
+                                     read_le16( &header[26] ) & 0x3FFF,
+                                     read_le16( &header[28] ) & 0x3FFF };
+            }
+            if ( chunk == "VP8L"sv && header[20] == 0x2F )
+            {
+                // Lossless: width - 1 and height - 1 packed on 14 bits each
+                uint32_t bits = read_le32( &header[21] );
+                return ImageHeader { ImageFormat::WebP, ( bits & 0x3FFF ) + 1,
+                                     ( ( bits >> 14 ) & 0x3FFF ) + 1 };
+            }
+            if ( chunk == "VP8X"sv )
+            {
+                // Extended: canvas width - 1 and height - 1 on 24 bits each
+                return ImageHeader { ImageFormat::WebP,
+                                     read_le24( &header[24] ) + 1,
+                                     read_le24( &header[27] ) + 1 };
+            }
+            return std::nullopt;
+        }
+    }  // namespace
+
+    std::optional< ImageHeader > read_image_header ( fs::path const & path )
+    {
+        File file { path };
+        std::array< unsigned char, HEADER_SIZE > header {};
+        if ( ! file.is_open() || ! file.read( header.data(), 16, 0 ) )
+        {
+            return std::nullopt;
+        }
+        // Shorter files are still valid for some formats
+        file.read( header.data(), header.size(), 0 );
+        std::string_view signature {
+            reinterpret_cast< char const * >( header.data() ), header.size() };
+
+        if ( signature.starts_with( "\x89PNG\r\n\x1a\n"sv )
+             && signature.substr( 12, 4 ) == "IHDR"sv )
+        {
+            return ImageHeader { ImageFormat::PNG, read_be32( &header[16] ),
+                                 read_be32( &header[20] ) };
+        }
+        if ( signature.starts_with( "\xff\xd8\xff"sv ) )
+        {
+            return read_jpeg( file );
+        }
+        if ( signature.starts_with( "GIF87a"sv )
+             || signature.starts_with( "GIF89a"sv ) )
+        {
+            return ImageHeader { ImageFormat::GIF, read_le16( &header[6] ),
+                                 read_le16( &header[8] ) };
+        }
+        if ( signature.starts_with( "BM"sv ) )
+        {
+            // The OS/2 header has 16 bits sizes, the others 32 bits signed
+            // sizes, with a negative height for top-down bitmaps
+            if ( read_le32( &header[14] ) == 12 )
+            {
+                return ImageHeader { ImageFormat::BMP, read_le16( &header[18] ),
+                                     read_le16( &header[20] ) };
+            }
+            // Negated on 64 bits, as -INT32_MIN doesn't fit on 32 bits
+            auto height = static_cast< int64_t >(
+                static_cast< int32_t >( read_le32( &header[22] ) ) );
+            return ImageHeader { ImageFormat::BMP, read_le32( &header[18] ),
+                                 static_cast< uint32_t >(
+                                     height < 0 ? -height : height ) };
+        }
+        if ( signature.starts_with( "RIFF"sv )
+             && signature.substr( 8, 4 ) == "WEBP"sv )
+        {
+            return read_webp( header );
+        }
+        return std::nullopt;
+    }
+
+    std::string_view to_string ( ImageFormat format )
+    {
+        switch ( format )
+        {
+        case ImageFormat::PNG :
+            return "PNG";
+        case ImageFormat::JPEG :
+            return "JPEG";
+        case ImageFormat::GIF :
+            return "GIF";
+        case ImageFormat::BMP :
+            return "BMP";
+        case ImageFormat::WebP :
+            return "WebP";
+        }
+        return "";
+    }
+}  // namespace ds
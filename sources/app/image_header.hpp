@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>      // for uint32_t
+#include <optional>     // for optional
+#include <string_view>  // for string_view
+
+#include "app/filesystem.hpp"  // for fs::path
+
+namespace ds
+{
+    enum class ImageFormat : uint8_t
+    {
+        PNG = 0,
+        JPEG,
+        GIF,
+        BMP,
+        WebP
+    };
+
+    struct ImageHeader
+    {
+        ImageFormat format;
+        uint32_t    width;
+        uint32_t    height;
+    };
+
+    // Read only the header of the image with a few small reads, nullopt if
+    // the format isn't supported or the header is corrupted
+    std::optional< ImageHeader > read_image_header ( fs::path const & path );
+    std::string_view             to_string ( ImageFormat format );
+}  // namespace ds
@@ -0,0 +1,30 @@
+#include "image_metadata.hpp"
+
+#include <imgui/imgui.h>  // for ImGui::Text
+
+namespace
+{
+    // Images queued or being read at the same time
+    constexpr std::size_t MAX_OUTSTANDING_READS { 32 };
+    constexpr std::size_t MAX_RESULTS { 100'000 };
+}  // namespace
+
+ImageMetadata::ImageMetadata()
+  : m_cache { ds::read_image_header, MAX_OUTSTANDING_READS, MAX_RESULTS }
+{}
+
+std::optional< ds::ImageHeader > ImageMetadata::get_header(
+    ds::Entry const & entry, ds::FileTypeInfo const & typeInfo )
+{
+    if ( typeInfo.type != ds::FileType::Image )
+    {
+        return std::nullopt;
+    }
+    return m_cache.get( entry.key, entry.path );
+}
+
+void ImageMetadata::debug_gui()
+{
+    ImGui::Text( "Image headers" );
+    m_cache.debug_gui();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <optional>  // for optional
+
+#include "app/background_file_cache.hpp"  // for BackgroundFileCache
+#include "app/filesystem.hpp"             // for ds::Entry
+#include "app/image_header.hpp"           // for ds::ImageHeader
+#include "tools/singleton.hpp"
+
+// Dimensions of the showed images, read in background from their headers
+// without decoding them
+class ImageMetadata : public Singleton< ImageMetadata >
+{
+    ENABLE_SINGLETON( ImageMetadata );
+
+    BackgroundFileCache< ds::ImageHeader > m_cache;
+
+    ImageMetadata();
+    virtual ~ImageMetadata() = default;
+
+  public:
+    // nullopt while the header isn't read, or if the entry isn't an image.
+    // Queue the image to be read if it's not already done.
+    std::optional< ds::ImageHeader > get_header (
+        ds::Entry const & entry, ds::FileTypeInfo const & typeInfo );
+
+    void debug_gui ();
+};
@@ -0,0 +1,220 @@
+#include "input_recording.hpp"
+
+#include <algorithm>     // for min
+#include <cstdint>       // for uint64_t
+#include <fstream>       // for ifstream, ofstream
+#include <optional>      // for optional
+#include <string>        // for string
+#include <string_view>   // for string_view
+#include <system_error>  // for error_code
+
+#include <fmt/format.h>            // for format
+#include <imgui/imgui_internal.h>  // for GImGui, ImGuiInputEvent
+
+#include "tools/traces.hpp"  // for Trace
+
+namespace
+{
+    // Followed by the ImGui version in the header, as the key codes are its
+    // own
+    constexpr std::string_view MAGIC { "FEINPUT" };
+    constexpr int              VERSION { 1 };
+    // Shortest event saved: five numbers of one digit and their separators
+    constexpr uint64_t         MIN_EVENT_SIZE { 10 };
+
+    // nullopt for the events the replay doesn't need
+    std::optional< InputRecording::Event > to_event (
+        ImGuiInputEvent const & event )
+    {
+        using Type = InputRecording::Event::Type;
+        switch ( event.Type )
+        {
+        case ImGuiInputEventType_MousePos :
+            return InputRecording::Event { Type::MousePosition,
+                                           event.MousePos.PosX,
+                                           event.MousePos.PosY, 0, false };
+        case ImGuiInputEventType_MouseWheel :
+            return InputRecording::Event { Type::MouseWheel,
+                                           event.MouseWheel.WheelX,
+                                           event.MouseWheel.WheelY, 0, false };
+        case ImGuiInputEventType_MouseButton :
+            return InputRecording::Event {
+                Type::MouseButton, 0.f, 0.f,
+                static_cast< unsigned int >( event.MouseButton.Button ),
+                event.MouseButton.Down };
+        case ImGuiInputEventType_Key :
+            return InputRecording::Event {
+                Type::Key, event.Key.AnalogValue, 0.f,
+                static_cast< unsigned int >( event.Key.Key ), event.Key.Down };
+        case ImGuiInputEventType_Text :
+            return InputRecording::Event { Type::Text, 0.f, 0.f,
+                                           event.Text.Char, false };
+        case ImGuiInputEventType_Focus :
+            return InputRecording::Event { Type::Focus, 0.f, 0.f, 0,
+                                           event.AppFocused.Focused };
+        default :
+            return std::nullopt;
+        }
+    }
+}  // namespace
+
+InputRecording::InputRecording()
+  : m_frames {}, m_start { std::chrono::steady_clock::now() }
+{}
+
+void InputRecording::record_frame()
+{
+    ImGuiIO const & io = ImGui::GetIO();
+
+    Frame frame { std::chrono::duration_cast< std::chrono::microseconds >(
+                      std::chrono::steady_clock::now() - m_start ),
+                  io.DeltaTime, io.DisplaySize, {} };
+    for ( ImGuiInputEvent const & event : GImGui->InputEventsQueue )
+    {
+        std::optional< Event > recorded = to_event( event );
+        if ( recorded.has_value() )
+        {
+            frame.events.push_back( recorded.value() );
+        }
+    }
+    m_frames.push_back( std::move( frame ) );
+}
+
+bool InputRecording::save( fs::path const & file ) const
+{
+    std::ofstream output { file };
+    output << fmt::format( "{} {} {}\n", MAGIC, VERSION, IMGUI_VERSION_NUM );
+    for ( Frame const & frame : m_frames )
+    {
+        output << fmt::format( "{} {} {} {} {}\n", frame.time.count(),
+                               frame.deltaTime, frame.displaySize.x,
+                               frame.displaySize.y, frame.events.size() );
+        for ( Event const & event : frame.events )
+        {
+            output << fmt::format( "{} {} {} {} {}\n",
+                                   static_cast< int >( event.type ), event.x,
+                                   event.y, event.code, event.isDown ? 1 : 0 );
+        }
+    }
+
+    output.close();
+    if ( ! output )
+    {
+        Trace::Error( "Can't write the input recording {}", file.c_str() );
+        return false;
+    }
+    Trace::Info( "{} frames of input recorded in {}", m_frames.size(),
+                 file.c_str() );
+    return true;
+}
+
+bool InputRecording::load( fs::path const & file )
+{
+    std::ifstream   input { file };
+    std::error_code error {};
+    uint64_t        fileSize = fs::file_size( file, error );
+    if ( ! input || error )
+    {
+        Trace::Error( "Can't read the input recording {}", file.c_str() );
+        return false;
+    }
+
+    std::string magic {};
+    int         version { 0 };
+    int         imguiVersion { 0 };
+    input >> magic >> version >> imguiVersion;
+    if ( magic != MAGIC || version != VERSION )
+    {
+        Trace::Error( "{} isn't an input recording", file.c_str() );
+        return false;
+    }
+    if ( imguiVersion != IMGUI_VERSION_NUM )
+    {
+        Trace::Warning(
+            "{} has been recorded with ImGui {}, its keys may differ",
+            file.c_str(), imguiVersion );
+    }
+
+    m_frames.clear();
+    int64_t     time;
+    std::size_t nbEvents;
+    Frame       frame {};
+    while ( input >> time >> frame.deltaTime >> frame.displaySize.x
+            >> frame.displaySize.y >> nbEvents )
+    {
+        // A corrupted count would allocate more events than the file holds
+        auto position = static_cast< uint64_t >( input.tellg() );
+        if ( nbEvents > ( fileSize - std::min( position, fileSize ) )
+                            / MIN_EVENT_SIZE )
+        {
+            Trace::Error( "{} is corrupted, {} events announced", file.c_str(),
+                          nbEvents );
+            m_frames.clear();
+            return false;
+        }
+        frame.time = std::chrono::microseconds { time };
+        frame.events.resize( nbEvents );
+        for ( Event & event : frame.events )
+        {
+            int type { 0 };
+            int isDown { 0 };
+            input >> type >> event.x >> event.y >> event.code >> isDown;
+            if ( type < 0 || type > static_cast< int >( Event::Type::Focus ) )
+            {
+                input.setstate( std::ios::failbit );
+            }
+            event.type   = static_cast< Event::Type >( type );
+            event.isDown = isDown != 0;
+        }
+        // The last frame of a recording cut short is dropped
+        if ( ! input )
+        {
+            break;
+        }
+        m_frames.push_back( frame );
+    }
+
+    if ( ! input.eof() )
+    {
+        Trace::Error( "{} is corrupted", file.c_str() );
+        m_frames.clear();
+        return false;
+    }
+    return true;
+}
+
+std::vector< InputRecording::Frame > const & InputRecording::get_frames() const
+{
+    return m_frames;
+}
+
+void InputRecording::queue_events( Frame const & frame )
+{
+    ImGuiIO & io = ImGui::GetIO();
+    for ( Event const & event : frame.events )
+    {
+        switch ( event.type )
+        {
+        case Event::Type::MousePosition :
+            io.AddMousePosEvent( event.x, event.y );
+            break;
+        case Event::Type::MouseWheel :
+            io.AddMouseWheelEvent( event.x, event.y );
+            break;
+        case Event::Type::MouseButton :
+            io.AddMouseButtonEvent( static_cast< int >( event.code ),
+                                    event.isDown );
+            break;
+        case Event::Type::Key :
+            io.AddKeyAnalogEvent( static_cast< ImGuiKey >( event.code ),
+                                  event.isDown, event.x );
+            break;
+        case Event::Type::Text :
+            io.AddInputCharacter( event.code );
+            break;
+        case Event::Type::Focus :
+            io.AddFocusEvent( event.isDown );
+            break;
+        }
+    }
+}
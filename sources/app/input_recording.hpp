@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>  // for steady_clock, microseconds
+#include <vector>  // for vector
+
+#include <imgui/imgui.h>  // for ImVec2
+
+#include "app/filesystem.hpp"  // for fs::path
+
+// Input events given to ImGui, frame by frame, to replay a session exactly in
+// a headless window. They are taken from the ImGui queue once the backend has
+// translated the GLFW events, so the replay doesn't need GLFW.
+class InputRecording
+{
+  public:
+    struct Event
+    {
+        enum class Type
+        {
+            MousePosition = 0,
+            MouseWheel,
+            MouseButton,
+            Key,
+            Text,
+            Focus
+        };
+
+        Type         type;
+        // Mouse position, wheel offsets, or analog value of a key in x
+        float        x;
+        float        y;
+        // Mouse button, key or character
+        unsigned int code;
+        // Pressed button or key, focused window
+        bool         isDown;
+    };
+
+    struct Frame
+    {
+        // Since the start of the recording, when the events were received
+        std::chrono::microseconds time;
+        float                     deltaTime;
+        ImVec2                    displaySize;
+        std::vector< Event >      events;
+    };
+
+  private:
+    std::vector< Frame >                  m_frames;
+    std::chrono::steady_clock::time_point m_start;
+
+  public:
+    InputRecording();
+    virtual ~InputRecording() = default;
+
+    // Take the events queued for the next frame, between the new frame of the
+    // backend and the one of ImGui
+    void record_frame ();
+
+    bool save ( fs::path const & file ) const;
+    // Return false if the file isn't a valid recording
+    bool load ( fs::path const & file );
+
+    std::vector< Frame > const & get_frames () const;
+
+    // Give the events of the frame to ImGui, for its next frame
+    static void queue_events ( Frame const & frame );
+};
@@ -0,0 +1,578 @@
+#include "job_scheduler.hpp"
+
+#include <algorithm>  // for clamp, nth_element, partition
+#include <climits>    // for UINT_MAX
+#include <exception>  // for exception
+#include <iterator>   // for back_inserter
+
+#include <sys/resource.h>  // for setpriority
+#include <sys/stat.h>      // for stat
+#include <sys/syscall.h>   // for SYS_ioprio_set
+#include <unistd.h>        // for gettid, syscall
+
+#include <imgui/imgui.h>  // for ImGui::BeginTable
+
+#include "app/device_info.hpp"        // for DeviceInfo
+#include "app/explorer_settings.hpp"  // for ExplorerSettings
+#include "tools/traces.hpp"           // for Trace
+
+namespace
+{
+    // Threads of each group of classes
+    constexpr unsigned int NB_METADATA_THREADS { 6 };
+    constexpr unsigned int NB_PREFETCH_THREADS { 1 };
+    constexpr unsigned int MAX_BACKGROUND_THREADS { 16 };
+    // Measures kept for the latency percentiles
+    constexpr std::size_t  NB_MEASURES { 256 };
+
+    // No glibc wrapper, see linux/ioprio.h
+    constexpr int IOPRIO_WHO_PROCESS { 1 };
+    constexpr int IOPRIO_CLASS_SHIFT { 13 };
+    constexpr int IOPRIO_CLASS_BE { 2 };
+    constexpr int IOPRIO_CLASS_IDLE { 3 };
+    // Lowest level of the best effort class
+    constexpr int IOPRIO_BE_LOWEST { 7 };
+
+    constexpr char const * CLASS_NAMES[] { "Interactive", "Metadata",
+                                           "Prefetch", "Background" };
+
+    double to_milliseconds ( std::chrono::steady_clock::duration duration )
+    {
+        return std::chrono::duration< double, std::milli > { duration }
+            .count();
+    }
+
+    double get_percentile ( RingBuffer< double > const & measures,
+                            double                       percentile )
+    {
+        if ( measures.empty() )
+        {
+            return 0.;
+        }
+        std::vector< double > values {};
+        for ( std::size_t idx = 0; idx < measures.size(); ++idx )
+        {
+            values.push_back( measures[idx] );
+        }
+        double rank = percentile * static_cast< double >( values.size() - 1 );
+        auto   nth  = values.begin() + static_cast< std::ptrdiff_t >( rank );
+        std::nth_element( values.begin(), nth, values.end() );
+        return *nth;
+    }
+}  // namespace
+
+JobScheduler::Queue::Queue( JobClass jobClass )
+  : m_jobClass { jobClass }, m_id { JobScheduler::get_instance().add_queue() }
+{}
+
+JobScheduler::Queue::~Queue()
+{
+    this->cancel();
+}
+
+void JobScheduler::Queue::submit( dev_t device, Task task, int64_t priority,
+                                  std::stop_token stopToken )
+{
+    JobScheduler::get_instance().submit(
+        m_jobClass, Job { m_id, device, 0, priority, 0,
+                          std::move( stopToken ), std::move( task ), {} } );
+}
+
+void JobScheduler::Queue::wait()
+{
+    JobScheduler::get_instance().wait( m_id );
+}
+
+void JobScheduler::Queue::cancel()
+{
+    JobScheduler::get_instance().cancel( m_jobClass, m_id );
+}
+
+JobScheduler::ClassState::ClassState()
+  : jobs {},
+    nbRunning { 0 },
+    nbDone { 0 },
+    nbCancelled { 0 },
+    waitTimes { NB_MEASURES },
+    runTimes { NB_MEASURES }
+{}
+
+JobScheduler::JobScheduler()
+  : m_mutex {},
+    m_condition {},
+    m_classes {},
+    m_devices {},
+    m_nbJobsByQueue {},
+    m_navigation {},
+    m_nbQueues { 0 },
+    m_nbSubmitted { 0 },
+    m_nbBusyThreads { 0 },
+    m_threads {}
+{
+    // Constructed before the scheduler so they are destroyed after it
+    Settings::get_instance();
+    DeviceInfo::get_instance();
+
+    auto add_threads = [this] ( unsigned int nbThreads, JobClass first,
+                                JobClass last ) {
+        for ( unsigned int idx = 0; idx < nbThreads; ++idx )
+        {
+            m_threads.emplace_back(
+                [this, first, last] ( std::stop_token stopToken ) {
+                    this->run( stopToken, first, last );
+                } );
+        }
+    };
+    add_threads( NB_METADATA_THREADS, JobClass::Interactive,
+                 JobClass::Metadata );
+    add_threads( NB_PREFETCH_THREADS, JobClass::Prefetch, JobClass::Prefetch );
+    add_threads( MAX_BACKGROUND_THREADS, JobClass::Background,
+                 JobClass::Background );
+}
+
+JobScheduler::~JobScheduler()
+{
+    for ( std::jthread & thread : m_threads )
+    {
+        thread.request_stop();
+    }
+    for ( std::jthread & thread : m_threads )
+    {
+        thread.join();
+    }
+
+    // Every queue should already be destroyed
+    std::stop_source stopped {};
+    stopped.request_stop();
+    for ( ClassState & state : m_classes )
+    {
+        for ( Job & job : state.jobs )
+        {
+            job.task( stopped.get_token() );
+        }
+        state.jobs.clear();
+    }
+}
+
+void JobScheduler::run_interactive( dev_t                           device,
+                                    std::function< void() > const & run )
+{
+    ClassState & state = this->get_state( JobClass::Interactive );
+    TimePoint    start = std::chrono::steady_clock::now();
+    unsigned int limit = device != 0 ? this->get_device_limit( device ) : 0;
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        ++state.nbRunning;
+        state.waitTimes.push_back( 0. );
+        if ( device != 0 )
+        {
+            DeviceState & deviceState = m_devices[device];
+            ++deviceState.nbRunning;
+            ++deviceState.nbInteractive;
+            deviceState.limit = limit;
+        }
+    }
+
+    run();
+
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        --state.nbRunning;
+        ++state.nbDone;
+        state.runTimes.push_back(
+            to_milliseconds( std::chrono::steady_clock::now() - start ) );
+        if ( device != 0 )
+        {
+            DeviceState & deviceState = m_devices[device];
+            --deviceState.nbRunning;
+            --deviceState.nbInteractive;
+            if ( deviceState.nbRunning == 0 )
+            {
+                m_devices.erase( device );
+            }
+        }
+    }
+    m_condition.notify_all();
+}
+
+void JobScheduler::navigate()
+{
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        m_navigation.request_stop();
+        m_navigation = std::stop_source {};
+    }
+    // The cancelled jobs are run first to release what they reserved
+    m_condition.notify_all();
+}
+
+void JobScheduler::debug_gui() const
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+
+    ImGui::Text( "Job scheduler" );
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders
+                            | ImGuiTableFlags_SizingFixedFit;
+    if ( ImGui::BeginTable( "Job Classes", 7, flags ) )
+    {
+        for ( char const * header :
+              { "Class", "Pending", "Running", "Done", "Cancelled",
+                "Wait p50 / p95", "Run p50 / p95" } )
+        {
+            ImGui::TableSetupColumn( header );
+        }
+        ImGui::TableHeadersRow();
+
+        for ( std::size_t idx = 0; idx < m_classes.size(); ++idx )
+        {
+            ClassState const & state    = m_classes[idx];
+            auto               jobClass = static_cast< JobClass >( idx );
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted( CLASS_NAMES[idx] );
+            ImGui::TableNextColumn();
+            ImGui::Text( "%lu", state.jobs.size() );
+            ImGui::TableNextColumn();
+            if ( jobClass == JobClass::Interactive )
+            {
+                ImGui::Text( "%u", state.nbRunning );
+            }
+            else
+            {
+                ImGui::Text( "%u / %u", state.nbRunning,
+                             this->get_class_limit( jobClass ) );
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text( "%lu", state.nbDone );
+            ImGui::TableNextColumn();
+            ImGui::Text( "%lu", state.nbCancelled );
+            ImGui::TableNextColumn();
+            ImGui::Text( "%.1f / %.1f ms",
+                         get_percentile( state.waitTimes, 0.5 ),
+                         get_percentile( state.waitTimes, 0.95 ) );
+            ImGui::TableNextColumn();
+            ImGui::Text( "%.1f / %.1f ms",
+                         get_percentile( state.runTimes, 0.5 ),
+                         get_percentile( state.runTimes, 0.95 ) );
+        }
+        ImGui::EndTable();
+    }
+
+    for ( auto const & [device, state] : m_devices )
+    {
+        ImGui::Text( "Device %lu: %u / %u running, %u interactive",
+                     static_cast< unsigned long >( device ), state.nbRunning,
+                     state.limit, state.nbInteractive );
+    }
+}
+
+std::size_t JobScheduler::get_nb_threads() const
+{
+    return m_threads.size();
+}
+
+unsigned int JobScheduler::get_nb_busy_threads() const
+{
+    return m_nbBusyThreads.load( std::memory_order_relaxed );
+}
+
+bool JobScheduler::is_interactive_running( dev_t device ) const
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    auto                          state = m_devices.find( device );
+    return state != m_devices.end() && state->second.nbInteractive > 0;
+}
+
+dev_t JobScheduler::get_device( fs::path const & path )
+{
+    struct stat status {};
+    if ( stat( path.c_str(), &status ) != 0 )
+    {
+        return 0;
+    }
+    return status.st_dev;
+}
+
+void JobScheduler::set_thread_class( JobClass jobClass )
+{
+    if ( jobClass != JobClass::Prefetch && jobClass != JobClass::Background )
+    {
+        return;
+    }
+
+    auto threadId = static_cast< id_t >( gettid() );
+    if ( setpriority( PRIO_PROCESS, threadId, 19 ) != 0 )
+    {
+        Trace::Warning( "Can't lower the CPU priority of a background thread" );
+    }
+    // The background jobs only read the disk when nothing else does
+    int ioPriority { jobClass == JobClass::Background
+                         ? IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT
+                         : IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT
+                               | IOPRIO_BE_LOWEST };
+    if ( syscall( SYS_ioprio_set, IOPRIO_WHO_PROCESS, threadId, ioPriority )
+         != 0 )
+    {
+        Trace::Warning( "Can't lower the I/O priority of a background thread" );
+    }
+}
+
+uint64_t JobScheduler::add_queue()
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    return ++m_nbQueues;
+}
+
+void JobScheduler::submit( JobClass jobClass, Job job )
+{
+    if ( job.device != 0 )
+    {
+        job.deviceLimit = this->get_device_limit( job.device );
+    }
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        job.order      = m_nbSubmitted++;
+        job.submitTime = std::chrono::steady_clock::now();
+        if ( is_tied_to_navigation( jobClass ) )
+        {
+            job.stopToken = m_navigation.get_token();
+        }
+        ++m_nbJobsByQueue[job.queue];
+        this->get_state( jobClass ).jobs.push_back( std::move( job ) );
+    }
+    // Each group of threads waits for its own classes
+    m_condition.notify_all();
+}
+
+void JobScheduler::wait( uint64_t queue )
+{
+    std::unique_lock< std::mutex > lock { m_mutex };
+    m_condition.wait( lock, [this, queue] () {
+        return ! m_nbJobsByQueue.contains( queue );
+    } );
+}
+
+void JobScheduler::cancel( JobClass jobClass, uint64_t queue )
+{
+    std::vector< Job > cancelled {};
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        ClassState & state = this->get_state( jobClass );
+        auto         end   = std::partition(
+            state.jobs.begin(), state.jobs.end(),
+            [queue] ( Job const & job ) { return job.queue != queue; } );
+        std::move( end, state.jobs.end(), std::back_inserter( cancelled ) );
+        state.jobs.erase( end, state.jobs.end() );
+        state.nbCancelled += cancelled.size();
+    }
+
+    std::stop_source stopped {};
+    stopped.request_stop();
+    for ( Job & job : cancelled )
+    {
+        job.task( stopped.get_token() );
+    }
+
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        if ( ! cancelled.empty()
+             && ( m_nbJobsByQueue[queue] -= cancelled.size() ) == 0 )
+        {
+            m_nbJobsByQueue.erase( queue );
+        }
+    }
+    m_condition.notify_all();
+    this->wait( queue );
+}
+
+void JobScheduler::run( std::stop_token stopToken, JobClass first,
+                        JobClass last )
+{
+    set_thread_class( first );
+
+    while ( ! stopToken.stop_requested() )
+    {
+        JobClass  jobClass { first };
+        Job       job {};
+        bool      isCancelled { false };
+        TimePoint start {};
+        {
+            std::unique_lock< std::mutex > lock { m_mutex };
+            std::size_t                    idxJob { 0 };
+            auto has_next = [this, first, last, &jobClass, &idxJob] () {
+                for ( auto idx = static_cast< std::size_t >( first );
+                      idx <= static_cast< std::size_t >( last ); ++idx )
+                {
+                    jobClass = static_cast< JobClass >( idx );
+                    idxJob   = this->find_next( jobClass );
+                    if ( idxJob < this->get_state( jobClass ).jobs.size() )
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            };
+            if ( ! m_condition.wait( lock, stopToken, has_next ) )
+            {
+                return;
+            }
+
+            ClassState & state = this->get_state( jobClass );
+            job                = std::move( state.jobs[idxJob] );
+            if ( idxJob + 1 != state.jobs.size() )
+            {
+                state.jobs[idxJob] = std::move( state.jobs.back() );
+            }
+            state.jobs.pop_back();
+
+            start       = std::chrono::steady_clock::now();
+            isCancelled = job.stopToken.stop_requested();
+            if ( ! isCancelled )
+            {
+                ++state.nbRunning;
+                state.waitTimes.push_back(
+                    to_milliseconds( start - job.submitTime ) );
+                if ( job.device != 0 )
+                {
+                    DeviceState & deviceState = m_devices[job.device];
+                    ++deviceState.nbRunning;
+                    deviceState.limit = job.deviceLimit;
+                }
+            }
+        }
+
+        m_nbBusyThreads.fetch_add( 1, std::memory_order_relaxed );
+        // A job that throws must not take the worker down with the process
+        try
+        {
+            job.task( job.stopToken );
+        }
+        catch ( std::exception const & exception )
+        {
+            Trace::Error( "{} job failed: {}",
+                          CLASS_NAMES[static_cast< std::size_t >( jobClass )],
+                          exception.what() );
+        }
+        m_nbBusyThreads.fetch_sub( 1, std::memory_order_relaxed );
+        this->finish( jobClass, job, isCancelled, start );
+    }
+}
+
+std::size_t JobScheduler::find_next( JobClass jobClass ) const
+{
+    ClassState const & state = this->get_state( jobClass );
+    bool isFull = state.nbRunning >= this->get_class_limit( jobClass );
+    bool isLowPriority = jobClass == JobClass::Prefetch
+                         || jobClass == JobClass::Background;
+
+    std::size_t next = state.jobs.size();
+    for ( std::size_t idx = 0; idx < state.jobs.size(); ++idx )
+    {
+        Job const & job = state.jobs[idx];
+        if ( job.stopToken.stop_requested() )
+        {
+            return idx;
+        }
+        if ( isFull )
+        {
+            continue;
+        }
+
+        if ( job.device != 0 )
+        {
+            auto         device        = m_devices.find( job.device );
+            unsigned int nbRunning     = 0;
+            unsigned int nbInteractive = 0;
+            if ( device != m_devices.end() )
+            {
+                nbRunning     = device->second.nbRunning;
+                nbInteractive = device->second.nbInteractive;
+            }
+            unsigned int limit = job.deviceLimit;
+            // A place is kept for the urgent jobs
+            unsigned int nbReserved = isLowPriority && limit > 1 ? 1 : 0;
+            if ( nbRunning + nbReserved >= limit
+                 || ( isLowPriority && nbInteractive > 0 ) )
+            {
+                continue;
+            }
+        }
+
+        if ( next == state.jobs.size()
+             || job.priority > state.jobs[next].priority
+             || ( job.priority == state.jobs[next].priority
+                  && job.order < state.jobs[next].order ) )
+        {
+            next = idx;
+        }
+    }
+    return next;
+}
+
+void JobScheduler::finish( JobClass jobClass, Job const & job,
+                           bool isCancelled, TimePoint startTime )
+{
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        ClassState & state = this->get_state( jobClass );
+        if ( isCancelled )
+        {
+            ++state.nbCancelled;
+        }
+        else
+        {
+            --state.nbRunning;
+            ++state.nbDone;
+            state.runTimes.push_back( to_milliseconds(
+                std::chrono::steady_clock::now() - startTime ) );
+            if ( job.device != 0 && --m_devices[job.device].nbRunning == 0 )
+            {
+                m_devices.erase( job.device );
+            }
+        }
+        if ( --m_nbJobsByQueue[job.queue] == 0 )
+        {
+            m_nbJobsByQueue.erase( job.queue );
+        }
+    }
+    m_condition.notify_all();
+}
+
+unsigned int JobScheduler::get_class_limit( JobClass jobClass ) const
+{
+    switch ( jobClass )
+    {
+    case JobClass::Metadata :
+        return NB_METADATA_THREADS;
+    case JobClass::Prefetch :
+        return NB_PREFETCH_THREADS;
+    case JobClass::Background :
+        return std::clamp( Settings::get_instance().fileOperationThreads, 1u,
+                           MAX_BACKGROUND_THREADS );
+    case JobClass::Interactive :
+    case JobClass::Count :
+        break;
+    }
+    return UINT_MAX;
+}
+
+unsigned int JobScheduler::get_device_limit( dev_t device ) const
+{
+    return DeviceInfo::get_instance().get_concurrency( device );
+}
+
+JobScheduler::ClassState & JobScheduler::get_state( JobClass jobClass )
+{
+    return m_classes[static_cast< std::size_t >( jobClass )];
+}
+
+JobScheduler::ClassState const & JobScheduler::get_state(
+    JobClass jobClass ) const
+{
+    return m_classes[static_cast< std::size_t >( jobClass )];
+}
+
+bool JobScheduler::is_tied_to_navigation( JobClass jobClass )
+{
+    return jobClass == JobClass::Metadata || jobClass == JobClass::Prefetch;
+}
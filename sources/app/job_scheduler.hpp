@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>               // for array
+#include <atomic>              // for atomic
+#include <chrono>              // for steady_clock
+#include <condition_variable>  // for condition_variable_any
+#include <cstdint>             // for int64_t, uint64_t
+#include <functional>          // for function
+#include <mutex>               // for mutex
+#include <stop_token>          // for stop_token, stop_source
+#include <thread>              // for jthread
+#include <unordered_map>       // for unordered_map
+#include <vector>              // for vector
+
+#include <sys/types.h>  // for dev_t
+
+#include "app/filesystem.hpp"  // for fs::path
+#include "tools/ring_buffer.hpp"
+#include "tools/singleton.hpp"
+
+// Run the background work of the explorer, so the listings, the metadata of
+// the visible files, the prefetching and the file operations don't compete
+// equally for the disks. The most urgent class runs first, a device never
+// runs more jobs than its limit, and the least urgent classes always leave a
+// place on it to the others. They also run on threads with a low CPU and I/O
+// priority.
+class JobScheduler : public Singleton< JobScheduler >
+{
+    ENABLE_SINGLETON( JobScheduler );
+
+  public:
+    // From the most to the least urgent
+    enum class JobClass
+    {
+        // Directory read by the UI thread
+        Interactive = 0,
+        // Type, dimensions and thumbnail of the visible files
+        Metadata,
+        // Directories the user will probably open next
+        Prefetch,
+        // File operations and long scans
+        Background,
+        Count
+    };
+
+    // Called once, with a stop requested if the job has been cancelled before
+    // running, so it can release what it reserved
+    using Task = std::function< void( std::stop_token ) >;
+
+    // Jobs of an object. They are cancelled, and the running ones are
+    // waited, when it's destroyed, so no job outlives its owner.
+    class Queue
+    {
+        JobClass m_jobClass;
+        uint64_t m_id;
+
+      public:
+        explicit Queue( JobClass jobClass );
+        virtual ~Queue();
+
+        Queue( Queue const & )              = delete;
+        Queue & operator= ( Queue const & ) = delete;
+
+        // The device is the one the job reads, 0 if it doesn't read any. The
+        // highest priority of the class runs first, the first submitted for
+        // the same priority. The jobs of the classes tied to the current
+        // directory are stopped by a navigation instead of the stop token.
+        void submit ( dev_t device, Task task, int64_t priority = 0,
+                      std::stop_token stopToken = {} );
+        // Wait for every job submitted to be done
+        void wait ();
+        // Cancel the pending jobs on the calling thread, and wait for the
+        // running ones
+        void cancel ();
+    };
+
+  private:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    struct Job
+    {
+        uint64_t        queue;
+        dev_t           device;
+        // Found when submitted, as DeviceInfo may read the mounts and sysfs
+        // to find it, which mustn't be done with the lock taken
+        unsigned int    deviceLimit;
+        int64_t         priority;
+        uint64_t        order;
+        std::stop_token stopToken;
+        Task            task;
+        TimePoint       submitTime;
+    };
+
+    struct ClassState
+    {
+        // Not sorted, searched for the next job allowed to run
+        std::vector< Job >   jobs;
+        unsigned int         nbRunning;
+        uint64_t             nbDone;
+        uint64_t             nbCancelled;
+        // Last measures, in milliseconds
+        RingBuffer< double > waitTimes;
+        RingBuffer< double > runTimes;
+
+        ClassState();
+    };
+
+    struct DeviceState
+    {
+        unsigned int nbRunning;
+        unsigned int nbInteractive;
+        unsigned int limit;
+    };
+
+    mutable std::mutex          m_mutex;
+    std::condition_variable_any m_condition;
+    std::array< ClassState, static_cast< std::size_t >( JobClass::Count ) >
+                                                 m_classes;
+    std::unordered_map< dev_t, DeviceState >     m_devices;
+    // Pending and running jobs of each queue
+    std::unordered_map< uint64_t, std::size_t >  m_nbJobsByQueue;
+    // Stopped when the user leaves the directory
+    std::stop_source                             m_navigation;
+    uint64_t                                     m_nbQueues;
+    uint64_t                                     m_nbSubmitted;
+    // Workers running a job, read without lock by the performance overlay
+    std::atomic< unsigned int >                  m_nbBusyThreads;
+    // Started last, once every other member is initialized
+    std::vector< std::jthread >                  m_threads;
+
+    JobScheduler();
+    virtual ~JobScheduler();
+
+  public:
+    // Run the function on the calling thread as an interactive job, the
+    // prefetch and background jobs don't start on the device meanwhile
+    void run_interactive ( dev_t device, std::function< void() > const & run );
+    // Cancel the jobs tied to the directory the user is leaving, the ones
+    // still needed are submitted again by their owner
+    void navigate ();
+
+    void debug_gui () const;
+
+    std::size_t  get_nb_threads () const;
+    unsigned int get_nb_busy_threads () const;
+    // True while the UI thread reads the device
+    bool         is_interactive_running ( dev_t device ) const;
+
+    // 0 if the path can't be stat
+    static dev_t get_device ( fs::path const & path );
+    // Lower the CPU and I/O priority of the calling thread to the one of the
+    // class. The threads it creates inherit it.
+    static void set_thread_class ( JobClass jobClass );
+
+  private:
+    uint64_t add_queue ();
+    void     submit ( JobClass jobClass, Job job );
+    void     wait ( uint64_t queue );
+    void     cancel ( JobClass jobClass, uint64_t queue );
+
+    // Run the jobs of the classes from first to last
+    void        run ( std::stop_token stopToken, JobClass first,
+                      JobClass last );
+    // Index of the next job of the class allowed to start, a cancelled one
+    // first, the number of jobs if there is none
+    std::size_t find_next ( JobClass jobClass ) const;
+    void        finish ( JobClass jobClass, Job const & job, bool isCancelled,
+                         TimePoint startTime );
+
+    unsigned int get_class_limit ( JobClass jobClass ) const;
+    // Called without the lock
+    unsigned int get_device_limit ( dev_t device ) const;
+
+    ClassState &       get_state ( JobClass jobClass );
+    ClassState const & get_state ( JobClass jobClass ) const;
+
+    static bool is_tied_to_navigation ( JobClass jobClass );
+};
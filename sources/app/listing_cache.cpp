@@ -0,0 +1,219 @@
+#include "listing_cache.hpp"
+
+#include <imgui/imgui.h>  // for ImGui::Text
+
+#include "app/job_scheduler.hpp"  // for JobScheduler
+#include "app/mount_guard.hpp"    // for MountGuard
+#include "app/prefetcher.hpp"     // for Prefetcher
+#include "app/vfs.hpp"            // for vfs::get_file_system
+
+namespace
+{
+    constexpr std::size_t MAX_CACHED_LISTINGS { 64 };
+    // Longest a frame waits for a directory, the listing is cached once read
+    // if it's longer
+    constexpr std::chrono::milliseconds SCAN_TIMEOUT { 300 };
+
+    float ratio ( uint64_t numerator, uint64_t denominator )
+    {
+        if ( denominator == 0 )
+        {
+            return 0.f;
+        }
+        return static_cast< float >( numerator )
+               / static_cast< float >( denominator );
+    }
+}  // namespace
+
+ListingCache::ListingCache()
+  : m_mutex {},
+    m_slots {},
+    m_tick { 0 },
+    m_statistics {}
+{}
+
+std::shared_ptr< ds::Listing const > ListingCache::get(
+    fs::path const & directory, bool showHidden )
+{
+    // Checked without the lock, as the directory may be slow to answer
+    std::shared_ptr< ds::Listing const > listing =
+        this->find( directory, showHidden );
+    if ( listing && is_valid( *listing, showHidden ) )
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        ++m_statistics.lookups;
+        ++m_statistics.hits;
+        auto slot = m_slots.find( directory.string() );
+        if ( slot != m_slots.end() && slot->second.listing == listing )
+        {
+            if ( slot->second.isPrefetched )
+            {
+                ++m_statistics.prefetchHits;
+                slot->second.isPrefetched = false;
+            }
+            slot->second.lastUse = ++m_tick;
+        }
+        return listing;
+    }
+
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        ++m_statistics.lookups;
+    }
+    return this->scan( directory, showHidden );
+}
+
+std::shared_ptr< ds::Listing const > ListingCache::scan(
+    fs::path const & directory, bool showHidden )
+{
+    // Read by the scan worker of the mount, and cached even if it's too late
+    // for the caller
+    auto result = std::make_shared< std::shared_ptr< ds::Listing const > >();
+    bool isDone = MountGuard::get_instance().run(
+        directory,
+        [directory, showHidden, result] () {
+            // The prefetch and background jobs wait for it
+            JobScheduler::get_instance().run_interactive(
+                JobScheduler::get_device( directory ), [&] () {
+                    *result = ds::scan_directory( directory, showHidden );
+                } );
+            if ( *result )
+            {
+                ListingCache::get_instance().insert( *result, false );
+            }
+        },
+        SCAN_TIMEOUT, MountGuard::Lane::Scan, true );
+    return isDone ? *result : nullptr;
+}
+
+std::shared_ptr< ds::Listing const > ListingCache::find(
+    fs::path const & directory, bool showHidden ) const
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    auto slot = m_slots.find( directory.string() );
+    if ( slot == m_slots.end()
+         || slot->second.listing->showHidden != showHidden )
+    {
+        return nullptr;
+    }
+    return slot->second.listing;
+}
+
+void ListingCache::insert( std::shared_ptr< ds::Listing const > listing,
+                           bool                                 isPrefetched )
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+
+    Slot & slot = m_slots[listing->directory.string()];
+    if ( slot.isPrefetched )
+    {
+        ++m_statistics.prefetchWasted;
+    }
+    if ( isPrefetched )
+    {
+        ++m_statistics.prefetched;
+    }
+
+    slot.listing      = std::move( listing );
+    slot.lastUse      = ++m_tick;
+    slot.isPrefetched = isPrefetched;
+
+    this->evict();
+}
+
+bool ListingCache::contains( fs::path const & directory,
+                             bool             showHidden ) const
+{
+    std::shared_ptr< ds::Listing const > listing =
+        this->find( directory, showHidden );
+    return listing && is_valid( *listing, showHidden );
+}
+
+ListingCache::Statistics ListingCache::get_statistics() const
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    return m_statistics;
+}
+
+void ListingCache::clear()
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    m_slots.clear();
+}
+
+void ListingCache::debug_gui()
+{
+    Statistics  statistics = this->get_statistics();
+    std::size_t nbListings = 0;
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        nbListings = m_slots.size();
+    }
+
+    ImGui::Text( "Cached listings: %lu / %lu", nbListings,
+                 MAX_CACHED_LISTINGS );
+    ImGui::Text( "Lookups: %lu", statistics.lookups );
+    ImGui::Text( "Hit rate: %.1f %%",
+                 100.f * ratio( statistics.hits, statistics.lookups ) );
+
+    ImGui::Separator();
+
+    ImGui::Text( "Prefetch queue: %lu",
+                 Prefetcher::get_instance().get_queue_size() );
+    ImGui::Text( "Prefetched listings: %lu", statistics.prefetched );
+    ImGui::Text( "Prefetch hits: %lu (%.1f %% of lookups)",
+                 statistics.prefetchHits,
+                 100.f * ratio( statistics.prefetchHits, statistics.lookups ) );
+    ImGui::Text( "Prefetch wasted: %lu", statistics.prefetchWasted );
+    ImGui::Text(
+        "Prefetch usefulness: %.1f %%",
+        100.f * ratio( statistics.prefetchHits, statistics.prefetched ) );
+
+    if ( ImGui::Button( "Clear Cache" ) )
+    {
+        this->clear();
+    }
+}
+
+bool ListingCache::is_valid( ds::Listing const & listing, bool showHidden )
+{
+    if ( listing.showHidden != showHidden )
+    {
+        return false;
+    }
+
+    // Adding, removing or renaming an entry updates the directory write time
+    return MountGuard::get_instance()
+        .call< bool >( listing.directory,
+                       [directory     = listing.directory,
+                        lastWriteTime = listing.lastWriteTime] () {
+                           std::error_code error {};
+                           return vfs::get_file_system()
+                                          .status( directory, error )
+                                          .modificationTime
+                                      == lastWriteTime
+                                  && ! error;
+                       } )
+        .value_or( false );
+}
+
+void ListingCache::evict()
+{
+    while ( m_slots.size() > MAX_CACHED_LISTINGS )
+    {
+        auto oldest = m_slots.begin();
+        for ( auto slot = m_slots.begin(); slot != m_slots.end(); ++slot )
+        {
+            if ( slot->second.lastUse < oldest->second.lastUse )
+            {
+                oldest = slot;
+            }
+        }
+
+        if ( oldest->second.isPrefetched )
+        {
+            ++m_statistics.prefetchWasted;
+        }
+        m_slots.erase( oldest );
+    }
+}
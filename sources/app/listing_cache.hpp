@@ -0,0 +1,71 @@
+#pragma once
+
+#include <mutex>          // for mutex
+#include <unordered_map>  // for unordered_map
+
+#include "app/filesystem.hpp"  // for ds::Listing
+#include "tools/singleton.hpp"
+
+// Keep the last listings read, so navigating to an already visited (or
+// prefetched) directory doesn't need to read it again
+class ListingCache : public Singleton< ListingCache >
+{
+    ENABLE_SINGLETON( ListingCache );
+
+  public:
+    struct Statistics
+    {
+        uint64_t lookups;
+        uint64_t hits;
+        // Foreground lookups served by a listing read by the prefetcher
+        uint64_t prefetchHits;
+        // Listings inserted by the prefetcher
+        uint64_t prefetched;
+        // Prefetched listings evicted or invalidated before being used
+        uint64_t prefetchWasted;
+    };
+
+  private:
+    struct Slot
+    {
+        std::shared_ptr< ds::Listing const > listing;
+        uint64_t                             lastUse;
+        bool                                 isPrefetched;
+    };
+
+    mutable std::mutex                       m_mutex;
+    std::unordered_map< std::string, Slot >  m_slots;
+    uint64_t                                 m_tick;
+    Statistics                               m_statistics;
+
+    ListingCache();
+    virtual ~ListingCache() = default;
+
+  public:
+    // Return the cached listing if it's still valid, read the directory
+    // otherwise
+    std::shared_ptr< ds::Listing const > get ( fs::path const & directory,
+                                               bool             showHidden );
+    // Always read the directory and replace the cached listing. Return
+    // nullptr if the mount of the directory is too slow to answer, the
+    // listing is cached once it has been read.
+    std::shared_ptr< ds::Listing const > scan ( fs::path const & directory,
+                                                bool             showHidden );
+    // The cached listing, without checking if it's still valid
+    std::shared_ptr< ds::Listing const > find ( fs::path const & directory,
+                                                bool showHidden ) const;
+    void insert ( std::shared_ptr< ds::Listing const > listing,
+                  bool                                 isPrefetched );
+    bool contains ( fs::path const & directory, bool showHidden ) const;
+
+    Statistics get_statistics () const;
+
+    void clear ();
+    void debug_gui ();
+
+    // The listing is valid if the directory hasn't changed since it was read
+    static bool is_valid ( ds::Listing const & listing, bool showHidden );
+
+  private:
+    void evict ();
+};
@@ -0,0 +1,642 @@
+#include "memory_file_system.hpp"
+
+#include <algorithm>  // for min, remove
+#include <cerrno>     // for ENOENT, ENOTDIR, EISDIR, ELOOP
+#include <charconv>   // for from_chars
+#include <cstring>    // for memcpy
+#include <thread>     // for sleep_for
+
+#include <fmt/format.h>   // for format
+#include <imgui/imgui.h>  // for ImGui::SliderInt
+
+namespace
+{
+    constexpr std::string_view SYNTHETIC_FILE_PREFIX { "file_" };
+    constexpr std::string_view SYNTHETIC_DIRECTORY_PREFIX { "dir_" };
+    // Modification time of the tree when it's created, and of every synthetic
+    // file: 2023-11-14, in nanoseconds
+    constexpr int64_t          START_TIME { 1'700'000'000'000'000'000 };
+    // Time passed between two changes of the tree
+    constexpr int64_t          CHANGE_DURATION { 1'000'000 };
+    // Same as Linux, the symbolic links aren't followed more than this
+    constexpr unsigned int     MAX_SYMLINK_DEPTH { 40 };
+    // Size given to the directories, as most filesystems do
+    constexpr uint64_t         DIRECTORY_SIZE { 4096 };
+
+    // Directories nested in the synthetic home, and their number in each
+    // directory
+    constexpr unsigned int HOME_DEPTH { 2 };
+    constexpr unsigned int HOME_DIRECTORIES { 10 };
+    constexpr uint64_t     HOME_MAX_SIZE { 1024 * 1024 };
+
+    std::error_code make_error ( int value )
+    {
+        return std::error_code { value, std::generic_category() };
+    }
+
+    std::string get_parent ( std::string const & path )
+    {
+        std::size_t separator = path.find_last_of( '/' );
+        return separator == 0 ? "/" : path.substr( 0, separator );
+    }
+
+    std::string get_child ( std::string const & directory,
+                            std::string_view    name )
+    {
+        return directory == "/" ? fmt::format( "/{}", name )
+                                : fmt::format( "{}/{}", directory, name );
+    }
+
+    // Digits of the indices of the synthetic names, so they sort in order
+    unsigned int get_width ( uint64_t nbEntries )
+    {
+        unsigned int width { 1 };
+        for ( uint64_t max = nbEntries - 1; max >= 10; max /= 10 )
+        {
+            ++width;
+        }
+        return width;
+    }
+
+    std::string get_synthetic_name ( std::string_view prefix, uint64_t index,
+                                     uint64_t nbEntries )
+    {
+        return fmt::format( "{}{:0{}}", prefix, index,
+                            get_width( nbEntries ) );
+    }
+
+    // Same hash as splitmix64, so the sizes look random but are always the
+    // same
+    uint64_t get_synthetic_size ( uint64_t inode, uint64_t maxSize )
+    {
+        uint64_t hash = inode + 0x9e3779b97f4a7c15;
+        hash = ( hash ^ ( hash >> 30 ) ) * 0xbf58476d1ce4e5b9;
+        hash = ( hash ^ ( hash >> 27 ) ) * 0x94d049bb133111eb;
+        hash ^= hash >> 31;
+        return hash % ( maxSize + 1 );
+    }
+
+    class MemoryFile : public vfs::File
+    {
+        std::shared_ptr< vfs::MemoryFileSystem::Counters > m_counters;
+        // Nullptr for a synthetic file
+        std::shared_ptr< std::string const >               m_content;
+        uint64_t                                           m_size;
+
+      public:
+        MemoryFile(
+            std::shared_ptr< vfs::MemoryFileSystem::Counters > counters,
+            std::shared_ptr< std::string const > content, uint64_t size )
+          : m_counters { std::move( counters ) },
+            m_content { std::move( content ) },
+            m_size { size }
+        {}
+        virtual ~MemoryFile() = default;
+
+        ssize_t read_at ( void * buffer, std::size_t size,
+                          uint64_t offset ) override
+        {
+            m_counters->wait( vfs::MemoryFileSystem::Operation::Read );
+            if ( offset >= m_size )
+            {
+                return 0;
+            }
+            std::size_t nbRead = static_cast< std::size_t >(
+                std::min< uint64_t >( size, m_size - offset ) );
+            auto * bytes = static_cast< char * >( buffer );
+            if ( m_content )
+            {
+                std::memcpy( bytes, m_content->data() + offset, nbRead );
+                return static_cast< ssize_t >( nbRead );
+            }
+            vfs::fill_synthetic_content( bytes, nbRead, offset );
+            return static_cast< ssize_t >( nbRead );
+        }
+
+        uint64_t get_size () const override
+        {
+            return m_size;
+        }
+    };
+
+    class MemoryWatch : public vfs::Watch
+    {
+        std::shared_ptr< vfs::MemoryFileSystem::Watchers > m_watchers;
+        std::string                                        m_directory;
+        uint64_t                                           m_id;
+
+      public:
+        MemoryWatch(
+            std::shared_ptr< vfs::MemoryFileSystem::Watchers > watchers,
+            std::string directory, uint64_t id )
+          : m_watchers { std::move( watchers ) },
+            m_directory { std::move( directory ) },
+            m_id { id }
+        {}
+        virtual ~MemoryWatch()
+        {
+            std::lock_guard< std::mutex > lock { m_watchers->mutex };
+            auto watched = m_watchers->callbacks.find( m_directory );
+            if ( watched != m_watchers->callbacks.end() )
+            {
+                watched->second.erase( m_id );
+                if ( watched->second.empty() )
+                {
+                    m_watchers->callbacks.erase( watched );
+                }
+            }
+        }
+
+        MemoryWatch( MemoryWatch const & )              = delete;
+        MemoryWatch & operator= ( MemoryWatch const & ) = delete;
+    };
+}  // namespace
+
+namespace vfs
+{
+    void MemoryFileSystem::Counters::wait( Operation operation )
+    {
+        auto index = static_cast< std::size_t >( operation );
+        ++nbCalls[index];
+        std::chrono::microseconds latency { latencies[index].load() };
+        if ( latency.count() > 0 )
+        {
+            std::this_thread::sleep_for( latency );
+        }
+    }
+
+    MemoryFileSystem::MemoryFileSystem()
+      : m_mutex {},
+        m_nodes {},
+        m_nextInode { 2 },
+        m_clock { START_TIME },
+        m_counters { std::make_shared< Counters >() },
+        m_watchers { std::make_shared< Watchers >() }
+    {
+        m_nodes.emplace( "/", Node { FileKind::Directory, 1, m_clock, nullptr,
+                                     {}, {}, 0, 0, 0 } );
+    }
+
+    std::vector< DirectoryEntry > MemoryFileSystem::enumerate(
+        fs::path const & directory, std::error_code & error )
+    {
+        m_counters->wait( Operation::Enumerate );
+
+        std::vector< DirectoryEntry > entries {};
+        std::lock_guard< std::mutex > lock { m_mutex };
+        std::string path { vfs::normalize( directory ) };
+        Node        synthetic {};
+        Node const * node = this->resolve( path, synthetic );
+        if ( node == nullptr || node->kind != FileKind::Directory )
+        {
+            error = make_error( node == nullptr ? ENOENT : ENOTDIR );
+            return entries;
+        }
+        error.clear();
+
+        entries.reserve( node->children.size() + node->nbSyntheticFiles );
+        for ( std::string const & name : node->children )
+        {
+            entries.push_back( DirectoryEntry {
+                name, m_nodes.at( get_child( path, name ) ).kind } );
+        }
+        for ( uint64_t idx = 0; idx < node->nbSyntheticFiles; ++idx )
+        {
+            entries.push_back( DirectoryEntry {
+                get_synthetic_name( SYNTHETIC_FILE_PREFIX, idx,
+                                    node->nbSyntheticFiles ),
+                FileKind::Regular } );
+        }
+        return entries;
+    }
+
+    Status MemoryFileSystem::status( fs::path const &  path,
+                                     std::error_code & error )
+    {
+        m_counters->wait( Operation::Stat );
+
+        std::lock_guard< std::mutex > lock { m_mutex };
+        Node         synthetic {};
+        Node const * node = this->resolve( vfs::normalize( path ), synthetic );
+        if ( node == nullptr )
+        {
+            error = make_error( ENOENT );
+            return Status { FileKind::Unknown, 0, 0, 0, 0 };
+        }
+        error.clear();
+        return get_status( *node );
+    }
+
+    Status MemoryFileSystem::symlink_status( fs::path const &  path,
+                                             std::error_code & error )
+    {
+        m_counters->wait( Operation::Stat );
+
+        std::lock_guard< std::mutex > lock { m_mutex };
+        Node         synthetic {};
+        Node const * node = this->find( vfs::normalize( path ), synthetic );
+        if ( node == nullptr )
+        {
+            error = make_error( ENOENT );
+            return Status { FileKind::Unknown, 0, 0, 0, 0 };
+        }
+        error.clear();
+        return get_status( *node );
+    }
+
+    std::unique_ptr< File > MemoryFileSystem::open( fs::path const &  path,
+                                                    std::error_code & error )
+    {
+        m_counters->wait( Operation::Open );
+
+        std::lock_guard< std::mutex > lock { m_mutex };
+        Node         synthetic {};
+        Node const * node = this->resolve( vfs::normalize( path ), synthetic );
+        if ( node == nullptr || node->kind != FileKind::Regular )
+        {
+            error = make_error( node == nullptr ? ENOENT : EISDIR );
+            return nullptr;
+        }
+        error.clear();
+        return std::make_unique< MemoryFile >( m_counters, node->content,
+                                               get_status( *node ).size );
+    }
+
+    std::unique_ptr< Watch > MemoryFileSystem::watch(
+        fs::path const & directory, std::function< void() > onChange,
+        std::error_code & error )
+    {
+        m_counters->wait( Operation::Watch );
+
+        std::string path { vfs::normalize( directory ) };
+        {
+            std::lock_guard< std::mutex > lock { m_mutex };
+            auto node = m_nodes.find( path );
+            if ( node == m_nodes.end()
+                 || node->second.kind != FileKind::Directory )
+            {
+                error = make_error( node == m_nodes.end() ? ENOENT : ENOTDIR );
+                return nullptr;
+            }
+        }
+        error.clear();
+
+        std::lock_guard< std::mutex > lock { m_watchers->mutex };
+        uint64_t id { m_watchers->nextId++ };
+        m_watchers->callbacks[path].emplace( id, std::move( onChange ) );
+        return std::make_unique< MemoryWatch >( m_watchers, path, id );
+    }
+
+    bool MemoryFileSystem::create_directory( fs::path const & path )
+    {
+        std::string directory { vfs::normalize( path ) };
+        bool        isCreated { false };
+        {
+            std::lock_guard< std::mutex > lock { m_mutex };
+            Node * node = this->insert( directory, FileKind::Directory );
+            isCreated   = node != nullptr && node->kind == FileKind::Directory;
+        }
+        this->notify( get_parent( directory ) );
+        return isCreated;
+    }
+
+    bool MemoryFileSystem::create_file( fs::path const & path,
+                                        std::string      content )
+    {
+        std::string file { vfs::normalize( path ) };
+        {
+            std::lock_guard< std::mutex > lock { m_mutex };
+            Node * node = this->insert( file, FileKind::Regular );
+            if ( node == nullptr || node->kind != FileKind::Regular )
+            {
+                return false;
+            }
+            node->content = std::make_shared< std::string const >(
+                std::move( content ) );
+            node->modificationTime = m_clock;
+        }
+        this->notify( get_parent( file ) );
+        return true;
+    }
+
+    bool MemoryFileSystem::create_symlink( fs::path const & target,
+                                           fs::path const & path )
+    {
+        std::string link { vfs::normalize( path ) };
+        {
+            std::lock_guard< std::mutex > lock { m_mutex };
+            Node * node = this->insert( link, FileKind::Symlink );
+            if ( node == nullptr || node->kind != FileKind::Symlink )
+            {
+                return false;
+            }
+            node->target = target;
+        }
+        this->notify( get_parent( link ) );
+        return true;
+    }
+
+    bool MemoryFileSystem::create_synthetic_files( fs::path const & directory,
+                                                   uint64_t         nbFiles,
+                                                   uint64_t         maxSize )
+    {
+        std::string path { vfs::normalize( directory ) };
+        {
+            std::lock_guard< std::mutex > lock { m_mutex };
+            Node * node = this->insert( path, FileKind::Directory );
+            if ( node == nullptr || node->kind != FileKind::Directory )
+            {
+                return false;
+            }
+            node->nbSyntheticFiles    = nbFiles;
+            node->maxSyntheticSize    = maxSize;
+            node->firstSyntheticInode = m_nextInode;
+            node->modificationTime    = m_clock += CHANGE_DURATION;
+            m_nextInode += nbFiles;
+        }
+        this->notify( path );
+        return true;
+    }
+
+    bool MemoryFileSystem::create_synthetic_tree(
+        fs::path const & root, unsigned int depth, unsigned int nbDirectories,
+        uint64_t nbFiles, uint64_t maxSize )
+    {
+        if ( ! this->create_synthetic_files( root, nbFiles, maxSize ) )
+        {
+            return false;
+        }
+        if ( depth == 0 )
+        {
+            return true;
+        }
+        for ( unsigned int idx = 0; idx < nbDirectories; ++idx )
+        {
+            fs::path directory {
+                root
+                / get_synthetic_name( SYNTHETIC_DIRECTORY_PREFIX, idx,
+                                      nbDirectories ) };
+            if ( ! this->create_synthetic_tree( directory, depth - 1,
+                                                nbDirectories, nbFiles,
+                                                maxSize ) )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool MemoryFileSystem::remove( fs::path const & path )
+    {
+        std::string                removed { vfs::normalize( path ) };
+        std::vector< std::string > changed { get_parent( removed ) };
+        {
+            std::lock_guard< std::mutex > lock { m_mutex };
+            if ( removed == "/" || ! m_nodes.contains( removed ) )
+            {
+                return false;
+            }
+
+            std::vector< std::string > pending { removed };
+            while ( ! pending.empty() )
+            {
+                std::string current { std::move( pending.back() ) };
+                pending.pop_back();
+                auto node = m_nodes.find( current );
+                for ( std::string const & name : node->second.children )
+                {
+                    pending.push_back( get_child( current, name ) );
+                }
+                if ( node->second.kind == FileKind::Directory )
+                {
+                    changed.push_back( current );
+                }
+                m_nodes.erase( node );
+            }
+
+            Node &                       parent = m_nodes.at( changed.front() );
+            std::vector< std::string > & children = parent.children;
+            std::string                  name {
+                removed.substr( removed.find_last_of( '/' ) + 1 ) };
+            children.erase(
+                std::remove( children.begin(), children.end(), name ),
+                children.end() );
+            parent.modificationTime = m_clock += CHANGE_DURATION;
+        }
+        for ( std::string const & directory : changed )
+        {
+            this->notify( directory );
+        }
+        return true;
+    }
+
+    void MemoryFileSystem::set_latency( Operation                 operation,
+                                        std::chrono::microseconds latency )
+    {
+        m_counters->latencies[static_cast< std::size_t >( operation )] =
+            latency.count();
+    }
+
+    std::chrono::microseconds MemoryFileSystem::get_latency(
+        Operation operation ) const
+    {
+        return std::chrono::microseconds {
+            m_counters->latencies[static_cast< std::size_t >( operation )]
+                .load() };
+    }
+
+    uint64_t MemoryFileSystem::get_nb_calls( Operation operation ) const
+    {
+        return m_counters->nbCalls[static_cast< std::size_t >( operation )]
+            .load();
+    }
+
+    std::size_t MemoryFileSystem::get_nb_nodes() const
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        return m_nodes.size();
+    }
+
+    void MemoryFileSystem::debug_gui()
+    {
+        ImGui::Text( "Memory file system" );
+        ImGui::Text( "Stored entries: %lu", this->get_nb_nodes() );
+
+        ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders
+                                | ImGuiTableFlags_SizingFixedFit;
+        if ( ! ImGui::BeginTable( "Memory Operations", 3, flags ) )
+        {
+            return;
+        }
+        for ( char const * header : { "Operation", "Latency", "Calls" } )
+        {
+            ImGui::TableSetupColumn( header );
+        }
+        ImGui::TableHeadersRow();
+        for ( std::size_t idx = 0;
+              idx < static_cast< std::size_t >( Operation::Count ); ++idx )
+        {
+            auto operation = static_cast< Operation >( idx );
+            ImGui::PushID( static_cast< int >( idx ) );
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted( get_operation_name( operation ) );
+            ImGui::TableNextColumn();
+            int latency =
+                static_cast< int >( this->get_latency( operation ).count() );
+            ImGui::SetNextItemWidth( ImGui::GetFontSize() * 12.f );
+            if ( ImGui::SliderInt( "##Latency", &latency, 0, 10'000'000,
+                                   "%d us", ImGuiSliderFlags_Logarithmic ) )
+            {
+                this->set_latency( operation,
+                                   std::chrono::microseconds { latency } );
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text( "%lu", this->get_nb_calls( operation ) );
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+
+    char const * MemoryFileSystem::get_operation_name( Operation operation )
+    {
+        switch ( operation )
+        {
+        case Operation::Enumerate :
+            return "Enumerate";
+        case Operation::Stat :
+            return "Stat";
+        case Operation::Open :
+            return "Open";
+        case Operation::Read :
+            return "Read";
+        case Operation::Watch :
+            return "Watch";
+        case Operation::Count :
+            break;
+        }
+        return "Unknown";
+    }
+
+    MemoryFileSystem::Node const * MemoryFileSystem::find(
+        std::string const & path, Node & synthetic ) const
+    {
+        if ( auto node = m_nodes.find( path ); node != m_nodes.end() )
+        {
+            return &node->second;
+        }
+
+        // Maybe a synthetic file of its parent
+        auto parent = m_nodes.find( get_parent( path ) );
+        if ( parent == m_nodes.end() || parent->second.nbSyntheticFiles == 0 )
+        {
+            return nullptr;
+        }
+        Node const &     directory = parent->second;
+        std::string_view name { path };
+        name.remove_prefix( path.find_last_of( '/' ) + 1 );
+        if ( ! name.starts_with( SYNTHETIC_FILE_PREFIX )
+             || name.size() != SYNTHETIC_FILE_PREFIX.size()
+                                   + get_width( directory.nbSyntheticFiles ) )
+        {
+            return nullptr;
+        }
+        name.remove_prefix( SYNTHETIC_FILE_PREFIX.size() );
+        uint64_t index { 0 };
+        auto [end, error] =
+            std::from_chars( name.data(), name.data() + name.size(), index );
+        if ( error != std::errc {} || end != name.data() + name.size()
+             || index >= directory.nbSyntheticFiles )
+        {
+            return nullptr;
+        }
+
+        synthetic.kind             = FileKind::Regular;
+        synthetic.inode            = directory.firstSyntheticInode + index;
+        synthetic.modificationTime = START_TIME;
+        synthetic.content          = nullptr;
+        synthetic.maxSyntheticSize =
+            get_synthetic_size( synthetic.inode, directory.maxSyntheticSize );
+        return &synthetic;
+    }
+
+    MemoryFileSystem::Node const * MemoryFileSystem::resolve(
+        std::string path, Node & synthetic ) const
+    {
+        for ( unsigned int idx = 0; idx < MAX_SYMLINK_DEPTH; ++idx )
+        {
+            Node const * node = this->find( path, synthetic );
+            if ( node == nullptr || node->kind != FileKind::Symlink )
+            {
+                return node;
+            }
+            path = vfs::normalize( node->target.is_absolute()
+                                  ? node->target
+                                  : fs::path { get_parent( path ) }
+                                        / node->target );
+        }
+        return nullptr;
+    }
+
+    MemoryFileSystem::Node * MemoryFileSystem::insert( std::string const & path,
+                                                       FileKind kind )
+    {
+        if ( auto node = m_nodes.find( path ); node != m_nodes.end() )
+        {
+            return &node->second;
+        }
+
+        std::string parentPath { get_parent( path ) };
+        Node *      parent = this->insert( parentPath, FileKind::Directory );
+        if ( parent == nullptr || parent->kind != FileKind::Directory )
+        {
+            return nullptr;
+        }
+        m_clock += CHANGE_DURATION;
+        parent->children.push_back(
+            path.substr( path.find_last_of( '/' ) + 1 ) );
+        parent->modificationTime = m_clock;
+        return &m_nodes
+                    .emplace( path, Node { kind, m_nextInode++, m_clock,
+                                           nullptr, {}, {}, 0, 0, 0 } )
+                    .first->second;
+    }
+
+    Status MemoryFileSystem::get_status( Node const & node )
+    {
+        uint64_t size { DIRECTORY_SIZE };
+        if ( node.kind == FileKind::Regular )
+        {
+            size = node.content ? node.content->size() : node.maxSyntheticSize;
+        }
+        else if ( node.kind == FileKind::Symlink )
+        {
+            size = node.target.native().size();
+        }
+        return Status { node.kind, size, DEVICE, node.inode,
+                        node.modificationTime };
+    }
+
+    void MemoryFileSystem::notify( std::string const & directory )
+    {
+        std::lock_guard< std::mutex > lock { m_watchers->mutex };
+        auto watched = m_watchers->callbacks.find( directory );
+        if ( watched == m_watchers->callbacks.end() )
+        {
+            return;
+        }
+        for ( auto & [id, callback] : watched->second )
+        {
+            callback();
+        }
+    }
+
+    void use_synthetic_home ( uint64_t nbFiles )
+    {
+        auto fileSystem = std::make_shared< MemoryFileSystem >();
+        fileSystem->create_synthetic_tree(
+            ds::get_home_directory(), HOME_DEPTH, HOME_DIRECTORIES, nbFiles,
+            HOME_MAX_SIZE );
+        set_file_system( std::move( fileSystem ) );
+    }
+}  // namespace vfs
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>          // for array
+#include <atomic>         // for atomic
+#include <chrono>         // for microseconds
+#include <cstdint>        // for uint64_t, int64_t
+#include <memory>         // for shared_ptr
+#include <mutex>          // for mutex
+#include <string>         // for string
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+#include "app/vfs.hpp"  // for vfs::FileSystem
+
+namespace vfs
+{
+    // Tree held in memory, to measure the explorer on huge or slow
+    // directories the same way on any machine. The synthetic directories hold
+    // millions of files without storing them: their names, sizes and
+    // contents are computed from their index. Every operation can be slowed
+    // down by a fixed latency, as a network or a spinning disk would.
+    class MemoryFileSystem : public FileSystem
+    {
+      public:
+        enum class Operation
+        {
+            Enumerate = 0,
+            Stat,
+            Open,
+            Read,
+            Watch,
+            Count
+        };
+
+        // Shared with the files and the watches, which may outlive the file
+        // system
+        struct Counters
+        {
+            std::array< std::atomic< int64_t >,
+                        static_cast< std::size_t >( Operation::Count ) >
+                latencies;
+            std::array< std::atomic< uint64_t >,
+                        static_cast< std::size_t >( Operation::Count ) >
+                nbCalls;
+
+            // Count the call and wait for its latency
+            void wait ( Operation operation );
+        };
+
+        struct Watchers
+        {
+            std::mutex mutex;
+            uint64_t   nextId;
+            // Callbacks of each directory, by the id of their watch
+            std::unordered_map<
+                std::string,
+                std::unordered_map< uint64_t, std::function< void() > > >
+                callbacks;
+        };
+
+      private:
+        struct Node
+        {
+            FileKind                             kind;
+            uint64_t                             inode;
+            int64_t                              modificationTime;
+            // Of a regular file
+            std::shared_ptr< std::string const > content;
+            // Of a symbolic link
+            fs::path                             target;
+            // Of a directory, the synthetic files aren't in the list
+            std::vector< std::string >           children;
+            uint64_t                             nbSyntheticFiles;
+            // Size of a synthetic file, or the largest one of a directory
+            uint64_t                             maxSyntheticSize;
+            // Inode of the first synthetic file, the next ones follow
+            uint64_t                             firstSyntheticInode;
+        };
+
+        mutable std::mutex                      m_mutex;
+        // By their normalized absolute path
+        std::unordered_map< std::string, Node > m_nodes;
+        uint64_t                                m_nextInode;
+        // In nanoseconds, moved forward by each change so the modification
+        // times don't depend on when the tree is built
+        int64_t                                 m_clock;
+
+        std::shared_ptr< Counters > m_counters;
+        std::shared_ptr< Watchers > m_watchers;
+
+      public:
+        // Device given by the status of every file
+        static constexpr uint64_t DEVICE { 0xFFFF'0001 };
+
+        MemoryFileSystem();
+        virtual ~MemoryFileSystem() = default;
+
+        MemoryFileSystem( MemoryFileSystem const & )              = delete;
+        MemoryFileSystem & operator= ( MemoryFileSystem const & ) = delete;
+
+        std::vector< DirectoryEntry > enumerate (
+            fs::path const & directory, std::error_code & error ) override;
+        Status status ( fs::path const &  path,
+                        std::error_code & error ) override;
+        Status symlink_status ( fs::path const &  path,
+                                std::error_code & error ) override;
+        std::unique_ptr< File > open ( fs::path const &  path,
+                                       std::error_code & error ) override;
+        std::unique_ptr< Watch > watch ( fs::path const &        directory,
+                                         std::function< void() > onChange,
+                                         std::error_code & error ) override;
+
+        // The parent directories are created if needed. The changes call the
+        // watches of the parent directory, and return false if the parent
+        // isn't a directory.
+        bool create_directory ( fs::path const & path );
+        bool create_file ( fs::path const & path, std::string content );
+        bool create_symlink ( fs::path const & target, fs::path const & path );
+        // Add files named "file_<index>", of sizes spread up to the maximum,
+        // to the directory
+        bool create_synthetic_files ( fs::path const & directory,
+                                      uint64_t nbFiles, uint64_t maxSize );
+        // Directories "dir_<index>" nested on the depth, each with its
+        // synthetic files
+        bool create_synthetic_tree ( fs::path const & root, unsigned int depth,
+                                     unsigned int nbDirectories,
+                                     uint64_t nbFiles, uint64_t maxSize );
+        // Remove the entry and everything under it
+        bool remove ( fs::path const & path );
+
+        void set_latency ( Operation                 operation,
+                           std::chrono::microseconds latency );
+        std::chrono::microseconds get_latency ( Operation operation ) const;
+        uint64_t                  get_nb_calls ( Operation operation ) const;
+        // Entries stored, synthetic files excluded
+        std::size_t               get_nb_nodes () const;
+
+        void debug_gui () override;
+
+        static char const * get_operation_name ( Operation operation );
+
+      private:
+        // Called with the mutex locked, nullptr if there is no such entry. The
+        // synthetic files are given in the node.
+        Node const * find ( std::string const & path, Node & synthetic ) const;
+        // Called with the mutex locked, follow the symbolic links
+        Node const * resolve ( std::string path, Node & synthetic ) const;
+        // Called with the mutex locked, the parent directories are created
+        Node * insert ( std::string const & path, FileKind kind );
+        // Call the watches of the directory, without the mutex locked
+        void   notify ( std::string const & directory );
+
+        static Status get_status ( Node const & node );
+    };
+
+    // Use a memory file system whose home directory holds a synthetic tree,
+    // with the number of files in each directory (explorer --memory)
+    void use_synthetic_home ( uint64_t nbFiles );
+}  // namespace vfs
@@ -0,0 +1,324 @@
+#include "mount_guard.hpp"
+
+#include <algorithm>  // for find_if
+#include <exception>  // for exception
+#include <thread>     // for thread, sleep_for
+
+#include <fmt/format.h>   // for format
+#include <imgui/imgui.h>  // for ImGui::BeginTable
+
+#include "tools/traces.hpp"  // for Trace
+
+namespace
+{
+    // The mounts are read again at most this often, it's cheap as
+    // /proc/self/mountinfo doesn't access them
+    constexpr std::chrono::seconds      MOUNTS_REFRESH_DELAY { 1 };
+    // A short call not returning for this long is stuck, not slow
+    constexpr std::chrono::milliseconds HUNG_DELAY { 1000 };
+    // Delay injected by the debug window to simulate a hung mount
+    constexpr std::chrono::milliseconds HUNG_MOUNT_DELAY { 10000 };
+
+    bool is_inside ( std::string const & path, std::string const & mountPoint )
+    {
+        if ( mountPoint == "/" )
+        {
+            return path.starts_with( '/' );
+        }
+        return path.starts_with( mountPoint )
+               && ( path.size() == mountPoint.size()
+                    || path[mountPoint.size()] == '/' );
+    }
+}  // namespace
+
+MountGuard::Mount::Mount( fs::path path )
+  : mountPoint { std::move( path ) },
+    mutex {},
+    condition {},
+    workers {},
+    isReported { false },
+    isStopped { false },
+    nbCalls { 0 },
+    nbTimeouts { 0 },
+    injectedDelay { 0 }
+{}
+
+MountGuard::MountGuard()
+  : m_mutex {}, m_mountPoints {}, m_lastRead {}, m_mounts {}
+{}
+
+MountGuard::~MountGuard()
+{
+    // The workers can't be joined, a call stuck in the kernel would block
+    // the exit. They only leave once their current call is done.
+    std::lock_guard< std::mutex > lock { m_mutex };
+    for ( auto & [mountPoint, mount] : m_mounts )
+    {
+        {
+            std::lock_guard< std::mutex > mountLock { mount->mutex };
+            mount->isStopped = true;
+            for ( Worker & worker : mount->workers )
+            {
+                worker.calls.clear();
+            }
+        }
+        mount->condition.notify_all();
+    }
+}
+
+bool MountGuard::run( fs::path const & path, std::function< void() > function,
+                      std::chrono::milliseconds timeout, Lane lane,
+                      bool mustRun )
+{
+    std::shared_ptr< Mount > mount = this->get_mount( path );
+    auto call = std::make_shared< Call >( std::move( function ), timeout,
+                                          false );
+
+    std::unique_lock< std::mutex > lock { mount->mutex };
+    ++mount->nbCalls;
+    bool isHung { is_hung( *mount ) };
+    if ( isHung && ! mount->isReported )
+    {
+        mount->isReported = true;
+        Trace::Warning( "{} isn't responding", mount->mountPoint.c_str() );
+    }
+    if ( isHung && ! mustRun )
+    {
+        return false;
+    }
+    queue( *mount, lane, call );
+    if ( isHung )
+    {
+        return false;
+    }
+
+    if ( mount->condition.wait_for( lock, timeout,
+                                    [&call] () { return call->isDone; } ) )
+    {
+        return true;
+    }
+    // Waiting too long only fails this call, the mount is hung only once its
+    // running call is stuck
+    ++mount->nbTimeouts;
+    return false;
+}
+
+void MountGuard::post( fs::path const & path,
+                       std::function< void() > function, Lane lane )
+{
+    std::shared_ptr< Mount > mount = this->get_mount( path );
+
+    std::lock_guard< std::mutex > lock { mount->mutex };
+    ++mount->nbCalls;
+    if ( ! is_hung( *mount ) )
+    {
+        queue( *mount, lane,
+               std::make_shared< Call >( std::move( function ), UI_TIMEOUT,
+                                         false ) );
+    }
+}
+
+bool MountGuard::is_responding( fs::path const & path )
+{
+    std::shared_ptr< Mount >      mount = this->get_mount( path );
+    std::lock_guard< std::mutex > lock { mount->mutex };
+    return ! is_hung( *mount );
+}
+
+bool MountGuard::is_scanning( fs::path const & path )
+{
+    std::shared_ptr< Mount >      mount = this->get_mount( path );
+    std::lock_guard< std::mutex > lock { mount->mutex };
+    Worker const & worker =
+        mount->workers[static_cast< std::size_t >( Lane::Scan )];
+    return worker.isRunning || ! worker.calls.empty();
+}
+
+fs::path MountGuard::get_mount_point( fs::path const & path )
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    return this->find_mount( path ).mountPoint;
+}
+
+dev_t MountGuard::get_device( fs::path const & path )
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    return this->find_mount( path ).device;
+}
+
+void MountGuard::debug_gui()
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+
+    ImGui::Text( "Mounts accessed by the UI" );
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders
+                            | ImGuiTableFlags_SizingFixedFit;
+    if ( ! ImGui::BeginTable( "Guarded Mounts", 7, flags ) )
+    {
+        return;
+    }
+    for ( char const * header : { "Mount Point", "State", "Scan", "Queued",
+                                  "Calls", "Timeouts", "Simulate Hang" } )
+    {
+        ImGui::TableSetupColumn( header );
+    }
+    ImGui::TableHeadersRow();
+    auto now = std::chrono::steady_clock::now();
+    for ( auto & [mountPoint, mount] : m_mounts )
+    {
+        std::lock_guard< std::mutex > mountLock { mount->mutex };
+        ImGui::PushID( mountPoint.c_str() );
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted( mountPoint.c_str() );
+        std::size_t nbQueued { 0 };
+        for ( Worker const & worker : mount->workers )
+        {
+            ImGui::TableNextColumn();
+            if ( &worker == &mount->workers.front() && is_hung( *mount ) )
+            {
+                ImGui::TextColored( ImVec4 { 1.f, 0.4f, 0.4f, 1.f },
+                                    "Not responding" );
+            }
+            else if ( worker.isRunning )
+            {
+                ImGui::Text( "Busy for %.0f ms",
+                             std::chrono::duration< double, std::milli > {
+                                 now - worker.runningSince }
+                                 .count() );
+            }
+            else
+            {
+                ImGui::TextUnformatted( "Idle" );
+            }
+            nbQueued += worker.calls.size();
+        }
+        ImGui::TableNextColumn();
+        ImGui::Text( "%lu", nbQueued );
+        ImGui::TableNextColumn();
+        ImGui::Text( "%lu", mount->nbCalls );
+        ImGui::TableNextColumn();
+        ImGui::Text( "%lu", mount->nbTimeouts );
+        ImGui::TableNextColumn();
+        bool isHung { mount->injectedDelay.count() > 0 };
+        if ( ImGui::Checkbox( "##SimulateHang", &isHung ) )
+        {
+            mount->injectedDelay = isHung ? HUNG_MOUNT_DELAY
+                                          : std::chrono::milliseconds { 0 };
+        }
+        ImGui::PopID();
+    }
+    ImGui::EndTable();
+}
+
+ds::Mount const & MountGuard::find_mount( fs::path const & path )
+{
+    auto now = std::chrono::steady_clock::now();
+    if ( m_mountPoints.empty() || now - m_lastRead > MOUNTS_REFRESH_DELAY )
+    {
+        m_lastRead    = now;
+        m_mountPoints = ds::read_mounts();
+        if ( m_mountPoints.empty() )
+        {
+            m_mountPoints.push_back( ds::Mount { 0, "/", {}, {} } );
+        }
+    }
+
+    // The deepest mount point containing the path, the first mount (the
+    // root) for a relative path
+    std::string       normalized { path.lexically_normal().string() };
+    ds::Mount const * deepest { &m_mountPoints.front() };
+    std::size_t       deepestSize { 0 };
+    for ( ds::Mount const & mount : m_mountPoints )
+    {
+        std::string const & mountPoint { mount.mountPoint.native() };
+        if ( is_inside( normalized, mountPoint )
+             && mountPoint.size() > deepestSize )
+        {
+            deepest     = &mount;
+            deepestSize = mountPoint.size();
+        }
+    }
+    return *deepest;
+}
+
+std::shared_ptr< MountGuard::Mount > MountGuard::get_mount(
+    fs::path const & path )
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    fs::path const & mountPoint = this->find_mount( path ).mountPoint;
+
+    std::shared_ptr< Mount > & mount = m_mounts[mountPoint.string()];
+    if ( ! mount )
+    {
+        mount = std::make_shared< Mount >( mountPoint );
+        std::thread { work, mount, Lane::Interactive }.detach();
+        std::thread { work, mount, Lane::Scan }.detach();
+    }
+    return mount;
+}
+
+bool MountGuard::is_hung( Mount const & mount )
+{
+    Worker const & worker =
+        mount.workers[static_cast< std::size_t >( Lane::Interactive )];
+    return worker.isRunning
+           && std::chrono::steady_clock::now() - worker.runningSince
+                  >= HUNG_DELAY;
+}
+
+void MountGuard::queue( Mount & mount, Lane lane,
+                        std::shared_ptr< Call > call )
+{
+    Worker & worker = mount.workers[static_cast< std::size_t >( lane )];
+    auto     position = std::find_if(
+        worker.calls.begin(), worker.calls.end(),
+        [&call] ( std::shared_ptr< Call > const & queued ) {
+            return queued->timeout > call->timeout;
+        } );
+    worker.calls.insert( position, std::move( call ) );
+    mount.condition.notify_all();
+}
+
+void MountGuard::work( std::shared_ptr< Mount > mount, Lane lane )
+{
+    Worker & worker = mount->workers[static_cast< std::size_t >( lane )];
+    std::unique_lock< std::mutex > lock { mount->mutex };
+    while ( true )
+    {
+        mount->condition.wait( lock, [&mount, &worker] () {
+            return mount->isStopped || ! worker.calls.empty();
+        } );
+        if ( mount->isStopped )
+        {
+            return;
+        }
+        std::shared_ptr< Call > call = std::move( worker.calls.front() );
+        worker.calls.pop_front();
+        worker.isRunning    = true;
+        worker.runningSince = std::chrono::steady_clock::now();
+        std::chrono::milliseconds injectedDelay { mount->injectedDelay };
+        lock.unlock();
+
+        std::this_thread::sleep_for( injectedDelay );
+        try
+        {
+            call->function();
+        }
+        catch ( std::exception const & exception )
+        {
+            Trace::Error( "Error in {}: {}", mount->mountPoint.c_str(),
+                          exception.what() );
+        }
+
+        lock.lock();
+        call->isDone     = true;
+        worker.isRunning = false;
+        if ( lane == Lane::Interactive && mount->isReported )
+        {
+            mount->isReported = false;
+            Trace::Info( "{} is responding again", mount->mountPoint.c_str() );
+        }
+        mount->condition.notify_all();
+    }
+}
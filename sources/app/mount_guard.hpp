@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>               // for array
+#include <chrono>              // for milliseconds, steady_clock
+#include <condition_variable>  // for condition_variable
+#include <cstddef>             // for size_t
+#include <cstdint>             // for uint64_t
+#include <deque>               // for deque
+#include <functional>          // for function
+#include <memory>              // for shared_ptr
+#include <mutex>               // for mutex
+#include <optional>            // for optional
+#include <string>              // for string
+#include <unordered_map>       // for unordered_map
+#include <vector>              // for vector
+
+#include <sys/types.h>  // for dev_t
+
+#include "app/device_info.hpp"  // for ds::Mount
+#include "app/filesystem.hpp"   // for fs::path
+#include "tools/singleton.hpp"
+
+// Run the filesystem calls of the UI on a worker of the mount they access,
+// and wait for them only for a while. A stale NFS or a slow FUSE mount then
+// blocks its own workers instead of the render thread, and the other mounts
+// stay usable. The directory scans have their own worker, so a large or a
+// prefetched directory doesn't delay the short calls. A mount isn't
+// responding while its short call running hasn't returned for HUNG_DELAY,
+// however long the callers waited; the calls fail without waiting meanwhile.
+class MountGuard : public Singleton< MountGuard >
+{
+    ENABLE_SINGLETON( MountGuard );
+
+  public:
+    // Longest a frame waits for a mount
+    static constexpr std::chrono::milliseconds UI_TIMEOUT { 200 };
+
+    enum class Lane
+    {
+        // Short calls, like a status or a watch
+        Interactive = 0,
+        // Directory scans, which may be long without being stuck
+        Scan,
+        Count
+    };
+
+  private:
+    struct Call
+    {
+        std::function< void() >   function;
+        std::chrono::milliseconds timeout;
+        bool                      isDone;
+    };
+
+    struct Worker
+    {
+        // The shortest timeouts first
+        std::deque< std::shared_ptr< Call > > calls;
+        bool                                  isRunning;
+        std::chrono::steady_clock::time_point runningSince;
+    };
+
+    // Shared with its workers, which are never joined as they may be stuck
+    // in the kernel for good
+    struct Mount
+    {
+        fs::path                mountPoint;
+        std::mutex              mutex;
+        std::condition_variable condition;
+        std::array< Worker, static_cast< std::size_t >( Lane::Count ) >
+                                  workers;
+        // Reported as not responding, until its call returns
+        bool                      isReported;
+        bool                      isStopped;
+        uint64_t                  nbCalls;
+        uint64_t                  nbTimeouts;
+        // Slept before each call, to test a hung mount without one
+        std::chrono::milliseconds injectedDelay;
+
+        explicit Mount( fs::path path );
+    };
+
+    mutable std::mutex                    m_mutex;
+    // Found from the path only, so a hung mount isn't accessed to find it
+    std::vector< ds::Mount >              m_mountPoints;
+    std::chrono::steady_clock::time_point m_lastRead;
+    std::unordered_map< std::string, std::shared_ptr< Mount > > m_mounts;
+
+    MountGuard();
+    virtual ~MountGuard();
+
+  public:
+    // Run the function on the worker of the lane of the mount holding the
+    // path, and wait for it at most the timeout. Return true if it has been
+    // run. When the mount isn't responding, the function is queued without
+    // waiting if it must run anyway, and dropped otherwise.
+    bool run ( fs::path const & path, std::function< void() > function,
+               std::chrono::milliseconds timeout,
+               Lane lane = Lane::Interactive, bool mustRun = false );
+    // Queue the function on the worker of the lane without waiting for it,
+    // as a call of the UI. It's dropped if the mount isn't responding.
+    void post ( fs::path const & path, std::function< void() > function,
+                Lane lane );
+    // Result of the function, nothing if it timed out or threw
+    template< typename Result >
+    std::optional< Result > call (
+        fs::path const & path, std::function< Result() > function,
+        std::chrono::milliseconds timeout = UI_TIMEOUT );
+
+    bool     is_responding ( fs::path const & path );
+    // A scan is queued or running on the mount holding the path
+    bool     is_scanning ( fs::path const & path );
+    // Mount point holding the path, found without accessing it
+    fs::path get_mount_point ( fs::path const & path );
+    // Device of the mount holding the path, found without accessing it
+    dev_t    get_device ( fs::path const & path );
+
+    void debug_gui ();
+
+  private:
+    // Called with the mutex locked
+    ds::Mount const &        find_mount ( fs::path const & path );
+    std::shared_ptr< Mount > get_mount ( fs::path const & path );
+
+    // Called with the mount locked
+    static bool is_hung ( Mount const & mount );
+    static void queue ( Mount & mount, Lane lane,
+                        std::shared_ptr< Call > call );
+
+    static void work ( std::shared_ptr< Mount > mount, Lane lane );
+};
+
+#include "mount_guard_impl.hpp"
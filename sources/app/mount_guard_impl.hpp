@@ -0,0 +1,22 @@
+#pragma once
+
+#include "mount_guard.hpp"
+
+template< typename Result >
+std::optional< Result > MountGuard::call( fs::path const &          path,
+                                          std::function< Result() > function,
+                                          std::chrono::milliseconds timeout )
+{
+    // Written by the worker even if the caller has stopped waiting
+    auto result = std::make_shared< std::optional< Result > >();
+    if ( ! this->run(
+             path,
+             [result, function = std::move( function )] () {
+                 *result = function();
+             },
+             timeout ) )
+    {
+        return std::nullopt;
+    }
+    return std::move( *result );
+}
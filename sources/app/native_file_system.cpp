@@ -0,0 +1,435 @@
+#include "native_file_system.hpp"
+
+#include <array>          // for array
+#include <cerrno>         // for errno
+#include <cstring>        // for strcmp
+#include <mutex>          // for mutex, lock_guard
+#include <thread>         // for thread
+#include <unordered_map>  // for unordered_map
+
+#include <dirent.h>       // for opendir, readdir, closedir
+#include <fcntl.h>        // for open, posix_fadvise
+#include <poll.h>         // for poll
+#include <sys/eventfd.h>  // for eventfd
+#include <sys/inotify.h>  // for inotify_init1, inotify_add_watch
+#include <sys/stat.h>     // for stat, lstat, fstat
+#include <unistd.h>       // for pread, close, read, write
+
+#include <imgui/imgui.h>  // for ImGui::Text
+
+#include "tools/traces.hpp"  // for Trace
+
+namespace
+{
+    // Changes of the entries of a directory, not of the files content
+    constexpr uint32_t WATCHED_EVENTS { IN_CREATE | IN_DELETE | IN_MOVE
+                                        | IN_CLOSE_WRITE | IN_ATTRIB
+                                        | IN_DELETE_SELF | IN_MOVE_SELF
+                                        | IN_ONLYDIR };
+
+    std::error_code get_error ()
+    {
+        return std::error_code { errno, std::generic_category() };
+    }
+
+    vfs::FileKind get_kind ( mode_t mode )
+    {
+        if ( S_ISREG( mode ) )
+        {
+            return vfs::FileKind::Regular;
+        }
+        if ( S_ISDIR( mode ) )
+        {
+            return vfs::FileKind::Directory;
+        }
+        if ( S_ISLNK( mode ) )
+        {
+            return vfs::FileKind::Symlink;
+        }
+        return vfs::FileKind::Other;
+    }
+
+    vfs::FileKind get_kind ( unsigned char direntType )
+    {
+        switch ( direntType )
+        {
+        case DT_REG :
+            return vfs::FileKind::Regular;
+        case DT_DIR :
+            return vfs::FileKind::Directory;
+        case DT_LNK :
+            return vfs::FileKind::Symlink;
+        case DT_UNKNOWN :
+            return vfs::FileKind::Unknown;
+        default :
+            return vfs::FileKind::Other;
+        }
+    }
+
+    vfs::Status to_status ( struct stat const & status )
+    {
+        return vfs::Status {
+            get_kind( status.st_mode ),
+            static_cast< uint64_t >( status.st_size ),
+            status.st_dev,
+            status.st_ino,
+            status.st_mtim.tv_sec * 1'000'000'000 + status.st_mtim.tv_nsec };
+    }
+
+    class NativeFile : public vfs::File
+    {
+        int      m_descriptor;
+        uint64_t m_size;
+
+      public:
+        NativeFile( int descriptor, uint64_t size )
+          : m_descriptor { descriptor }, m_size { size }
+        {}
+        virtual ~NativeFile()
+        {
+            close( m_descriptor );
+        }
+
+        NativeFile( NativeFile const & )              = delete;
+        NativeFile & operator= ( NativeFile const & ) = delete;
+
+        ssize_t read_at ( void * buffer, std::size_t size,
+                          uint64_t offset ) override
+        {
+            std::size_t nbRead { 0 };
+            while ( nbRead < size )
+            {
+                ssize_t result = pread(
+                    m_descriptor, static_cast< char * >( buffer ) + nbRead,
+                    size - nbRead, static_cast< off_t >( offset + nbRead ) );
+                if ( result < 0 && errno == EINTR )
+                {
+                    continue;
+                }
+                if ( result < 0 )
+                {
+                    return -1;
+                }
+                if ( result == 0 )
+                {
+                    break;
+                }
+                nbRead += static_cast< std::size_t >( result );
+            }
+            return static_cast< ssize_t >( nbRead );
+        }
+
+        uint64_t get_size () const override
+        {
+            return m_size;
+        }
+
+        void advise ( vfs::Access access, uint64_t offset,
+                      uint64_t size ) override
+        {
+            int advice = POSIX_FADV_NORMAL;
+            switch ( access )
+            {
+            case vfs::Access::Random :
+                advice = POSIX_FADV_RANDOM;
+                break;
+            case vfs::Access::Sequential :
+                advice = POSIX_FADV_SEQUENTIAL;
+                break;
+            case vfs::Access::Done :
+                advice = POSIX_FADV_DONTNEED;
+                break;
+            }
+            posix_fadvise( m_descriptor, static_cast< off_t >( offset ),
+                           static_cast< off_t >( size ), advice );
+        }
+    };
+}  // namespace
+
+namespace vfs
+{
+    struct NativeFileSystem::Watcher
+    {
+        std::mutex  mutex;
+        int         descriptor;
+        // Written to stop the thread
+        int         stopEvent;
+        uint64_t    nextId;
+        // A watch added meanwhile may have been removed with them, as the
+        // watches of a directory share their inotify watch
+        uint64_t    nbRemovedWatches;
+        // Callbacks of each inotify watch, by the id of their watch
+        std::unordered_map<
+            int, std::unordered_map< uint64_t, std::function< void() > > >
+                    callbacks;
+        std::thread thread;
+
+        Watcher();
+        ~Watcher();
+
+        Watcher( Watcher const & )              = delete;
+        Watcher & operator= ( Watcher const & ) = delete;
+
+        void run ();
+    };
+
+    NativeFileSystem::Watcher::Watcher()
+      : mutex {},
+        descriptor { inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) },
+        stopEvent { eventfd( 0, EFD_CLOEXEC ) },
+        nextId { 0 },
+        nbRemovedWatches { 0 },
+        callbacks {},
+        thread {}
+    {
+        if ( descriptor < 0 || stopEvent < 0 )
+        {
+            Trace::Error( "Can't watch the directories: "
+                          + get_error().message() );
+            return;
+        }
+        thread = std::thread { &Watcher::run, this };
+    }
+
+    NativeFileSystem::Watcher::~Watcher()
+    {
+        if ( thread.joinable() )
+        {
+            uint64_t value { 1 };
+            if ( write( stopEvent, &value, sizeof( value ) ) < 0 )
+            {
+                Trace::Error( "Can't stop the directory watcher" );
+            }
+            thread.join();
+        }
+        for ( int fileDescriptor : { descriptor, stopEvent } )
+        {
+            if ( fileDescriptor >= 0 )
+            {
+                close( fileDescriptor );
+            }
+        }
+    }
+
+    void NativeFileSystem::Watcher::run()
+    {
+        // Aligned as the events are read in place
+        alignas( inotify_event ) std::array< char, 16 * 1024 > buffer {};
+        std::array< pollfd, 2 > descriptors {
+            pollfd { descriptor, POLLIN, 0 }, pollfd { stopEvent, POLLIN, 0 } };
+        while ( true )
+        {
+            if ( poll( descriptors.data(), descriptors.size(), -1 ) < 0 )
+            {
+                if ( errno == EINTR )
+                {
+                    continue;
+                }
+                Trace::Error( "Directory watcher stopped: "
+                              + get_error().message() );
+                return;
+            }
+            if ( descriptors[1].revents != 0 )
+            {
+                return;
+            }
+
+            ssize_t nbRead = read( descriptor, buffer.data(), buffer.size() );
+            std::lock_guard< std::mutex > lock { mutex };
+            for ( ssize_t offset = 0; offset < nbRead; )
+            {
+                auto const * event = reinterpret_cast< inotify_event const * >(
+                    buffer.data() + offset );
+                offset += sizeof( inotify_event ) + event->len;
+
+                auto watched = callbacks.find( event->wd );
+                if ( watched == callbacks.end() )
+                {
+                    continue;
+                }
+                for ( auto & [id, callback] : watched->second )
+                {
+                    callback();
+                }
+                // The directory has been removed, the kernel has removed its
+                // watch and may give its number to another directory
+                if ( event->mask & IN_IGNORED )
+                {
+                    callbacks.erase( watched );
+                }
+            }
+        }
+    }
+
+    namespace
+    {
+        class NativeWatch : public Watch
+        {
+            std::shared_ptr< NativeFileSystem::Watcher > m_watcher;
+            int                                          m_descriptor;
+            uint64_t                                     m_id;
+
+          public:
+            NativeWatch( std::shared_ptr< NativeFileSystem::Watcher > watcher,
+                         int descriptor, uint64_t id )
+              : m_watcher { std::move( watcher ) },
+                m_descriptor { descriptor },
+                m_id { id }
+            {}
+            virtual ~NativeWatch()
+            {
+                std::lock_guard< std::mutex > lock { m_watcher->mutex };
+                auto watched = m_watcher->callbacks.find( m_descriptor );
+                // The number may have been given to another directory, which
+                // doesn't have this id
+                if ( watched != m_watcher->callbacks.end()
+                     && watched->second.erase( m_id ) > 0
+                     && watched->second.empty() )
+                {
+                    inotify_rm_watch( m_watcher->descriptor, m_descriptor );
+                    m_watcher->callbacks.erase( watched );
+                    ++m_watcher->nbRemovedWatches;
+                }
+            }
+
+            NativeWatch( NativeWatch const & )              = delete;
+            NativeWatch & operator= ( NativeWatch const & ) = delete;
+        };
+    }  // namespace
+
+    NativeFileSystem::NativeFileSystem() : m_mutex {}, m_watcher { nullptr } {}
+
+    std::vector< DirectoryEntry > NativeFileSystem::enumerate(
+        fs::path const & directory, std::error_code & error )
+    {
+        std::vector< DirectoryEntry > entries {};
+        DIR * stream = opendir( directory.c_str() );
+        if ( stream == nullptr )
+        {
+            error = get_error();
+            return entries;
+        }
+
+        errno = 0;
+        while ( dirent const * entry = readdir( stream ) )
+        {
+            if ( std::strcmp( entry->d_name, "." ) != 0
+                 && std::strcmp( entry->d_name, ".." ) != 0 )
+            {
+                entries.push_back( DirectoryEntry {
+                    entry->d_name, get_kind( entry->d_type ) } );
+            }
+        }
+        error = errno != 0 ? get_error() : std::error_code {};
+        closedir( stream );
+        return entries;
+    }
+
+    Status NativeFileSystem::status( fs::path const &  path,
+                                     std::error_code & error )
+    {
+        struct stat status {};
+        if ( stat( path.c_str(), &status ) != 0 )
+        {
+            error = get_error();
+            return Status { FileKind::Unknown, 0, 0, 0, 0 };
+        }
+        error.clear();
+        return to_status( status );
+    }
+
+    Status NativeFileSystem::symlink_status( fs::path const &  path,
+                                             std::error_code & error )
+    {
+        struct stat status {};
+        if ( lstat( path.c_str(), &status ) != 0 )
+        {
+            error = get_error();
+            return Status { FileKind::Unknown, 0, 0, 0, 0 };
+        }
+        error.clear();
+        return to_status( status );
+    }
+
+    std::unique_ptr< File > NativeFileSystem::open( fs::path const &  path,
+                                                    std::error_code & error )
+    {
+        int descriptor = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+        struct stat status {};
+        if ( descriptor < 0 || fstat( descriptor, &status ) != 0 )
+        {
+            error = get_error();
+            if ( descriptor >= 0 )
+            {
+                close( descriptor );
+            }
+            return nullptr;
+        }
+        error.clear();
+        return std::make_unique< NativeFile >(
+            descriptor, static_cast< uint64_t >( status.st_size ) );
+    }
+
+    std::unique_ptr< Watch > NativeFileSystem::watch(
+        fs::path const & directory, std::function< void() > onChange,
+        std::error_code & error )
+    {
+        std::shared_ptr< Watcher > watcher {};
+        {
+            // The thread is started by the first watch
+            std::lock_guard< std::mutex > lock { m_mutex };
+            if ( ! m_watcher )
+            {
+                m_watcher = std::make_shared< Watcher >();
+            }
+            watcher = m_watcher;
+        }
+
+        while ( true )
+        {
+            uint64_t nbRemovedWatches {};
+            {
+                std::lock_guard< std::mutex > lock { watcher->mutex };
+                nbRemovedWatches = watcher->nbRemovedWatches;
+            }
+            // Without the lock, as it blocks on a hung mount, and the
+            // watcher thread and the destroyed watches need it
+            int descriptor = inotify_add_watch(
+                watcher->descriptor, directory.c_str(), WATCHED_EVENTS );
+            if ( descriptor < 0 )
+            {
+                error = get_error();
+                return nullptr;
+            }
+
+            std::lock_guard< std::mutex > lock { watcher->mutex };
+            if ( watcher->nbRemovedWatches != nbRemovedWatches )
+            {
+                // The last watch of the directory may have been destroyed
+                // meanwhile, removing the inotify watch just added
+                continue;
+            }
+            error.clear();
+            uint64_t id { watcher->nextId++ };
+            watcher->callbacks[descriptor].emplace( id, std::move( onChange ) );
+            return std::make_unique< NativeWatch >( watcher, descriptor, id );
+        }
+    }
+
+    void NativeFileSystem::debug_gui()
+    {
+        std::shared_ptr< Watcher > watcher {};
+        {
+            std::lock_guard< std::mutex > lock { m_mutex };
+            watcher = m_watcher;
+        }
+        ImGui::Text( "Native file system" );
+        std::size_t nbWatched { 0 };
+        if ( watcher )
+        {
+            std::lock_guard< std::mutex > lock { watcher->mutex };
+            nbWatched = watcher->callbacks.size();
+        }
+        ImGui::Text( "Watched directories: %lu", nbWatched );
+    }
+}  // namespace vfs
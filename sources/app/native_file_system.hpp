@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>  // for shared_ptr
+#include <mutex>   // for mutex
+
+#include "app/vfs.hpp"  // for vfs::FileSystem
+
+namespace vfs
+{
+    // The files of the disks, through the POSIX calls
+    class NativeFileSystem : public FileSystem
+    {
+      public:
+        // Single inotify instance and thread watching every directory
+        struct Watcher;
+
+      private:
+        std::mutex                 m_mutex;
+        // Started by the first watch, and shared with the watches as they may
+        // outlive the file system
+        std::shared_ptr< Watcher > m_watcher;
+
+      public:
+        NativeFileSystem();
+        virtual ~NativeFileSystem() = default;
+
+        std::vector< DirectoryEntry > enumerate (
+            fs::path const & directory, std::error_code & error ) override;
+        Status status ( fs::path const &  path,
+                        std::error_code & error ) override;
+        Status symlink_status ( fs::path const &  path,
+                                std::error_code & error ) override;
+        std::unique_ptr< File > open ( fs::path const &  path,
+                                       std::error_code & error ) override;
+        std::unique_ptr< Watch > watch ( fs::path const &        directory,
+                                         std::function< void() > onChange,
+                                         std::error_code & error ) override;
+
+        void debug_gui () override;
+    };
+}  // namespace vfs
@@ -0,0 +1,427 @@
+#include "perf_counters.hpp"
+
+#include <cerrno>        // for errno, EACCES, EPERM
+#include <fstream>       // for ifstream
+#include <optional>      // for optional
+#include <system_error>  // for generic_category
+#include <vector>        // for vector
+
+#include <linux/perf_event.h>  // for perf_event_attr, PERF_TYPE_SOFTWARE
+#include <sys/syscall.h>       // for SYS_perf_event_open
+#include <unistd.h>            // for syscall, read, close
+
+#include <fmt/format.h>   // for format
+#include <imgui/imgui.h>  // for ImGui::BeginTable
+
+namespace
+{
+    constexpr char const * EVENT_NAMES[] {
+        "Task clock (us)", "Context switches", "Page faults",
+        "Syscalls",        "Instructions",     "Cache misses" };
+    // The events are read in the order they have been added to their group
+    constexpr uint64_t READ_FORMAT { PERF_FORMAT_GROUP
+                                     | PERF_FORMAT_TOTAL_TIME_ENABLED
+                                     | PERF_FORMAT_TOTAL_TIME_RUNNING };
+    // Two tracefs mount points
+    constexpr char const * SYSCALL_TRACEPOINTS[] {
+        "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+        "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id" };
+
+    using Event = PerfCounters::Event;
+
+    std::optional< uint64_t > get_syscall_tracepoint ()
+    {
+        for ( char const * path : SYSCALL_TRACEPOINTS )
+        {
+            std::ifstream file { path };
+            uint64_t      id { 0 };
+            if ( file >> id )
+            {
+                return id;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::string get_paranoid_level ()
+    {
+        std::ifstream file { "/proc/sys/kernel/perf_event_paranoid" };
+        std::string   level {};
+        file >> level;
+        return level.empty() ? "?" : level;
+    }
+
+    // The counters of the calling thread, in a group of kernel events and a
+    // group of hardware events, so each is read with one system call
+    class ThreadCounters
+    {
+        struct Group
+        {
+            // Of the leader, read for the whole group
+            int                  descriptor { -1 };
+            std::vector< Event > events {};
+            std::vector< int >   descriptors {};
+        };
+
+        Group                      m_software;
+        Group                      m_hardware;
+        PerfCounters::Mask         m_isCounted;
+        // Why the missing events can't be counted
+        std::vector< std::string > m_issues;
+
+      public:
+        ThreadCounters()
+          : m_software {}, m_hardware {}, m_isCounted {}, m_issues {}
+        {
+            std::optional< uint64_t > syscalls = get_syscall_tracepoint();
+            this->open( m_software, Event::TaskClock, PERF_TYPE_SOFTWARE,
+                        PERF_COUNT_SW_TASK_CLOCK );
+            this->open( m_software, Event::ContextSwitches, PERF_TYPE_SOFTWARE,
+                        PERF_COUNT_SW_CONTEXT_SWITCHES );
+            this->open( m_software, Event::PageFaults, PERF_TYPE_SOFTWARE,
+                        PERF_COUNT_SW_PAGE_FAULTS );
+            if ( syscalls.has_value() )
+            {
+                this->open( m_software, Event::Syscalls, PERF_TYPE_TRACEPOINT,
+                            syscalls.value() );
+            }
+            else
+            {
+                m_issues.push_back(
+                    "Syscalls: the raw_syscalls tracepoint can't be read" );
+            }
+            this->open( m_hardware, Event::Instructions, PERF_TYPE_HARDWARE,
+                        PERF_COUNT_HW_INSTRUCTIONS );
+            this->open( m_hardware, Event::CacheMisses, PERF_TYPE_HARDWARE,
+                        PERF_COUNT_HW_CACHE_MISSES );
+        }
+
+        ~ThreadCounters()
+        {
+            for ( Group const * group : { &m_software, &m_hardware } )
+            {
+                for ( int descriptor : group->descriptors )
+                {
+                    close( descriptor );
+                }
+            }
+        }
+
+        ThreadCounters( ThreadCounters const & )              = delete;
+        ThreadCounters & operator= ( ThreadCounters const & ) = delete;
+
+        PerfCounters::Mask const & get_counted () const
+        {
+            return m_isCounted;
+        }
+
+        std::vector< std::string > const & get_issues () const
+        {
+            return m_issues;
+        }
+
+        // The hardware group is read first at the start of a region and last
+        // at its end, so the reads only add one system call to it
+        bool read ( PerfCounters::Values & values, bool isStart )
+        {
+            bool isRead { true };
+            for ( Group const * group :
+                  { isStart ? &m_hardware : &m_software,
+                    isStart ? &m_software : &m_hardware } )
+            {
+                isRead = isRead && this->read( *group, values );
+            }
+            return isRead;
+        }
+
+      private:
+        void open ( Group & group, Event event, uint32_t type,
+                    uint64_t config )
+        {
+            perf_event_attr attributes {};
+            attributes.size        = sizeof( attributes );
+            attributes.type        = type;
+            attributes.config      = config;
+            attributes.read_format = READ_FORMAT;
+            attributes.exclude_hv  = 1;
+
+            // Only happen in the kernel, there is nothing to count without it
+            bool isKernelEvent { event == Event::ContextSwitches
+                                 || event == Event::Syscalls };
+            int  descriptor = open_event( attributes, group.descriptor );
+            if ( descriptor < 0 && ! isKernelEvent
+                 && ( errno == EACCES || errno == EPERM ) )
+            {
+                // Without the rights to count in the kernel, as the default
+                // paranoid level 2, only the user space is counted
+                attributes.exclude_kernel = 1;
+                descriptor = open_event( attributes, group.descriptor );
+                if ( descriptor >= 0 )
+                {
+                    m_issues.push_back( fmt::format(
+                        "{}: user space only", EVENT_NAMES[index( event )] ) );
+                }
+            }
+            if ( descriptor < 0 )
+            {
+                m_issues.push_back( fmt::format(
+                    "{}: {}", EVENT_NAMES[index( event )],
+                    std::generic_category().message( errno ) ) );
+                return;
+            }
+
+            if ( group.descriptor < 0 )
+            {
+                group.descriptor = descriptor;
+            }
+            group.events.push_back( event );
+            group.descriptors.push_back( descriptor );
+            m_isCounted[index( event )] = true;
+        }
+
+        bool read ( Group const & group, PerfCounters::Values & values ) const
+        {
+            if ( group.descriptor < 0 )
+            {
+                return true;
+            }
+
+            // Number of events, time enabled, time running, then the values
+            std::array< uint64_t, 3 + PerfCounters::NB_EVENTS > buffer {};
+            auto size = static_cast< ssize_t >(
+                ( 3 + group.events.size() ) * sizeof( uint64_t ) );
+            if ( ::read( group.descriptor, buffer.data(),
+                         static_cast< std::size_t >( size ) )
+                 != size )
+            {
+                return false;
+            }
+
+            // Scaled up if the hardware counters are shared with others
+            double scale { buffer[2] > 0 ? static_cast< double >( buffer[1] )
+                                               / static_cast< double >(
+                                                   buffer[2] )
+                                         : 1. };
+            for ( std::size_t idx = 0; idx < group.events.size(); ++idx )
+            {
+                values[index( group.events[idx] )] = static_cast< uint64_t >(
+                    static_cast< double >( buffer[3 + idx] ) * scale );
+            }
+            return true;
+        }
+
+        static int open_event ( perf_event_attr & attributes, int group )
+        {
+            // The calling thread, on any CPU
+            return static_cast< int >( syscall( SYS_perf_event_open,
+                                                &attributes, 0, -1, group,
+                                                PERF_FLAG_FD_CLOEXEC ) );
+        }
+
+        static std::size_t index ( Event event )
+        {
+            return static_cast< std::size_t >( event );
+        }
+    };
+
+    // Opened at the first region of the thread
+    ThreadCounters & get_thread_counters ()
+    {
+        thread_local ThreadCounters counters {};
+        return counters;
+    }
+
+    // Of the events counted, the Syscalls of the last read of the region
+    // removed
+    PerfCounters::Values subtract ( PerfCounters::Values const & end,
+                                    PerfCounters::Values const & start )
+    {
+        PerfCounters::Values values {};
+        for ( std::size_t idx = 0; idx < values.size(); ++idx )
+        {
+            values[idx] = end[idx] >= start[idx] ? end[idx] - start[idx] : 0;
+        }
+        uint64_t & syscalls = values[static_cast< std::size_t >(
+            Event::Syscalls )];
+        syscalls = syscalls > 0 ? syscalls - 1 : 0;
+        return values;
+    }
+}  // namespace
+
+PerfCounters::Region::Region( char const * name )
+  : m_name { name },
+    m_isCounting { PerfCounters::get_instance().is_enabled() },
+    m_start {}
+{
+    if ( m_isCounting )
+    {
+        get_thread_counters().read( m_start, true );
+    }
+}
+
+PerfCounters::Region::~Region()
+{
+    if ( ! m_isCounting )
+    {
+        return;
+    }
+
+    ThreadCounters & counters = get_thread_counters();
+    Values           end {};
+    if ( counters.read( end, false ) )
+    {
+        PerfCounters::get_instance().add(
+            m_name, subtract( end, m_start ), counters.get_counted() );
+    }
+    else
+    {
+        PerfCounters::get_instance().add( m_name, {}, {} );
+    }
+}
+
+PerfCounters::PerfCounters()
+  : m_mutex {}, m_regions {}, m_status {}, m_isEnabled { false }
+{}
+
+void PerfCounters::set_enabled( bool isEnabled )
+{
+    if ( isEnabled && ! m_isEnabled.load() )
+    {
+        // The status of the events is given by the counters of this thread
+        std::vector< std::string > const & issues =
+            get_thread_counters().get_issues();
+        std::string status {};
+        for ( std::string const & issue : issues )
+        {
+            status += fmt::format( "{}{}", status.empty() ? "" : ", ",
+                                   issue );
+        }
+        if ( ! status.empty() )
+        {
+            status += fmt::format( " (kernel.perf_event_paranoid = {})",
+                                   get_paranoid_level() );
+        }
+        this->set_status( std::move( status ) );
+    }
+    m_isEnabled.store( isEnabled );
+}
+
+bool PerfCounters::is_enabled() const
+{
+    return m_isEnabled.load( std::memory_order_relaxed );
+}
+
+std::map< std::string, PerfCounters::Totals, std::less<> >
+    PerfCounters::get_regions() const
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    return m_regions;
+}
+
+std::string PerfCounters::get_status() const
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    return m_status;
+}
+
+void PerfCounters::clear()
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    m_regions.clear();
+}
+
+void PerfCounters::debug_gui()
+{
+    ImGui::Text( "Perf counters" );
+    bool isEnabled = this->is_enabled();
+    if ( ImGui::Checkbox( "Count Events of the Regions", &isEnabled ) )
+    {
+        this->set_enabled( isEnabled );
+    }
+    ImGui::SameLine();
+    if ( ImGui::Button( "Clear##PerfCounters" ) )
+    {
+        this->clear();
+    }
+
+    std::string status = this->get_status();
+    if ( ! status.empty() )
+    {
+        ImGui::TextWrapped( "Not counted: %s", status.c_str() );
+    }
+
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders
+                            | ImGuiTableFlags_SizingFixedFit;
+    if ( ! ImGui::BeginTable( "Perf Regions",
+                                 static_cast< int >( 2 + NB_EVENTS ), flags ) )
+    {
+        return;
+    }
+    ImGui::TableSetupColumn( "Region" );
+    ImGui::TableSetupColumn( "Calls" );
+    for ( char const * name : EVENT_NAMES )
+    {
+        ImGui::TableSetupColumn( name );
+    }
+    ImGui::TableHeadersRow();
+
+    // Means by call
+    for ( auto const & [name, totals] : this->get_regions() )
+    {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted( name.c_str() );
+        ImGui::TableNextColumn();
+        ImGui::Text( "%lu", totals.nbCalls );
+        for ( std::size_t idx = 0; idx < NB_EVENTS; ++idx )
+        {
+            ImGui::TableNextColumn();
+            if ( totals.nbCounted[idx] == 0 )
+            {
+                ImGui::TextUnformatted( "-" );
+                continue;
+            }
+            double mean = static_cast< double >( totals.values[idx] )
+                          / static_cast< double >( totals.nbCounted[idx] );
+            if ( static_cast< Event >( idx ) == Event::TaskClock )
+            {
+                mean /= 1e3;
+            }
+            ImGui::Text( "%.1f", mean );
+        }
+    }
+    ImGui::EndTable();
+}
+
+char const * PerfCounters::get_event_name( Event event )
+{
+    return EVENT_NAMES[static_cast< std::size_t >( event )];
+}
+
+void PerfCounters::add( char const * name, Values const & values,
+                        Mask const & isCounted )
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    auto region = m_regions.find( std::string_view { name } );
+    if ( region == m_regions.end() )
+    {
+        region = m_regions.emplace( name, Totals {} ).first;
+    }
+
+    Totals & totals = region->second;
+    ++totals.nbCalls;
+    for ( std::size_t idx = 0; idx < NB_EVENTS; ++idx )
+    {
+        if ( isCounted[idx] )
+        {
+            totals.values[idx] += values[idx];
+            ++totals.nbCounted[idx];
+        }
+    }
+}
+
+void PerfCounters::set_status( std::string status )
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    m_status = std::move( status );
+}
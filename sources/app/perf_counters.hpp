@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>    // for array
+#include <atomic>   // for atomic
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint64_t
+#include <map>      // for map
+#include <mutex>    // for mutex
+#include <string>   // for string
+
+#include "tools/singleton.hpp"
+
+// Hardware and kernel events counted by perf_event_open around named regions
+// of the code, to see what a refresh or a walk costs beyond its time: system
+// calls, context switches, page faults, cache misses. Each thread counts its
+// own events, and the regions are summed by name. The events the kernel
+// doesn't allow to count, depending on kernel.perf_event_paranoid and the
+// hardware, are left out.
+class PerfCounters : public Singleton< PerfCounters >
+{
+    ENABLE_SINGLETON( PerfCounters );
+
+  public:
+    enum class Event
+    {
+        // CPU time in nanoseconds
+        TaskClock = 0,
+        ContextSwitches,
+        PageFaults,
+        // Needs the raw_syscalls tracepoint, usually only readable by root
+        Syscalls,
+        Instructions,
+        CacheMisses,
+        Count
+    };
+
+    static constexpr std::size_t NB_EVENTS {
+        static_cast< std::size_t >( Event::Count ) };
+
+    using Values = std::array< uint64_t, NB_EVENTS >;
+    // Events counted by a thread
+    using Mask   = std::array< bool, NB_EVENTS >;
+
+    // Count the events of the calling thread until the end of the scope, if
+    // the counting is enabled. The name must outlive the program, as a string
+    // literal.
+    class Region
+    {
+        char const * m_name;
+        bool         m_isCounting;
+        Values       m_start;
+
+      public:
+        explicit Region( char const * name );
+        ~Region();
+
+        Region( Region const & )              = delete;
+        Region & operator= ( Region const & ) = delete;
+    };
+
+    struct Totals
+    {
+        uint64_t nbCalls;
+        Values   values;
+        // Calls in which the event has been counted
+        Values   nbCounted;
+    };
+
+  private:
+    mutable std::mutex                           m_mutex;
+    std::map< std::string, Totals, std::less<> > m_regions;
+    // Why some events aren't counted, seen when the counting is enabled
+    std::string                                  m_status;
+    std::atomic< bool >                          m_isEnabled;
+
+    PerfCounters();
+    virtual ~PerfCounters() = default;
+
+  public:
+    // Disabled by default, the counters are read with two system calls at
+    // each end of a region
+    void set_enabled ( bool isEnabled );
+    bool is_enabled () const;
+
+    std::map< std::string, Totals, std::less<> > get_regions () const;
+    // Empty if every event is counted
+    std::string                                  get_status () const;
+    void                                         clear ();
+
+    void debug_gui ();
+
+    static char const * get_event_name ( Event event );
+
+  private:
+    void add ( char const * name, Values const & values,
+               Mask const & isCounted );
+    void set_status ( std::string status );
+};
@@ -0,0 +1,245 @@
+#include "performance_overlay.hpp"
+
+#include <algorithm>  // for sort, max
+#include <cfloat>     // for FLT_MAX
+#include <cmath>      // for ceil
+#include <iterator>   // for back_inserter
+
+#include <fmt/format.h>   // for format, format_to
+#include <imgui/imgui.h>  // for ImGui::Begin, ImGui::PlotLines
+
+#include "app/job_scheduler.hpp"  // for JobScheduler
+
+namespace
+{
+    constexpr char const * PHASE_NAMES[] { "New frame", "Explorer::update",
+                                           "Render", "Swap and wait" };
+    // Longer frames are late on a 60 Hz display
+    constexpr float        FRAME_BUDGET { 1000.f / 60.f };
+    // Of 1 ms, the last one holds the longer frames
+    constexpr std::size_t  NB_HISTOGRAM_BINS { 50 };
+    constexpr ImVec2       GRAPH_SIZE { 320.f, 60.f };
+
+    float to_milliseconds ( std::chrono::steady_clock::duration duration )
+    {
+        return std::chrono::duration< float, std::milli > { duration }.count();
+    }
+
+    // Nearest rank, the values must be sorted
+    float get_percentile ( std::vector< float > const & sorted,
+                           float                        percentile )
+    {
+        if ( sorted.empty() )
+        {
+            return 0.f;
+        }
+        auto rank = static_cast< std::size_t >( std::ceil(
+            percentile / 100.f * static_cast< float >( sorted.size() ) ) );
+        return sorted[std::max< std::size_t >( rank, 1 ) - 1];
+    }
+}  // namespace
+
+PerformanceOverlay::PerformanceOverlay()
+  : m_frames { MAX_FRAMES },
+    m_current {},
+    m_frameStart { std::chrono::steady_clock::now() },
+    m_phaseStart { m_frameStart },
+    m_isShown { false }
+{}
+
+void PerformanceOverlay::begin_frame()
+{
+    m_frameStart = std::chrono::steady_clock::now();
+    m_phaseStart = m_frameStart;
+    m_current    = Frame {};
+}
+
+void PerformanceOverlay::end_phase( Phase phase )
+{
+    TimePoint now = std::chrono::steady_clock::now();
+    m_current.phases[static_cast< std::size_t >( phase )] +=
+        to_milliseconds( now - m_phaseStart );
+    m_phaseStart = now;
+}
+
+void PerformanceOverlay::end_frame()
+{
+    m_current.end      = std::chrono::steady_clock::now();
+    m_current.duration = to_milliseconds( m_current.end - m_frameStart );
+
+    JobScheduler const & scheduler = JobScheduler::get_instance();
+    m_current.workerLoad =
+        static_cast< float >( scheduler.get_nb_busy_threads() )
+        / static_cast< float >( std::max< std::size_t >(
+            scheduler.get_nb_threads(), 1 ) );
+    m_frames.push_back( m_current );
+}
+
+bool PerformanceOverlay::is_shown() const
+{
+    return m_isShown;
+}
+
+void PerformanceOverlay::set_shown( bool isShown )
+{
+    m_isShown = isShown;
+}
+
+void PerformanceOverlay::update_gui()
+{
+    if ( ! m_isShown )
+    {
+        return;
+    }
+
+    // At the bottom right of the window, without title bar
+    ImGuiViewport const * viewport = ImGui::GetMainViewport();
+    ImVec2                padding  = ImGui::GetStyle().WindowPadding;
+    ImGui::SetNextWindowPos(
+        ImVec2 { viewport->WorkPos.x + viewport->WorkSize.x - padding.x,
+                 viewport->WorkPos.y + viewport->WorkSize.y - padding.y },
+        ImGuiCond_Always, ImVec2 { 1.f, 1.f } );
+    ImGui::SetNextWindowBgAlpha( 0.85f );
+    ImGuiWindowFlags flags =
+        ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize
+        | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing
+        | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove;
+    if ( ! ImGui::Begin( "Performance", nullptr, flags ) )
+    {
+        ImGui::End();
+        return;
+    }
+
+    Summary summary = this->get_summary();
+    ImGui::Text( "Frames of the last %.1f s: %lu", summary.seconds,
+                 summary.durations.size() );
+    ImGui::Text( "p50 %.2f ms, p95 %.2f ms, p99 %.2f ms", summary.p50,
+                 summary.p95, summary.p99 );
+
+    float scaleMax = std::max( summary.p99 * 1.25f, FRAME_BUDGET * 2.f );
+    ImGui::PlotLines( "##FrameTimes", summary.durations.data(),
+                      static_cast< int >( summary.durations.size() ), 0,
+                      "Frame time", 0.f, scaleMax, GRAPH_SIZE );
+
+    std::array< float, NB_HISTOGRAM_BINS > histogram {};
+    for ( float duration : summary.durations )
+    {
+        auto bin = std::min( static_cast< std::size_t >( duration ),
+                             NB_HISTOGRAM_BINS - 1 );
+        histogram[bin] += 1.f;
+    }
+    ImGui::PlotHistogram( "##FrameHistogram", histogram.data(),
+                          static_cast< int >( histogram.size() ), 0,
+                          "Frames by ms (0-50)", 0.f, FLT_MAX, GRAPH_SIZE );
+
+    ImGuiTableFlags tableFlags = ImGuiTableFlags_RowBg
+                                 | ImGuiTableFlags_Borders
+                                 | ImGuiTableFlags_SizingFixedFit;
+    if ( ImGui::BeginTable( "Phases", 3, tableFlags ) )
+    {
+        for ( char const * header : { "Phase", "Mean", "p99" } )
+        {
+            ImGui::TableSetupColumn( header );
+        }
+        ImGui::TableHeadersRow();
+        for ( std::size_t idx = 0; idx < NB_PHASES; ++idx )
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted( PHASE_NAMES[idx] );
+            ImGui::TableNextColumn();
+            ImGui::Text( "%.2f ms", summary.phaseMeans[idx] );
+            ImGui::TableNextColumn();
+            ImGui::Text( "%.2f ms", summary.phaseP99s[idx] );
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::Text( "Job workers busy: %.0f%% of %lu", summary.workerLoad * 100.f,
+                 JobScheduler::get_instance().get_nb_threads() );
+
+    if ( ImGui::Button( "Copy" ) )
+    {
+        ImGui::SetClipboardText(
+            PerformanceOverlay::to_string( summary ).c_str() );
+    }
+    ImGui::SameLine();
+    if ( ImGui::Button( "Close" ) )
+    {
+        m_isShown = false;
+    }
+    ImGui::End();
+}
+
+PerformanceOverlay::Summary PerformanceOverlay::get_summary() const
+{
+    Summary summary {};
+    if ( m_frames.empty() )
+    {
+        return summary;
+    }
+
+    // From the oldest frame of the period
+    TimePoint   start = m_frames.back().end - PERIOD;
+    std::size_t first = m_frames.size();
+    while ( first > 0 && m_frames[first - 1].end >= start )
+    {
+        --first;
+    }
+
+    // Since the start of its first frame
+    summary.seconds =
+        std::chrono::duration< float > { m_frames.back().end
+                                         - m_frames[first].end }
+            .count()
+        + m_frames[first].duration / 1000.f;
+
+    std::array< std::vector< float >, NB_PHASES > phases {};
+    float                                         workerLoad { 0.f };
+    for ( std::size_t idx = first; idx < m_frames.size(); ++idx )
+    {
+        Frame const & frame = m_frames[idx];
+        summary.durations.push_back( frame.duration );
+        for ( std::size_t phase = 0; phase < NB_PHASES; ++phase )
+        {
+            phases[phase].push_back( frame.phases[phase] );
+            summary.phaseMeans[phase] += frame.phases[phase];
+        }
+        workerLoad += frame.workerLoad;
+    }
+
+    auto nbFrames = static_cast< float >( summary.durations.size() );
+    std::vector< float > sorted { summary.durations };
+    std::sort( sorted.begin(), sorted.end() );
+    summary.p50 = get_percentile( sorted, 50.f );
+    summary.p95 = get_percentile( sorted, 95.f );
+    summary.p99 = get_percentile( sorted, 99.f );
+    for ( std::size_t phase = 0; phase < NB_PHASES; ++phase )
+    {
+        std::sort( phases[phase].begin(), phases[phase].end() );
+        summary.phaseMeans[phase] /= nbFrames;
+        summary.phaseP99s[phase] = get_percentile( phases[phase], 99.f );
+    }
+    summary.workerLoad = workerLoad / nbFrames;
+    return summary;
+}
+
+std::string PerformanceOverlay::to_string( Summary const & summary )
+{
+    std::string text = fmt::format(
+        "{} frames in {:.1f} s: p50 {:.2f} ms, p95 {:.2f} ms, p99 {:.2f} ms\n",
+        summary.durations.size(), summary.seconds, summary.p50, summary.p95,
+        summary.p99 );
+    for ( std::size_t idx = 0; idx < NB_PHASES; ++idx )
+    {
+        fmt::format_to( std::back_inserter( text ),
+                        "{}: mean {:.2f} ms, p99 {:.2f} ms\n",
+                        PHASE_NAMES[idx], summary.phaseMeans[idx],
+                        summary.phaseP99s[idx] );
+    }
+    fmt::format_to( std::back_inserter( text ),
+                    "Job workers busy: {:.0f}% of {}\n",
+                    summary.workerLoad * 100.f,
+                    JobScheduler::get_instance().get_nb_threads() );
+    return text;
+}
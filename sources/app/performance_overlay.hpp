@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>   // for array
+#include <chrono>  // for steady_clock, seconds
+#include <string>  // for string
+#include <vector>  // for vector
+
+#include "tools/ring_buffer.hpp"
+#include "tools/singleton.hpp"
+
+// Time of the last frames, broken down in the phases of Window::update, with
+// the load of the job workers. It only reads the clock a few times by frame,
+// so it's always measured, and the overlay shows the numbers of a release
+// build for the users to report.
+class PerformanceOverlay : public Singleton< PerformanceOverlay >
+{
+    ENABLE_SINGLETON( PerformanceOverlay );
+
+  public:
+    enum class Phase
+    {
+        NewFrame = 0,
+        // Explorer::update
+        Update,
+        Render,
+        // Buffer swap and event wait, the vsync and the idle time
+        SwapAndWait,
+        Count
+    };
+
+    // Frames of the percentiles and the graph
+    static constexpr std::chrono::seconds PERIOD { 10 };
+    // 10 seconds at 400 frames per second, a shorter time is covered above
+    static constexpr std::size_t          MAX_FRAMES { 4096 };
+
+  private:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    static constexpr std::size_t NB_PHASES {
+        static_cast< std::size_t >( Phase::Count ) };
+
+    struct Frame
+    {
+        TimePoint                      end;
+        // In milliseconds
+        float                          duration;
+        std::array< float, NB_PHASES > phases;
+        // Part of the workers running a job at the end of the frame
+        float                          workerLoad;
+    };
+
+    struct Summary
+    {
+        std::vector< float >           durations;
+        // Covered by the frames, shorter than PERIOD if MAX_FRAMES are
+        // drawn faster
+        float                          seconds;
+        float                          p50;
+        float                          p95;
+        float                          p99;
+        std::array< float, NB_PHASES > phaseMeans;
+        std::array< float, NB_PHASES > phaseP99s;
+        float                          workerLoad;
+    };
+
+    RingBuffer< Frame > m_frames;
+    Frame               m_current;
+    TimePoint           m_frameStart;
+    TimePoint           m_phaseStart;
+    bool                m_isShown;
+
+    PerformanceOverlay();
+    virtual ~PerformanceOverlay() = default;
+
+  public:
+    // Called by the window, each phase starts at the end of the previous one
+    void begin_frame ();
+    void end_phase ( Phase phase );
+    void end_frame ();
+
+    bool is_shown () const;
+    void set_shown ( bool isShown );
+
+    // In a corner of the window, if it's shown
+    void update_gui ();
+
+  private:
+    // Of the frames of the period
+    Summary            get_summary () const;
+    // To paste in a bug report
+    static std::string to_string ( Summary const & summary );
+};
@@ -0,0 +1,138 @@
+#include "prefetcher.hpp"
+
+#include <algorithm>  // for max
+#include <thread>     // for sleep_for
+
+#include "app/explorer_settings.hpp"  // for ExplorerSettings
+#include "app/listing_cache.hpp"      // for ListingCache
+#include "app/mount_guard.hpp"        // for MountGuard
+
+namespace
+{
+    constexpr std::size_t MAX_PENDING_REQUESTS { 8 };
+    // Minimum delay between two directory reads of the prefetcher on a device
+    constexpr std::chrono::milliseconds SCAN_INTERVAL { 50 };
+    // A directory not read by then isn't worth waiting for
+    constexpr std::chrono::milliseconds SCAN_TIMEOUT { 5000 };
+}  // namespace
+
+Prefetcher::Prefetcher()
+  : m_mutex {},
+    m_pending {},
+    m_nbRequests { 0 },
+    m_lastRequest {},
+    m_nextScans {},
+    m_jobs { JobScheduler::JobClass::Prefetch }
+{
+    // Constructed before the prefetcher so it's destroyed after it
+    ListingCache::get_instance();
+}
+
+void Prefetcher::request( fs::path const & directory )
+{
+    Request request {};
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+
+        // Hovering a row requests the same directory every frame
+        if ( directory == m_lastRequest )
+        {
+            return;
+        }
+        m_lastRequest = directory;
+
+        if ( m_pending.contains( directory.string() ) )
+        {
+            return;
+        }
+        request = Request { directory,
+                            MountGuard::get_instance().get_device( directory ),
+                            Settings::get_instance().showHidden,
+                            ++m_nbRequests };
+        m_pending[directory.string()] = request.number;
+    }
+
+    // The directory isn't accessed from the UI thread
+    m_jobs.submit(
+        request.device,
+        [this, request] ( std::stop_token stopToken ) {
+            this->prefetch( request, stopToken );
+        },
+        static_cast< int64_t >( request.number ) );
+}
+
+void Prefetcher::cancel()
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    m_pending.clear();
+    m_lastRequest.clear();
+}
+
+std::size_t Prefetcher::get_queue_size() const
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    return m_pending.size();
+}
+
+void Prefetcher::prefetch( Request const & request,
+                           std::stop_token stopToken )
+{
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        // Requested again since, by a job still pending
+        auto pending = m_pending.find( request.directory.string() );
+        if ( pending != m_pending.end()
+             && pending->second == request.number )
+        {
+            m_pending.erase( pending );
+        }
+        if ( stopToken.stop_requested()
+             || m_nbRequests - request.number >= MAX_PENDING_REQUESTS )
+        {
+            return;
+        }
+    }
+
+    ListingCache & cache = ListingCache::get_instance();
+    if ( ! this->wait_turn( request.device, stopToken )
+         || cache.contains( request.directory, request.showHidden ) )
+    {
+        return;
+    }
+    // Read by the scan worker of the mount, so a hung mount doesn't block
+    // the prefetch of the others, and the short calls of the UI don't wait
+    // for it
+    MountGuard::get_instance().run(
+        request.directory,
+        [request, stopToken] () {
+            std::shared_ptr< ds::Listing const > listing = ds::scan_directory(
+                request.directory, request.showHidden, stopToken );
+            if ( listing )
+            {
+                ListingCache::get_instance().insert( listing, true );
+            }
+        },
+        SCAN_TIMEOUT, MountGuard::Lane::Scan );
+}
+
+bool Prefetcher::wait_turn( dev_t device, std::stop_token const & stopToken )
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        // Reserved before waiting, so two jobs don't take the same turn
+        std::lock_guard< std::mutex > lock { m_mutex };
+        auto & nextScan = m_nextScans[device];
+        start           = std::max( start, nextScan );
+        nextScan        = start + SCAN_INTERVAL;
+    }
+    std::this_thread::sleep_until( start );
+
+    // Never compete with the directory read by the UI thread
+    JobScheduler const & scheduler = JobScheduler::get_instance();
+    while ( ! stopToken.stop_requested()
+            && scheduler.is_interactive_running( device ) )
+    {
+        std::this_thread::sleep_for( SCAN_INTERVAL / 5 );
+    }
+    return ! stopToken.stop_requested();
+}
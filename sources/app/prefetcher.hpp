@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>         // for steady_clock
+#include <cstdint>        // for uint64_t
+#include <mutex>          // for mutex
+#include <stop_token>     // for stop_token
+#include <string>         // for string
+#include <unordered_map>  // for unordered_map
+
+#include <sys/types.h>  // for dev_t
+
+#include "app/filesystem.hpp"     // for fs::path
+#include "app/job_scheduler.hpp"  // for JobScheduler
+#include "tools/singleton.hpp"
+
+// Read the directories the user will probably open next as prefetch jobs,
+// and store them in the listing cache. The reads of a device are spaced by
+// a minimum interval, and wait for the directory read by the UI thread.
+class Prefetcher : public Singleton< Prefetcher >
+{
+    ENABLE_SINGLETON( Prefetcher );
+
+    struct Request
+    {
+        fs::path directory;
+        dev_t    device;
+        bool     showHidden;
+        // Number of the request, the newest are read first
+        uint64_t number;
+    };
+
+    mutable std::mutex                          m_mutex;
+    // Number of the request of each pending directory
+    std::unordered_map< std::string, uint64_t > m_pending;
+    uint64_t                                    m_nbRequests;
+    fs::path                                    m_lastRequest;
+    // Earliest start of the next read of each device
+    std::unordered_map< dev_t, std::chrono::steady_clock::time_point >
+                                                m_nextScans;
+    // Destroyed first, so no job runs on a partially destroyed prefetcher
+    JobScheduler::Queue                         m_jobs;
+
+    Prefetcher();
+    virtual ~Prefetcher() = default;
+
+  public:
+    // Ask for the directory to be read in background, the oldest requests
+    // are dropped if too many are pending
+    void        request ( fs::path const & directory );
+    // Forget the requests, their jobs are cancelled by the navigation
+    void        cancel ();
+    std::size_t get_queue_size () const;
+
+  private:
+    void prefetch ( Request const & request, std::stop_token stopToken );
+    // Return false if stopped meanwhile
+    bool wait_turn ( dev_t device, std::stop_token const & stopToken );
+};
@@ -0,0 +1,375 @@
+#include "snapshot.hpp"
+
+#include <algorithm>  // for sort
+#include <deque>      // for deque
+#include <fstream>    // for ifstream, ofstream
+#include <limits>     // for numeric_limits
+#include <optional>   // for optional
+#include <random>     // for random_device
+
+#include <fmt/format.h>  // for format
+
+#include "app/vfs.hpp"       // for vfs::get_file_system
+#include "tools/md5.hpp"     // for md5::hex_digest
+#include "tools/traces.hpp"  // for Trace
+
+namespace
+{
+    constexpr std::string_view MAGIC { "FESNAP" };
+    constexpr uint8_t          VERSION { 1 };
+    constexpr uint8_t          HASHED_NAMES_FLAG { 0x01 };
+    // Written to the file once the buffer is this large
+    constexpr std::size_t      FLUSH_SIZE { 1024 * 1024 };
+    // Entries recorded between two progress messages
+    constexpr uint64_t         PROGRESS_STEP { 1'000'000 };
+    // Longer extensions are more likely a part of the name
+    constexpr std::size_t      MAX_EXTENSION_SIZE { 8 };
+    // Hexadecimal digits kept from the hash of a name
+    constexpr std::size_t      HASH_SIZE { 16 };
+
+    struct Child
+    {
+        std::string name;
+        uint8_t     kind;
+        uint64_t    size;
+        int64_t     modificationTime;
+        fs::path    path;
+    };
+
+    void write_varint ( std::string & buffer, uint64_t value )
+    {
+        while ( value >= 0x80 )
+        {
+            buffer.push_back( static_cast< char >( value | 0x80 ) );
+            value >>= 7;
+        }
+        buffer.push_back( static_cast< char >( value ) );
+    }
+
+    // The times are stored as the difference with the previous entry, which
+    // is small and may be negative
+    uint64_t zigzag ( int64_t value )
+    {
+        return ( static_cast< uint64_t >( value ) << 1 )
+               ^ static_cast< uint64_t >( value >> 63 );
+    }
+
+    int64_t unzigzag ( uint64_t value )
+    {
+        return static_cast< int64_t >( value >> 1 )
+               ^ -static_cast< int64_t >( value & 1 );
+    }
+
+    // Read the values of a snapshot, it's invalid once a read went past its
+    // end
+    class Reader
+    {
+        std::string_view m_data;
+        std::size_t      m_position;
+        bool             m_isValid;
+
+      public:
+        explicit Reader( std::string_view data )
+          : m_data { data }, m_position { 0 }, m_isValid { true }
+        {}
+
+        std::string_view read ( std::size_t size )
+        {
+            if ( size > this->get_remaining() )
+            {
+                m_isValid = false;
+                return {};
+            }
+            std::string_view value { m_data.substr( m_position, size ) };
+            m_position += size;
+            return value;
+        }
+
+        uint8_t read_byte ()
+        {
+            std::string_view byte { this->read( 1 ) };
+            return byte.empty() ? 0 : static_cast< uint8_t >( byte[0] );
+        }
+
+        uint64_t read_varint ()
+        {
+            uint64_t value { 0 };
+            for ( unsigned int shift = 0; shift < 64; shift += 7 )
+            {
+                uint8_t byte = this->read_byte();
+                value |= static_cast< uint64_t >( byte & 0x7F ) << shift;
+                if ( ( byte & 0x80 ) == 0 )
+                {
+                    return value;
+                }
+            }
+            m_isValid = false;
+            return 0;
+        }
+
+        std::size_t get_remaining () const
+        {
+            return m_data.size() - m_position;
+        }
+
+        bool is_valid () const
+        {
+            return m_isValid;
+        }
+    };
+
+    std::string make_key ()
+    {
+        std::random_device device {};
+        return fmt::format( "{:08x}{:08x}{:08x}{:08x}", device(), device(),
+                            device(), device() );
+    }
+
+    // The hidden files stay hidden, and the extension is kept so the file
+    // types are the same
+    std::string hash_name ( std::string_view name, std::string const & key )
+    {
+        std::size_t      start { name.starts_with( '.' ) ? 1u : 0u };
+        std::size_t      dot = name.find_last_of( '.' );
+        std::string_view extension {};
+        if ( dot != std::string_view::npos && dot > start
+             && name.size() - dot <= MAX_EXTENSION_SIZE )
+        {
+            extension = name.substr( dot );
+        }
+        return fmt::format( "{}{}{}", name.substr( 0, start ),
+                            md5::hex_digest( key + std::string { name } )
+                                .substr( 0, HASH_SIZE ),
+                            extension );
+    }
+
+    // Nothing if the entry has been removed since its directory was read
+    std::optional< Child > read_child ( vfs::FileSystem &           fileSystem,
+                                        fs::path const &            directory,
+                                        vfs::DirectoryEntry const & entry )
+    {
+        Child child { entry.name, 0, 0, 0, directory / entry.name };
+
+        std::error_code error {};
+        vfs::Status status = fileSystem.symlink_status( child.path, error );
+        if ( error )
+        {
+            return std::nullopt;
+        }
+        child.kind = static_cast< uint8_t >( status.kind );
+        if ( status.kind == vfs::FileKind::Symlink )
+        {
+            vfs::Status target = fileSystem.status( child.path, error );
+            child.kind =
+                static_cast< uint8_t >( error ? vfs::FileKind::Unknown
+                                              : target.kind )
+                | snapshot::LINK_FLAG;
+            if ( ! error )
+            {
+                status = target;
+            }
+        }
+        child.size             = status.size;
+        child.modificationTime = status.modificationTime;
+        return child;
+    }
+}  // namespace
+
+namespace snapshot
+{
+    std::size_t Tree::size() const
+    {
+        return kinds.size();
+    }
+
+    std::string_view Tree::get_name( uint32_t index ) const
+    {
+        return std::string_view { names }.substr(
+            nameOffsets[index], nameOffsets[index + 1] - nameOffsets[index] );
+    }
+
+    bool record ( fs::path const & directory, fs::path const & file,
+                  bool hashNames )
+    {
+        vfs::FileSystem & fileSystem = vfs::get_file_system();
+
+        std::error_code error {};
+        vfs::Status     root = fileSystem.status( directory, error );
+        if ( ! error && root.kind != vfs::FileKind::Directory )
+        {
+            error = std::make_error_code( std::errc::not_a_directory );
+        }
+        if ( error )
+        {
+            Trace::Error( "Can't read directory {}: {}", directory.c_str(),
+                          error.message() );
+            return false;
+        }
+        std::ofstream output { file, std::ios::binary };
+        if ( ! output )
+        {
+            Trace::Error( "Can't write the snapshot {}", file.c_str() );
+            return false;
+        }
+
+        std::string key { hashNames ? make_key() : "" };
+        std::string buffer { MAGIC };
+        buffer.push_back( static_cast< char >( VERSION ) );
+        buffer.push_back( static_cast< char >( hashNames ? HASHED_NAMES_FLAG
+                                                         : 0 ) );
+        write_varint( buffer, zigzag( root.modificationTime ) );
+        int64_t  previousTime { root.modificationTime };
+        uint64_t nbEntries { 1 };
+        uint64_t nbWritten { 0 };
+
+        // The entries of each directory are written in the order the
+        // directories have been found, so they are read back in breadth
+        // first order
+        std::deque< fs::path > pending { directory };
+        while ( ! pending.empty() )
+        {
+            fs::path current { std::move( pending.front() ) };
+            pending.pop_front();
+
+            std::vector< Child > children {};
+            for ( vfs::DirectoryEntry const & entry :
+                  fileSystem.enumerate( current, error ) )
+            {
+                std::optional< Child > child =
+                    read_child( fileSystem, current, entry );
+                if ( child.has_value() )
+                {
+                    if ( hashNames )
+                    {
+                        child->name = hash_name( child->name, key );
+                    }
+                    children.push_back( std::move( child.value() ) );
+                }
+            }
+            if ( error )
+            {
+                Trace::Warning( "Can't read directory {}: {}", current.c_str(),
+                                error.message() );
+            }
+            std::sort( children.begin(), children.end(),
+                       [] ( Child const & lhs, Child const & rhs ) {
+                           return lhs.name < rhs.name;
+                       } );
+
+            write_varint( buffer, children.size() );
+            for ( Child & child : children )
+            {
+                buffer.push_back( static_cast< char >( child.kind ) );
+                write_varint( buffer, child.name.size() );
+                buffer += child.name;
+                write_varint( buffer, child.size );
+                write_varint( buffer,
+                              zigzag( child.modificationTime - previousTime ) );
+                previousTime = child.modificationTime;
+                if ( child.kind
+                     == static_cast< uint8_t >( vfs::FileKind::Directory ) )
+                {
+                    pending.push_back( std::move( child.path ) );
+                }
+                if ( ++nbEntries % PROGRESS_STEP == 0 )
+                {
+                    Trace::Info( "{} entries recorded", nbEntries );
+                }
+            }
+
+            if ( buffer.size() >= FLUSH_SIZE || pending.empty() )
+            {
+                output.write( buffer.data(),
+                              static_cast< std::streamsize >( buffer.size() ) );
+                nbWritten += buffer.size();
+                buffer.clear();
+            }
+        }
+
+        output.close();
+        if ( ! output )
+        {
+            Trace::Error( "Can't write the snapshot {}", file.c_str() );
+            return false;
+        }
+        Trace::Info( "{} entries recorded in {} ({} bytes)", nbEntries,
+                     file.c_str(), nbWritten );
+        return true;
+    }
+
+    bool load ( fs::path const & file, Tree & tree )
+    {
+        std::ifstream input { file, std::ios::binary | std::ios::ate };
+        if ( ! input )
+        {
+            Trace::Error( "Can't read the snapshot {}", file.c_str() );
+            return false;
+        }
+        std::string data( static_cast< std::size_t >( input.tellg() ), '\0' );
+        input.seekg( 0 );
+        input.read( data.data(),
+                    static_cast< std::streamsize >( data.size() ) );
+
+        Reader reader { data };
+        if ( reader.read( MAGIC.size() ) != MAGIC
+             || reader.read_byte() != VERSION )
+        {
+            Trace::Error( "{} isn't a snapshot", file.c_str() );
+            return false;
+        }
+        reader.read_byte();
+
+        tree = Tree {};
+        auto add = [&tree] ( std::string_view name, uint8_t kind,
+                             uint64_t size, int64_t modificationTime ) {
+            tree.nameOffsets.push_back( tree.names.size() );
+            tree.names += name;
+            tree.kinds.push_back( kind );
+            tree.sizes.push_back( size );
+            tree.modificationTimes.push_back( modificationTime );
+            tree.firstChildren.push_back( 0 );
+            tree.nbChildren.push_back( 0 );
+        };
+        int64_t previousTime { unzigzag( reader.read_varint() ) };
+        add( "", static_cast< uint8_t >( vfs::FileKind::Directory ), 0,
+             previousTime );
+
+        auto directoryKind = static_cast< uint8_t >( vfs::FileKind::Directory );
+        for ( std::size_t directory = 0;
+              directory < tree.size() && reader.is_valid(); ++directory )
+        {
+            if ( tree.kinds[directory] != directoryKind )
+            {
+                continue;
+            }
+            uint64_t nbChildren = reader.read_varint();
+            // Each entry takes a few bytes, a larger count is corrupted
+            if ( nbChildren > reader.get_remaining()
+                 || tree.size() + nbChildren
+                        >= std::numeric_limits< uint32_t >::max() )
+            {
+                Trace::Error( "{} is corrupted", file.c_str() );
+                return false;
+            }
+            tree.firstChildren[directory] =
+                static_cast< uint32_t >( tree.size() );
+            tree.nbChildren[directory] = static_cast< uint32_t >( nbChildren );
+            for ( uint64_t idx = 0; idx < nbChildren; ++idx )
+            {
+                uint8_t          kind = reader.read_byte();
+                std::string_view name = reader.read( reader.read_varint() );
+                uint64_t         size = reader.read_varint();
+                previousTime += unzigzag( reader.read_varint() );
+                add( name, kind, size, previousTime );
+            }
+        }
+        tree.nameOffsets.push_back( tree.names.size() );
+
+        if ( ! reader.is_valid() || reader.get_remaining() != 0 )
+        {
+            Trace::Error( "{} is corrupted", file.c_str() );
+            return false;
+        }
+        return true;
+    }
+}  // namespace snapshot
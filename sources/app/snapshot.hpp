@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>      // for uint8_t, uint32_t, uint64_t, int64_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include "app/filesystem.hpp"  // for fs::path
+
+// Shape of a directory tree (names, types, sizes and modification times,
+// without the contents), recorded in a compact file to reproduce the
+// performance issues of a tree that can't be shared
+namespace snapshot
+{
+    // The kind of the entries is a vfs::FileKind, with this bit set for the
+    // symbolic links. A link has the kind, size and time of its target, and
+    // a link to a directory has no entries.
+    constexpr uint8_t LINK_FLAG { 0x80 };
+
+    // The entries in breadth first order: the root is the first one, and the
+    // entries of each directory follow each other, sorted by name
+    struct Tree
+    {
+        // Each name ends where the next one starts
+        std::string             names;
+        std::vector< uint64_t > nameOffsets;
+        std::vector< uint8_t >  kinds;
+        std::vector< uint64_t > sizes;
+        // In nanoseconds since epoch
+        std::vector< int64_t >  modificationTimes;
+        std::vector< uint32_t > firstChildren;
+        std::vector< uint32_t > nbChildren;
+
+        std::size_t      size () const;
+        std::string_view get_name ( uint32_t index ) const;
+    };
+
+    // Read the tree below the directory through the current file system and
+    // write its snapshot. The hashed names only keep their extension, with
+    // a key that isn't saved so they can't be guessed from a dictionary.
+    bool record ( fs::path const & directory, fs::path const & file,
+                  bool hashNames );
+    // Return false if the file isn't a valid snapshot
+    bool load ( fs::path const & file, Tree & tree );
+}  // namespace snapshot
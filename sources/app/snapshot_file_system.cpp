@@ -0,0 +1,258 @@
+#include "snapshot_file_system.hpp"
+
+#include <algorithm>  // for min
+#include <cerrno>     // for ENOENT, ENOTDIR, EISDIR
+
+#include <imgui/imgui.h>  // for ImGui::Text
+
+namespace
+{
+    // The entries of the snapshot have the next inodes
+    constexpr uint64_t ABOVE_INODE { 1 };
+
+    std::error_code make_error ( int value )
+    {
+        return std::error_code { value, std::generic_category() };
+    }
+
+    vfs::FileKind get_kind ( uint8_t kind )
+    {
+        return static_cast< vfs::FileKind >( kind & ~snapshot::LINK_FLAG );
+    }
+
+    class SnapshotFile : public vfs::File
+    {
+        uint64_t m_size;
+
+      public:
+        explicit SnapshotFile( uint64_t size ) : m_size { size } {}
+        virtual ~SnapshotFile() = default;
+
+        ssize_t read_at ( void * buffer, std::size_t size,
+                          uint64_t offset ) override
+        {
+            if ( offset >= m_size )
+            {
+                return 0;
+            }
+            std::size_t nbRead = static_cast< std::size_t >(
+                std::min< uint64_t >( size, m_size - offset ) );
+            vfs::fill_synthetic_content( static_cast< char * >( buffer ),
+                                         nbRead, offset );
+            return static_cast< ssize_t >( nbRead );
+        }
+
+        uint64_t get_size () const override
+        {
+            return m_size;
+        }
+    };
+}  // namespace
+
+namespace vfs
+{
+    SnapshotFileSystem::SnapshotFileSystem( snapshot::Tree   tree,
+                                            fs::path const & mountPoint )
+      : m_tree { std::move( tree ) }, m_mountPoint { normalize( mountPoint ) }
+    {}
+
+    std::vector< DirectoryEntry > SnapshotFileSystem::enumerate(
+        fs::path const & directory, std::error_code & error )
+    {
+        std::vector< DirectoryEntry > entries {};
+        Location location = this->find( directory );
+        if ( location.kind == Location::Kind::Above )
+        {
+            // Only the next directory to the mount point
+            std::string path { normalize( directory ) };
+            std::size_t start { path == "/" ? 1 : path.size() + 1 };
+            std::size_t end { m_mountPoint.find( '/', start ) };
+            entries.push_back( DirectoryEntry {
+                m_mountPoint.substr( start, end - start ),
+                FileKind::Directory } );
+            error.clear();
+            return entries;
+        }
+        if ( location.kind == Location::Kind::Outside
+             || m_tree.kinds[location.index]
+                    != static_cast< uint8_t >( FileKind::Directory ) )
+        {
+            error = make_error( location.kind == Location::Kind::Outside
+                                    ? ENOENT
+                                    : ENOTDIR );
+            return entries;
+        }
+        error.clear();
+
+        uint32_t first { m_tree.firstChildren[location.index] };
+        uint32_t last { first + m_tree.nbChildren[location.index] };
+        entries.reserve( last - first );
+        for ( uint32_t child = first; child < last; ++child )
+        {
+            uint8_t kind { m_tree.kinds[child] };
+            entries.push_back( DirectoryEntry {
+                std::string { m_tree.get_name( child ) },
+                kind & snapshot::LINK_FLAG ? FileKind::Symlink
+                                           : get_kind( kind ) } );
+        }
+        return entries;
+    }
+
+    Status SnapshotFileSystem::status( fs::path const &  path,
+                                       std::error_code & error )
+    {
+        Location location = this->find( path );
+        Status   status   = this->get_status( location, true );
+        // Also for the broken links
+        error = status.kind == FileKind::Unknown ? make_error( ENOENT )
+                                                 : std::error_code {};
+        return status;
+    }
+
+    Status SnapshotFileSystem::symlink_status( fs::path const &  path,
+                                               std::error_code & error )
+    {
+        Location location = this->find( path );
+        error             = location.kind == Location::Kind::Outside
+                                ? make_error( ENOENT )
+                                : std::error_code {};
+        return this->get_status( location, false );
+    }
+
+    std::unique_ptr< File > SnapshotFileSystem::open( fs::path const &  path,
+                                                      std::error_code & error )
+    {
+        Location location = this->find( path );
+        Status   status   = this->get_status( location, true );
+        if ( status.kind != FileKind::Regular )
+        {
+            error = make_error( status.kind == FileKind::Unknown ? ENOENT
+                                                                 : EISDIR );
+            return nullptr;
+        }
+        error.clear();
+        return std::make_unique< SnapshotFile >( status.size );
+    }
+
+    std::unique_ptr< Watch > SnapshotFileSystem::watch(
+        fs::path const & directory, std::function< void() > /* onChange */,
+        std::error_code & error )
+    {
+        if ( this->find( directory ).kind == Location::Kind::Outside )
+        {
+            error = make_error( ENOENT );
+            return nullptr;
+        }
+        error.clear();
+        return std::make_unique< Watch >();
+    }
+
+    void SnapshotFileSystem::debug_gui()
+    {
+        ImGui::Text( "Snapshot file system" );
+        ImGui::Text( "Mounted on %s", m_mountPoint.c_str() );
+        ImGui::Text( "Entries: %lu", m_tree.size() );
+        ImGui::Text( "Names: %lu bytes", m_tree.names.size() );
+    }
+
+    SnapshotFileSystem::Location SnapshotFileSystem::find(
+        fs::path const & path ) const
+    {
+        std::string normalized { normalize( path ) };
+        if ( normalized == m_mountPoint )
+        {
+            return Location { Location::Kind::Inside, 0 };
+        }
+        if ( normalized == "/"
+             || ( m_mountPoint.starts_with( normalized )
+                  && m_mountPoint[normalized.size()] == '/' ) )
+        {
+            return Location { Location::Kind::Above, 0 };
+        }
+        if ( m_mountPoint != "/"
+             && ( ! normalized.starts_with( m_mountPoint )
+                  || normalized[m_mountPoint.size()] != '/' ) )
+        {
+            return Location { Location::Kind::Outside, 0 };
+        }
+
+        // The entries of each directory are sorted by name
+        std::string_view remaining { normalized };
+        remaining.remove_prefix(
+            m_mountPoint == "/" ? 1 : m_mountPoint.size() + 1 );
+        uint32_t index { 0 };
+        while ( ! remaining.empty() )
+        {
+            if ( m_tree.kinds[index]
+                 != static_cast< uint8_t >( FileKind::Directory ) )
+            {
+                return Location { Location::Kind::Outside, 0 };
+            }
+            std::size_t      separator = remaining.find( '/' );
+            std::string_view name { remaining.substr( 0, separator ) };
+            remaining.remove_prefix( separator == std::string_view::npos
+                                         ? remaining.size()
+                                         : separator + 1 );
+
+            uint32_t first { m_tree.firstChildren[index] };
+            uint32_t last { first + m_tree.nbChildren[index] };
+            uint32_t count { last - first };
+            // Binary search of the name among the entries
+            while ( count > 0 )
+            {
+                uint32_t step { count / 2 };
+                if ( m_tree.get_name( first + step ) < name )
+                {
+                    first += step + 1;
+                    count -= step + 1;
+                }
+                else
+                {
+                    count = step;
+                }
+            }
+            if ( first == last || m_tree.get_name( first ) != name )
+            {
+                return Location { Location::Kind::Outside, 0 };
+            }
+            index = first;
+        }
+        return Location { Location::Kind::Inside, index };
+    }
+
+    Status SnapshotFileSystem::get_status( Location const & location,
+                                           bool             followLink ) const
+    {
+        switch ( location.kind )
+        {
+        case Location::Kind::Outside :
+            return Status { FileKind::Unknown, 0, 0, 0, 0 };
+        case Location::Kind::Above :
+            return Status { FileKind::Directory, 0, DEVICE, ABOVE_INODE,
+                            m_tree.modificationTimes[0] };
+        case Location::Kind::Inside :
+            break;
+        }
+
+        uint32_t index { location.index };
+        uint8_t  kind { m_tree.kinds[index] };
+        return Status { ! followLink && ( kind & snapshot::LINK_FLAG )
+                            ? FileKind::Symlink
+                            : get_kind( kind ),
+                        m_tree.sizes[index], DEVICE,
+                        ABOVE_INODE + 1 + index,
+                        m_tree.modificationTimes[index] };
+    }
+
+    bool use_snapshot_home ( fs::path const & file )
+    {
+        snapshot::Tree tree {};
+        if ( ! snapshot::load( file, tree ) )
+        {
+            return false;
+        }
+        set_file_system( std::make_shared< SnapshotFileSystem >(
+            std::move( tree ), ds::get_home_directory() ) );
+        return true;
+    }
+}  // namespace vfs
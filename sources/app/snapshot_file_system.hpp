@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>  // for uint32_t
+#include <string>   // for string
+
+#include "app/snapshot.hpp"  // for snapshot::Tree
+#include "app/vfs.hpp"       // for vfs::FileSystem
+
+namespace vfs
+{
+    // Serve a recorded snapshot, read only. The root of the snapshot is
+    // showed at the mount point, and its parent directories only hold it.
+    // The files content isn't recorded, they are read as lines of letters.
+    class SnapshotFileSystem : public FileSystem
+    {
+        // Where a path is in the tree
+        struct Location
+        {
+            enum class Kind
+            {
+                Outside = 0,
+                // Parent directory of the mount point
+                Above,
+                Inside
+            };
+
+            Kind     kind;
+            uint32_t index;
+        };
+
+        snapshot::Tree m_tree;
+        std::string    m_mountPoint;
+
+      public:
+        // Device given by the status of every file
+        static constexpr uint64_t DEVICE { 0xFFFF'0002 };
+
+        SnapshotFileSystem( snapshot::Tree tree, fs::path const & mountPoint );
+        virtual ~SnapshotFileSystem() = default;
+
+        std::vector< DirectoryEntry > enumerate (
+            fs::path const & directory, std::error_code & error ) override;
+        Status status ( fs::path const &  path,
+                        std::error_code & error ) override;
+        Status symlink_status ( fs::path const &  path,
+                                std::error_code & error ) override;
+        std::unique_ptr< File > open ( fs::path const &  path,
+                                       std::error_code & error ) override;
+        // The snapshot never changes, the watch is never called
+        std::unique_ptr< Watch > watch ( fs::path const &        directory,
+                                         std::function< void() > onChange,
+                                         std::error_code & error ) override;
+
+        void debug_gui () override;
+
+      private:
+        Location find ( fs::path const & path ) const;
+        Status   get_status ( Location const & location,
+                              bool             followLink ) const;
+    };
+
+    // Use the snapshot in the file, mounted on the home directory (explorer
+    // --snapshot). Return false if it can't be loaded.
+    bool use_snapshot_home ( fs::path const & file );
+}  // namespace vfs
@@ -0,0 +1,353 @@
+#include "text_preview.hpp"
+
+#include <algorithm>     // for min, max
+#include <climits>       // for INT_MAX
+#include <cstring>       // for memrchr
+#include <system_error>  // for error_code
+
+#include <fmt/format.h>   // for format
+#include <imgui/imgui.h>  // for ImGui::TextUnformatted, ImGuiListClipper
+
+#include "app/filesystem.hpp"     // for ds::get_size_pretty_print
+#include "app/job_scheduler.hpp"  // for JobScheduler
+#include "tools/newlines.hpp"     // for newlines::find_nth
+#include "tools/traces.hpp"       // for Trace
+
+namespace
+{
+    // Rows indexed between two saved row starts
+    constexpr uint64_t ROWS_PER_CHECKPOINT { 64 };
+    // Read by the indexer between two updates of the index
+    constexpr uint64_t INDEX_CHUNK_SIZE { 8 * 1024 * 1024 };
+    // Longer lines are cut in several rows
+    constexpr uint64_t MAX_LINE_LENGTH { 16 * 1024 };
+    // Read at once for the showed rows, more than the longest row
+    constexpr uint64_t READ_SIZE { 64 * 1024 };
+    // Used for the estimations until some rows are indexed
+    constexpr uint64_t DEFAULT_LINE_LENGTH { 80 };
+
+    // Length of the row at the start of the data, its newline included. It's
+    // 0 if the row goes past the data and the data doesn't end the file.
+    uint64_t get_row_length ( std::string_view data, bool isFileEnd )
+    {
+        uint64_t        size  = std::min< uint64_t >( data.size(),
+                                                      MAX_LINE_LENGTH + 1 );
+        newlines::Match match = newlines::find_nth( data.data(), size, 1 );
+        if ( match.count == 1 )
+        {
+            return match.position + 1;
+        }
+        if ( data.size() > MAX_LINE_LENGTH )
+        {
+            return MAX_LINE_LENGTH;
+        }
+        return isFileEnd ? data.size() : 0;
+    }
+}  // namespace
+
+TextPreview::TextPreview( fs::path const & path )
+  : m_path { path },
+    m_file {},
+    m_size { 0 },
+    m_buffer {},
+    m_mutex {},
+    m_checkpoints { 0 },
+    m_nbIndexedRows { 0 },
+    m_indexedSize { 0 },
+    m_isIndexed { false },
+    m_indexer {}
+{
+    std::error_code error {};
+    m_file = vfs::get_file_system().open( path, error );
+    if ( ! m_file )
+    {
+        Trace::Warning( "Can't open {}: {}", path.c_str(), error.message() );
+        return;
+    }
+    m_size = m_file->get_size();
+    if ( m_size == 0 )
+    {
+        m_isIndexed = true;
+        return;
+    }
+
+    m_indexer = std::jthread { [this] ( std::stop_token stopToken ) {
+        this->index( stopToken );
+    } };
+}
+
+TextPreview::~TextPreview()
+{
+    if ( m_indexer.joinable() )
+    {
+        m_indexer.request_stop();
+        m_indexer.join();
+    }
+}
+
+void TextPreview::update_gui()
+{
+    ImGui::TextUnformatted( m_path.filename().c_str() );
+    if ( ! this->is_open() )
+    {
+        ImGui::TextDisabled( "Can't be previewed" );
+        return;
+    }
+
+    uint64_t nbLines  = this->get_nb_rows();
+    bool     isExact  = m_isIndexed.load();
+    uint64_t progress = 0;
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        progress = m_size > 0 ? m_indexedSize * 100 / m_size : 100;
+    }
+    ImGui::TextDisabled(
+        "%s, %s%lu lines%s",
+        ds::get_size_pretty_print( m_size, false ).c_str(),
+        isExact ? "" : "~", nbLines,
+        isExact ? "" : fmt::format( " (indexing {}%)", progress ).c_str() );
+    ImGui::Separator();
+
+    if ( ! ImGui::BeginChild( "Text Preview Lines", ImVec2 { 0.f, 0.f },
+                              false, ImGuiWindowFlags_HorizontalScrollbar ) )
+    {
+        ImGui::EndChild();
+        return;
+    }
+
+    int nbRows = static_cast< int >(
+        std::min< uint64_t >( nbLines, static_cast< uint64_t >( INT_MAX ) ) );
+    ImGuiListClipper clipper {};
+    clipper.Begin( nbRows );
+    while ( clipper.Step() )
+    {
+        auto idxFirst = static_cast< uint64_t >( clipper.DisplayStart );
+        auto idxLast  = static_cast< uint64_t >( clipper.DisplayEnd );
+
+        // At the end of a file not yet indexed, the last rows are found
+        // from the end, whatever the estimation was
+        bool     isLast = idxLast == static_cast< uint64_t >( nbRows );
+        uint64_t offset = ! isExact && isLast
+                              ? this->find_last_rows( idxLast - idxFirst )
+                              : this->get_row_offset( idxFirst );
+
+        // The bytes read from the offset, read again from the next row once
+        // a row goes past them
+        std::string_view data {};
+        bool             isFileEnd { false };
+        for ( uint64_t idx = idxFirst; idx < idxLast; ++idx )
+        {
+            uint64_t length = get_row_length( data, isFileEnd );
+            if ( length == 0 && ! isFileEnd )
+            {
+                data      = this->read( offset, READ_SIZE, m_buffer );
+                isFileEnd = data.size() < READ_SIZE;
+                length    = get_row_length( data, isFileEnd );
+            }
+            if ( length == 0 )
+            {
+                // Every row must be submitted to keep the layout
+                ImGui::TextUnformatted( "" );
+                continue;
+            }
+
+            std::string_view row { data.substr( 0, length ) };
+            if ( row.back() == '\n' )
+            {
+                row.remove_suffix( 1 );
+            }
+            ImGui::TextUnformatted( row.data(), row.data() + row.size() );
+            data.remove_prefix( length );
+            offset += length;
+        }
+    }
+    ImGui::EndChild();
+}
+
+fs::path const & TextPreview::get_path() const
+{
+    return m_path;
+}
+
+bool TextPreview::is_open() const
+{
+    return m_file != nullptr;
+}
+
+uint64_t TextPreview::get_nb_rows() const
+{
+    if ( m_size == 0 )
+    {
+        return 0;
+    }
+
+    std::lock_guard< std::mutex > lock { m_mutex };
+    if ( m_isIndexed )
+    {
+        return m_nbIndexedRows;
+    }
+
+    uint64_t rowLength = m_nbIndexedRows > 0
+                             ? m_indexedSize / m_nbIndexedRows
+                             : std::max( m_indexedSize, DEFAULT_LINE_LENGTH );
+    rowLength          = std::max< uint64_t >( rowLength, 1 );
+    return m_nbIndexedRows
+           + ( m_size - m_indexedSize + rowLength - 1 ) / rowLength;
+}
+
+uint64_t TextPreview::get_row_offset( uint64_t idxRow ) const
+{
+    uint64_t checkpoint    = 0;
+    uint64_t nbIndexedRows = 0;
+    uint64_t indexedSize   = 0;
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        nbIndexedRows = m_nbIndexedRows;
+        indexedSize   = m_indexedSize;
+        if ( idxRow <= nbIndexedRows )
+        {
+            checkpoint = m_checkpoints[idxRow / ROWS_PER_CHECKPOINT];
+        }
+    }
+
+    if ( idxRow <= nbIndexedRows )
+    {
+        // At most ROWS_PER_CHECKPOINT rows are read
+        return this->skip_rows( checkpoint, idxRow % ROWS_PER_CHECKPOINT );
+    }
+
+    uint64_t rowLength =
+        nbIndexedRows > 0 ? indexedSize / nbIndexedRows : DEFAULT_LINE_LENGTH;
+    uint64_t offset = std::min(
+        m_size - 1, indexedSize + ( idxRow - nbIndexedRows ) * rowLength );
+
+    // Aligned on the start of the line containing the estimated offset
+    uint64_t         min  = offset > MAX_LINE_LENGTH ? offset - MAX_LINE_LENGTH
+                                                     : 0;
+    std::string_view data = this->read( min, offset - min, m_buffer );
+    auto const *     newline = static_cast< char const * >(
+        memrchr( data.data(), '\n', data.size() ) );
+    if ( newline )
+    {
+        return min + static_cast< uint64_t >( newline - data.data() ) + 1;
+    }
+    return min == 0 ? 0 : offset;
+}
+
+uint64_t TextPreview::find_last_rows( uint64_t nbRows ) const
+{
+    uint64_t offset = m_size;
+    for ( uint64_t idx = 0; idx < nbRows && offset > 0; ++idx )
+    {
+        // Skip the newline ending the previous row
+        uint64_t         end  = offset - 1;
+        uint64_t         min  = end > MAX_LINE_LENGTH ? end - MAX_LINE_LENGTH
+                                                      : 0;
+        std::string_view data = this->read( min, end - min, m_buffer );
+        auto const *     newline = static_cast< char const * >(
+            memrchr( data.data(), '\n', data.size() ) );
+        offset = min;
+        if ( newline )
+        {
+            offset += static_cast< uint64_t >( newline - data.data() ) + 1;
+        }
+    }
+    return offset;
+}
+
+uint64_t TextPreview::skip_rows( uint64_t offset, uint64_t nbRows ) const
+{
+    while ( nbRows > 0 )
+    {
+        std::string_view data      = this->read( offset, READ_SIZE, m_buffer );
+        bool             isFileEnd = data.size() < READ_SIZE;
+        while ( nbRows > 0 )
+        {
+            uint64_t length = get_row_length( data, isFileEnd );
+            if ( length == 0 )
+            {
+                break;
+            }
+            data.remove_prefix( length );
+            offset += length;
+            --nbRows;
+        }
+        if ( isFileEnd )
+        {
+            break;
+        }
+    }
+    return offset;
+}
+
+std::string_view TextPreview::read( uint64_t offset, uint64_t length,
+                                    std::vector< char > & buffer ) const
+{
+    buffer.resize( length );
+    // Reads up to the end of the file, nothing on error
+    ssize_t     nbRead = m_file->read_at( buffer.data(), length, offset );
+    std::size_t size   = nbRead > 0 ? static_cast< std::size_t >( nbRead ) : 0;
+    return std::string_view { buffer.data(), size };
+}
+
+void TextPreview::index( std::stop_token stopToken )
+{
+    // The UI thread reads the same file, it must stay the fastest
+    JobScheduler::set_thread_class( JobScheduler::JobClass::Prefetch );
+
+    // Reused for each chunk, so the memory used doesn't grow with the file
+    std::vector< char > buffer {};
+    uint64_t            nbRows    = 0;
+    uint64_t            offset    = 0;
+    bool                isFileEnd = false;
+    while ( ! isFileEnd && ! stopToken.stop_requested() )
+    {
+        uint64_t chunkSize = std::min( m_size - offset, INDEX_CHUNK_SIZE );
+        std::string_view data = this->read( offset, chunkSize, buffer );
+        // Shorter if the file has been truncated meanwhile
+        isFileEnd = offset + chunkSize >= m_size || data.size() < chunkSize;
+
+        std::vector< uint64_t > checkpoints {};
+        uint64_t                position = 0;
+        while ( position < data.size() )
+        {
+            uint64_t untilCheckpoint =
+                ROWS_PER_CHECKPOINT - nbRows % ROWS_PER_CHECKPOINT;
+            std::string_view rest { data.substr( position ) };
+            // The rows until the checkpoint are counted at once when they
+            // hold in MAX_LINE_LENGTH, none of them can be cut then
+            newlines::Match match = newlines::find_nth(
+                rest.data(),
+                std::min< uint64_t >( rest.size(), MAX_LINE_LENGTH + 1 ),
+                untilCheckpoint );
+            if ( match.count == untilCheckpoint )
+            {
+                position += match.position + 1;
+                nbRows   += untilCheckpoint;
+            }
+            else
+            {
+                uint64_t length = get_row_length( rest, isFileEnd );
+                if ( length == 0 )
+                {
+                    // Indexed with the next chunk
+                    break;
+                }
+                position += length;
+                ++nbRows;
+            }
+            if ( nbRows % ROWS_PER_CHECKPOINT == 0 )
+            {
+                checkpoints.push_back( offset + position );
+            }
+        }
+        offset += position;
+
+        std::lock_guard< std::mutex > lock { m_mutex };
+        m_checkpoints.insert( m_checkpoints.end(), checkpoints.begin(),
+                              checkpoints.end() );
+        m_nbIndexedRows = nbRows;
+        m_indexedSize   = offset;
+    }
+    m_isIndexed = isFileEnd;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>       // for atomic
+#include <cstdint>      // for uint64_t
+#include <memory>       // for unique_ptr
+#include <mutex>        // for mutex
+#include <stop_token>   // for stop_token
+#include <string_view>  // for string_view
+#include <thread>       // for jthread
+#include <vector>       // for vector
+
+#include "app/filesystem.hpp"  // for fs::path
+#include "app/vfs.hpp"         // for vfs::File
+
+// Read only view of a text file of any size. Only the showed rows are read,
+// and the rows are indexed in background; until the index reaches the showed
+// rows, their position is estimated from the average row length. The file is
+// read at an offset through the file system rather than mapped, so every
+// backend can be previewed, and a file truncated meanwhile, like a rotated
+// log, gives shorter reads instead of a SIGBUS. The lines longer than
+// MAX_LINE_LENGTH are cut in several rows, both when shown and when indexed.
+class TextPreview
+{
+    fs::path                     m_path;
+    // Read by the UI thread and the indexer at the same time
+    std::unique_ptr< vfs::File > m_file;
+    // When opened, the end of a file growing meanwhile isn't showed
+    uint64_t                     m_size;
+
+    // Bytes of the showed rows, only used by the UI thread
+    mutable std::vector< char > m_buffer;
+
+    mutable std::mutex      m_mutex;
+    // Start of every ROWS_PER_CHECKPOINT rows, the first one being 0
+    std::vector< uint64_t > m_checkpoints;
+    uint64_t                m_nbIndexedRows;
+    // Start of the first row not indexed
+    uint64_t                m_indexedSize;
+    std::atomic< bool >     m_isIndexed;
+
+    // Started last, once every other member is initialized
+    std::jthread m_indexer;
+
+  public:
+    explicit TextPreview( fs::path const & path );
+    virtual ~TextPreview();
+
+    TextPreview( TextPreview const & )              = delete;
+    TextPreview & operator= ( TextPreview const & ) = delete;
+
+    void update_gui ();
+
+    fs::path const & get_path () const;
+    bool             is_open () const;
+    // Exact once the file is indexed, estimated until then
+    uint64_t         get_nb_rows () const;
+    // Start of the row, estimated and aligned on the closest line start if
+    // it isn't indexed yet
+    uint64_t         get_row_offset ( uint64_t idxRow ) const;
+
+  private:
+    // Start of the rows at the end of the file, found backwards
+    uint64_t         find_last_rows ( uint64_t nbRows ) const;
+    // Start of the row nbRows rows after the one starting at the offset
+    uint64_t         skip_rows ( uint64_t offset, uint64_t nbRows ) const;
+    // Shorter than the length at the end of the file
+    std::string_view read ( uint64_t offset, uint64_t length,
+                            std::vector< char > & buffer ) const;
+
+    void index ( std::stop_token stopToken );
+};
@@ -0,0 +1,237 @@
+#include "texture_atlas.hpp"
+
+#include <algorithm>  // for min_element
+
+#include <glad/glad.h>
+//
+#include <imgui/imgui.h>  // for ImGui::Text
+// The copy built by imgui is static to imgui_draw.cpp
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imgui/imstb_rectpack.h>
+
+namespace
+{
+    constexpr int PAGE_SIZE { 2048 };
+    // 128 MiB of textures at most
+    constexpr std::size_t MAX_PAGES { 8 };
+    // Empty pixels between the images, so they don't bleed on each other
+    // when drawn at a non integer position
+    constexpr int PADDING { 1 };
+
+    ImTextureID to_texture_id ( unsigned int texture )
+    {
+        return reinterpret_cast< ImTextureID >(
+            static_cast< intptr_t >( texture ) );
+    }
+}  // namespace
+
+TextureAtlas::TextureAtlas()
+  : m_pages {},
+    m_nbAllocated { 0 },
+    m_nbEvictedPages { 0 },
+    m_isHeadless { false }
+{
+    // The packers point to themselves, the pages must never move
+    m_pages.reserve( MAX_PAGES );
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    this->release();
+}
+
+std::optional< TextureAtlas::Allocation > TextureAtlas::insert(
+    ds::Image const & image )
+{
+    int width  = static_cast< int >( image.width );
+    int height = static_cast< int >( image.height );
+    if ( width + PADDING > PAGE_SIZE || height + PADDING > PAGE_SIZE )
+    {
+        return std::nullopt;
+    }
+
+    std::optional< Allocation > allocation {};
+    for ( std::size_t idxPage = 0;
+          idxPage < m_pages.size() && ! allocation.has_value(); ++idxPage )
+    {
+        allocation = this->pack( idxPage, width, height );
+    }
+    if ( ! allocation.has_value() && m_pages.size() < MAX_PAGES )
+    {
+        this->add_page();
+        allocation = this->pack( m_pages.size() - 1, width, height );
+    }
+    if ( ! allocation.has_value() && ! m_pages.empty() )
+    {
+        // The images of the current frame must stay
+        int  frame       = ImGui::GetFrameCount();
+        auto leastRecent = std::min_element(
+            m_pages.begin(), m_pages.end(),
+            [] ( Page const & lhs, Page const & rhs ) {
+                return lhs.lastUse < rhs.lastUse;
+            } );
+        if ( leastRecent->lastUse != frame )
+        {
+            this->reset_page( *leastRecent );
+            ++m_nbEvictedPages;
+            allocation =
+                this->pack( static_cast< std::size_t >(
+                                leastRecent - m_pages.begin() ),
+                            width, height );
+        }
+    }
+    if ( ! allocation.has_value() )
+    {
+        return std::nullopt;
+    }
+
+    Page & page = m_pages[allocation->idxPage];
+    if ( ! m_isHeadless )
+    {
+        glBindTexture( GL_TEXTURE_2D, page.texture );
+        glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+        glTexSubImage2D( GL_TEXTURE_2D, 0, allocation->x, allocation->y,
+                         width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                         image.pixels.data() );
+        glBindTexture( GL_TEXTURE_2D, 0 );
+    }
+
+    page.lastUse = ImGui::GetFrameCount();
+    ++page.nbImages;
+    page.usedArea += static_cast< std::size_t >( width * height );
+    ++m_nbAllocated;
+    return allocation;
+}
+
+std::optional< TextureAtlas::Region > TextureAtlas::get(
+    Allocation const & allocation )
+{
+    if ( ! this->is_valid( allocation ) )
+    {
+        return std::nullopt;
+    }
+
+    Page & page  = m_pages[allocation.idxPage];
+    page.lastUse = ImGui::GetFrameCount();
+
+    float pageSize = static_cast< float >( PAGE_SIZE );
+    return Region {
+        to_texture_id( page.texture ),
+        ImVec2 { static_cast< float >( allocation.x ) / pageSize,
+                 static_cast< float >( allocation.y ) / pageSize },
+        ImVec2 {
+            static_cast< float >( allocation.x + allocation.width ) / pageSize,
+            static_cast< float >( allocation.y + allocation.height )
+                / pageSize },
+        ImVec2 { static_cast< float >( allocation.width ),
+                 static_cast< float >( allocation.height ) } };
+}
+
+bool TextureAtlas::is_valid( Allocation const & allocation ) const
+{
+    return allocation.idxPage < m_pages.size()
+           && m_pages[allocation.idxPage].generation == allocation.generation;
+}
+
+void TextureAtlas::release()
+{
+    if ( ! m_isHeadless )
+    {
+        for ( Page const & page : m_pages )
+        {
+            glDeleteTextures( 1, &page.texture );
+        }
+    }
+    m_pages.clear();
+}
+
+void TextureAtlas::set_headless()
+{
+    this->release();
+    m_isHeadless = true;
+}
+
+void TextureAtlas::debug_gui() const
+{
+    ImGui::Text( "Texture atlas" );
+    ImGui::Text( "Pages: %lu / %lu (%dx%d)", m_pages.size(), MAX_PAGES,
+                 PAGE_SIZE, PAGE_SIZE );
+    for ( std::size_t idxPage = 0; idxPage < m_pages.size(); ++idxPage )
+    {
+        Page const & page = m_pages[idxPage];
+        ImGui::Text( "  Page %lu: %lu images, %.1f%% used", idxPage,
+                     page.nbImages,
+                     100.f * static_cast< float >( page.usedArea )
+                         / static_cast< float >( PAGE_SIZE * PAGE_SIZE ) );
+    }
+    ImGui::Text( "Allocated: %lu (%lu pages evicted)", m_nbAllocated,
+                 m_nbEvictedPages );
+
+    // Each command is a draw call of the renderer
+    ImDrawData const * drawData = ImGui::GetDrawData();
+    if ( drawData )
+    {
+        int nbDrawCalls = 0;
+        for ( int idx = 0; idx < drawData->CmdListsCount; ++idx )
+        {
+            nbDrawCalls += drawData->CmdLists[idx]->CmdBuffer.Size;
+        }
+        ImGui::Text( "Draw calls (last frame): %d", nbDrawCalls );
+    }
+}
+
+std::optional< TextureAtlas::Allocation > TextureAtlas::pack(
+    std::size_t idxPage, int width, int height )
+{
+    Page &     page = m_pages[idxPage];
+    stbrp_rect rect {};
+    rect.w = width + PADDING;
+    rect.h = height + PADDING;
+    if ( ! stbrp_pack_rects( &page.packer, &rect, 1 ) )
+    {
+        return std::nullopt;
+    }
+    return Allocation { idxPage, page.generation, rect.x, rect.y, width,
+                        height };
+}
+
+void TextureAtlas::add_page()
+{
+    Page & page = m_pages.emplace_back();
+    if ( m_isHeadless )
+    {
+        // Never 0, which is the font texture
+        page.texture = static_cast< unsigned int >( m_pages.size() );
+    }
+    else
+    {
+        glGenTextures( 1, &page.texture );
+        glBindTexture( GL_TEXTURE_2D, page.texture );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+        glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, PAGE_SIZE, PAGE_SIZE, 0,
+                      GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+        glBindTexture( GL_TEXTURE_2D, 0 );
+    }
+
+    page.generation = 0;
+    page.nodes.resize( PAGE_SIZE );
+    this->reset_page( page );
+}
+
+void TextureAtlas::reset_page( Page & page )
+{
+    ++page.generation;
+    page.lastUse  = ImGui::GetFrameCount();
+    page.nbImages = 0;
+    page.usedArea = 0;
+    stbrp_init_target( &page.packer, PAGE_SIZE, PAGE_SIZE, page.nodes.data(),
+                       static_cast< int >( page.nodes.size() ) );
+    // The padding must stay transparent
+    if ( ! m_isHeadless )
+    {
+        glClearTexImage( page.texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>   // for uint64_t
+#include <optional>  // for optional
+#include <vector>    // for vector
+
+#include <imgui/imgui.h>           // for ImTextureID, ImVec2
+#include <imgui/imstb_rectpack.h>  // for stbrp_context, stbrp_node
+
+#include "app/thumbnail.hpp"  // for ds::Image
+#include "tools/singleton.hpp"
+
+// Small images packed in a few large textures, so showing many of them only
+// needs a draw call for each page instead of one for each image. When every
+// page is full, the least recently used one is emptied.
+class TextureAtlas : public Singleton< TextureAtlas >
+{
+    ENABLE_SINGLETON( TextureAtlas );
+
+  public:
+    // Place of an image in the atlas, valid until its page is evicted
+    struct Allocation
+    {
+        std::size_t idxPage;
+        uint64_t    generation;
+        int         x;
+        int         y;
+        int         width;
+        int         height;
+    };
+
+    // What's needed to draw an allocated image
+    struct Region
+    {
+        ImTextureID texture;
+        ImVec2      uvMin;
+        ImVec2      uvMax;
+        ImVec2      size;
+    };
+
+  private:
+    struct Page
+    {
+        unsigned int              texture;
+        // Incremented when the page is emptied, to invalidate its allocations
+        uint64_t                  generation;
+        int                       lastUse;
+        std::size_t               nbImages;
+        std::size_t               usedArea;
+        stbrp_context             packer;
+        std::vector< stbrp_node > nodes;
+    };
+
+    std::vector< Page > m_pages;
+
+    uint64_t m_nbAllocated;
+    uint64_t m_nbEvictedPages;
+    // Without OpenGL context, the images are only packed
+    bool     m_isHeadless;
+
+    TextureAtlas();
+    virtual ~TextureAtlas();
+
+  public:
+    // Upload the image in a page with enough space, nullopt if every page is
+    // full and used by the current frame
+    std::optional< Allocation > insert ( ds::Image const & image );
+    // nullopt if the page of the allocation has been evicted since. Mark the
+    // page as used by the current frame.
+    std::optional< Region >     get ( Allocation const & allocation );
+    bool is_valid ( Allocation const & allocation ) const;
+
+    // Must be called while the OpenGL context is still alive
+    void release ();
+    // For a window without OpenGL context. Each page still has its own
+    // texture id, so the draw calls are split as with real textures.
+    void set_headless ();
+
+    void debug_gui () const;
+
+  private:
+    std::optional< Allocation > pack ( std::size_t idxPage, int width,
+                                       int height );
+    void                        add_page ();
+    void                        reset_page ( Page & page );
+};
@@ -0,0 +1,576 @@
+#include "thumbnail.hpp"
+
+#include <algorithm>      // for max, fill, copy
+#include <cctype>         // for isalnum
+#include <csetjmp>        // for setjmp, longjmp
+#include <cstdio>         // for FILE, fopen, fclose, rename
+#include <cstdlib>        // for getenv, mkstemp
+#include <memory>         // for unique_ptr
+#include <string_view>    // for string_view
+#include <unordered_map>  // for unordered_map
+
+#include <sys/stat.h>  // for stat
+#include <unistd.h>    // for close, unlink
+
+#include <fmt/format.h>  // for format
+// jpeglib.h needs FILE and size_t to be declared first
+#include <jpeglib.h>
+#include <png.h>
+
+#include "app/image_header.hpp"  // for read_image_header
+#include "tools/md5.hpp"         // for md5::hex_digest
+
+namespace ds
+{
+    namespace
+    {
+        using Texts = std::unordered_map< std::string, std::string >;
+
+        // Larger images aren't thumbnailed, checked from their header before
+        // decoding them
+        constexpr uint64_t MAX_PIXELS { 200'000'000 };
+        // The interlaced PNG are decoded at full size, 64 MB in RGBA
+        constexpr uint64_t MAX_INTERLACED_PIXELS { 16'000'000 };
+
+        // Box filter fed one source row at a time, so the full size image is
+        // never in memory
+        class RowDownscaler
+        {
+            uint32_t m_sourceWidth;
+            uint32_t m_sourceHeight;
+            Image    m_image;
+
+            std::vector< uint64_t > m_sums;
+            std::vector< uint64_t > m_counts;
+            uint32_t                m_idxSourceRow;
+            uint32_t                m_idxRow;
+
+          public:
+            RowDownscaler( uint32_t sourceWidth, uint32_t sourceHeight,
+                           uint32_t maxSize )
+              : m_sourceWidth { sourceWidth },
+                m_sourceHeight { sourceHeight },
+                m_image {},
+                m_sums {},
+                m_counts {},
+                m_idxSourceRow { 0 },
+                m_idxRow { 0 }
+            {
+                uint32_t largestSide = std::max( sourceWidth, sourceHeight );
+                m_image.width        = sourceWidth;
+                m_image.height       = sourceHeight;
+                if ( largestSide > maxSize )
+                {
+                    m_image.width = std::max< uint32_t >(
+                        1, uint64_t { sourceWidth } * maxSize / largestSide );
+                    m_image.height = std::max< uint32_t >(
+                        1, uint64_t { sourceHeight } * maxSize / largestSide );
+                }
+                m_image.pixels.resize( std::size_t { m_image.width }
+                                       * m_image.height * 4 );
+                m_sums.resize( std::size_t { m_image.width } * 4 );
+                m_counts.resize( m_image.width );
+            }
+
+            void add_row ( unsigned char const * rgba )
+            {
+                if ( m_idxSourceRow >= m_sourceHeight )
+                {
+                    return;
+                }
+                uint32_t idxRow = static_cast< uint32_t >(
+                    uint64_t { m_idxSourceRow } * m_image.height
+                    / m_sourceHeight );
+                if ( idxRow != m_idxRow )
+                {
+                    this->flush();
+                    m_idxRow = idxRow;
+                }
+
+                for ( uint32_t x = 0; x < m_sourceWidth; ++x )
+                {
+                    std::size_t idxColumn =
+                        uint64_t { x } * m_image.width / m_sourceWidth;
+                    for ( std::size_t channel = 0; channel < 4; ++channel )
+                    {
+                        m_sums[idxColumn * 4 + channel] +=
+                            rgba[std::size_t { x } * 4 + channel];
+                    }
+                    ++m_counts[idxColumn];
+                }
+                ++m_idxSourceRow;
+            }
+
+            bool is_complete () const
+            {
+                return m_idxSourceRow == m_sourceHeight;
+            }
+
+            Image get_image ()
+            {
+                this->flush();
+                return std::move( m_image );
+            }
+
+          private:
+            void flush ()
+            {
+                unsigned char * row = m_image.pixels.data()
+                                      + std::size_t { m_idxRow }
+                                            * m_image.width * 4;
+                for ( std::size_t idx = 0; idx < m_sums.size(); ++idx )
+                {
+                    uint64_t count = m_counts[idx / 4];
+                    if ( count > 0 )
+                    {
+                        row[idx] = static_cast< unsigned char >(
+                            m_sums[idx] / count );
+                    }
+                }
+                std::fill( m_sums.begin(), m_sums.end(), 0 );
+                std::fill( m_counts.begin(), m_counts.end(), 0 );
+            }
+        };
+
+        struct FileCloser
+        {
+            void operator() ( FILE * file ) const { std::fclose( file ); }
+        };
+        using File = std::unique_ptr< FILE, FileCloser >;
+
+        // libpng and libjpeg report errors with a longjmp to the decoding
+        // function, only C objects and objects created before the setjmp
+        // are used in between
+
+        void on_png_error ( png_structp png, png_const_charp /* message */ )
+        {
+            png_longjmp( png, 1 );
+        }
+
+        void on_png_warning ( png_structp /* png */,
+                              png_const_charp /* message */ )
+        {}
+
+        bool decode_png ( FILE * file, uint32_t maxSize,
+                          std::optional< RowDownscaler > & downscaler,
+                          std::vector< unsigned char > & pixels,
+                          Texts * texts )
+        {
+            png_structp png = png_create_read_struct(
+                PNG_LIBPNG_VER_STRING, nullptr, on_png_error, on_png_warning );
+            png_infop info = png ? png_create_info_struct( png ) : nullptr;
+            if ( ! info )
+            {
+                png_destroy_read_struct( &png, nullptr, nullptr );
+                return false;
+            }
+            if ( setjmp( png_jmpbuf( png ) ) )
+            {
+                png_destroy_read_struct( &png, &info, nullptr );
+                return false;
+            }
+
+            png_init_io( png, file );
+            png_read_info( png, info );
+
+            // Always decoded to 8 bits RGBA
+            png_set_expand( png );
+            png_set_strip_16( png );
+            png_set_gray_to_rgb( png );
+            png_set_add_alpha( png, 0xFF, PNG_FILLER_AFTER );
+            int nbPasses = png_set_interlace_handling( png );
+            png_read_update_info( png, info );
+
+            uint32_t width  = png_get_image_width( png, info );
+            uint32_t height = png_get_image_height( png, info );
+            if ( uint64_t { width } * height
+                 > ( nbPasses == 1 ? MAX_PIXELS : MAX_INTERLACED_PIXELS ) )
+            {
+                png_destroy_read_struct( &png, &info, nullptr );
+                return false;
+            }
+            downscaler.emplace( width, height, maxSize );
+
+            std::size_t rowSize = png_get_rowbytes( png, info );
+            if ( nbPasses == 1 )
+            {
+                pixels.resize( rowSize );
+                for ( uint32_t y = 0; y < height; ++y )
+                {
+                    png_read_row( png, pixels.data(), nullptr );
+                    downscaler->add_row( pixels.data() );
+                }
+            }
+            else
+            {
+                // Every pass goes over the whole image, so it's decoded at
+                // full size first
+                pixels.resize( rowSize * height );
+                for ( int pass = 0; pass < nbPasses; ++pass )
+                {
+                    for ( uint32_t y = 0; y < height; ++y )
+                    {
+                        png_read_row( png, pixels.data() + rowSize * y,
+                                      nullptr );
+                    }
+                }
+                for ( uint32_t y = 0; y < height; ++y )
+                {
+                    downscaler->add_row( pixels.data() + rowSize * y );
+                }
+            }
+            png_read_end( png, info );
+
+            if ( texts )
+            {
+                png_textp textChunks = nullptr;
+                int nbTexts = png_get_text( png, info, &textChunks, nullptr );
+                for ( int idx = 0; idx < nbTexts; ++idx )
+                {
+                    ( *texts )[textChunks[idx].key] = textChunks[idx].text;
+                }
+            }
+
+            png_destroy_read_struct( &png, &info, nullptr );
+            return true;
+        }
+
+        std::optional< Image > read_png ( fs::path const & path,
+                                          uint32_t maxSize, Texts * texts )
+        {
+            File file { std::fopen( path.c_str(), "rbe" ) };
+            if ( ! file )
+            {
+                return std::nullopt;
+            }
+            std::optional< RowDownscaler > downscaler {};
+            std::vector< unsigned char >   pixels {};
+            if ( ! decode_png( file.get(), maxSize, downscaler, pixels, texts )
+                 || ! downscaler->is_complete() )
+            {
+                return std::nullopt;
+            }
+            return downscaler->get_image();
+        }
+
+        struct JpegError
+        {
+            jpeg_error_mgr manager;
+            std::jmp_buf   jump;
+        };
+
+        void on_jpeg_error ( j_common_ptr info )
+        {
+            std::longjmp( reinterpret_cast< JpegError * >( info->err )->jump,
+                          1 );
+        }
+
+        void on_jpeg_message ( j_common_ptr /* info */ ) {}
+
+        bool decode_jpeg ( FILE * file, uint32_t maxSize,
+                           std::optional< RowDownscaler > & downscaler,
+                           std::vector< unsigned char > &   pixels )
+        {
+            jpeg_decompress_struct info {};
+            JpegError              error {};
+            info.err                     = jpeg_std_error( &error.manager );
+            error.manager.error_exit     = on_jpeg_error;
+            error.manager.output_message = on_jpeg_message;
+            if ( setjmp( error.jump ) )
+            {
+                jpeg_destroy_decompress( &info );
+                return false;
+            }
+
+            jpeg_create_decompress( &info );
+            jpeg_stdio_src( &info, file );
+            jpeg_read_header( &info, TRUE );
+
+            // The largest reduction done by the decoder that keeps the image
+            // larger than the thumbnail, the rest is done by the box filter
+            info.scale_num   = 1;
+            info.scale_denom = 1;
+            uint32_t largestSide =
+                std::max( info.image_width, info.image_height );
+            for ( unsigned int denominator : { 8u, 4u, 2u } )
+            {
+                if ( largestSide / denominator >= maxSize )
+                {
+                    info.scale_denom = denominator;
+                    break;
+                }
+            }
+            // Quality doesn't matter much once downscaled
+            info.dct_method          = JDCT_IFAST;
+            info.do_fancy_upsampling = FALSE;
+            bool isCmyk              = info.jpeg_color_space == JCS_CMYK
+                          || info.jpeg_color_space == JCS_YCCK;
+            info.out_color_space = isCmyk ? JCS_CMYK : JCS_RGB;
+
+            jpeg_start_decompress( &info );
+            downscaler.emplace( info.output_width, info.output_height,
+                                maxSize );
+
+            std::size_t nbComponents = isCmyk ? 4 : 3;
+            // The decoded row, then the same row in RGBA
+            pixels.resize( std::size_t { info.output_width }
+                           * ( nbComponents + 4 ) );
+            unsigned char * decoded = pixels.data();
+            unsigned char * rgba    = pixels.data()
+                                   + std::size_t { info.output_width }
+                                         * nbComponents;
+            while ( info.output_scanline < info.output_height )
+            {
+                jpeg_read_scanlines( &info, &decoded, 1 );
+                for ( std::size_t x = 0; x < info.output_width; ++x )
+                {
+                    unsigned char const * pixel = decoded + x * nbComponents;
+                    if ( isCmyk )
+                    {
+                        // Adobe writes the CMYK values inverted
+                        for ( std::size_t channel = 0; channel < 3; ++channel )
+                        {
+                            rgba[x * 4 + channel] =
+                                static_cast< unsigned char >(
+                                    pixel[channel] * pixel[3] / 255 );
+                        }
+                    }
+                    else
+                    {
+                        std::copy( pixel, pixel + 3, rgba + x * 4 );
+                    }
+                    rgba[x * 4 + 3] = 0xFF;
+                }
+                downscaler->add_row( rgba );
+            }
+
+            jpeg_finish_decompress( &info );
+            jpeg_destroy_decompress( &info );
+            return true;
+        }
+
+        std::optional< Image > read_jpeg ( fs::path const & path,
+                                           uint32_t         maxSize )
+        {
+            File file { std::fopen( path.c_str(), "rbe" ) };
+            if ( ! file )
+            {
+                return std::nullopt;
+            }
+            std::optional< RowDownscaler > downscaler {};
+            std::vector< unsigned char >   pixels {};
+            if ( ! decode_jpeg( file.get(), maxSize, downscaler, pixels )
+                 || ! downscaler->is_complete() )
+            {
+                return std::nullopt;
+            }
+            return downscaler->get_image();
+        }
+
+        bool encode_png ( FILE * file, Image const & image,
+                          std::vector< png_text > & textChunks )
+        {
+            png_structp png = png_create_write_struct(
+                PNG_LIBPNG_VER_STRING, nullptr, on_png_error, on_png_warning );
+            png_infop info = png ? png_create_info_struct( png ) : nullptr;
+            if ( ! info )
+            {
+                png_destroy_write_struct( &png, nullptr );
+                return false;
+            }
+            if ( setjmp( png_jmpbuf( png ) ) )
+            {
+                png_destroy_write_struct( &png, &info );
+                return false;
+            }
+
+            png_init_io( png, file );
+            png_set_IHDR( png, info, image.width, image.height, 8,
+                          PNG_COLOR_TYPE_RGBA, PNG_INTERLACE_NONE,
+                          PNG_COMPRESSION_TYPE_DEFAULT,
+                          PNG_FILTER_TYPE_DEFAULT );
+            png_set_text( png, info, textChunks.data(),
+                          static_cast< int >( textChunks.size() ) );
+            png_write_info( png, info );
+            for ( uint32_t y = 0; y < image.height; ++y )
+            {
+                png_write_row( png, image.pixels.data()
+                                        + std::size_t { y } * image.width * 4 );
+            }
+            png_write_end( png, info );
+
+            png_destroy_write_struct( &png, &info );
+            return true;
+        }
+
+        // Written in a temporary file renamed once complete, so other
+        // applications never read a partial thumbnail
+        bool write_png ( fs::path const & path, Image const & image,
+                         Texts const & texts )
+        {
+            std::vector< png_text > textChunks {};
+            for ( auto const & [key, text] : texts )
+            {
+                png_text chunk {};
+                chunk.compression = PNG_TEXT_COMPRESSION_NONE;
+                chunk.key         = const_cast< char * >( key.c_str() );
+                chunk.text        = const_cast< char * >( text.c_str() );
+                chunk.text_length = text.size();
+                textChunks.push_back( chunk );
+            }
+
+            std::string temporaryPath =
+                fmt::format( "{}.XXXXXX", path.string() );
+            // Created with 0600 permissions, as required by the specification
+            int descriptor = mkstemp( temporaryPath.data() );
+            if ( descriptor < 0 )
+            {
+                return false;
+            }
+            File file { fdopen( descriptor, "wb" ) };
+            if ( ! file )
+            {
+                close( descriptor );
+                unlink( temporaryPath.c_str() );
+                return false;
+            }
+
+            bool isWritten = encode_png( file.get(), image, textChunks );
+            isWritten      = std::fclose( file.release() ) == 0 && isWritten;
+            if ( ! isWritten
+                 || std::rename( temporaryPath.c_str(), path.c_str() ) != 0 )
+            {
+                unlink( temporaryPath.c_str() );
+                return false;
+            }
+            return true;
+        }
+
+        fs::path get_cache_directory ()
+        {
+            // Relative paths must be ignored
+            char const * cacheHome = std::getenv( "XDG_CACHE_HOME" );
+            fs::path     directory { cacheHome ? cacheHome : "" };
+            if ( ! directory.is_absolute() )
+            {
+                directory = get_home_directory() / ".cache";
+            }
+            return directory / "thumbnails" / "normal";
+        }
+
+        bool is_up_to_date ( Texts const & texts, std::string const & uri,
+                             struct stat const & status )
+        {
+            auto text = texts.find( "Thumb::URI" );
+            if ( text == texts.end() || text->second != uri )
+            {
+                return false;
+            }
+            text = texts.find( "Thumb::MTime" );
+            if ( text == texts.end()
+                 || text->second != std::to_string( status.st_mtim.tv_sec ) )
+            {
+                return false;
+            }
+            // Optional, but checked when it's present
+            text = texts.find( "Thumb::Size" );
+            return text == texts.end()
+                   || text->second == std::to_string( status.st_size );
+        }
+    }  // namespace
+
+    std::string get_uri ( fs::path const & path )
+    {
+        // Escaped like GLib does, so the thumbnails are shared with the other
+        // applications
+        constexpr std::string_view ALLOWED { "-._~!$&'()*+,;=:@/" };
+
+        std::string uri { "file://" };
+        for ( unsigned char character : fs::absolute( path ).string() )
+        {
+            if ( std::isalnum( character )
+                 || ALLOWED.find( static_cast< char >( character ) )
+                        != std::string_view::npos )
+            {
+                uri += static_cast< char >( character );
+            }
+            else
+            {
+                uri += fmt::format( "%{:02X}", character );
+            }
+        }
+        return uri;
+    }
+
+    fs::path get_thumbnail_path ( fs::path const & path )
+    {
+        return get_cache_directory()
+               / fmt::format( "{}.png", md5::hex_digest( get_uri( path ) ) );
+    }
+
+    std::optional< Image > make_thumbnail ( fs::path const & path )
+    {
+        struct stat status {};
+        if ( ::stat( path.c_str(), &status ) != 0 )
+        {
+            return std::nullopt;
+        }
+
+        // The thumbnails themselves are never thumbnailed
+        fs::path cacheDirectory = get_cache_directory();
+        bool     isCacheable    = path.parent_path() != cacheDirectory;
+
+        std::string uri           = get_uri( path );
+        fs::path    thumbnailPath = get_thumbnail_path( path );
+        if ( isCacheable )
+        {
+            Texts                  texts {};
+            std::optional< Image > cached =
+                read_png( thumbnailPath, THUMBNAIL_SIZE, &texts );
+            if ( cached.has_value() && is_up_to_date( texts, uri, status ) )
+            {
+                return cached;
+            }
+        }
+
+        std::optional< ImageHeader > header = read_image_header( path );
+        if ( ! header.has_value()
+             || uint64_t { header->width } * header->height > MAX_PIXELS )
+        {
+            return std::nullopt;
+        }
+        std::optional< Image > image {};
+        switch ( header->format )
+        {
+        case ImageFormat::PNG :
+            image = read_png( path, THUMBNAIL_SIZE, nullptr );
+            break;
+        case ImageFormat::JPEG :
+            image = read_jpeg( path, THUMBNAIL_SIZE );
+            break;
+        default :
+            break;
+        }
+
+        // The small images are as fast to decode as their thumbnail
+        if ( image.has_value() && isCacheable
+             && std::max( header->width, header->height ) > THUMBNAIL_SIZE )
+        {
+            std::error_code error {};
+            fs::create_directories( cacheDirectory, error );
+            fs::permissions( cacheDirectory, fs::perms::owner_all, error );
+            write_png( thumbnailPath, image.value(),
+                       Texts {
+                           { "Thumb::URI", uri },
+                           { "Thumb::MTime",
+                             std::to_string( status.st_mtim.tv_sec ) },
+                           { "Thumb::Size", std::to_string( status.st_size ) },
+                           { "Thumb::Image::Width",
+                             std::to_string( header->width ) },
+                           { "Thumb::Image::Height",
+                             std::to_string( header->height ) },
+                           { "Software", "File Explorer" } } );
+        }
+        return image;
+    }
+}  // namespace ds
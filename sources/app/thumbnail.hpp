@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>   // for uint32_t
+#include <optional>  // for optional
+#include <string>    // for string
+#include <vector>    // for vector
+
+#include "app/filesystem.hpp"  // for fs::path
+
+namespace ds
+{
+    // Largest side of the thumbnails, the "normal" size of the freedesktop
+    // thumbnail cache
+    constexpr uint32_t THUMBNAIL_SIZE { 128 };
+
+    struct Image
+    {
+        uint32_t                     width;
+        uint32_t                     height;
+        // RGBA, 8 bits per channel, row after row
+        std::vector< unsigned char > pixels;
+    };
+
+    // URI of the file as written in the freedesktop thumbnails
+    std::string get_uri ( fs::path const & path );
+    // Where the thumbnail of the file is stored in the freedesktop cache
+    fs::path    get_thumbnail_path ( fs::path const & path );
+
+    // Read the thumbnail from the freedesktop cache if it's up to date.
+    // Otherwise decode the image, downscaling it while decoding, and store
+    // the result in the cache. nullopt if the image can't be decoded.
+    std::optional< Image > make_thumbnail ( fs::path const & path );
+}  // namespace ds
@@ -0,0 +1,127 @@
+#include "thumbnails.hpp"
+
+#include <imgui/imgui.h>  // for ImGui::Text
+
+namespace
+{
+    // Images queued or being decoded at the same time
+    constexpr std::size_t MAX_OUTSTANDING_DECODES { 64 };
+    // Decoded thumbnails kept in memory to be uploaded again
+    constexpr std::size_t MAX_DECODED { 256 };
+    // More than what the atlas can hold, the evicted ones are removed past it
+    constexpr std::size_t MAX_ALLOCATIONS { 4096 };
+
+    std::optional< std::shared_ptr< ds::Image const > > decode (
+        fs::path const & path )
+    {
+        std::optional< ds::Image > image = ds::make_thumbnail( path );
+        if ( ! image.has_value() )
+        {
+            return std::nullopt;
+        }
+        return std::make_shared< ds::Image const >(
+            std::move( image.value() ) );
+    }
+}  // namespace
+
+Thumbnails::Thumbnails()
+  : m_cache { decode, MAX_OUTSTANDING_DECODES, MAX_DECODED },
+    m_allocations {},
+    m_uploads {},
+    m_nbUploaded { 0 },
+    m_lastFrameUploadSize { 0 }
+{}
+
+std::optional< TextureAtlas::Region > Thumbnails::get_thumbnail(
+    ds::Entry const & entry, ds::FileTypeInfo const & typeInfo )
+{
+    if ( typeInfo.type != ds::FileType::Image )
+    {
+        return std::nullopt;
+    }
+
+    int  frame      = ImGui::GetFrameCount();
+    auto allocation = m_allocations.find( entry.key );
+    if ( allocation != m_allocations.end() )
+    {
+        std::optional< TextureAtlas::Region > region =
+            TextureAtlas::get_instance().get( allocation->second );
+        if ( region.has_value() )
+        {
+            return region;
+        }
+        // Its page has been evicted, it must be uploaded again
+        m_allocations.erase( allocation );
+    }
+
+    auto upload = m_uploads.find( entry.key );
+    if ( upload != m_uploads.end() )
+    {
+        upload->second.lastRequest = frame;
+        return std::nullopt;
+    }
+
+    std::optional< std::shared_ptr< ds::Image const > > image =
+        m_cache.get( entry.key, entry.path );
+    if ( image.has_value() )
+    {
+        m_uploads.emplace( entry.key, Upload { image.value(), frame } );
+    }
+    return std::nullopt;
+}
+
+void Thumbnails::upload_textures( std::size_t maxBytes )
+{
+    int frame             = ImGui::GetFrameCount();
+    m_lastFrameUploadSize = 0;
+
+    for ( auto upload = m_uploads.begin(); upload != m_uploads.end(); )
+    {
+        // Scrolled away before its upload, still in the decoded cache if
+        // it's showed again
+        if ( upload->second.lastRequest != frame )
+        {
+            upload = m_uploads.erase( upload );
+            continue;
+        }
+        if ( m_lastFrameUploadSize >= maxBytes )
+        {
+            break;
+        }
+
+        std::optional< TextureAtlas::Allocation > allocation =
+            TextureAtlas::get_instance().insert( *upload->second.image );
+        // Every page is used by this frame
+        if ( ! allocation.has_value() )
+        {
+            break;
+        }
+        m_lastFrameUploadSize += upload->second.image->pixels.size();
+        ++m_nbUploaded;
+        m_allocations.insert_or_assign( upload->first, allocation.value() );
+        upload = m_uploads.erase( upload );
+    }
+
+    if ( m_allocations.size() > MAX_ALLOCATIONS )
+    {
+        this->remove_evicted();
+    }
+}
+
+void Thumbnails::debug_gui()
+{
+    ImGui::Text( "Thumbnails" );
+    m_cache.debug_gui();
+    ImGui::Text( "In the atlas: %lu", m_allocations.size() );
+    ImGui::Text( "Uploaded: %lu", m_nbUploaded );
+    ImGui::Text( "Waiting for upload: %lu", m_uploads.size() );
+    ImGui::Text( "Uploaded last frame: %lu KiB",
+                 m_lastFrameUploadSize / 1024 );
+}
+
+void Thumbnails::remove_evicted()
+{
+    std::erase_if( m_allocations, [] ( auto const & allocation ) {
+        return ! TextureAtlas::get_instance().is_valid( allocation.second );
+    } );
+}
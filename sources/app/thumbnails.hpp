@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>         // for shared_ptr
+#include <optional>       // for optional
+#include <unordered_map>  // for unordered_map
+
+#include "app/background_file_cache.hpp"  // for BackgroundFileCache
+#include "app/filesystem.hpp"             // for ds::Entry
+#include "app/texture_atlas.hpp"          // for TextureAtlas
+#include "app/thumbnail.hpp"              // for ds::Image
+#include "tools/singleton.hpp"
+
+// Thumbnails of the showed images, decoded in background and uploaded to the
+// texture atlas a few at a time, so the frame rate doesn't drop while
+// scrolling
+class Thumbnails : public Singleton< Thumbnails >
+{
+    ENABLE_SINGLETON( Thumbnails );
+
+    struct Upload
+    {
+        std::shared_ptr< ds::Image const > image;
+        int                                lastRequest;
+    };
+
+    BackgroundFileCache< std::shared_ptr< ds::Image const > > m_cache;
+
+    std::unordered_map< ds::FileKey, TextureAtlas::Allocation,
+                        ds::FileKeyHash >
+        m_allocations;
+    // Decoded thumbnails waiting for their upload
+    std::unordered_map< ds::FileKey, Upload, ds::FileKeyHash > m_uploads;
+
+    uint64_t    m_nbUploaded;
+    std::size_t m_lastFrameUploadSize;
+
+    Thumbnails();
+    virtual ~Thumbnails() = default;
+
+  public:
+    // nullopt while the thumbnail isn't uploaded, or if the entry isn't an
+    // image. Only called from the UI thread.
+    std::optional< TextureAtlas::Region > get_thumbnail (
+        ds::Entry const & entry, ds::FileTypeInfo const & typeInfo );
+
+    // Upload the thumbnails requested during the frame, until the size
+    // uploaded reaches the budget
+    void upload_textures ( std::size_t maxBytes );
+
+    void debug_gui ();
+
+  private:
+    // Forget the thumbnails whose atlas page has been evicted
+    void remove_evicted ();
+};
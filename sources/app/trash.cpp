@@ -0,0 +1,585 @@
+#include "trash.hpp"
+
+#include <cctype>         // for isalnum, isxdigit
+#include <cerrno>         // for errno, EEXIST
+#include <chrono>         // for system_clock
+#include <cstdlib>        // for getenv
+#include <ctime>          // for localtime_r, strftime
+#include <fstream>        // for ifstream
+#include <map>            // for map
+#include <mutex>          // for mutex
+#include <set>            // for set
+#include <sstream>        // for istringstream
+#include <string_view>    // for string_view
+#include <system_error>   // for error_code
+#include <unordered_map>  // for unordered_map
+
+#include <fcntl.h>     // for open
+#include <stdlib.h>    // for mkostemp
+#include <sys/stat.h>  // for lstat, mkdir
+#include <unistd.h>    // for getuid, write, close, unlink
+
+#include <fmt/format.h>  // for format
+
+#include "app/device_info.hpp"  // for ds::read_mounts
+#include "app/file_copy.hpp"    // for ds::rename_no_replace
+
+namespace
+{
+    // Names tried for an item before giving up, "name (2)" and so on
+    constexpr unsigned int MAX_NAME_ATTEMPTS { 10000 };
+    constexpr char         INFO_EXTENSION[] { ".trashinfo" };
+    constexpr char         SIZES_FILE[] { "directorysizes" };
+
+    // "directorysizes" is rewritten by several operations at the same time
+    std::mutex sizesMutex {};
+
+    // Size of a directory when it has been trashed
+    struct DirectorySize
+    {
+        uint64_t size;
+        // Modification time of the info file, to detect a stale line
+        int64_t  infoTime;
+    };
+
+    // The lines of "directorysizes", by percent-encoded name
+    using DirectorySizes = std::unordered_map< std::string, DirectorySize >;
+
+    // Characters kept as is, the others are written as %XX
+    bool is_unreserved ( unsigned char character )
+    {
+        return std::isalnum( character ) || character == '/'
+               || std::string_view { "-_.!~*'()" }.find(
+                      static_cast< char >( character ) )
+                      != std::string_view::npos;
+    }
+
+    std::string percent_encode ( std::string const & text )
+    {
+        std::string encoded {};
+        for ( char character : text )
+        {
+            if ( is_unreserved( static_cast< unsigned char >( character ) ) )
+            {
+                encoded += character;
+            }
+            else
+            {
+                encoded += fmt::format(
+                    "%{:02X}", static_cast< unsigned char >( character ) );
+            }
+        }
+        return encoded;
+    }
+
+    std::string percent_decode ( std::string const & text )
+    {
+        std::string decoded {};
+        for ( std::size_t idx = 0; idx < text.size(); ++idx )
+        {
+            if ( text[idx] == '%' && idx + 2 < text.size()
+                 && std::isxdigit( static_cast< unsigned char >(
+                     text[idx + 1] ) )
+                 && std::isxdigit( static_cast< unsigned char >(
+                     text[idx + 2] ) ) )
+            {
+                decoded += static_cast< char >(
+                    std::stoi( text.substr( idx + 1, 2 ), nullptr, 16 ) );
+                idx += 2;
+            }
+            else
+            {
+                decoded += text[idx];
+            }
+        }
+        return decoded;
+    }
+
+    fs::path get_home_trash ()
+    {
+        char const * dataHome = std::getenv( "XDG_DATA_HOME" );
+        fs::path     data { dataHome != nullptr && dataHome[0] == '/'
+                                ? fs::path { dataHome }
+                                : ds::get_home_directory() / ".local/share" };
+        return data / "Trash";
+    }
+
+    // Create the trash and its subdirectories if they don't exist
+    bool make_trash ( fs::path const & trash )
+    {
+        for ( fs::path const & directory :
+              { trash, trash / "files", trash / "info" } )
+        {
+            if ( mkdir( directory.c_str(), S_IRWXU ) != 0 && errno != EEXIST )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Directory of the mount point containing the path
+    fs::path find_top_directory ( fs::path const & path, dev_t device )
+    {
+        std::error_code error {};
+        fs::path        directory { fs::weakly_canonical(
+            fs::absolute( path, error ).parent_path(), error ) };
+        while ( directory.has_relative_path() )
+        {
+            struct stat status {};
+            if ( stat( directory.parent_path().c_str(), &status ) != 0
+                 || status.st_dev != device )
+            {
+                break;
+            }
+            directory = directory.parent_path();
+        }
+        return directory;
+    }
+
+    // "$topdir/.Trash/$uid" if the administrator created "$topdir/.Trash",
+    // "$topdir/.Trash-$uid" otherwise
+    std::optional< fs::path > get_top_trash ( fs::path const & topDirectory )
+    {
+        uid_t       uid { getuid() };
+        struct stat status {};
+        fs::path    shared { topDirectory / ".Trash" };
+        // It must not be a link, and must be sticky so the users can't
+        // remove the trash of the others
+        if ( lstat( shared.c_str(), &status ) == 0 && S_ISDIR( status.st_mode )
+             && ( status.st_mode & S_ISVTX ) != 0 )
+        {
+            fs::path trash { shared / std::to_string( uid ) };
+            if ( make_trash( trash ) )
+            {
+                return trash;
+            }
+        }
+
+        fs::path trash { topDirectory / fmt::format( ".Trash-{}", uid ) };
+        if ( make_trash( trash ) && lstat( trash.c_str(), &status ) == 0
+             && S_ISDIR( status.st_mode ) && status.st_uid == uid )
+        {
+            return trash;
+        }
+        return std::nullopt;
+    }
+
+    // The mount point of a trash at the top of a mount, empty for the home
+    // trash
+    fs::path get_top_directory_of ( fs::path const & trash )
+    {
+        if ( trash.filename().string().starts_with( ".Trash-" ) )
+        {
+            return trash.parent_path();
+        }
+        if ( trash.parent_path().filename() == ".Trash" )
+        {
+            return trash.parent_path().parent_path();
+        }
+        return {};
+    }
+
+    std::string get_local_date ()
+    {
+        std::time_t now { std::chrono::system_clock::to_time_t(
+            std::chrono::system_clock::now() ) };
+        std::tm     date {};
+        localtime_r( &now, &date );
+        char buffer[32] {};
+        std::strftime( buffer, sizeof( buffer ), "%Y-%m-%dT%H:%M:%S", &date );
+        return buffer;
+    }
+
+    // Space used on the disk, as computed by "du -B1"
+    uint64_t get_disk_usage ( fs::path const & path )
+    {
+        struct stat status {};
+        if ( lstat( path.c_str(), &status ) != 0 )
+        {
+            return 0;
+        }
+        uint64_t size { static_cast< uint64_t >( status.st_blocks ) * 512 };
+        if ( ! S_ISDIR( status.st_mode ) )
+        {
+            return size;
+        }
+
+        std::error_code error {};
+        for ( fs::recursive_directory_iterator it {
+                  path, fs::directory_options::skip_permission_denied, error };
+              ! error && it != fs::recursive_directory_iterator {};
+              it.increment( error ) )
+        {
+            if ( lstat( it->path().c_str(), &status ) == 0 )
+            {
+                size += static_cast< uint64_t >( status.st_blocks ) * 512;
+            }
+        }
+        return size;
+    }
+
+    int64_t get_modification_time ( fs::path const & path )
+    {
+        struct stat status {};
+        if ( stat( path.c_str(), &status ) != 0 )
+        {
+            return -1;
+        }
+        return static_cast< int64_t >( status.st_mtime );
+    }
+
+    // Each line is "size mtime name"
+    DirectorySizes read_directory_sizes ( fs::path const & trash )
+    {
+        DirectorySizes sizes {};
+        std::ifstream  file { trash / SIZES_FILE };
+        std::string    line {};
+        while ( std::getline( file, line ) )
+        {
+            std::istringstream stream { line };
+            DirectorySize      size {};
+            std::string        name {};
+            if ( stream >> size.size >> size.infoTime >> name )
+            {
+                sizes[name] = size;
+            }
+        }
+        return sizes;
+    }
+
+    // Add and remove lines of "directorysizes". It's written in a temporary
+    // file renamed over it, so a reader never sees it half written.
+    void update_directory_sizes ( fs::path const &              trash,
+                                  DirectorySizes const &        added,
+                                  std::set< std::string > const & removed )
+    {
+        std::lock_guard< std::mutex > lock { sizesMutex };
+        DirectorySizes sizes { read_directory_sizes( trash ) };
+        for ( std::string const & name : removed )
+        {
+            sizes.erase( name );
+        }
+        for ( auto const & [name, size] : added )
+        {
+            sizes[name] = size;
+        }
+
+        std::string content {};
+        for ( auto const & [name, size] : sizes )
+        {
+            content += fmt::format( "{} {} {}\n", size.size, size.infoTime,
+                                    name );
+        }
+        std::string temporary {
+            ( trash / fmt::format( ".{}.XXXXXX", SIZES_FILE ) ).string() };
+        int descriptor = mkostemp( temporary.data(), O_CLOEXEC );
+        if ( descriptor < 0 )
+        {
+            return;
+        }
+        bool isWritten = write( descriptor, content.data(), content.size() )
+                         == static_cast< ssize_t >( content.size() );
+        close( descriptor );
+        if ( ! isWritten
+             || rename( temporary.c_str(),
+                        ( trash / SIZES_FILE ).c_str() )
+                    != 0 )
+        {
+            unlink( temporary.c_str() );
+        }
+    }
+
+    std::optional< ds::TrashItem > read_info ( fs::path const & trash,
+                                               fs::path const & infoPath )
+    {
+        std::ifstream file { infoPath };
+        std::string   line {};
+        if ( ! std::getline( file, line ) || line != "[Trash Info]" )
+        {
+            return std::nullopt;
+        }
+
+        ds::TrashItem item { trash, infoPath.stem().string(), {}, {}, 0,
+                             false };
+        while ( std::getline( file, line ) )
+        {
+            if ( line.starts_with( "Path=" ) )
+            {
+                item.originalPath = percent_decode( line.substr( 5 ) );
+            }
+            else if ( line.starts_with( "DeletionDate=" ) )
+            {
+                item.deletionDate = line.substr( 13 );
+            }
+        }
+        if ( item.originalPath.empty() )
+        {
+            return std::nullopt;
+        }
+        if ( item.originalPath.is_relative() )
+        {
+            item.originalPath = get_top_directory_of( trash )
+                                / item.originalPath;
+        }
+        return item;
+    }
+
+    // The home trash, and the trashes of the mounted filesystems
+    std::vector< fs::path > find_trashes ()
+    {
+        std::vector< fs::path > trashes { get_home_trash() };
+        std::set< fs::path >    mountPoints {};
+        for ( ds::Mount const & mount : ds::read_mounts() )
+        {
+            mountPoints.insert( mount.mountPoint );
+        }
+
+        uid_t uid { getuid() };
+        for ( fs::path const & mountPoint : mountPoints )
+        {
+            for ( fs::path const & trash :
+                  { mountPoint / ".Trash" / std::to_string( uid ),
+                    mountPoint / fmt::format( ".Trash-{}", uid ) } )
+            {
+                struct stat status {};
+                if ( lstat( ( trash / "info" ).c_str(), &status ) == 0
+                     && S_ISDIR( status.st_mode ) )
+                {
+                    trashes.push_back( trash );
+                }
+            }
+        }
+        return trashes;
+    }
+}  // namespace
+
+namespace ds
+{
+    fs::path TrashItem::get_path() const
+    {
+        return trash / "files" / name;
+    }
+
+    fs::path TrashItem::get_info_path() const
+    {
+        return trash / "info" / ( name + INFO_EXTENSION );
+    }
+
+    std::optional< TrashItem > create_trash_item( fs::path const & path )
+    {
+        // "directory/" is trashed as "directory"
+        fs::path    target { path.has_filename() ? path : path.parent_path() };
+        struct stat status {};
+        if ( lstat( target.c_str(), &status ) != 0 )
+        {
+            return std::nullopt;
+        }
+
+        // A trash on another filesystem is only used if there is no other
+        // choice, the file is then copied
+        fs::path    homeTrash { get_home_trash() };
+        std::error_code error {};
+        fs::create_directories( homeTrash.parent_path(), error );
+        bool        hasHomeTrash { make_trash( homeTrash ) };
+        struct stat trashStatus {};
+        fs::path    trash { homeTrash };
+        fs::path    topDirectory {};
+        if ( ! hasHomeTrash || stat( homeTrash.c_str(), &trashStatus ) != 0
+             || trashStatus.st_dev != status.st_dev )
+        {
+            fs::path top { find_top_directory( target, status.st_dev ) };
+            std::optional< fs::path > topTrash { get_top_trash( top ) };
+            if ( topTrash.has_value()
+                 && stat( topTrash->c_str(), &trashStatus ) == 0
+                 && trashStatus.st_dev == status.st_dev )
+            {
+                trash        = topTrash.value();
+                topDirectory = top;
+            }
+            else if ( ! hasHomeTrash )
+            {
+                return std::nullopt;
+            }
+        }
+
+        // The link itself is trashed, not what it points to
+        fs::path originalPath {
+            fs::weakly_canonical( fs::absolute( target, error ).parent_path(),
+                                  error )
+            / target.filename() };
+        if ( ! topDirectory.empty() )
+        {
+            originalPath = originalPath.lexically_relative( topDirectory );
+        }
+        std::string deletionDate { get_local_date() };
+        std::string info { fmt::format(
+            "[Trash Info]\nPath={}\nDeletionDate={}\n",
+            percent_encode( originalPath.string() ), deletionDate ) };
+
+        // The info file is created first, it reserves the name
+        for ( unsigned int idx = 1; idx <= MAX_NAME_ATTEMPTS; ++idx )
+        {
+            std::string name {
+                idx == 1 ? target.filename().string()
+                         : fmt::format( "{} ({}){}", target.stem().string(),
+                                        idx, target.extension().string() ) };
+            TrashItem item { trash,
+                             name,
+                             originalPath,
+                             deletionDate,
+                             0,
+                             S_ISDIR( status.st_mode ) };
+            struct stat existing {};
+            if ( lstat( item.get_path().c_str(), &existing ) == 0 )
+            {
+                continue;
+            }
+            int descriptor = ::open( item.get_info_path().c_str(),
+                                     O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                                     S_IRUSR | S_IWUSR );
+            if ( descriptor < 0 && errno == EEXIST )
+            {
+                continue;
+            }
+            if ( descriptor < 0 )
+            {
+                return std::nullopt;
+            }
+            bool isWritten = write( descriptor, info.data(), info.size() )
+                             == static_cast< ssize_t >( info.size() );
+            int  writeError = errno;
+            close( descriptor );
+            if ( ! isWritten )
+            {
+                unlink( item.get_info_path().c_str() );
+                errno = writeError;
+                return std::nullopt;
+            }
+            if ( ! topDirectory.empty() )
+            {
+                item.originalPath = topDirectory / originalPath;
+            }
+            return item;
+        }
+        errno = EEXIST;
+        return std::nullopt;
+    }
+
+    void discard_trash_item( TrashItem const & item )
+    {
+        unlink( item.get_info_path().c_str() );
+    }
+
+    void add_directory_size( TrashItem const & item )
+    {
+        if ( ! item.isDirectory )
+        {
+            return;
+        }
+        update_directory_sizes(
+            item.trash,
+            { { percent_encode( item.name ),
+                DirectorySize { get_disk_usage( item.get_path() ),
+                                get_modification_time(
+                                    item.get_info_path() ) } } },
+            {} );
+    }
+
+    std::vector< TrashItem > list_trash()
+    {
+        std::vector< TrashItem > items {};
+        for ( fs::path const & trash : find_trashes() )
+        {
+            DirectorySizes  sizes { read_directory_sizes( trash ) };
+            DirectorySizes  missingSizes {};
+            std::error_code error {};
+            for ( fs::directory_iterator it { trash / "info", error };
+                  ! error && it != fs::directory_iterator {};
+                  it.increment( error ) )
+            {
+                if ( it->path().extension() != INFO_EXTENSION )
+                {
+                    continue;
+                }
+                std::optional< TrashItem > item { read_info( trash,
+                                                             it->path() ) };
+                struct stat status {};
+                if ( ! item.has_value()
+                     || lstat( item->get_path().c_str(), &status ) != 0 )
+                {
+                    continue;
+                }
+
+                item->isDirectory = S_ISDIR( status.st_mode );
+                if ( ! item->isDirectory )
+                {
+                    item->size = static_cast< uint64_t >( status.st_size );
+                    items.push_back( std::move( item.value() ) );
+                    continue;
+                }
+                // A line older than the info file is of another directory
+                // trashed with the same name
+                std::string name { percent_encode( item->name ) };
+                int64_t     infoTime { get_modification_time( it->path() ) };
+                auto        size = sizes.find( name );
+                if ( size != sizes.end() && size->second.infoTime == infoTime )
+                {
+                    item->size = size->second.size;
+                }
+                else
+                {
+                    item->size = get_disk_usage( item->get_path() );
+                    missingSizes[name] = DirectorySize { item->size,
+                                                         infoTime };
+                }
+                items.push_back( std::move( item.value() ) );
+            }
+            if ( ! missingSizes.empty() )
+            {
+                update_directory_sizes( trash, missingSizes, {} );
+            }
+        }
+        return items;
+    }
+
+    void forget_trash_items( std::vector< fs::path > const & removedPaths )
+    {
+        std::map< fs::path, std::set< std::string > > removedNames {};
+        for ( fs::path const & path : removedPaths )
+        {
+            fs::path files { path.parent_path() };
+            if ( files.filename() != "files" )
+            {
+                continue;
+            }
+            TrashItem item { files.parent_path(),
+                             path.filename().string(),
+                             {},
+                             {},
+                             0,
+                             false };
+            if ( unlink( item.get_info_path().c_str() ) == 0 )
+            {
+                removedNames[item.trash].insert( percent_encode( item.name ) );
+            }
+        }
+        for ( auto const & [trash, names] : removedNames )
+        {
+            update_directory_sizes( trash, {}, names );
+        }
+    }
+
+    int restore_trash_item( TrashItem const & item )
+    {
+        std::error_code error {};
+        fs::create_directories( item.originalPath.parent_path(), error );
+        int result = ds::rename_no_replace( item.get_path(),
+                                            item.originalPath );
+        if ( result == 0 )
+        {
+            forget_trash_items( { item.get_path() } );
+        }
+        return result;
+    }
+}  // namespace ds
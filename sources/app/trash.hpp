@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>   // for uint64_t
+#include <optional>  // for optional
+#include <string>    // for string
+#include <vector>    // for vector
+
+#include "app/filesystem.hpp"  // for fs::path
+
+// Trash following the freedesktop.org Trash specification. The home trash is
+// used for the files of its filesystem, and a trash at the top of their mount
+// for the others, so trashing a file is a rename and never a copy when it's
+// possible.
+namespace ds
+{
+    // A trashed file or directory
+    struct TrashItem
+    {
+        // Trash directory containing "files" and "info"
+        fs::path    trash;
+        // Name in "files", and of the info file without its extension
+        std::string name;
+        fs::path    originalPath;
+        // Local time, as "YYYY-MM-DDThh:mm:ss"
+        std::string deletionDate;
+        // Disk usage for a directory, as cached in "directorysizes"
+        uint64_t    size;
+        bool        isDirectory;
+
+        fs::path get_path () const;
+        fs::path get_info_path () const;
+    };
+
+    // Choose the trash of the file, create its info file and return the item
+    // where the file must be moved. If no name is free, or the info file
+    // can't be written, return nullopt with errno set.
+    std::optional< TrashItem > create_trash_item ( fs::path const & path );
+    // Remove the info file of an item whose file couldn't be moved
+    void discard_trash_item ( TrashItem const & item );
+    // Once the file has been moved, cache the size of a directory
+    void add_directory_size ( TrashItem const & item );
+
+    // Every item of the trashes the user can access. The sizes of the
+    // directories are read from "directorysizes", they are only computed if
+    // they aren't there yet.
+    std::vector< TrashItem > list_trash ();
+
+    // Forget the info files and cached sizes of the paths removed from the
+    // "files" directory of a trash. The other paths are ignored.
+    void forget_trash_items ( std::vector< fs::path > const & removedPaths );
+
+    // Move the item back to its original path, the parent directories are
+    // created if needed. Return 0 or the errno of the failure, EXDEV if the
+    // trash isn't on the filesystem of the original path: the file must then
+    // be copied and removed from the trash by FileOperations::restore.
+    int restore_trash_item ( TrashItem const & item );
+}  // namespace ds
@@ -0,0 +1,204 @@
+#include "trash_window.hpp"
+
+#include <algorithm>  // for sort
+#include <optional>   // for optional
+
+#include <imgui/imgui.h>  // for ImGui::BeginTable, ImGuiListClipper
+
+#include "app/file_operations.hpp"  // for FileOperations
+
+TrashWindow::TrashWindow()
+  : m_isOpen { false },
+    m_items {},
+    m_totalSize { 0 },
+    m_nbFinishedOperations { 0 },
+    m_nbListings { 0 },
+    m_isListing { false },
+    m_mutex {},
+    m_listedItems { std::nullopt },
+    m_idxListed { 0 },
+    m_jobs { JobScheduler::JobClass::Background }
+{}
+
+void TrashWindow::open()
+{
+    m_isOpen = true;
+    this->refresh();
+}
+
+void TrashWindow::refresh()
+{
+    m_nbFinishedOperations = FileOperations::get_instance().get_nb_finished();
+    m_isListing            = true;
+    uint64_t idxListing    = ++m_nbListings;
+
+    // The trashes are on every mount, the job isn't tied to a device
+    m_jobs.submit( 0, [this, idxListing] ( std::stop_token stopToken ) {
+        if ( stopToken.stop_requested() )
+        {
+            return;
+        }
+        std::vector< ds::TrashItem > items = ds::list_trash();
+        // Last trashed first
+        std::sort( items.begin(), items.end(),
+                   [] ( ds::TrashItem const & lhs,
+                        ds::TrashItem const & rhs ) {
+                       return lhs.deletionDate > rhs.deletionDate;
+                   } );
+
+        // An older listing finishing last is dropped
+        std::lock_guard< std::mutex > lock { m_mutex };
+        if ( idxListing > m_idxListed )
+        {
+            m_listedItems = std::move( items );
+            m_idxListed   = idxListing;
+        }
+    } );
+}
+
+void TrashWindow::take_listed_items()
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    if ( ! m_listedItems.has_value() )
+    {
+        return;
+    }
+    m_items = std::move( m_listedItems.value() );
+    m_listedItems.reset();
+    m_isListing = m_idxListed != m_nbListings;
+
+    m_totalSize = 0;
+    for ( ds::TrashItem const & item : m_items )
+    {
+        m_totalSize += item.size;
+    }
+}
+
+void TrashWindow::update_gui()
+{
+    if ( ! m_isOpen )
+    {
+        return;
+    }
+    if ( m_nbFinishedOperations
+         != FileOperations::get_instance().get_nb_finished() )
+    {
+        this->refresh();
+    }
+    this->take_listed_items();
+
+    ImGui::SetNextWindowSize( ImVec2 { 720.f, 400.f }, ImGuiCond_FirstUseEver );
+    if ( ! ImGui::Begin( "Trash", &m_isOpen ) )
+    {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text( "%lu items, %s", m_items.size(),
+                 ds::get_size_pretty_print( m_totalSize, false ).c_str() );
+    if ( m_isListing )
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled( "Listing..." );
+    }
+    ImGui::SameLine();
+    if ( ImGui::Button( "Refresh##RefreshTrash" ) )
+    {
+        this->refresh();
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled( m_items.empty() );
+    if ( ImGui::Button( "Empty Trash" ) )
+    {
+        ImGui::OpenPopup( "Empty the Trash?" );
+    }
+    ImGui::EndDisabled();
+
+    if ( ImGui::BeginPopupModal( "Empty the Trash?", nullptr,
+                                 ImGuiWindowFlags_AlwaysAutoResize ) )
+    {
+        ImGui::Text( "%lu items will be deleted, it can't be undone.",
+                     m_items.size() );
+        if ( ImGui::Button( "Empty##ConfirmEmpty" ) )
+        {
+            std::vector< fs::path > paths {};
+            for ( ds::TrashItem const & item : m_items )
+            {
+                paths.push_back( item.get_path() );
+            }
+            FileOperations::get_instance().remove( std::move( paths ) );
+            m_items.clear();
+            m_totalSize = 0;
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::SameLine();
+        if ( ImGui::Button( "Cancel##CancelEmpty" )
+             || ImGui::IsKeyPressed( ImGuiKey_Escape, false ) )
+        {
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::EndPopup();
+    }
+
+    this->update_table();
+    ImGui::End();
+}
+
+void TrashWindow::update_table()
+{
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable
+                            | ImGuiTableFlags_ScrollY;
+    if ( ! ImGui::BeginTable( "Trash Item List", 5, flags ) )
+    {
+        return;
+    }
+    ImGui::TableSetupScrollFreeze( 0, 1 );
+    ImGui::TableSetupColumn( "Name", ImGuiTableColumnFlags_WidthStretch );
+    ImGui::TableSetupColumn( "Original Location",
+                             ImGuiTableColumnFlags_WidthStretch );
+    ImGui::TableSetupColumn( "Deleted", ImGuiTableColumnFlags_WidthFixed );
+    ImGui::TableSetupColumn( "Size", ImGuiTableColumnFlags_WidthFixed );
+    ImGui::TableSetupColumn( "##Actions", ImGuiTableColumnFlags_WidthFixed );
+    ImGui::TableHeadersRow();
+
+    std::optional< std::size_t > idxRestored {};
+    ImGuiListClipper             clipper {};
+    clipper.Begin( static_cast< int >( m_items.size() ) );
+    while ( clipper.Step() )
+    {
+        for ( int idxRow = clipper.DisplayStart; idxRow < clipper.DisplayEnd;
+              ++idxRow )
+        {
+            ds::TrashItem const & item = m_items[idxRow];
+            ImGui::PushID( idxRow );
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted( item.name.c_str() );
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(
+                item.originalPath.parent_path().string().c_str() );
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted( item.deletionDate.c_str() );
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(
+                ds::get_size_pretty_print( item.size, false ).c_str() );
+            ImGui::TableNextColumn();
+            if ( ImGui::SmallButton( "Restore" ) )
+            {
+                idxRestored = static_cast< std::size_t >( idxRow );
+            }
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndTable();
+
+    if ( idxRestored.has_value() )
+    {
+        // Listed again once restored, or if it couldn't be
+        ds::TrashItem const & item = m_items[idxRestored.value()];
+        FileOperations::get_instance().restore( { item } );
+        m_totalSize -= item.size;
+        m_items.erase( m_items.begin()
+                       + static_cast< std::ptrdiff_t >( idxRestored.value() ) );
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>   // for uint64_t
+#include <mutex>     // for mutex
+#include <optional>  // for optional
+#include <vector>    // for vector
+
+#include "app/job_scheduler.hpp"  // for JobScheduler
+#include "app/trash.hpp"          // for ds::TrashItem
+
+// Items of the trash, which can be restored or deleted. The trash is listed
+// by a background job, as it reads every mount and may compute the size of
+// the trashed directories; the last listing stays showed meanwhile.
+class TrashWindow
+{
+    bool                         m_isOpen;
+    std::vector< ds::TrashItem > m_items;
+    uint64_t                     m_totalSize;
+    // The trash is listed again when a file operation ends
+    uint64_t                     m_nbFinishedOperations;
+    uint64_t                     m_nbListings;
+    bool                         m_isListing;
+
+    // Written by the job, the items of the last listing done
+    std::mutex                                    m_mutex;
+    std::optional< std::vector< ds::TrashItem > > m_listedItems;
+    uint64_t                                      m_idxListed;
+    // Destroyed first, so no job runs on a partially destroyed window
+    JobScheduler::Queue                           m_jobs;
+
+  public:
+    TrashWindow();
+    virtual ~TrashWindow() = default;
+
+    TrashWindow( TrashWindow const & )              = delete;
+    TrashWindow & operator= ( TrashWindow const & ) = delete;
+
+    void open ();
+    void update_gui ();
+
+  private:
+    void refresh ();
+    // Show the items of the listing done since the last frame, if any
+    void take_listed_items ();
+    void update_table ();
+};
@@ -0,0 +1,169 @@
+#include "tree_walker.hpp"
+
+#include <algorithm>     // for sort, push_heap, pop_heap, reverse
+#include <cerrno>        // for errno
+#include <cstring>       // for strcmp
+#include <system_error>  // for generic_category
+#include <vector>        // for vector
+
+#include <dirent.h>  // for getdents64, dirent64
+#include <fcntl.h>   // for open, fstatat
+#include <unistd.h>  // for close
+
+#include <fmt/format.h>  // for format
+
+#include "app/perf_counters.hpp"  // for PerfCounters
+
+namespace
+{
+    // Entries read by a single getdents call
+    constexpr std::size_t DIRENT_BUFFER_SIZE { 64 * 1024 };
+
+    struct Name
+    {
+        std::string name;
+        ino_t       inode;
+    };
+
+    struct PendingDirectory
+    {
+        fs::path path;
+        ino_t    inode;
+    };
+
+    // The lowest inode is on the top of the heap
+    bool is_after ( PendingDirectory const & lhs, PendingDirectory const & rhs )
+    {
+        return lhs.inode > rhs.inode;
+    }
+
+    // Every entry of the directory but "." and "..", errno is set on failure
+    bool read_names ( int descriptor, std::vector< char > & buffer,
+                      std::vector< Name > & names )
+    {
+        while ( true )
+        {
+            ssize_t nbRead =
+                getdents64( descriptor, buffer.data(), buffer.size() );
+            if ( nbRead <= 0 )
+            {
+                return nbRead == 0;
+            }
+            for ( ssize_t offset = 0; offset < nbRead; )
+            {
+                auto const * entry = reinterpret_cast< dirent64 const * >(
+                    buffer.data() + offset );
+                offset += entry->d_reclen;
+                if ( std::strcmp( entry->d_name, "." ) != 0
+                     && std::strcmp( entry->d_name, ".." ) != 0 )
+                {
+                    names.push_back( Name { entry->d_name, entry->d_ino } );
+                }
+            }
+        }
+    }
+}  // namespace
+
+namespace ds
+{
+    bool walk_tree ( fs::path const & root, WalkOrder order,
+                     WalkCallback const &                         onEntry,
+                     std::function< void( std::string ) > const & onError,
+                     std::stop_token                               stopToken )
+    {
+        PerfCounters::Region perfRegion { "ds::walk_tree" };
+        auto report = [&onError] ( fs::path const & path, int error ) {
+            onError( fmt::format( "Can't read {}: {}", path.string(),
+                                  std::generic_category().message( error ) ) );
+        };
+
+        struct stat status {};
+        if ( lstat( root.c_str(), &status ) != 0 )
+        {
+            report( root, errno );
+            return false;
+        }
+        onEntry( root, status );
+        if ( ! S_ISDIR( status.st_mode ) )
+        {
+            return true;
+        }
+
+        bool                            isComplete { true };
+        std::vector< PendingDirectory > pending { { root, status.st_ino } };
+        std::vector< char >             buffer( DIRENT_BUFFER_SIZE );
+        std::vector< Name >             names {};
+        while ( ! pending.empty() )
+        {
+            if ( stopToken.stop_requested() )
+            {
+                return false;
+            }
+            if ( order == WalkOrder::Inode )
+            {
+                std::pop_heap( pending.begin(), pending.end(), is_after );
+            }
+            PendingDirectory directory { std::move( pending.back() ) };
+            pending.pop_back();
+
+            int descriptor =
+                ::open( directory.path.c_str(),
+                        O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC );
+            if ( descriptor < 0 )
+            {
+                report( directory.path, errno );
+                isComplete = false;
+                continue;
+            }
+            names.clear();
+            if ( ! read_names( descriptor, buffer, names ) )
+            {
+                report( directory.path, errno );
+                isComplete = false;
+            }
+            if ( order == WalkOrder::Inode )
+            {
+                std::sort( names.begin(), names.end(),
+                           [] ( Name const & lhs, Name const & rhs ) {
+                               return lhs.inode < rhs.inode;
+                           } );
+            }
+
+            std::size_t idxFirstChild { pending.size() };
+            for ( Name const & name : names )
+            {
+                fs::path path { directory.path / name.name };
+                if ( fstatat( descriptor, name.name.c_str(), &status,
+                              AT_SYMLINK_NOFOLLOW )
+                     != 0 )
+                {
+                    report( path, errno );
+                    isComplete = false;
+                    continue;
+                }
+                onEntry( path, status );
+                if ( S_ISDIR( status.st_mode ) )
+                {
+                    pending.push_back(
+                        PendingDirectory { std::move( path ), status.st_ino } );
+                    if ( order == WalkOrder::Inode )
+                    {
+                        std::push_heap( pending.begin(), pending.end(),
+                                        is_after );
+                    }
+                }
+            }
+            close( descriptor );
+
+            if ( order == WalkOrder::Directory )
+            {
+                // The first subdirectory found is visited first
+                std::reverse( pending.begin()
+                                  + static_cast< std::ptrdiff_t >(
+                                      idxFirstChild ),
+                              pending.end() );
+            }
+        }
+        return isComplete;
+    }
+}  // namespace ds
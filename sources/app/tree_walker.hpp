@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>  // for function
+#include <stop_token>  // for stop_token
+#include <string>      // for string
+
+#include <sys/stat.h>  // for stat
+
+#include "app/filesystem.hpp"  // for fs::path
+
+namespace ds
+{
+    enum class WalkOrder
+    {
+        // Entries in the order given by the directory, the subdirectories
+        // depth first
+        Directory,
+        // Entries of a directory read first, then stat by inode number, and
+        // the directories visited by inode number. The inodes are mostly
+        // stored in that order, so a rotational disk seeks forward instead of
+        // back and forth, like fsck and mlocate do.
+        Inode
+    };
+
+    using WalkCallback =
+        std::function< void( fs::path const &, struct stat const & ) >;
+
+    // Give the status of the path, and of everything under it if it's a
+    // directory, to onEntry. A directory is always given before its content
+    // and the symbolic links aren't followed. An entry that can't be read is
+    // given to onError and the walk continues; return true if everything has
+    // been read.
+    bool walk_tree ( fs::path const & root, WalkOrder order,
+                     WalkCallback const &                         onEntry,
+                     std::function< void( std::string ) > const & onError,
+                     std::stop_token stopToken = {} );
+}  // namespace ds
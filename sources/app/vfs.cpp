@@ -0,0 +1,68 @@
+#include "vfs.hpp"
+
+#include "app/native_file_system.hpp"  // for vfs::NativeFileSystem
+
+namespace
+{
+    // The synthetic contents are lines of this size
+    constexpr uint64_t LINE_SIZE { 64 };
+
+    std::shared_ptr< vfs::FileSystem > & get_current ()
+    {
+        static std::shared_ptr< vfs::FileSystem > current {
+            std::make_shared< vfs::NativeFileSystem >() };
+        return current;
+    }
+}  // namespace
+
+namespace vfs
+{
+    void File::advise( Access, uint64_t, uint64_t ) {}
+
+    void FileSystem::debug_gui() {}
+
+    std::string normalize ( fs::path const & path )
+    {
+        // Most paths are already normal, lexically_normal is slow
+        std::string const & native = path.native();
+        if ( native.starts_with( '/' )
+             && ( native.size() == 1 || ! native.ends_with( '/' ) )
+             && ! native.ends_with( "/." ) && ! native.ends_with( "/.." )
+             && native.find( "//" ) == std::string::npos
+             && native.find( "/./" ) == std::string::npos
+             && native.find( "/../" ) == std::string::npos )
+        {
+            return native;
+        }
+
+        std::string normalized {
+            ( fs::path { "/" } / path ).lexically_normal().string() };
+        if ( normalized.size() > 1 && normalized.back() == '/' )
+        {
+            normalized.pop_back();
+        }
+        return normalized;
+    }
+
+    void fill_synthetic_content ( char * buffer, std::size_t size,
+                                  uint64_t offset )
+    {
+        for ( std::size_t idx = 0; idx < size; ++idx )
+        {
+            uint64_t column = ( offset + idx ) % LINE_SIZE;
+            buffer[idx]     = column == LINE_SIZE - 1
+                                  ? '\n'
+                                  : static_cast< char >( 'a' + column % 26 );
+        }
+    }
+
+    FileSystem & get_file_system ()
+    {
+        return *get_current();
+    }
+
+    void set_file_system ( std::shared_ptr< FileSystem > fileSystem )
+    {
+        get_current() = std::move( fileSystem );
+    }
+}  // namespace vfs
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>       // for uint64_t, int64_t
+#include <functional>    // for function
+#include <memory>        // for shared_ptr, unique_ptr
+#include <string>        // for string
+#include <system_error>  // for error_code
+#include <vector>        // for vector
+
+#include <sys/types.h>  // for ssize_t
+
+#include "app/filesystem.hpp"  // for fs::path
+
+// Virtual file system, what the explorer reads the directories and files
+// through. The native backend is the real one, the memory backend holds
+// synthetic trees to benchmark the explorer without a disk layout.
+namespace vfs
+{
+    enum class FileKind
+    {
+        Regular = 0,
+        Directory,
+        Symlink,
+        // Devices, sockets and pipes
+        Other,
+        // Not given by the directory, a stat is needed
+        Unknown
+    };
+
+    struct DirectoryEntry
+    {
+        std::string name;
+        // Of the entry itself, a link isn't followed
+        FileKind    kind;
+    };
+
+    struct Status
+    {
+        FileKind kind;
+        // In bytes
+        uint64_t size;
+        uint64_t device;
+        uint64_t inode;
+        // In nanoseconds since epoch
+        int64_t  modificationTime;
+    };
+
+    // How a range of a file is going to be read
+    enum class Access
+    {
+        Random = 0,
+        Sequential,
+        // Won't be read again, the cached pages can be dropped
+        Done
+    };
+
+    // Opened for reading
+    class File
+    {
+      public:
+        virtual ~File() = default;
+
+        // Read until the size is reached or the end of the file, -1 on error
+        virtual ssize_t  read_at ( void * buffer, std::size_t size,
+                                   uint64_t offset ) = 0;
+        virtual uint64_t get_size () const         = 0;
+        // Hint for the read ahead, ignored by default. A null size goes to
+        // the end of the file.
+        virtual void     advise ( Access access, uint64_t offset,
+                                  uint64_t size );
+    };
+
+    // Stops watching when it's destroyed
+    class Watch
+    {
+      public:
+        virtual ~Watch() = default;
+    };
+
+    // The errors are returned like the std::filesystem overloads taking an
+    // error code, which is cleared on success
+    class FileSystem
+    {
+      public:
+        virtual ~FileSystem() = default;
+
+        // Every entry but "." and ".."
+        virtual std::vector< DirectoryEntry > enumerate (
+            fs::path const & directory, std::error_code & error ) = 0;
+        // The symbolic links are followed
+        virtual Status status ( fs::path const & path,
+                                std::error_code & error )         = 0;
+        virtual Status symlink_status ( fs::path const & path,
+                                        std::error_code & error ) = 0;
+        virtual std::unique_ptr< File > open ( fs::path const & path,
+                                               std::error_code & error ) = 0;
+        // Call onChange when an entry of the directory is added, removed,
+        // renamed or modified. It may be called from another thread, with the
+        // watches locked, so it must be quick and not use the file system.
+        virtual std::unique_ptr< Watch > watch (
+            fs::path const & directory, std::function< void() > onChange,
+            std::error_code & error ) = 0;
+
+        virtual void debug_gui ();
+    };
+
+    // Absolute, without "." and ".." nor a trailing slash, the paths of the
+    // backends held in memory are compared this way
+    std::string normalize ( fs::path const & path );
+
+    // Content of the files whose content isn't known, lines of letters so
+    // they are previewed as text
+    void fill_synthetic_content ( char * buffer, std::size_t size,
+                                  uint64_t offset );
+
+    // The native one, unless it has been replaced
+    FileSystem & get_file_system ();
+    // Must be called before the explorer starts reading
+    void         set_file_system ( std::shared_ptr< FileSystem > fileSystem );
+}  // namespace vfs
@@ -1,5 +1,6 @@
 #include "window.hpp"
 
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
 
@@ -11,30 +12,97 @@
 
 #include "app/display.hpp"
 #include "app/filesystem.hpp"
+#include "app/performance_overlay.hpp"
+#include "app/texture_atlas.hpp"
+#include "app/thumbnails.hpp"
 #include "tools/traces.hpp"
+#include "tools/tracing.hpp"
+
+namespace
+{
+    // 16 thumbnails of 128x128, uploading more in one frame makes it late
+    constexpr std::size_t MAX_UPLOAD_BYTES_PER_FRAME { 1024 * 1024 };
+}  // namespace
 
 Window::Window()
-  : m_window { nullptr }, m_eventMode { EventMode::Poll }, m_vsync { true }
+  : m_window { nullptr },
+    m_eventMode { EventMode::Poll },
+    m_vsync { true },
+    m_headlessSize {},
+    m_lastFrame {},
+    m_replayedDeltaTime { std::nullopt },
+    m_inputRecording { nullptr },
+    m_inputRecordingFile {}
 {
     this->initialize_GLFW();
     this->initialize_OpenGL();
     this->initialize_ImGui();
 }
 
+Window::Window( ImVec2 headlessSize )
+  : m_window { nullptr },
+    m_eventMode { EventMode::Poll },
+    m_vsync { false },
+    m_headlessSize { headlessSize },
+    m_lastFrame { std::chrono::steady_clock::now() },
+    m_replayedDeltaTime { std::nullopt },
+    m_inputRecording { nullptr },
+    m_inputRecordingFile {}
+{
+    TextureAtlas::get_instance().set_headless();
+    this->initialize_headless_ImGui();
+}
+
 Window::~Window()
 {
+    if ( m_inputRecording )
+    {
+        m_inputRecording->save( m_inputRecordingFile );
+    }
+    TextureAtlas::get_instance().release();
+    if ( this->is_headless() )
+    {
+        ImGui::DestroyContext();
+        return;
+    }
     this->terminate_ImGui();
     this->terminate_SDL();
 }
 
 void Window::update( std::function< void() > callback )
 {
+    TRACE_SPAN( "Window::update" );
+    PerformanceOverlay & overlay = PerformanceOverlay::get_instance();
+    overlay.begin_frame();
+    if ( this->is_headless() )
+    {
+        this->new_headless_frame();
+        overlay.end_phase( PerformanceOverlay::Phase::NewFrame );
+        callback();
+        overlay.end_phase( PerformanceOverlay::Phase::Update );
+        Thumbnails::get_instance().upload_textures(
+            MAX_UPLOAD_BYTES_PER_FRAME );
+        // Only builds the draw data, there is nothing to render it
+        {
+            TRACE_SPAN( "ImGui::Render" );
+            ImGui::Render();
+        }
+        overlay.end_phase( PerformanceOverlay::Phase::Render );
+        overlay.end_frame();
+        return;
+    }
+
     this->new_frame();
     this->clear();
+    overlay.end_phase( PerformanceOverlay::Phase::NewFrame );
 
     callback();
+    overlay.end_phase( PerformanceOverlay::Phase::Update );
+    // The thumbnails requested by this frame are showed from the next one
+    Thumbnails::get_instance().upload_textures( MAX_UPLOAD_BYTES_PER_FRAME );
 
     this->render();
+    overlay.end_phase( PerformanceOverlay::Phase::Render );
     // todo put this if define imguiviewport exist
     // if ( ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable )
     // {
@@ -43,17 +111,48 @@ void Window::update( std::function< void() > callback )
     //     ImGui::RenderPlatformWindowsDefault();
     //     glfwMakeContextCurrent( backup_current_context );
     // }
-    glfwSwapBuffers( m_window );
+    {
+        TRACE_SPAN( "glfwSwapBuffers" );
+        glfwSwapBuffers( m_window );
+    }
 
-    switch ( m_eventMode )
     {
-    case EventMode::Poll :
-        glfwPollEvents();
-        break;
-    case EventMode::Wait :
-        glfwWaitEvents();
-        break;
+        TRACE_SPAN( "Window::wait_events" );
+        switch ( m_eventMode )
+        {
+        case EventMode::Poll :
+            glfwPollEvents();
+            break;
+        case EventMode::Wait :
+            glfwWaitEvents();
+            break;
+        }
     }
+    overlay.end_phase( PerformanceOverlay::Phase::SwapAndWait );
+    overlay.end_frame();
+}
+
+bool Window::is_headless() const
+{
+    return m_window == nullptr;
+}
+
+void Window::record_input( fs::path const & file )
+{
+    m_inputRecording     = std::make_unique< InputRecording >();
+    m_inputRecordingFile = file;
+}
+
+void Window::replay_input( InputRecording::Frame const & frame )
+{
+    if ( ! this->is_headless() )
+    {
+        Trace::Error( "Only a headless window can replay the input" );
+        return;
+    }
+    m_headlessSize      = frame.displaySize;
+    m_replayedDeltaTime = frame.deltaTime;
+    InputRecording::queue_events( frame );
 }
 
 GLFWwindow * Window::get_backend()
@@ -63,6 +162,10 @@ GLFWwindow * Window::get_backend()
 
 ImVec2 Window::get_size() const
 {
+    if ( this->is_headless() )
+    {
+        return m_headlessSize;
+    }
     int width, height;
     glfwGetWindowSize( m_window, &width, &height );
     return ImVec2 { static_cast< float >( width ),
@@ -71,6 +174,10 @@ ImVec2 Window::get_size() const
 
 ImVec2 Window::get_display_scale() const
 {
+    if ( this->is_headless() )
+    {
+        return ImVec2 { 1.f, 1.f };
+    }
     float xscale, yscale;
     glfwGetWindowContentScale( m_window, &xscale, &yscale );
     return ImVec2 { xscale, yscale };
@@ -83,6 +190,7 @@ ImVec2 Window::get_display_size()
     if ( ! mode )
     {
         Trace::Error( "GLFW can't get video mode" );
+        return ImVec2 { 0.f, 0.f };
     }
 
     return ImVec2 { static_cast< float >( mode->width ),
@@ -113,7 +221,10 @@ void Window::set_event_mode( Window::EventMode eventMode )
 void Window::set_vsync( bool vsync )
 {
     m_vsync = vsync;
-    glfwSwapInterval( vsync ? 1 : 0 );
+    if ( ! this->is_headless() )
+    {
+        glfwSwapInterval( vsync ? 1 : 0 );
+    }
 }
 
 bool Window::get_vsync() const
@@ -125,7 +236,7 @@ namespace
 {
     void error_callback ( int error, const char * description )
     {
-        Trace::Error( fmt::format( "GLFW {}: {}\n", error, description ) );
+        Trace::Error( "GLFW {}: {}\n", error, description );
     }
 
     void window_size_callback ( GLFWwindow * /* window */, int width,
@@ -177,11 +288,10 @@ void Window::initialize_OpenGL() const
 
     glViewport( 0, 0, this->get_size().x, this->get_size().y );
 
-    Trace::Info( fmt::format(
+    Trace::Info(
         "OpenGL renderer: {}",
-        reinterpret_cast< const char * >( glGetString( GL_VERSION ) ) ) );
-    Trace::Info( fmt::format( "OpenGL version: {}.{}", GLVersion.major,
-                              GLVersion.minor ) );
+        reinterpret_cast< const char * >( glGetString( GL_VERSION ) ) );
+    Trace::Info( "OpenGL version: {}.{}", GLVersion.major, GLVersion.minor );
 }
 
 namespace
@@ -219,19 +329,25 @@ void Window::reset_imgui_style() const
     float uiScale =
         std::sqrt( this->get_display_scale().x * this->get_display_scale().y );
 
-    Trace::Info( fmt::format( "UI scale: {}", uiScale ) );
+    Trace::Info( "UI scale: {}", uiScale );
 
     ImGuiIO & io = ImGui::GetIO();
-    Trace::Info( fmt::format( "Current program path: {}",
-                              fs::current_path().string() ) );
-    Trace::Info(
-        fmt::format( "Executable path: {}", get_executable_dir().string() ) );
-    Trace::Info( fmt::format(
-        "Resources path: {}",
-        ( get_resources_dir() / "fonts/Inter-Regular.ttf" ).string() ) );
-    io.Fonts->AddFontFromFileTTF(
-        ( get_resources_dir() / "fonts/Inter-Regular.ttf" ).string().c_str(),
-        uiScale * 20.f );
+    Trace::Info( "Current program path: {}", fs::current_path().c_str() );
+    Trace::Info( "Executable path: {}", get_executable_dir().c_str() );
+    Trace::Info( "Resources path: {}",
+                 ( get_resources_dir() / "fonts/Inter-Regular.ttf" ).c_str() );
+    fs::path font { get_resources_dir() / "fonts/Inter-Regular.ttf" };
+    if ( fs::exists( font ) )
+    {
+        io.Fonts->AddFontFromFileTTF( font.string().c_str(), uiScale * 20.f );
+    }
+    else
+    {
+        // ImGui stops on a missing font file
+        Trace::Warning( "Can't find the font {}, the default one is used",
+                        font.c_str() );
+        io.Fonts->AddFontDefault();
+    }
 
     // io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
@@ -300,6 +416,25 @@ void Window::initialize_ImGui() const
     ImGui_ImplOpenGL3_Init( "#version 460" );
 }
 
+void Window::initialize_headless_ImGui() const
+{
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+
+    this->reset_imgui_style();
+
+    ImGuiIO & io = ImGui::GetIO();
+    // Each run starts from the same layout
+    io.IniFilename         = nullptr;
+    io.BackendRendererName = "null";
+    // As the OpenGL backend, so the draw lists are split the same way
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    // Built by the renderer backend otherwise
+    unsigned char * pixels;
+    int             width, height;
+    io.Fonts->GetTexDataAsRGBA32( &pixels, &width, &height );
+}
+
 void Window::terminate_SDL() const
 {
     glfwDestroyWindow( m_window );
@@ -315,8 +450,33 @@ void Window::terminate_ImGui() const
 
 void Window::new_frame()
 {
+    TRACE_SPAN( "Window::new_frame" );
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
+    // Once the backend has given all the events of the frame to ImGui
+    if ( m_inputRecording )
+    {
+        m_inputRecording->record_frame();
+    }
+    ImGui::NewFrame();
+}
+
+void Window::new_headless_frame()
+{
+    TRACE_SPAN( "Window::new_frame" );
+    auto now = std::chrono::steady_clock::now();
+
+    ImGuiIO & io   = ImGui::GetIO();
+    io.DisplaySize = m_headlessSize;
+    // ImGui needs some time between two frames. A replayed frame keeps the
+    // recorded one, so the double clicks and the key repeats are the same.
+    io.DeltaTime = std::max(
+        m_replayedDeltaTime.value_or(
+            std::chrono::duration< float > { now - m_lastFrame }.count() ),
+        1e-6f );
+    m_lastFrame         = now;
+    m_replayedDeltaTime = std::nullopt;
+
     ImGui::NewFrame();
 }
 
@@ -329,6 +489,7 @@ void Window::clear()
 
 void Window::render()
 {
+    TRACE_SPAN( "Window::render" );
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData( ImGui::GetDrawData() );
 }
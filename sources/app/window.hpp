@@ -1,7 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <optional>
 
 #define GLFW_INCLUDE_NONE
 #include <glad/glad.h>
@@ -10,6 +12,8 @@
 #include <GLFW/glfw3.h>
 #include <imgui/imgui.h>
 
+#include "app/input_recording.hpp"
+
 class Window
 {
   public:
@@ -20,12 +24,27 @@ class Window
     };
 
   private:
+    // nullptr when the window is headless
     GLFWwindow * m_window;
     EventMode    m_eventMode;
     bool         m_vsync;
 
+    // Display size of a headless window, and start of its previous frame
+    ImVec2                                m_headlessSize;
+    std::chrono::steady_clock::time_point m_lastFrame;
+    // Delta time of the next headless frame, given by a replayed frame
+    std::optional< float >                m_replayedDeltaTime;
+
+    // Saved in the file when the window is destroyed
+    std::unique_ptr< InputRecording > m_inputRecording;
+    fs::path                          m_inputRecordingFile;
+
   public:
     Window();
+    // Without GLFW nor OpenGL: the frames are built for a display of this
+    // size and never rendered, to measure them without GPU nor display
+    // server
+    explicit Window( ImVec2 headlessSize );
     virtual ~Window();
 
     Window( Window const & )              = delete;
@@ -33,6 +52,14 @@ class Window
 
     void update ( std::function< void() > callback );
 
+    bool is_headless () const;
+
+    // Record the input events of every frame from now on
+    void record_input ( fs::path const & file );
+    // Queue the events of a recorded frame for the next frame of a headless
+    // window, which takes its display size and delta time
+    void replay_input ( InputRecording::Frame const & frame );
+
     GLFWwindow *       get_backend ();
     GLFWwindow const * get_backend () const;
 
@@ -52,10 +79,12 @@ class Window
     void initialize_GLFW ();
     void initialize_OpenGL () const;
     void initialize_ImGui () const;
+    void initialize_headless_ImGui () const;
     void terminate_SDL () const;
     void terminate_ImGui () const;
 
-    static void new_frame ();
+    void        new_frame ();
+    void        new_headless_frame ();
     static void clear ();
     static void render ();
 };
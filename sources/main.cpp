@@ -1,9 +1,93 @@
+#include <charconv>     // for from_chars
+#include <cstdio>       // for stderr
+#include <optional>     // for optional
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include <fmt/format.h>  // for print
+
 #include "app/application.hpp"
+#include "app/memory_file_system.hpp"
+#include "app/snapshot.hpp"
+#include "app/snapshot_file_system.hpp"
 #include "tools/clock.hpp"
 
-int main ()
+namespace
+{
+    uint64_t to_number ( std::string_view argument )
+    {
+        uint64_t number { 0 };
+        std::from_chars( argument.data(), argument.data() + argument.size(),
+                         number );
+        return number;
+    }
+
+    int print_usage ( std::string_view program )
+    {
+        fmt::print( stderr,
+                    "Usage: {} [--memory <files by directory> | --snapshot "
+                    "<file>] [--record-input <file>]\n"
+                    "       {} --record <directory> <file> [--hash-names]\n",
+                    program, program );
+        return 1;
+    }
+}  // namespace
+
+// explorer [--memory <files by directory> | --snapshot <file>]
+//          [--record-input <file>]
+// explorer --record <directory> <file> [--hash-names]
+int main ( int argc, char ** argv )
 {
+    std::vector< std::string_view > arguments { argv + 1, argv + argc };
+    if ( ! arguments.empty() && arguments[0] == "--record" )
+    {
+        bool hashNames { arguments.size() == 4
+                         && arguments[3] == "--hash-names" };
+        if ( arguments.size() != 3 && ! hashNames )
+        {
+            return print_usage( argv[0] );
+        }
+        return snapshot::record( arguments[1], arguments[2], hashNames ) ? 0
+                                                                         : 1;
+    }
+
+    // The input of the session is replayed by replay_benchmark
+    std::optional< fs::path > inputRecording {};
+    for ( std::size_t idx = 0; idx < arguments.size(); idx += 2 )
+    {
+        // Every option is followed by its value
+        if ( idx + 1 == arguments.size() )
+        {
+            return print_usage( argv[0] );
+        }
+        if ( arguments[idx] == "--memory" )
+        {
+            // Its latencies are set in the settings
+            vfs::use_synthetic_home( to_number( arguments[idx + 1] ) );
+        }
+        else if ( arguments[idx] == "--snapshot" )
+        {
+            if ( ! vfs::use_snapshot_home( arguments[idx + 1] ) )
+            {
+                return 1;
+            }
+        }
+        else if ( arguments[idx] == "--record-input" )
+        {
+            inputRecording = arguments[idx + 1];
+        }
+        else
+        {
+            fmt::print( stderr, "Unknown option {}\n", arguments[idx] );
+            return print_usage( argv[0] );
+        }
+    }
+
     Application app;
+    if ( inputRecording.has_value() )
+    {
+        app.record_input( inputRecording.value() );
+    }
 
     while ( app.should_run() )
     {
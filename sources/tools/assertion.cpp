@@ -16,12 +16,12 @@ namespace too
     {
         if ( ! expression )
         {
-            Trace::Error( fmt::format(
-                "Assertion failed : {}\n"
-                "Expected : ({}) == true\n"
-                "Source : {}:{}\n"
-                "Function Call : {}\n",
-                message, expressionString, fileName, line, functionName ) );
+            Trace::Error( "Assertion failed : {}\n"
+                          "Expected : ({}) == true\n"
+                          "Source : {}:{}\n"
+                          "Function Call : {}\n",
+                          message, expressionString, fileName, line,
+                          functionName );
         }
     }
 }  // namespace too
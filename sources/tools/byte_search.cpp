@@ -0,0 +1,74 @@
+#include "byte_search.hpp"
+
+#include <bit>      // for countr_zero
+#include <cstring>  // for memchr, memcmp
+
+#ifdef __SSE2__
+    #include <emmintrin.h>  // for _mm_cmpeq_epi8, _mm_movemask_epi8
+#endif
+
+namespace byte_search
+{
+    std::size_t find ( unsigned char const * data, std::size_t size,
+                       unsigned char const * pattern, std::size_t patternSize )
+    {
+        if ( patternSize == 0 || patternSize > size )
+        {
+            return size;
+        }
+        if ( patternSize == 1 )
+        {
+            auto const * found = static_cast< unsigned char const * >(
+                std::memchr( data, pattern[0], size ) );
+            return found ? static_cast< std::size_t >( found - data ) : size;
+        }
+
+        std::size_t const last     = patternSize - 1;
+        std::size_t       position = 0;
+
+#ifdef __SSE2__
+        __m128i const first =
+            _mm_set1_epi8( static_cast< char >( pattern[0] ) );
+        __m128i const end =
+            _mm_set1_epi8( static_cast< char >( pattern[last] ) );
+        // Both blocks must stay in the data
+        for ( ; position + last + 16 <= size; position += 16 )
+        {
+            __m128i blockFirst = _mm_loadu_si128(
+                reinterpret_cast< __m128i const * >( data + position ) );
+            __m128i blockLast = _mm_loadu_si128(
+                reinterpret_cast< __m128i const * >( data + position + last ) );
+            // Candidates are the positions matching both ends of the pattern
+            auto mask = static_cast< unsigned int >(
+                _mm_movemask_epi8( _mm_and_si128(
+                    _mm_cmpeq_epi8( blockFirst, first ),
+                    _mm_cmpeq_epi8( blockLast, end ) ) ) );
+            while ( mask != 0 )
+            {
+                std::size_t candidate =
+                    position + static_cast< std::size_t >(
+                        std::countr_zero( mask ) );
+                if ( std::memcmp( data + candidate + 1, pattern + 1,
+                                  last - 1 )
+                     == 0 )
+                {
+                    return candidate;
+                }
+                mask &= mask - 1;
+            }
+        }
+#endif
+
+        for ( ; position + last < size; ++position )
+        {
+            if ( data[position] == pattern[0]
+                 && data[position + last] == pattern[last]
+                 && std::memcmp( data + position + 1, pattern + 1, last - 1 )
+                        == 0 )
+            {
+                return position;
+            }
+        }
+        return size;
+    }
+}  // namespace byte_search
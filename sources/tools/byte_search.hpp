@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>  // for size_t
+
+namespace byte_search
+{
+    // Position of the first occurrence of the pattern in the data, or the
+    // size if it's not found. The data is filtered 16 bytes at a time on the
+    // first and last bytes of the pattern before being compared.
+    std::size_t find ( unsigned char const * data, std::size_t size,
+                       unsigned char const * pattern, std::size_t patternSize );
+}  // namespace byte_search
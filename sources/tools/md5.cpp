@@ -0,0 +1,133 @@
+#include "md5.hpp"
+
+#include <algorithm>  // for copy
+#include <array>      // for array
+#include <bit>        // for rotl
+#include <cstdint>    // for uint32_t, uint64_t
+
+#include <fmt/format.h>  // for format
+
+namespace md5
+{
+    namespace
+    {
+        // RFC 1321
+        constexpr std::array< uint32_t, 64 > SINES {
+            0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf,
+            0x4787c62a, 0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af,
+            0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e,
+            0x49b40821, 0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+            0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8, 0x21e1cde6,
+            0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+            0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122,
+            0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+            0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039,
+            0xe6db99e5, 0x1fa27cf8, 0xc4ac5665, 0xf4292244, 0x432aff97,
+            0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d,
+            0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+            0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391 };
+        constexpr std::array< int, 16 > SHIFTS { 7, 12, 17, 22, 5, 9,  14, 20,
+                                                 4, 11, 16, 23, 6, 10, 15, 21 };
+
+        void process_block ( std::array< uint32_t, 4 > & state,
+                             unsigned char const *       block )
+        {
+            std::array< uint32_t, 16 > words {};
+            for ( std::size_t idx = 0; idx < words.size(); ++idx )
+            {
+                words[idx] = static_cast< uint32_t >( block[idx * 4] )
+                             | static_cast< uint32_t >( block[idx * 4 + 1] )
+                                   << 8
+                             | static_cast< uint32_t >( block[idx * 4 + 2] )
+                                   << 16
+                             | static_cast< uint32_t >( block[idx * 4 + 3] )
+                                   << 24;
+            }
+
+            uint32_t a = state[0];
+            uint32_t b = state[1];
+            uint32_t c = state[2];
+            uint32_t d = state[3];
+            for ( std::size_t round = 0; round < 64; ++round )
+            {
+                uint32_t    mixed   = 0;
+                std::size_t idxWord = 0;
+                switch ( round / 16 )
+                {
+                case 0 :
+                    mixed   = ( b & c ) | ( ~b & d );
+                    idxWord = round;
+                    break;
+                case 1 :
+                    mixed   = ( d & b ) | ( ~d & c );
+                    idxWord = ( 5 * round + 1 ) % 16;
+                    break;
+                case 2 :
+                    mixed   = b ^ c ^ d;
+                    idxWord = ( 3 * round + 5 ) % 16;
+                    break;
+                default :
+                    mixed   = c ^ ( b | ~d );
+                    idxWord = ( 7 * round ) % 16;
+                    break;
+                }
+                uint32_t rotated =
+                    b
+                    + std::rotl( a + mixed + SINES[round] + words[idxWord],
+                                 SHIFTS[round / 16 * 4 + round % 4] );
+                a = d;
+                d = c;
+                c = b;
+                b = rotated;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+        }
+    }  // namespace
+
+    std::string hex_digest ( std::string_view data )
+    {
+        std::array< uint32_t, 4 > state { 0x67452301, 0xefcdab89, 0x98badcfe,
+                                          0x10325476 };
+
+        auto const * bytes =
+            reinterpret_cast< unsigned char const * >( data.data() );
+        std::size_t idxBlock = 0;
+        for ( ; idxBlock + 64 <= data.size(); idxBlock += 64 )
+        {
+            process_block( state, bytes + idxBlock );
+        }
+
+        // The remaining bytes, a 1 bit, then the length in bits on the last
+        // 8 bytes of the padded block(s)
+        std::array< unsigned char, 128 > tail {};
+        std::size_t                      remaining = data.size() - idxBlock;
+        std::copy( bytes + idxBlock, bytes + data.size(), tail.begin() );
+        tail[remaining]      = 0x80;
+        std::size_t tailSize = remaining < 56 ? 64 : 128;
+        uint64_t    nbBits   = static_cast< uint64_t >( data.size() ) * 8;
+        for ( std::size_t idx = 0; idx < 8; ++idx )
+        {
+            tail[tailSize - 8 + idx] =
+                static_cast< unsigned char >( nbBits >> ( 8 * idx ) );
+        }
+        for ( std::size_t idx = 0; idx < tailSize; idx += 64 )
+        {
+            process_block( state, tail.data() + idx );
+        }
+
+        std::string digest {};
+        digest.reserve( 32 );
+        for ( uint32_t word : state )
+        {
+            for ( std::size_t idx = 0; idx < 4; ++idx )
+            {
+                digest +=
+                    fmt::format( "{:02x}", ( word >> ( 8 * idx ) ) & 0xff );
+            }
+        }
+        return digest;
+    }
+}  // namespace md5
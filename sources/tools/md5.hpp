@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+namespace md5
+{
+    // Lowercase hexadecimal digest of the data, as used by the freedesktop
+    // thumbnail cache. Not meant for anything security related.
+    std::string hex_digest ( std::string_view data );
+}  // namespace md5
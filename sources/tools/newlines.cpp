@@ -0,0 +1,53 @@
+#include "newlines.hpp"
+
+#include <bit>  // for popcount, countr_zero
+
+#ifdef __SSE2__
+    #include <emmintrin.h>  // for _mm_cmpeq_epi8, _mm_movemask_epi8
+#endif
+
+namespace newlines
+{
+    Match find_nth ( char const * data, std::size_t size, std::size_t nth )
+    {
+        std::size_t count    = 0;
+        std::size_t position = 0;
+        if ( nth == 0 )
+        {
+            return Match { size, 0 };
+        }
+
+#ifdef __SSE2__
+        __m128i const newline = _mm_set1_epi8( '\n' );
+        for ( ; position + 16 <= size; position += 16 )
+        {
+            __m128i block = _mm_loadu_si128(
+                reinterpret_cast< __m128i const * >( data + position ) );
+            auto mask = static_cast< unsigned int >(
+                _mm_movemask_epi8( _mm_cmpeq_epi8( block, newline ) ) );
+            auto nbNewlines =
+                static_cast< std::size_t >( std::popcount( mask ) );
+            if ( count + nbNewlines < nth )
+            {
+                count += nbNewlines;
+                continue;
+            }
+            // The searched newline is in this block, skip the ones before it
+            for ( ; count + 1 < nth; ++count )
+            {
+                mask &= mask - 1;
+            }
+            return Match { position + std::countr_zero( mask ), nth };
+        }
+#endif
+
+        for ( ; position < size; ++position )
+        {
+            if ( data[position] == '\n' && ++count == nth )
+            {
+                return Match { position, nth };
+            }
+        }
+        return Match { size, count };
+    }
+}  // namespace newlines
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>  // for size_t
+
+namespace newlines
+{
+    struct Match
+    {
+        // Position of the newline found, or the size if it's not found
+        std::size_t position;
+        // Number of newlines found, until the one searched included
+        std::size_t count;
+    };
+
+    // Find the nth newline (starting from 1) of the data, 16 bytes at a time
+    Match find_nth ( char const * data, std::size_t size, std::size_t nth );
+}  // namespace newlines
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>        // for array
+#include <bit>          // for bit_width
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint32_t
+#include <stdexcept>    // for logic_error
+#include <string_view>  // for string_view
+
+namespace perfect_hash
+{
+    // FNV-1a, the seed changes the whole sequence of hashes
+    constexpr uint32_t hash ( std::string_view key, uint32_t seed )
+    {
+        uint32_t value = 2166136261u ^ ( seed * 16777619u );
+        for ( char character : key )
+        {
+            value ^= static_cast< unsigned char >( character );
+            value *= 16777619u;
+        }
+        return value;
+    }
+
+    template< typename Value >
+    struct Entry
+    {
+        std::string_view key;
+        Value            value;
+    };
+
+    // Immutable map built at compile time without collisions ("hash and
+    // displace"): keys are spread in buckets with a first hash, then each
+    // bucket gets the seed of a second hash that sends all its keys to free
+    // slots. A lookup costs two hashes and one key comparison.
+    template< typename Value, std::size_t NbKeys >
+    class Map
+    {
+        static constexpr std::size_t NB_BUCKETS { NbKeys / 2 + 1 };
+        // Power of two at least twice the number of keys
+        static constexpr std::size_t TABLE_SIZE {
+            std::size_t { 1 } << std::bit_width( NbKeys * 2 - 1 ) };
+        static constexpr uint32_t EMPTY_SLOT { UINT32_MAX };
+
+        std::array< Entry< Value >, NbKeys > m_entries;
+        std::array< uint32_t, NB_BUCKETS >   m_seeds;
+        // Index in m_entries of the key stored in the slot
+        std::array< uint32_t, TABLE_SIZE >   m_slots;
+
+      public:
+        consteval explicit Map(
+            std::array< Entry< Value >, NbKeys > const & entries );
+
+        constexpr Value const * find ( std::string_view key ) const;
+
+        constexpr std::size_t size () const { return NbKeys; }
+
+        constexpr std::size_t get_table_size () const { return TABLE_SIZE; }
+
+      private:
+        static constexpr std::size_t get_bucket ( std::string_view key );
+        static constexpr std::size_t get_slot ( std::string_view key,
+                                                uint32_t         seed );
+    };
+
+    template< typename Value, std::size_t NbKeys >
+    consteval Map< Value, NbKeys >::Map(
+        std::array< Entry< Value >, NbKeys > const & entries )
+      : m_entries { entries }, m_seeds {}, m_slots {}
+    {
+        m_slots.fill( EMPTY_SLOT );
+
+        std::array< std::size_t, NB_BUCKETS > bucketSizes {};
+        std::size_t                           maxBucketSize = 0;
+        for ( Entry< Value > const & entry : m_entries )
+        {
+            std::size_t size = ++bucketSizes[get_bucket( entry.key )];
+            maxBucketSize    = size > maxBucketSize ? size : maxBucketSize;
+        }
+
+        // Place the biggest buckets first, while most slots are still free
+        for ( std::size_t size = maxBucketSize; size > 0; --size )
+        {
+            for ( std::size_t bucket = 0; bucket < NB_BUCKETS; ++bucket )
+            {
+                if ( bucketSizes[bucket] != size )
+                {
+                    continue;
+                }
+
+                std::array< std::size_t, NbKeys > slots {};
+                for ( uint32_t seed = 1;; ++seed )
+                {
+                    if ( seed == 100'000 )
+                    {
+                        throw std::logic_error( "Duplicated key" );
+                    }
+
+                    std::size_t nbPlaced = 0;
+                    for ( std::size_t idx = 0; idx < NbKeys; ++idx )
+                    {
+                        if ( get_bucket( m_entries[idx].key ) != bucket )
+                        {
+                            continue;
+                        }
+
+                        std::size_t slot = get_slot( m_entries[idx].key, seed );
+                        bool        isFree = m_slots[slot] == EMPTY_SLOT;
+                        for ( std::size_t placed = 0; placed < nbPlaced;
+                              ++placed )
+                        {
+                            isFree = isFree && slots[placed] != slot;
+                        }
+                        if ( ! isFree )
+                        {
+                            break;
+                        }
+                        slots[nbPlaced++] = slot;
+                    }
+                    if ( nbPlaced != size )
+                    {
+                        continue;
+                    }
+
+                    // Every key of the bucket has a free slot with this seed
+                    m_seeds[bucket] = seed;
+                    std::size_t placed = 0;
+                    for ( std::size_t idx = 0; idx < NbKeys; ++idx )
+                    {
+                        if ( get_bucket( m_entries[idx].key ) == bucket )
+                        {
+                            m_slots[slots[placed++]] =
+                                static_cast< uint32_t >( idx );
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    template< typename Value, std::size_t NbKeys >
+    constexpr Value const * Map< Value, NbKeys >::find(
+        std::string_view key ) const
+    {
+        uint32_t index = m_slots[get_slot( key, m_seeds[get_bucket( key )] )];
+        if ( index == EMPTY_SLOT || m_entries[index].key != key )
+        {
+            return nullptr;
+        }
+        return &m_entries[index].value;
+    }
+
+    template< typename Value, std::size_t NbKeys >
+    constexpr std::size_t Map< Value, NbKeys >::get_bucket(
+        std::string_view key )
+    {
+        return hash( key, 0 ) % NB_BUCKETS;
+    }
+
+    template< typename Value, std::size_t NbKeys >
+    constexpr std::size_t Map< Value, NbKeys >::get_slot( std::string_view key,
+                                                          uint32_t seed )
+    {
+        return hash( key, seed ) & ( TABLE_SIZE - 1 );
+    }
+}  // namespace perfect_hash
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>  // for size_t
+#include <vector>   // for vector
+
+// Fixed capacity container, pushing an element when it's full overwrites the
+// oldest one without moving the others
+template< typename T >
+class RingBuffer
+{
+    std::vector< T > m_data;
+    // Index of the oldest element in m_data
+    std::size_t      m_first;
+    std::size_t      m_size;
+
+  public:
+    explicit RingBuffer( std::size_t capacity );
+    virtual ~RingBuffer() = default;
+
+    std::size_t get_capacity () const;
+    // Keep the newest elements if the capacity is reduced
+    void        set_capacity ( std::size_t capacity );
+
+    std::size_t size () const;
+    bool        empty () const;
+
+    void      push_back ( T value );
+    void      pop_back ();
+    T &       back ();
+    T const & back () const;
+    void      clear ();
+
+    // Index 0 is the oldest element
+    T const & operator[] ( std::size_t index ) const;
+
+  private:
+    std::size_t get_data_index ( std::size_t index ) const;
+};
+
+#include "ring_buffer_impl.hpp"
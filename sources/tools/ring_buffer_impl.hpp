@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>  // for min
+#include <utility>    // for move
+
+#include "ring_buffer.hpp"
+
+template< typename T >
+RingBuffer< T >::RingBuffer( std::size_t capacity )
+  : m_data( capacity ), m_first { 0 }, m_size { 0 }
+{}
+
+template< typename T >
+std::size_t RingBuffer< T >::get_capacity() const
+{
+    return m_data.size();
+}
+
+template< typename T >
+void RingBuffer< T >::set_capacity( std::size_t capacity )
+{
+    if ( capacity == this->get_capacity() )
+    {
+        return;
+    }
+
+    std::vector< T > data( capacity );
+    std::size_t      nbKept = std::min( m_size, capacity );
+    for ( std::size_t index = 0; index < nbKept; ++index )
+    {
+        data[index] =
+            std::move( m_data[this->get_data_index( m_size - nbKept + index )] );
+    }
+
+    m_data  = std::move( data );
+    m_first = 0;
+    m_size  = nbKept;
+}
+
+template< typename T >
+std::size_t RingBuffer< T >::size() const
+{
+    return m_size;
+}
+
+template< typename T >
+bool RingBuffer< T >::empty() const
+{
+    return m_size == 0;
+}
+
+template< typename T >
+void RingBuffer< T >::push_back( T value )
+{
+    if ( m_data.empty() )
+    {
+        return;
+    }
+
+    if ( m_size < m_data.size() )
+    {
+        m_data[this->get_data_index( m_size )] = std::move( value );
+        ++m_size;
+    }
+    else
+    {
+        // Overwrite the oldest element
+        m_data[m_first] = std::move( value );
+        m_first         = ( m_first + 1 ) % m_data.size();
+    }
+}
+
+template< typename T >
+void RingBuffer< T >::pop_back()
+{
+    if ( m_size == 0 )
+    {
+        return;
+    }
+
+    // Release the resources held by the element
+    m_data[this->get_data_index( m_size - 1 )] = T {};
+    --m_size;
+}
+
+template< typename T >
+T & RingBuffer< T >::back()
+{
+    return m_data[this->get_data_index( m_size - 1 )];
+}
+
+template< typename T >
+T const & RingBuffer< T >::back() const
+{
+    return m_data[this->get_data_index( m_size - 1 )];
+}
+
+template< typename T >
+void RingBuffer< T >::clear()
+{
+    while ( ! this->empty() )
+    {
+        this->pop_back();
+    }
+    m_first = 0;
+}
+
+template< typename T >
+T const & RingBuffer< T >::operator[]( std::size_t index ) const
+{
+    return m_data[this->get_data_index( index )];
+}
+
+template< typename T >
+std::size_t RingBuffer< T >::get_data_index( std::size_t index ) const
+{
+    return ( m_first + index ) % m_data.size();
+}
@@ -1,39 +1,286 @@
 #include "traces.hpp"
 
-#include <iostream>
+#include <algorithm>  // for min
+#include <atomic>     // for atomic
+#include <cstdio>     // for fwrite, fflush, stdout
+#include <cstdlib>    // for atexit
+#include <memory>     // for unique_ptr, make_unique
+#include <thread>     // for jthread, yield
 
-namespace Trace
+namespace
 {
-    void Error ( std::string const & message )
+    std::string_view get_prefix ( Trace::Level level )
+    {
+        switch ( level )
+        {
+        case Trace::Level::Debug :
+            return "[DEBUG]         ";
+        case Trace::Level::Info :
+            return "[INFO]          ";
+        case Trace::Level::Warning :
+            return "[WARNING]       ";
+        case Trace::Level::Error :
+            return "[ERROR]         ";
+        }
+        return "";
+    }
+
+    void append_line ( std::string & output, Trace::Level level,
+                       std::string_view message )
     {
-        std::cout << "[ERROR]         " << message << std::endl;
+        output.append( get_prefix( level ) );
+        output.append( message );
+        output.push_back( '\n' );
     }
 
-    void Warning ( std::string const & message )
+    // Without the writer thread
+    void write_line ( Trace::Level level, std::string_view message )
+    {
+        std::string line {};
+        append_line( line, level, message );
+        std::fwrite( line.data(), 1, line.size(), stdout );
+        std::fflush( stdout );
+    }
+
+    // Set once the writer thread has stopped at exit, the messages of the
+    // static destructors which follow are written directly
+    std::atomic< bool > isShutDown { false };
+
+    // Bounded queue of preallocated records, pushed by any thread and popped
+    // by the writer thread. Each record has a sequence number telling whether
+    // it waits to be written or to be reused, so no lock is taken. It's never
+    // destroyed, as the detached threads may still log during the exit.
+    class Logger
+    {
+        struct Record
+        {
+            std::atomic< std::size_t > sequence;
+            Trace::Level               level;
+            std::size_t                size;
+            char                       text[Trace::MAX_MESSAGE_SIZE];
+        };
+
+        std::unique_ptr< Record[] > m_records;
+        std::atomic< std::size_t >  m_pushIndex;
+        // Only used by the writer thread
+        std::size_t                 m_popIndex;
+        std::size_t                 m_nbReportedDrops;
+        // Pushed but not written yet, the writer thread sleeps on it
+        std::atomic< std::size_t >  m_nbQueued;
+        std::atomic< std::size_t >  m_nbDropped;
+        std::atomic< bool >         m_isStopping;
+        std::jthread                m_writer;
+
+      public:
+        Logger()
+          : m_records {
+              std::make_unique< Record[] >( Trace::QUEUE_CAPACITY ) },
+            m_pushIndex { 0 },
+            m_popIndex { 0 },
+            m_nbReportedDrops { 0 },
+            m_nbQueued { 0 },
+            m_nbDropped { 0 },
+            m_isStopping { false },
+            m_writer {}
+        {
+            for ( std::size_t idx = 0; idx < Trace::QUEUE_CAPACITY; ++idx )
+            {
+                m_records[idx].sequence.store( idx );
+            }
+            m_writer = std::jthread { [this] () { this->run(); } };
+        }
+
+        Logger( Logger const & )              = delete;
+        Logger & operator= ( Logger const & ) = delete;
+
+        // Called at exit, the messages pushed after are lost
+        void stop ()
+        {
+            isShutDown.store( true );
+            m_isStopping.store( true );
+            // Wake the writer, which writes what remains before stopping
+            m_nbQueued.fetch_add( 1 );
+            m_nbQueued.notify_one();
+            m_writer.join();
+        }
+
+        void write ( Trace::Level level, std::string_view message )
+        {
+            // The errors aren't dropped, they wait for the writer
+            while ( ! this->push( level, message ) )
+            {
+                if ( level != Trace::Level::Error )
+                {
+                    m_nbDropped.fetch_add( 1, std::memory_order_relaxed );
+                    return;
+                }
+                if ( m_isStopping.load() )
+                {
+                    write_line( level, message );
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            if ( m_nbQueued.fetch_add( 1 ) == 0 )
+            {
+                m_nbQueued.notify_one();
+            }
+        }
+
+        std::size_t get_nb_dropped () const
+        {
+            return m_nbDropped.load( std::memory_order_relaxed );
+        }
+
+      private:
+        // Return false if the queue is full
+        bool push ( Trace::Level level, std::string_view message )
+        {
+            std::size_t index = m_pushIndex.load( std::memory_order_relaxed );
+            Record *    record { nullptr };
+            while ( true )
+            {
+                record = &m_records[index % Trace::QUEUE_CAPACITY];
+                std::size_t sequence =
+                    record->sequence.load( std::memory_order_acquire );
+                if ( sequence == index )
+                {
+                    if ( m_pushIndex.compare_exchange_weak(
+                             index, index + 1, std::memory_order_relaxed ) )
+                    {
+                        break;
+                    }
+                }
+                else if ( sequence < index )
+                {
+                    // Not written since the previous round
+                    return false;
+                }
+                else
+                {
+                    index = m_pushIndex.load( std::memory_order_relaxed );
+                }
+            }
+
+            record->level = level;
+            record->size  = std::min( message.size(), Trace::MAX_MESSAGE_SIZE );
+            message.copy( record->text, record->size );
+            record->sequence.store( index + 1, std::memory_order_release );
+            return true;
+        }
+
+        // Return false if the next record isn't pushed yet
+        bool pop ( std::string & output )
+        {
+            Record & record = m_records[m_popIndex % Trace::QUEUE_CAPACITY];
+            if ( record.sequence.load( std::memory_order_acquire )
+                 != m_popIndex + 1 )
+            {
+                return false;
+            }
+
+            append_line( output, record.level,
+                         std::string_view { record.text, record.size } );
+            record.sequence.store( m_popIndex + Trace::QUEUE_CAPACITY,
+                                   std::memory_order_release );
+            ++m_popIndex;
+            return true;
+        }
+
+        void run ()
+        {
+            std::string batch {};
+            batch.reserve( Trace::QUEUE_CAPACITY * 128 );
+            while ( true )
+            {
+                std::size_t nbPopped { 0 };
+                while ( nbPopped < Trace::QUEUE_CAPACITY && this->pop( batch ) )
+                {
+                    ++nbPopped;
+                }
+
+                std::size_t nbDropped = this->get_nb_dropped();
+                if ( nbDropped != m_nbReportedDrops )
+                {
+                    append_line( batch, Trace::Level::Warning,
+                                 fmt::format( "{} messages dropped, the log "
+                                              "queue was full",
+                                              nbDropped - m_nbReportedDrops ) );
+                    m_nbReportedDrops = nbDropped;
+                }
+
+                // A single write for the whole batch
+                if ( ! batch.empty() )
+                {
+                    std::fwrite( batch.data(), 1, batch.size(), stdout );
+                    std::fflush( stdout );
+                    batch.clear();
+                }
+
+                if ( nbPopped > 0 )
+                {
+                    m_nbQueued.fetch_sub( nbPopped );
+                    continue;
+                }
+                if ( m_isStopping.load() )
+                {
+                    return;
+                }
+                if ( m_nbQueued.load() > 0 )
+                {
+                    // A message is being pushed before the queued ones
+                    std::this_thread::yield();
+                    continue;
+                }
+                m_nbQueued.wait( 0 );
+            }
+        }
+    };
+
+    Logger & get_logger ()
+    {
+        static Logger * logger = [] () {
+            auto * created = new Logger {};
+            // Run before the destructors of the statics constructed earlier,
+            // whose messages are then written directly
+            std::atexit( [] () { get_logger().stop(); } );
+            return created;
+        }();
+        return *logger;
+    }
+}  // namespace
+
+namespace Trace
+{
+    void write ( Level level, std::string_view message )
     {
-        std::cout << "[WARNING]       " << message << std::endl;
+        if ( isShutDown.load( std::memory_order_relaxed ) )
+        {
+            write_line( level, message );
+            return;
+        }
+        get_logger().write( level, message );
     }
 
-    void Info ( std::string const & message )
+    char * get_thread_buffer ()
     {
-        std::cout << "[INFO]          " << message << std::endl;
+        thread_local char buffer[MAX_MESSAGE_SIZE];
+        return buffer;
     }
 
-    void Debug ( std::string const & message )
+    std::size_t get_nb_dropped ()
     {
-        std::cout << "[DEBUG]         " << message << std::endl;
+        return get_logger().get_nb_dropped();
     }
 
     void FileNotFound ( std::string const & filePath,
                         std::string const & message )
     {
-        std::cout << "[FILE NOT FOUND] (" << filePath << ") " << message
-                  << std::endl;
+        Trace::Error( "File not found ({}) {}", filePath, message );
     }
 
     void FileIssue ( std::string const & filePath, std::string const & message )
     {
-        std::cout << "[FILE ISSUE]     (" << filePath << ") - " << message
-                  << std::endl;
+        Trace::Error( "File issue ({}) - {}", filePath, message );
     }
 }  // namespace Trace
@@ -1,13 +1,127 @@
 #pragma once
 
-#include <string>
+#include <cstddef>      // for size_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <utility>      // for forward
 
+#include <fmt/format.h>  // for format_string, format_to_n
+
+// The messages of a level below TRACE_MIN_LEVEL are removed at compile time:
+// 0 keeps them all, 1 removes Debug, 2 removes Info...
+#ifndef TRACE_MIN_LEVEL
+#    ifdef NDEBUG
+#        define TRACE_MIN_LEVEL 1
+#    else
+#        define TRACE_MIN_LEVEL 0
+#    endif
+#endif
+
+// The messages are written to the standard output by a background thread, so
+// logging from the UI thread never waits for the terminal. They are formatted
+// in a buffer of the calling thread, then copied in a preallocated queue.
+// When the queue is full, the messages are dropped and counted, except the
+// errors which wait for a place.
 namespace Trace
 {
-    void Error ( std::string const & message = "" );
-    void Warning ( std::string const & message = "" );
-    void Info ( std::string const & message = "" );
-    void Debug ( std::string const & message = "" );
+    enum class Level
+    {
+        Debug = 0,
+        Info,
+        Warning,
+        Error
+    };
+
+    constexpr Level MIN_LEVEL { static_cast< Level >( TRACE_MIN_LEVEL ) };
+    // Messages waiting for the writer thread
+    constexpr std::size_t QUEUE_CAPACITY { 1024 };
+    // Longer messages are truncated
+    constexpr std::size_t MAX_MESSAGE_SIZE { 1024 };
+
+    void   write ( Level level, std::string_view message );
+    // Of MAX_MESSAGE_SIZE, owned by the calling thread
+    char * get_thread_buffer ();
+
+    // Number of messages dropped because the queue was full
+    std::size_t get_nb_dropped ();
+
+    template< Level level, typename... Args >
+    void write_format ( fmt::format_string< Args... > format, Args &&... args )
+    {
+        if constexpr ( level >= MIN_LEVEL )
+        {
+            char * buffer = Trace::get_thread_buffer();
+            auto   result = fmt::format_to_n( buffer, MAX_MESSAGE_SIZE, format,
+                                              std::forward< Args >( args )... );
+            Trace::write( level,
+                          std::string_view {
+                              buffer, static_cast< std::size_t >(
+                                          result.out - buffer ) } );
+        }
+    }
+
+    inline void Error ( std::string_view message = "" )
+    {
+        if constexpr ( Level::Error >= MIN_LEVEL )
+        {
+            Trace::write( Level::Error, message );
+        }
+    }
+    inline void Warning ( std::string_view message = "" )
+    {
+        if constexpr ( Level::Warning >= MIN_LEVEL )
+        {
+            Trace::write( Level::Warning, message );
+        }
+    }
+    inline void Info ( std::string_view message = "" )
+    {
+        if constexpr ( Level::Info >= MIN_LEVEL )
+        {
+            Trace::write( Level::Info, message );
+        }
+    }
+    inline void Debug ( std::string_view message = "" )
+    {
+        if constexpr ( Level::Debug >= MIN_LEVEL )
+        {
+            Trace::write( Level::Debug, message );
+        }
+    }
+
+    // Formatted in the buffer of the thread, without allocation
+    template< typename Arg, typename... Args >
+    void Error ( fmt::format_string< Arg, Args... > format, Arg && arg,
+                 Args &&... args )
+    {
+        Trace::write_format< Level::Error, Arg, Args... >(
+            format, std::forward< Arg >( arg ),
+            std::forward< Args >( args )... );
+    }
+    template< typename Arg, typename... Args >
+    void Warning ( fmt::format_string< Arg, Args... > format, Arg && arg,
+                   Args &&... args )
+    {
+        Trace::write_format< Level::Warning, Arg, Args... >(
+            format, std::forward< Arg >( arg ),
+            std::forward< Args >( args )... );
+    }
+    template< typename Arg, typename... Args >
+    void Info ( fmt::format_string< Arg, Args... > format, Arg && arg,
+                Args &&... args )
+    {
+        Trace::write_format< Level::Info, Arg, Args... >(
+            format, std::forward< Arg >( arg ),
+            std::forward< Args >( args )... );
+    }
+    template< typename Arg, typename... Args >
+    void Debug ( fmt::format_string< Arg, Args... > format, Arg && arg,
+                 Args &&... args )
+    {
+        Trace::write_format< Level::Debug, Arg, Args... >(
+            format, std::forward< Arg >( arg ),
+            std::forward< Args >( args )... );
+    }
 
     void FileNotFound ( std::string const & filePath,
                         std::string const & message = "" );
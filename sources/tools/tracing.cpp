@@ -0,0 +1,197 @@
+#include "tracing.hpp"
+
+#include <algorithm>  // for find_if, max
+#include <chrono>     // for steady_clock, nanoseconds
+#include <fstream>    // for ofstream
+
+#include <fmt/format.h>  // for format
+#include <unistd.h>      // for getpid, gettid
+
+#include "tools/traces.hpp"  // for Trace
+
+struct Tracing::ThreadHandle
+{
+    std::shared_ptr< ThreadBuffer > buffer;
+
+    ~ThreadHandle()
+    {
+        if ( buffer )
+        {
+            buffer->isFinished.store( true );
+        }
+    }
+};
+
+Tracing::Span::Span( char const * name )
+  : m_name { name }, m_start { Tracing::get_time() }
+{}
+
+Tracing::Span::~Span()
+{
+    Tracing::get_instance().record( m_name, m_start, Tracing::get_time() );
+}
+
+Tracing::Tracing() : m_mutex {}, m_buffers {} {}
+
+uint64_t Tracing::get_time()
+{
+    return static_cast< uint64_t >(
+        std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::steady_clock::now().time_since_epoch() )
+            .count() );
+}
+
+bool Tracing::export_chrome_trace( std::filesystem::path const & file )
+{
+    std::vector< std::shared_ptr< ThreadBuffer > > buffers {};
+    {
+        std::lock_guard< std::mutex > lock { m_mutex };
+        buffers = m_buffers;
+    }
+
+    std::vector< std::pair< pid_t, std::vector< Event > > > threads {};
+    uint64_t origin { UINT64_MAX };
+    for ( std::shared_ptr< ThreadBuffer > const & buffer : buffers )
+    {
+        threads.emplace_back( buffer->threadId, Tracing::read( *buffer ) );
+        for ( Event const & event : threads.back().second )
+        {
+            origin = std::min( origin, event.start );
+        }
+    }
+
+    std::ofstream output { file };
+    output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool isFirst { true };
+    int  processId { getpid() };
+    for ( auto const & [threadId, events] : threads )
+    {
+        for ( Event const & event : events )
+        {
+            // The names are literals of the code, without characters to
+            // escape. The times are in microseconds.
+            output << fmt::format(
+                "{}\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":{},\"tid\":{},"
+                "\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                isFirst ? "" : ",", event.name, processId, threadId,
+                static_cast< double >( event.start - origin ) / 1e3,
+                static_cast< double >( event.end - event.start ) / 1e3 );
+            isFirst = false;
+        }
+    }
+    output << "\n]}\n";
+
+    output.close();
+    if ( ! output )
+    {
+        Trace::Error( "Can't write the trace {}", file.c_str() );
+        return false;
+    }
+    Trace::Info( "Trace of {} threads written in {}", threads.size(),
+                 file.c_str() );
+    return true;
+}
+
+void Tracing::clear()
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    for ( std::shared_ptr< ThreadBuffer > const & buffer : m_buffers )
+    {
+        buffer->nbCleared.store( buffer->nbWritten.load() );
+    }
+}
+
+Tracing::Statistics Tracing::get_statistics()
+{
+    std::lock_guard< std::mutex > lock { m_mutex };
+    Statistics                    statistics { m_buffers.size(), 0, 0 };
+    for ( std::shared_ptr< ThreadBuffer > const & buffer : m_buffers )
+    {
+        uint64_t nbSpans =
+            buffer->nbWritten.load() - buffer->nbCleared.load();
+        statistics.nbSpans += nbSpans;
+        statistics.nbLost += nbSpans > CAPACITY ? nbSpans - CAPACITY : 0;
+    }
+    return statistics;
+}
+
+void Tracing::record( char const * name, uint64_t start, uint64_t end )
+{
+    ThreadBuffer & buffer = this->get_thread_buffer();
+
+    // Only this thread writes the counters
+    uint64_t index = buffer.nbWritten.load( std::memory_order_relaxed );
+    buffer.nbStarted.store( index + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    Record & record = buffer.records[index % CAPACITY];
+    record.name.store( name, std::memory_order_relaxed );
+    record.start.store( start, std::memory_order_relaxed );
+    record.end.store( end, std::memory_order_relaxed );
+
+    buffer.nbWritten.store( index + 1, std::memory_order_release );
+}
+
+Tracing::ThreadBuffer & Tracing::get_thread_buffer()
+{
+    thread_local ThreadHandle handle {};
+    if ( handle.buffer )
+    {
+        return *handle.buffer;
+    }
+
+    handle.buffer           = std::make_shared< ThreadBuffer >();
+    handle.buffer->threadId = gettid();
+    handle.buffer->records  = std::make_unique< Record[] >( CAPACITY );
+
+    std::lock_guard< std::mutex > lock { m_mutex };
+    // The threads of the file operations come and go, only the last ones
+    // are kept
+    std::size_t nbFinished = static_cast< std::size_t >( std::count_if(
+        m_buffers.begin(), m_buffers.end(),
+        [] ( std::shared_ptr< ThreadBuffer > const & buffer ) {
+            return buffer->isFinished.load();
+        } ) );
+    if ( nbFinished >= MAX_FINISHED_THREADS )
+    {
+        m_buffers.erase( std::find_if(
+            m_buffers.begin(), m_buffers.end(),
+            [] ( std::shared_ptr< ThreadBuffer > const & buffer ) {
+                return buffer->isFinished.load();
+            } ) );
+    }
+    m_buffers.push_back( handle.buffer );
+    return *handle.buffer;
+}
+
+std::vector< Tracing::Event > Tracing::read( ThreadBuffer const & buffer )
+{
+    uint64_t nbWritten = buffer.nbWritten.load( std::memory_order_acquire );
+    uint64_t first     = std::max( buffer.nbCleared.load(),
+                                   nbWritten > CAPACITY ? nbWritten - CAPACITY
+                                                        : 0 );
+
+    std::vector< Event > events {};
+    events.reserve( nbWritten - std::min( first, nbWritten ) );
+    for ( uint64_t index = first; index < nbWritten; ++index )
+    {
+        Record const & record = buffer.records[index % CAPACITY];
+        events.push_back( { record.name.load( std::memory_order_relaxed ),
+                            record.start.load( std::memory_order_relaxed ),
+                            record.end.load( std::memory_order_relaxed ) } );
+    }
+
+    // The spans overwritten while they were copied are dropped
+    std::atomic_thread_fence( std::memory_order_acquire );
+    uint64_t nbStarted = buffer.nbStarted.load( std::memory_order_relaxed );
+    if ( nbStarted > CAPACITY && nbStarted - CAPACITY > first )
+    {
+        uint64_t nbOverwritten =
+            std::min( nbStarted - CAPACITY - first,
+                      static_cast< uint64_t >( events.size() ) );
+        events.erase( events.begin(),
+                      events.begin()
+                          + static_cast< std::ptrdiff_t >( nbOverwritten ) );
+    }
+    return events;
+}
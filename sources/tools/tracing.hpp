@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>      // for atomic
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint64_t
+#include <filesystem>  // for path
+#include <memory>      // for shared_ptr, unique_ptr
+#include <mutex>       // for mutex
+#include <vector>      // for vector
+
+#include <sys/types.h>  // for pid_t
+
+#include "tools/singleton.hpp"
+
+// Record the time spent until the end of the scope. The name must outlive
+// the program, as a string literal.
+#ifndef NDEBUG
+#    define TRACE_SPAN_CONCATENATE( prefix, line ) prefix##line
+#    define TRACE_SPAN_VARIABLE( line ) \
+        TRACE_SPAN_CONCATENATE( traceSpan, line )
+#    define TRACE_SPAN( name ) \
+        Tracing::Span TRACE_SPAN_VARIABLE( __LINE__ ) { name }
+#else
+#    define TRACE_SPAN( name )
+#endif
+
+// Spans of the work of every thread, to see in a trace viewer where the time
+// of a frame goes. Each thread writes its spans in its own ring buffer
+// without lock, the newest replacing the oldest, and the buffers are only
+// read to export them. The spans are removed from the release builds, as
+// the assertions.
+class Tracing : public Singleton< Tracing >
+{
+    ENABLE_SINGLETON( Tracing );
+
+  public:
+    // Spans kept by thread
+    static constexpr std::size_t CAPACITY { 1 << 14 };
+    // Buffers of the threads which are done, kept for the export
+    static constexpr std::size_t MAX_FINISHED_THREADS { 16 };
+
+    class Span
+    {
+        char const * m_name;
+        uint64_t     m_start;
+
+      public:
+        explicit Span( char const * name );
+        ~Span();
+
+        Span( Span const & )              = delete;
+        Span & operator= ( Span const & ) = delete;
+    };
+
+    struct Statistics
+    {
+        std::size_t nbThreads;
+        // Since the last clear
+        uint64_t    nbSpans;
+        // Replaced by newer spans
+        uint64_t    nbLost;
+    };
+
+  private:
+    // Atomic so the export can read it while its thread writes
+    struct Record
+    {
+        std::atomic< char const * > name;
+        std::atomic< uint64_t >     start;
+        std::atomic< uint64_t >     end;
+    };
+
+    struct ThreadBuffer
+    {
+        pid_t                       threadId;
+        std::unique_ptr< Record[] > records;
+        // Spans whose writing started, and spans written. A span is read
+        // as long as no writing started in its place since.
+        std::atomic< uint64_t >     nbStarted;
+        std::atomic< uint64_t >     nbWritten;
+        // Spans before are ignored
+        std::atomic< uint64_t >     nbCleared;
+        std::atomic< bool >         isFinished;
+    };
+
+    // Marks the buffer of its thread finished when the thread ends
+    struct ThreadHandle;
+
+    // Copy of a span taken by the export
+    struct Event
+    {
+        char const * name;
+        uint64_t     start;
+        uint64_t     end;
+    };
+
+    std::mutex                                     m_mutex;
+    std::vector< std::shared_ptr< ThreadBuffer > > m_buffers;
+
+    Tracing();
+
+  public:
+    virtual ~Tracing() = default;
+
+    // In nanoseconds, from an arbitrary origin
+    static uint64_t get_time ();
+
+    // JSON trace event format, to open in Perfetto or chrome://tracing
+    bool       export_chrome_trace ( std::filesystem::path const & file );
+    // Forget the spans recorded until now
+    void       clear ();
+    Statistics get_statistics ();
+
+  private:
+    void record ( char const * name, uint64_t start, uint64_t end );
+
+    // Created at the first span of the calling thread
+    ThreadBuffer &        get_thread_buffer ();
+    static std::vector< Event > read ( ThreadBuffer const & buffer );
+};